@@ -6,13 +6,20 @@
 // Created on September 7 2020.
 //
 
+#include <llvm-c/Target.h>
+#include <llvm-c/TargetMachine.h>
+#include <llvm-c/Transforms/PassBuilder.h>
 #include <stdio.h>
 #include <string.h>
 
 #include "../../../utils/list.h"
 #include "codegen.h"
 #include "functions.h"
+#include "generators.h"
+#include "lists.h"
 #include "llvm_types.h"
+#include "memory.h"
+#include "reference_counting.h"
 
 // build_expression(ir_sexpr_t*, LLVMBuilderRef, llvm_codegen_env_t*) -> LLVMValueRef
 // Builds an expression to LLVM IR.
@@ -22,6 +29,53 @@ LLVMValueRef build_expression(ir_sexpr_t* sexpr, LLVMBuilderRef builder, llvm_co
 // Builds an assignment to LLVM IR.
 LLVMValueRef build_assignment(ir_sexpr_t* sexpr, LLVMBuilderRef builder, llvm_codegen_env_t* env);
 
+// is_generator_constructor(ir_sexpr_t*) -> bool
+// Returns whether an S expression creates a new generator.
+bool is_generator_constructor(ir_sexpr_t* sexpr)
+{
+	return sexpr->tag == CURLY_IR_TAGS_RANGE || (sexpr->tag == CURLY_IR_TAGS_FOR
+		&& (sexpr->for_loop.loop_type == IR_LOOP_GENERATOR || sexpr->for_loop.loop_type == IR_LOOP_WHERE));
+}
+
+// build_iter_loop_start(ir_sexpr_t*, LLVMBuilderRef, llvm_codegen_env_t*) -> llvm_iter_loop_t
+// Starts a loop over a list or generator, leaving the builder in the body of the loop.
+llvm_iter_loop_t build_iter_loop_start(ir_sexpr_t* iter, LLVMBuilderRef builder, llvm_codegen_env_t* env);
+
+// build_generator(ir_sexpr_t*, LLVMBuilderRef, llvm_codegen_env_t*, bool) -> LLVMValueRef
+// Builds a generator as a coroutine closing over the locals it uses, placing them on the heap if the generator escapes.
+LLVMValueRef build_generator(ir_sexpr_t* sexpr, LLVMBuilderRef builder, llvm_codegen_env_t* env, bool escapes);
+
+// build_function(ir_sexpr_t*, LLVMBuilderRef, llvm_codegen_env_t*, char*, ir_binding_id_t*) -> LLVMValueRef
+// Builds a function closing over the locals it uses. binding is the variable the function is bound to, or NULL.
+LLVMValueRef build_function(ir_sexpr_t* sexpr, LLVMBuilderRef builder, llvm_codegen_env_t* env, char* name, ir_binding_id_t* binding);
+
+// build_iter_loop_exit(llvm_codegen_env_t*, LLVMBuilderRef, llvm_iter_loop_t, LLVMValueRef, bool) -> LLVMValueRef
+// Ends a loop that exits early once a condition is false (if all is true) or true (if all is false), returning whether the loop finished.
+LLVMValueRef build_iter_loop_exit(llvm_codegen_env_t* env, LLVMBuilderRef builder, llvm_iter_loop_t loop, LLVMValueRef cond, bool all)
+{
+	// Exit early once the result is known
+	LLVMBasicBlockRef exit_block = env->current_block;
+	LLVMBasicBlockRef next_block = LLVMAppendBasicBlock(env->current_func, "quant.next");
+	LLVMMoveBasicBlockAfter(next_block, exit_block);
+	if (all)
+		LLVMBuildCondBr(builder, cond, next_block, loop.post_block);
+	else LLVMBuildCondBr(builder, cond, loop.post_block, next_block);
+	LLVMPositionBuilderAtEnd(builder, next_block);
+	env->current_block = next_block;
+	build_iter_loop_end(env, builder, loop);
+
+	// Build phi
+	LLVMValueRef phi = LLVMBuildPhi(builder, LLVMInt1Type(), "");
+	LLVMValueRef incoming_values[] = {LLVMConstInt(LLVMInt1Type(), all, false), LLVMConstInt(LLVMInt1Type(), !all, false)};
+	LLVMBasicBlockRef incoming_blocks[] = {loop.cond_block, exit_block};
+	LLVMAddIncoming(phi, incoming_values, incoming_blocks, 2);
+
+	// Destroy the generator on every exit
+	if (loop.handle != NULL)
+		build_generator_destroy(env, builder, loop.handle);
+	return phi;
+}
+
 // build_infix(ir_sexpr_t*, LLVMBuilderRef, llvm_codegen_env_t*) -> LLVMValueRef
 // Builds an infix expression to LLVM IR.
 LLVMValueRef build_infix(ir_sexpr_t* sexpr, LLVMBuilderRef builder, llvm_codegen_env_t* env)
@@ -108,6 +162,425 @@ LLVMValueRef build_infix(ir_sexpr_t* sexpr, LLVMBuilderRef builder, llvm_codegen
 	}
 }
 
+// build_generator_body(ir_sexpr_t*, LLVMBuilderRef, llvm_codegen_env_t*, llvm_coro_t) -> void
+// Builds the body of a generator coroutine, yielding each of its values.
+void build_generator_body(ir_sexpr_t* sexpr, LLVMBuilderRef builder, llvm_codegen_env_t* env, llvm_coro_t coro)
+{
+	// Ranges count up from the start until the end (if any)
+	if (sexpr->tag == CURLY_IR_TAGS_RANGE)
+	{
+		LLVMValueRef start = build_expression(sexpr->range.start, builder, env);
+		LLVMValueRef end = sexpr->range.end != NULL ? build_expression(sexpr->range.end, builder, env) : NULL;
+
+		// Create basic blocks to jump to
+		LLVMBasicBlockRef from = env->current_block;
+		LLVMBasicBlockRef cond_block = LLVMAppendBasicBlock(env->current_func, "range.cond");
+		LLVMMoveBasicBlockAfter(cond_block, from);
+		LLVMBasicBlockRef body_block = LLVMAppendBasicBlock(env->current_func, "range.body");
+		LLVMMoveBasicBlockAfter(body_block, cond_block);
+		LLVMBasicBlockRef post_block = LLVMAppendBasicBlock(env->current_func, "range.post");
+		LLVMMoveBasicBlockAfter(post_block, body_block);
+
+		// Build the loop condition
+		LLVMBuildBr(builder, cond_block);
+		LLVMPositionBuilderAtEnd(builder, cond_block);
+		LLVMValueRef i = LLVMBuildPhi(builder, LLVMInt64Type(), "range.i");
+		if (end != NULL)
+			LLVMBuildCondBr(builder, LLVMBuildICmp(builder, LLVMIntSLT, i, end, ""), body_block, post_block);
+		else LLVMBuildBr(builder, body_block);
+
+		// Yield the current value and increment
+		LLVMPositionBuilderAtEnd(builder, body_block);
+		env->current_block = body_block;
+		build_coro_yield(env, builder, coro, i);
+		LLVMValueRef next = LLVMBuildAdd(builder, i, LLVMConstInt(LLVMInt64Type(), 1, false), "range.next");
+		LLVMAddIncoming(i, (LLVMValueRef[]) {start, next}, (LLVMBasicBlockRef[]) {from, env->current_block}, 2);
+		LLVMBuildBr(builder, cond_block);
+
+		// Move to the end of the loop
+		LLVMPositionBuilderAtEnd(builder, post_block);
+		env->current_block = post_block;
+		return;
+	}
+
+	// Build the body with the loop variable in scope
+	llvm_iter_loop_t loop = build_iter_loop_start(sexpr->for_loop.iter, builder, env);
+	size_t local_count = push_llvm_scope(env);
+	set_llvm_local(env, sexpr->for_loop.var_binding.index, loop.element);
+	LLVMValueRef body = build_expression(sexpr->for_loop.body, builder, env);
+	pop_llvm_scope(env, local_count);
+
+	// Maps yield the body, which is owned by the generator until it is resumed
+	if (sexpr->for_loop.loop_type == IR_LOOP_GENERATOR)
+	{
+		build_coro_yield(env, builder, coro, body);
+		if (llvm_rc_type(LLVMTypeOf(body)))
+			build_drop(env, builder, body);
+	}
+
+	// Filters yield the element if the body is true
+	else
+	{
+		LLVMBasicBlockRef yield_block = LLVMAppendBasicBlock(env->current_func, "where.yield");
+		LLVMMoveBasicBlockAfter(yield_block, env->current_block);
+		LLVMBasicBlockRef next_block = LLVMAppendBasicBlock(env->current_func, "where.next");
+		LLVMMoveBasicBlockAfter(next_block, yield_block);
+		LLVMBuildCondBr(builder, body, yield_block, next_block);
+		LLVMPositionBuilderAtEnd(builder, yield_block);
+		env->current_block = yield_block;
+		build_coro_yield(env, builder, coro, loop.element);
+		LLVMBuildBr(builder, next_block);
+		LLVMPositionBuilderAtEnd(builder, next_block);
+		env->current_block = next_block;
+	}
+
+	// End the loop
+	build_iter_loop_end(env, builder, loop);
+	if (loop.handle != NULL)
+		build_generator_destroy(env, builder, loop.handle);
+}
+
+// build_generator(ir_sexpr_t*, LLVMBuilderRef, llvm_codegen_env_t*, bool) -> LLVMValueRef
+// Builds a generator as a coroutine closing over the locals it uses, placing them on the heap if the generator escapes.
+LLVMValueRef build_generator(ir_sexpr_t* sexpr, LLVMBuilderRef builder, llvm_codegen_env_t* env, bool escapes)
+{
+	// Find the closed locals
+	size_t local_count = env->local_count;
+	char** closed_locals = calloc(local_count, sizeof(char*));
+	find_llvm_closure_locals(env, sexpr, closed_locals);
+	size_t count = 0;
+	size_t* slots = calloc(local_count, sizeof(size_t));
+	for (size_t i = 0; i < local_count; i++)
+	{
+		if (closed_locals[i] != NULL)
+			slots[count++] = i;
+	}
+	LLVMTypeRef* field_types = calloc(count, sizeof(LLVMTypeRef));
+	for (size_t i = 0; i < count; i++)
+	{
+		field_types[i] = LLVMTypeOf(env->locals[slots[i]]);
+	}
+	LLVMTypeRef env_type = LLVMStructType(field_types, count, false);
+
+	// Store the closed locals in the generator's environment, which holds references to them if it escapes
+	LLVMValueRef env_ptr;
+	if (escapes)
+	{
+		LLVMValueRef drop_func = build_drop_fields_function(env, env_type, "gen.env.drop");
+		env_ptr = LLVMBuildBitCast(builder, build_rc_alloc(env, builder, LLVMSizeOf(env_type), drop_func), LLVMPointerType(env_type, 0), "gen.env");
+	} else env_ptr = build_entry_alloca(env, env_type, "gen.env");
+	for (size_t i = 0; i < count; i++)
+	{
+		LLVMValueRef value = env->locals[slots[i]];
+		if (escapes && llvm_rc_type(field_types[i]))
+			build_dup(env, builder, value);
+		LLVMBuildStore(builder, value, LLVMBuildStructGEP2(builder, env_type, env_ptr, i, ""));
+	}
+	free(field_types);
+
+	// Create the ramp function
+	LLVMValueRef func = LLVMAddFunction(env->body_mod, "gen", generator_ramp_type());
+	LLVMSetLinkage(func, LLVMInternalLinkage);
+	LLVMContextRef context = LLVMGetModuleContext(env->body_mod);
+	LLVMAddAttributeAtIndex(func, LLVMAttributeFunctionIndex, LLVMCreateStringAttribute(context, "coroutine.presplit", 18, "0", 1));
+
+	// Save state and move builder to the start of the function
+	LLVMValueRef* last_locals = calloc(local_count, sizeof(LLVMValueRef));
+	if (local_count != 0)
+		memcpy(last_locals, env->locals, local_count * sizeof(LLVMValueRef));
+	LLVMValueRef last_func = env->current_func;
+	LLVMBasicBlockRef last_block = env->current_block;
+	LLVMValueRef last_self = env->current_self;
+	llvm_tail_calls_t* last_tail_calls = env->current_tail_calls;
+	if (local_count != 0)
+		memset(env->locals, 0, local_count * sizeof(LLVMValueRef));
+	env->current_func = func;
+	env->current_self = NULL;
+	env->current_tail_calls = NULL;
+	env->current_block = LLVMAppendBasicBlock(func, "entry");
+	LLVMPositionBuilderAtEnd(builder, env->current_block);
+
+	// Load the closed locals into their slots
+	LLVMValueRef param = LLVMBuildBitCast(builder, LLVMGetParam(func, 0), LLVMPointerType(env_type, 0), "");
+	for (size_t i = 0; i < count; i++)
+	{
+		LLVMValueRef ptr = LLVMBuildStructGEP2(builder, env_type, param, i, "");
+		set_llvm_local(env, slots[i], LLVMBuildLoad2(builder, LLVMStructGetTypeAtIndex(env_type, i), ptr, closed_locals[slots[i]]));
+	}
+
+	// Build the coroutine
+	llvm_coro_t coro = build_coro_begin(env, builder, internal_type_to_llvm(env, sexpr->type->field_types[0]));
+	build_generator_body(sexpr, builder, env, coro);
+	build_coro_end(env, builder, coro);
+
+	// Restore state
+	if (local_count != 0)
+		memcpy(env->locals, last_locals, local_count * sizeof(LLVMValueRef));
+	env->local_count = local_count;
+	env->current_func = last_func;
+	env->current_block = last_block;
+	env->current_self = last_self;
+	env->current_tail_calls = last_tail_calls;
+	LLVMPositionBuilderAtEnd(builder, last_block);
+	free(last_locals);
+	free(closed_locals);
+	free(slots);
+
+	// Build the generator value
+	LLVMValueRef generator = LLVMGetUndef(generator_value_type());
+	generator = LLVMBuildInsertValue(builder, generator, func, 0, "");
+	env_ptr = LLVMBuildBitCast(builder, env_ptr, LLVMPointerType(LLVMInt8Type(), 0), "");
+	return LLVMBuildInsertValue(builder, generator, env_ptr, 1, "generator");
+}
+
+// build_function(ir_sexpr_t*, LLVMBuilderRef, llvm_codegen_env_t*, char*, ir_binding_id_t*) -> LLVMValueRef
+// Builds a function closing over the locals it uses. binding is the variable the function is bound to, or NULL.
+LLVMValueRef build_function(ir_sexpr_t* sexpr, LLVMBuilderRef builder, llvm_codegen_env_t* env, char* name, ir_binding_id_t* binding)
+{
+	// Generic functions are only built through their specialisations, so they have no value
+	if (sexpr->type->has_vars)
+		return LLVMConstNull(function_value_type());
+	ir_sexpr_func_t* func = env->funcs[sexpr->func_id];
+
+	// Find the closed locals (functions bound to locals refer to themselves through their own value)
+	size_t local_count = env->local_count;
+	char** closed_locals = calloc(local_count, sizeof(char*));
+	find_llvm_closure_locals(env, func->body, closed_locals);
+	if (binding != NULL && !binding->global && binding->index < local_count)
+		closed_locals[binding->index] = NULL;
+	size_t count = 0;
+	size_t* slots = calloc(local_count, sizeof(size_t));
+	for (size_t i = 0; i < local_count; i++)
+	{
+		if (closed_locals[i] != NULL)
+			slots[count++] = i;
+	}
+	LLVMTypeRef* field_types = calloc(count, sizeof(LLVMTypeRef));
+	for (size_t i = 0; i < count; i++)
+	{
+		field_types[i] = LLVMTypeOf(env->locals[slots[i]]);
+	}
+	LLVMTypeRef env_type = LLVMStructType(field_types, count, false);
+
+	// Store new references to the closed locals in the function's environment
+	LLVMTypeRef i8_ptr = LLVMPointerType(LLVMInt8Type(), 0);
+	LLVMValueRef env_ptr = LLVMConstNull(i8_ptr);
+	if (count != 0)
+	{
+		LLVMValueRef drop_func = build_drop_fields_function(env, env_type, "func.env.drop");
+		env_ptr = build_rc_alloc(env, builder, LLVMSizeOf(env_type), drop_func);
+		LLVMValueRef fields = LLVMBuildBitCast(builder, env_ptr, LLVMPointerType(env_type, 0), "func.env");
+		for (size_t i = 0; i < count; i++)
+		{
+			LLVMValueRef value = env->locals[slots[i]];
+			if (llvm_rc_type(field_types[i]))
+				build_dup(env, builder, value);
+			LLVMBuildStore(builder, value, LLVMBuildStructGEP2(builder, env_type, fields, i, ""));
+		}
+	}
+	free(field_types);
+
+	// Create the direct function, which takes the environment and every argument (globals have the name of the variable)
+	LLVMTypeRef* param_types = calloc(func->arg_count + 1, sizeof(LLVMTypeRef));
+	param_types[0] = i8_ptr;
+	type_t* ret_type = sexpr->type;
+	for (size_t i = 0; i < func->arg_count; i++)
+	{
+		param_types[i + 1] = internal_type_to_llvm(env, func->args[i].type);
+		ret_type = ret_type->field_types[1];
+	}
+	LLVMTypeRef llvm_ret_type = internal_type_to_llvm(env, ret_type);
+	char* func_name = malloc(strlen(name) + 6);
+	sprintf(func_name, "%s.func", name);
+	LLVMValueRef direct = LLVMAddFunction(env->body_mod, func_name, LLVMFunctionType(llvm_ret_type, param_types, func->arg_count + 1, false));
+	LLVMSetLinkage(direct, LLVMInternalLinkage);
+	free(param_types);
+
+	// Calls of globals bound to the function can use the direct function, including recursive calls
+	if (binding != NULL && binding->global)
+		set_llvm_direct_function(env, binding->index, direct);
+	LLVMValueRef stub = build_function_stubs(env, direct, func_name);
+	free(func_name);
+
+	// Find the applications in tail position
+	llvm_tail_calls_t tail_calls = {0};
+	bool self_tail_calls = find_llvm_tail_calls(func->body, &tail_calls, binding, func->arg_count);
+
+	// Save state and move builder to the start of the function
+	LLVMValueRef* last_locals = calloc(local_count, sizeof(LLVMValueRef));
+	if (local_count != 0)
+		memcpy(last_locals, env->locals, local_count * sizeof(LLVMValueRef));
+	LLVMValueRef last_func = env->current_func;
+	LLVMBasicBlockRef last_block = env->current_block;
+	LLVMValueRef last_self = env->current_self;
+	llvm_tail_calls_t* last_tail_calls = env->current_tail_calls;
+	if (local_count != 0)
+		memset(env->locals, 0, local_count * sizeof(LLVMValueRef));
+	env->current_func = direct;
+	env->current_self = NULL;
+	env->current_tail_calls = &tail_calls;
+	env->current_block = LLVMAppendBasicBlock(direct, "entry");
+	LLVMPositionBuilderAtEnd(builder, env->current_block);
+
+	// Load the closed locals and arguments into their slots
+	LLVMValueRef param = LLVMBuildBitCast(builder, LLVMGetParam(direct, 0), LLVMPointerType(env_type, 0), "");
+	for (size_t i = 0; i < count; i++)
+	{
+		LLVMValueRef ptr = LLVMBuildStructGEP2(builder, env_type, param, i, "");
+		set_llvm_local(env, slots[i], LLVMBuildLoad2(builder, LLVMStructGetTypeAtIndex(env_type, i), ptr, closed_locals[slots[i]]));
+	}
+	if (binding != NULL && !binding->global)
+	{
+		env->current_self = build_function_value(builder, stub, LLVMGetParam(direct, 0));
+		set_llvm_local(env, binding->index, env->current_self);
+	}
+
+	// Self tail calls branch back to a loop over the arguments
+	if (self_tail_calls)
+	{
+		LLVMBasicBlockRef entry = env->current_block;
+		tail_calls.loop = LLVMAppendBasicBlock(direct, "tail.loop");
+		LLVMBuildBr(builder, tail_calls.loop);
+		LLVMPositionBuilderAtEnd(builder, tail_calls.loop);
+		env->current_block = tail_calls.loop;
+		tail_calls.args = calloc(func->arg_count, sizeof(LLVMValueRef));
+		for (size_t i = 0; i < func->arg_count; i++)
+		{
+			LLVMValueRef param = LLVMGetParam(direct, i + 1);
+			tail_calls.args[i] = LLVMBuildPhi(builder, LLVMTypeOf(param), "");
+			LLVMAddIncoming(tail_calls.args[i], &param, &entry, 1);
+		}
+	}
+	for (size_t i = 0; i < func->arg_count; i++)
+	{
+		LLVMValueRef arg = self_tail_calls ? tail_calls.args[i] : LLVMGetParam(direct, i + 1);
+		LLVMSetValueName2(arg, func->args[i].name, strlen(func->args[i].name));
+		set_llvm_local(env, func->args[i].binding.index, arg);
+	}
+
+	// Build the body
+	LLVMValueRef value = build_expression(func->body, builder, env);
+	LLVMBuildRet(builder, build_coerce_value(builder, value, llvm_ret_type));
+	mark_llvm_tail_calls(env, &tail_calls);
+
+	// Restore state
+	if (local_count != 0)
+		memcpy(env->locals, last_locals, local_count * sizeof(LLVMValueRef));
+	env->local_count = local_count;
+	env->current_func = last_func;
+	env->current_block = last_block;
+	env->current_self = last_self;
+	env->current_tail_calls = last_tail_calls;
+	LLVMPositionBuilderAtEnd(builder, last_block);
+	free(tail_calls.applies);
+	free(tail_calls.calls);
+	free(tail_calls.args);
+	free(last_locals);
+	free(closed_locals);
+	free(slots);
+	return build_function_value(builder, stub, env_ptr);
+}
+
+// build_apply(ir_sexpr_t*, LLVMBuilderRef, llvm_codegen_env_t*) -> LLVMValueRef
+// Builds a function application, calling the direct function of a global function given enough arguments.
+LLVMValueRef build_apply(ir_sexpr_t* sexpr, LLVMBuilderRef builder, llvm_codegen_env_t* env)
+{
+	// Find the applications from the innermost out
+	size_t count = 0;
+	for (ir_sexpr_t* apply = sexpr; apply->tag == CURLY_IR_TAGS_APPLY; apply = apply->apply.func)
+	{
+		count++;
+	}
+	ir_sexpr_t** applies = calloc(count, sizeof(ir_sexpr_t*));
+	ir_sexpr_t* head = sexpr;
+	for (size_t i = count; i > 0; i--)
+	{
+		applies[i - 1] = head;
+		head = head->apply.func;
+	}
+
+	// Find the direct function of a global, or of the function being built if it calls itself through a local
+	LLVMValueRef direct = NULL;
+	LLVMValueRef direct_env = LLVMConstNull(LLVMPointerType(LLVMInt8Type(), 0));
+	if (head->tag == CURLY_IR_TAGS_SYMBOL && head->binding.global)
+		direct = lookup_llvm_direct_function(env, head->binding.index);
+	else if (head->tag == CURLY_IR_TAGS_SYMBOL && env->current_self != NULL && lookup_llvm_local(env, head->binding.index) == env->current_self)
+	{
+		direct = env->current_func;
+		direct_env = LLVMGetParam(direct, 0);
+	}
+
+	// Call the direct function if there are enough arguments
+	LLVMValueRef value = NULL;
+	size_t applied = 0;
+	bool tail = is_llvm_tail_call(env, sexpr);
+	if (direct != NULL && LLVMCountParams(direct) - 1 <= count)
+	{
+		applied = LLVMCountParams(direct) - 1;
+		LLVMValueRef* args = calloc(applied + 1, sizeof(LLVMValueRef));
+		args[0] = direct_env;
+		for (size_t i = 0; i < applied; i++)
+		{
+			LLVMValueRef arg = build_expression(applies[i]->apply.arg, builder, env);
+			args[i + 1] = build_coerce_value(builder, arg, LLVMTypeOf(LLVMGetParam(direct, i + 1)));
+		}
+
+		// Self tail calls pass their arguments to the next iteration of the loop, leaving the builder in an unreachable block
+		if (tail && direct == env->current_func && applied == count && env->current_tail_calls->loop != NULL)
+		{
+			for (size_t i = 0; i < applied; i++)
+			{
+				LLVMAddIncoming(env->current_tail_calls->args[i], &args[i + 1], &env->current_block, 1);
+			}
+			LLVMBuildBr(builder, env->current_tail_calls->loop);
+			env->current_block = LLVMAppendBasicBlock(env->current_func, "tail.post");
+			LLVMPositionBuilderAtEnd(builder, env->current_block);
+			free(args);
+			free(applies);
+			return LLVMGetUndef(LLVMGetReturnType(LLVMGetElementType(LLVMTypeOf(direct))));
+		}
+		value = LLVMBuildCall2(builder, LLVMGetElementType(LLVMTypeOf(direct)), direct, args, applied + 1, "");
+		free(args);
+	} else value = build_expression(head, builder, env);
+
+	// Call the function values for the rest of the arguments, dropping the intermediate functions
+	for (size_t i = applied; i < count; i++)
+	{
+		LLVMValueRef arg = build_expression(applies[i]->apply.arg, builder, env);
+		LLVMTypeRef arg_type = internal_type_to_llvm(env, applies[i]->apply.func->type->field_types[0]);
+		LLVMValueRef result = build_function_call(env, builder, value, arg, arg_type, internal_type_to_llvm(env, applies[i]->type));
+		if (i != 0)
+			build_drop(env, builder, value);
+		value = result;
+	}
+
+	// Calls in tail position are marked as tail calls once the function is built
+	if (tail && LLVMIsACallInst(value))
+		list_append_element(env->current_tail_calls->calls, env->current_tail_calls->call_size, env->current_tail_calls->call_count, LLVMValueRef, value);
+	free(applies);
+	return value;
+}
+
+// build_iter_loop_start(ir_sexpr_t*, LLVMBuilderRef, llvm_codegen_env_t*) -> llvm_iter_loop_t
+// Starts a loop over a list or generator, leaving the builder in the body of the loop.
+llvm_iter_loop_t build_iter_loop_start(ir_sexpr_t* iter, LLVMBuilderRef builder, llvm_codegen_env_t* env)
+{
+	if (iter->type->type_type == IR_TYPES_LIST)
+		return build_list_loop_start(env, builder, build_expression(iter, builder, env));
+
+	// Generators consumed where they are created keep their environment on the stack, allowing the frame to be elided too
+	LLVMValueRef generator;
+	if (is_generator_constructor(iter))
+		generator = build_generator(iter, builder, env, false);
+	else generator = build_expression(iter, builder, env);
+
+	// Start the coroutine
+	LLVMValueRef ramp = LLVMBuildExtractValue(builder, generator, 0, "");
+	LLVMValueRef gen_env = LLVMBuildExtractValue(builder, generator, 1, "");
+	LLVMValueRef handle = LLVMBuildCall2(builder, generator_ramp_type(), ramp, (LLVMValueRef[]) {gen_env}, 1, "gen.handle");
+	return build_generator_loop_start(env, builder, handle, internal_type_to_llvm(env, iter->type->field_types[0]));
+}
+
 // build_expression(ir_sexpr_t*, LLVMBuilderRef, llvm_codegen_env_t*) -> LLVMValueRef
 // Builds an expression to LLVM IR.
 LLVMValueRef build_expression(ir_sexpr_t* sexpr, LLVMBuilderRef builder, llvm_codegen_env_t* env)
@@ -123,13 +596,12 @@ LLVMValueRef build_expression(ir_sexpr_t* sexpr, LLVMBuilderRef builder, llvm_co
 		case CURLY_IR_TAGS_SYMBOL:
 		{
 			// Get local
-			LLVMValueRef local = lookup_llvm_local(env, sexpr->symbol);
-			if (local != NULL)
+			if (!sexpr->binding.global)
 			// {
 				// // Local is definitely not a thunk
 				// uint64_t param_index = lookup_llvm_param(env, sexpr->symbol);
 				// if (param_index >= 64)
-					return local;
+					return lookup_llvm_local(env, sexpr->binding.index);
 
 			// 	// Local is a parameter that has not been checked for thunkiness
 			// 	LLVMValueRef thunk_bitmap_ptr = LLVMGetParam(env->current_func, 0);
@@ -176,8 +648,8 @@ LLVMValueRef build_expression(ir_sexpr_t* sexpr, LLVMBuilderRef builder, llvm_co
 			// }
 
 			// Get global
-			LLVMValueRef global = LLVMGetNamedGlobal(env->header_mod, sexpr->symbol);
-			return LLVMBuildLoad(builder, global, "");
+			LLVMValueRef global = lookup_llvm_global(env, sexpr->binding.index);
+			return LLVMBuildLoad2(builder, LLVMGlobalGetValueType(global), global, "");
 		}
 		case CURLY_IR_TAGS_INFIX:
 			switch (sexpr->infix.op)
@@ -197,11 +669,11 @@ LLVMValueRef build_expression(ir_sexpr_t* sexpr, LLVMBuilderRef builder, llvm_co
 					// Build the branch and right operand
 					LLVMBuildCondBr(builder, left, right_block, post_and);
 					LLVMPositionBuilderAtEnd(builder, right_block);
-					env->local = push_llvm_scope(env->local);
+					size_t local_count = push_llvm_scope(env);
 					env->current_block = right_block;
 					LLVMValueRef right = build_expression(sexpr->infix.right, builder, env);
 					right_block = env->current_block;
-					env->local = pop_llvm_scope(env->local);
+					pop_llvm_scope(env, local_count);
 
 					// Build phi
 					LLVMBuildBr(builder, post_and);
@@ -230,10 +702,10 @@ LLVMValueRef build_expression(ir_sexpr_t* sexpr, LLVMBuilderRef builder, llvm_co
 					LLVMBuildCondBr(builder, left, post_or, right_block);
 					LLVMPositionBuilderAtEnd(builder, right_block);
 					env->current_block = right_block;
-					env->local = push_llvm_scope(env->local);
+					size_t local_count = push_llvm_scope(env);
 					LLVMValueRef right = build_expression(sexpr->infix.right, builder, env);
 					right_block = env->current_block;
-					env->local = pop_llvm_scope(env->local);
+					pop_llvm_scope(env, local_count);
 
 					// Build phi
 					LLVMBuildBr(builder, post_or);
@@ -246,6 +718,25 @@ LLVMValueRef build_expression(ir_sexpr_t* sexpr, LLVMBuilderRef builder, llvm_co
 					return phi;
 				}
 
+				case IR_BINOPS_CMPIN:
+				{
+					// Search for the value in the iterator
+					LLVMValueRef left = build_expression(sexpr->infix.left, builder, env);
+					llvm_iter_loop_t loop = build_iter_loop_start(sexpr->infix.right, builder, env);
+					LLVMValueRef found;
+					if (LLVMGetTypeKind(LLVMTypeOf(left)) == LLVMDoubleTypeKind)
+						found = LLVMBuildFCmp(builder, LLVMRealOEQ, loop.element, left, "");
+					else found = LLVMBuildICmp(builder, LLVMIntEQ, loop.element, left, "");
+					return build_iter_loop_exit(env, builder, loop, found, false);
+				}
+
+				case IR_BINOPS_INDEX:
+				{
+					LLVMValueRef list = build_expression(sexpr->infix.left, builder, env);
+					LLVMValueRef index = build_expression(sexpr->infix.right, builder, env);
+					return build_list_index(env, builder, list, index);
+				}
+
 				default:
 					return build_infix(sexpr, builder, env);
 			}
@@ -264,8 +755,9 @@ LLVMValueRef build_expression(ir_sexpr_t* sexpr, LLVMBuilderRef builder, llvm_co
 					return NULL;
 			}
 		case CURLY_IR_TAGS_LOCAL_SCOPE:
+		{
 			// Push local scope
-			env->local = push_llvm_scope(env->local);
+			size_t local_count = push_llvm_scope(env);
 
 			// Build all the assignments
 			for (size_t i = 0; i < sexpr->local_scope.assign_count; i++)
@@ -278,8 +770,9 @@ LLVMValueRef build_expression(ir_sexpr_t* sexpr, LLVMBuilderRef builder, llvm_co
 			LLVMValueRef value = build_expression(sexpr->local_scope.value, builder, env);
 
 			// Pop local scope
-			env->local = pop_llvm_scope(env->local);
+			pop_llvm_scope(env, local_count);
 			return value;
+		}
 		case CURLY_IR_TAGS_IF:
 		{
 			// Build condition
@@ -297,19 +790,19 @@ LLVMValueRef build_expression(ir_sexpr_t* sexpr, LLVMBuilderRef builder, llvm_co
 			LLVMBuildCondBr(builder, cond, then_block, else_block);
 			LLVMPositionBuilderAtEnd(builder, then_block);
 			env->current_block = then_block;
-			env->local = push_llvm_scope(env->local);
+			size_t local_count = push_llvm_scope(env);
 			LLVMValueRef then_val = build_expression(sexpr->if_expr.then, builder, env);
 			then_block = env->current_block;
-			env->local = pop_llvm_scope(env->local);
+			pop_llvm_scope(env, local_count);
 
 			// Build the branch and else body
 			LLVMBuildBr(builder, post_if);
 			LLVMPositionBuilderAtEnd(builder, else_block);
 			env->current_block = else_block;
-			env->local = push_llvm_scope(env->local);
+			local_count = push_llvm_scope(env);
 			LLVMValueRef else_val = build_expression(sexpr->if_expr.elsy, builder, env);
 			else_block = env->current_block;
-			env->local = pop_llvm_scope(env->local);
+			pop_llvm_scope(env, local_count);
 
 			// Build phi
 			LLVMBuildBr(builder, post_if);
@@ -321,34 +814,204 @@ LLVMValueRef build_expression(ir_sexpr_t* sexpr, LLVMBuilderRef builder, llvm_co
 			LLVMAddIncoming(phi, incoming_values, incoming_blocks, 2);
 			return phi;
 		}
+		case CURLY_IR_TAGS_LIST:
+		{
+			// Build the elements
+			size_t count = sexpr->list.element_count;
+			LLVMValueRef* elements = calloc(count, sizeof(LLVMValueRef));
+			for (size_t i = 0; i < count; i++)
+			{
+				elements[i] = build_expression(sexpr->list.elements[i], builder, env);
+			}
+
+			// Build the list
+			LLVMTypeRef elem_type = count != 0 ? LLVMTypeOf(elements[0]) : LLVMInt64Type();
+			LLVMValueRef list = build_list_literal(env, builder, elem_type, elements, count);
+			free(elements);
+			return list;
+		}
+		case CURLY_IR_TAGS_SLICE:
+		{
+			LLVMValueRef list = build_expression(sexpr->slice.list, builder, env);
+			LLVMValueRef start = build_expression(sexpr->slice.start, builder, env);
+			LLVMValueRef end = build_expression(sexpr->slice.end, builder, env);
+			return build_list_slice(env, builder, list, start, end);
+		}
+		case CURLY_IR_TAGS_FOR:
+			switch (sexpr->for_loop.loop_type)
+			{
+				case IR_LOOP_LIST:
+				{
+					LLVMTypeRef result_type = internal_type_to_llvm(env, sexpr->type);
+					LLVMTypeRef elem_type = internal_type_to_llvm(env, sexpr->type->field_types[0]);
+					LLVMValueRef result = NULL;
+					LLVMValueRef result_ptr = NULL;
+					llvm_iter_loop_t loop;
+
+					LLVMValueRef iter = NULL;
+					LLVMValueRef reused = LLVMConstInt(LLVMInt1Type(), 0, false);
+
+					// Comprehensions over lists are maps into a list of the same length
+					if (sexpr->for_loop.iter->type->type_type == IR_TYPES_LIST)
+					{
+						iter = build_expression(sexpr->for_loop.iter, builder, env);
+						LLVMValueRef length = LLVMBuildExtractValue(builder, iter, 0, "");
+
+						// Maps that consume a uniquely referenced list of the same type write over it in place
+						if (sexpr->for_loop.consume && LLVMTypeOf(iter) == result_type && !llvm_rc_type(elem_type))
+						{
+							reused = build_rc_is_unique(env, builder, iter);
+							LLVMBasicBlockRef from = env->current_block;
+							LLVMBasicBlockRef alloc_block = LLVMAppendBasicBlock(env->current_func, "list.map.alloc");
+							LLVMMoveBasicBlockAfter(alloc_block, from);
+							LLVMBasicBlockRef post_block = LLVMAppendBasicBlock(env->current_func, "list.map.post");
+							LLVMMoveBasicBlockAfter(post_block, alloc_block);
+							LLVMBuildCondBr(builder, reused, post_block, alloc_block);
+							LLVMPositionBuilderAtEnd(builder, alloc_block);
+							env->current_block = alloc_block;
+							LLVMValueRef fresh = build_list_alloc(env, builder, elem_type, length);
+							LLVMBuildBr(builder, post_block);
+							LLVMPositionBuilderAtEnd(builder, post_block);
+							env->current_block = post_block;
+							result = LLVMBuildPhi(builder, result_type, "list.map");
+							LLVMAddIncoming(result, (LLVMValueRef[]) {iter, fresh}, (LLVMBasicBlockRef[]) {from, alloc_block}, 2);
+						} else result = build_list_alloc(env, builder, elem_type, length);
+						loop = build_list_loop_start(env, builder, iter);
+
+					// Comprehensions over generators grow a list as values are yielded
+					} else
+					{
+						result_ptr = build_entry_alloca(env, result_type, "list.acc");
+						LLVMBuildStore(builder, LLVMConstNull(result_type), result_ptr);
+						loop = build_iter_loop_start(sexpr->for_loop.iter, builder, env);
+					}
+
+					// Build the body with the loop variable in scope
+					size_t local_count = push_llvm_scope(env);
+					set_llvm_local(env, sexpr->for_loop.var_binding.index, loop.element);
+					LLVMValueRef body = build_expression(sexpr->for_loop.body, builder, env);
+					pop_llvm_scope(env, local_count);
+
+					// Store the mapped value
+					if (result_ptr == NULL)
+					{
+						LLVMValueRef result_data = LLVMBuildExtractValue(builder, result, 2, "");
+						LLVMValueRef ptr = LLVMBuildGEP2(builder, elem_type, result_data, (LLVMValueRef[]) {loop.index}, 1, "");
+						LLVMBuildStore(builder, body, ptr);
+						build_iter_loop_end(env, builder, loop);
+
+						// Drop the consumed list if it wasn't reused
+						if (sexpr->for_loop.consume)
+						{
+							LLVMBasicBlockRef drop_block = LLVMAppendBasicBlock(env->current_func, "list.map.drop");
+							LLVMMoveBasicBlockAfter(drop_block, env->current_block);
+							LLVMBasicBlockRef post_block = LLVMAppendBasicBlock(env->current_func, "list.map.end");
+							LLVMMoveBasicBlockAfter(post_block, drop_block);
+							LLVMBuildCondBr(builder, reused, post_block, drop_block);
+							LLVMPositionBuilderAtEnd(builder, drop_block);
+							env->current_block = drop_block;
+							build_drop(env, builder, iter);
+							LLVMBuildBr(builder, post_block);
+							LLVMPositionBuilderAtEnd(builder, post_block);
+							env->current_block = post_block;
+						}
+						return result;
+					}
+
+					build_list_append(env, builder, result_ptr, body);
+					build_iter_loop_end(env, builder, loop);
+					build_generator_destroy(env, builder, loop.handle);
+					return LLVMBuildLoad2(builder, result_type, result_ptr, "");
+				}
+
+				case IR_LOOP_ALL:
+				case IR_LOOP_SOME:
+				{
+					// Build the body with the loop variable in scope
+					llvm_iter_loop_t loop = build_iter_loop_start(sexpr->for_loop.iter, builder, env);
+					size_t local_count = push_llvm_scope(env);
+					set_llvm_local(env, sexpr->for_loop.var_binding.index, loop.element);
+					LLVMValueRef body = build_expression(sexpr->for_loop.body, builder, env);
+					pop_llvm_scope(env, local_count);
+
+					// Quantifiers exit early once the result is known
+					return build_iter_loop_exit(env, builder, loop, body, sexpr->for_loop.loop_type == IR_LOOP_ALL);
+				}
+
+				default:
+				{
+					// Generators that escape need their closed locals on the heap, and share the values they produce
+					LLVMValueRef generator = build_generator(sexpr, builder, env, true);
+					return build_memo_generator(env, builder, generator, internal_type_to_llvm(env, sexpr->type->field_types[0]));
+				}
+			}
+		case CURLY_IR_TAGS_RANGE:
+			return build_generator(sexpr, builder, env, true);
+		case CURLY_IR_TAGS_FUNC:
+			return build_function(sexpr, builder, env, "func", NULL);
+		case CURLY_IR_TAGS_APPLY:
+			return build_apply(sexpr, builder, env);
+		case CURLY_IR_TAGS_DUP:
+		{
+			LLVMValueRef value = build_expression(sexpr->rc.value, builder, env);
+			build_dup(env, builder, value);
+			return value;
+		}
+		case CURLY_IR_TAGS_DROP:
+		{
+			// Drop the locals after the value has been built
+			LLVMValueRef value = build_expression(sexpr->rc.value, builder, env);
+			for (size_t i = 0; i < sexpr->rc.drop_count; i++)
+			{
+				build_drop(env, builder, lookup_llvm_local(env, sexpr->rc.drops[i]->binding.index));
+			}
+			return value;
+		}
 		default:
 			puts("Unsupported S expression!");
 			return NULL;
 	}
 }
 
-// llvm_save_value(llvm_codegen_env_t*, char*, LLVMValueRef, LLVMBuilderRef) -> LLVMValueRef
-// Saves a value as a global value, or a local if a local scope is present.
-LLVMValueRef llvm_save_value(llvm_codegen_env_t* env, char* name, LLVMValueRef value, LLVMBuilderRef builder)
+// llvm_global_variable(llvm_codegen_env_t*, char*, ir_binding_id_t, LLVMTypeRef, bool*) -> LLVMValueRef
+// Returns the LLVM global variable of a global, creating it if it doesn't exist. created is set to whether it was created.
+LLVMValueRef llvm_global_variable(llvm_codegen_env_t* env, char* name, ir_binding_id_t binding, LLVMTypeRef type, bool* created)
 {
-	// Set the global variable
-	if (env->local == NULL)
+	LLVMValueRef global = lookup_llvm_global(env, binding.index);
+	*created = global == NULL;
+	if (global != NULL)
+		return global;
+
+	// Globals in the repl are defined by the repl
+	size_t length = 0;
+	global = LLVMAddGlobal(env->header_mod, type, name);
+	set_llvm_global(env, binding.index, global);
+	if (!strcmp(LLVMGetModuleIdentifier(env->header_mod, &length), "repl-header"))
+		LLVMSetLinkage(global, LLVMExternalWeakLinkage);
+	else
 	{
-		// Get expression and global
-		LLVMValueRef global = LLVMGetNamedGlobal(env->header_mod, name);
-		size_t length = 0;
+		LLVMSetLinkage(global, LLVMCommonLinkage);
+		LLVMSetInitializer(global, LLVMConstNull(type));
+	}
+	return global;
+}
 
-		// Create missing global
-		if (global == NULL)
+// llvm_save_value(llvm_codegen_env_t*, char*, ir_binding_id_t, LLVMValueRef, LLVMBuilderRef) -> LLVMValueRef
+// Saves a value as a global value or a local, depending on the variable it's bound to.
+LLVMValueRef llvm_save_value(llvm_codegen_env_t* env, char* name, ir_binding_id_t binding, LLVMValueRef value, LLVMBuilderRef builder)
+{
+	// Set the global variable
+	if (binding.global)
+	{
+		// Drop the previous value of a reassigned global after storing the new one
+		bool created = false;
+		LLVMValueRef global = llvm_global_variable(env, name, binding, LLVMTypeOf(value), &created);
+		if (!created && llvm_rc_type(LLVMTypeOf(value)))
 		{
-			global = LLVMAddGlobal(env->header_mod, LLVMTypeOf(value), name);
-			if (!strcmp(LLVMGetModuleIdentifier(env->header_mod, &length), "repl-header"))
-				LLVMSetLinkage(global, LLVMExternalWeakLinkage);
-			else
-			{
-				LLVMSetLinkage(global, LLVMCommonLinkage);
-				LLVMSetInitializer(global, LLVMConstInt(LLVMInt64Type(), 0, false));
-			}
+			LLVMValueRef old = LLVMBuildLoad2(builder, LLVMTypeOf(value), global, "");
+			LLVMBuildStore(builder, value, global);
+			build_drop(env, builder, old);
+			return value;
 		}
 
 		// Build store instruction
@@ -356,7 +1019,7 @@ LLVMValueRef llvm_save_value(llvm_codegen_env_t* env, char* name, LLVMValueRef v
 		return value;
 	} else
 	{
-		map_add(env->local->variables, name, value);
+		set_llvm_local(env, binding.index, value);
 		return value;
 	}
 }
@@ -365,8 +1028,22 @@ LLVMValueRef llvm_save_value(llvm_codegen_env_t* env, char* name, LLVMValueRef v
 // Builds an assignment to LLVM IR.
 LLVMValueRef build_assignment(ir_sexpr_t* sexpr, LLVMBuilderRef builder, llvm_codegen_env_t* env)
 {
-	LLVMValueRef value = build_expression(sexpr->assign.value, builder, env);
-	return llvm_save_value(env, sexpr->assign.name, value, builder);
+	// Functions are named after their variable, which exists before the function is built so it can refer to itself
+	LLVMValueRef value;
+	if (sexpr->assign.value->tag == CURLY_IR_TAGS_FUNC)
+	{
+		bool created = false;
+		if (sexpr->assign.binding.global)
+			llvm_global_variable(env, sexpr->assign.name, sexpr->assign.binding, function_value_type(), &created);
+		value = build_function(sexpr->assign.value, builder, env, sexpr->assign.name, &sexpr->assign.binding);
+	} else
+	{
+		// Globals reassigned to other values can't be called directly anymore
+		if (sexpr->assign.binding.global && lookup_llvm_direct_function(env, sexpr->assign.binding.index) != NULL)
+			set_llvm_direct_function(env, sexpr->assign.binding.index, NULL);
+		value = build_expression(sexpr->assign.value, builder, env);
+	}
+	return llvm_save_value(env, sexpr->assign.name, sexpr->assign.binding, value, builder);
 
 	// // var = expr and var: type = expr
 	// char* name = NULL;
@@ -472,16 +1149,16 @@ LLVMValueRef build_assignment(ir_sexpr_t* sexpr, LLVMBuilderRef builder, llvm_co
 	// return NULL;
 }
 
-// generate_code(curly_ir_t, llvm_codegen_env_t*) -> llvm_codegen_env_t*
+// generate_code(curly_ir_t, ir_scope_t*, llvm_codegen_env_t*) -> llvm_codegen_env_t*
 // Generates llvm ir code from an ast.
-llvm_codegen_env_t* generate_code(curly_ir_t ir, llvm_codegen_env_t* env)
+llvm_codegen_env_t* generate_code(curly_ir_t ir, ir_scope_t* scope, llvm_codegen_env_t* env)
 {
 	LLVMContextRef context;
 	bool repl_mode = env != NULL;
 	if (!repl_mode)
 	{
 		// Create the main module
-		context = LLVMContextCreate();
+		context = LLVMGetGlobalContext();
 		LLVMModuleRef main_mod = LLVMModuleCreateWithNameInContext("file", context);
 		env = create_llvm_codegen_environment(main_mod);
 		env->body_mod = main_mod;
@@ -490,10 +1167,18 @@ llvm_codegen_env_t* generate_code(curly_ir_t ir, llvm_codegen_env_t* env)
 		// Create the executed module for repl
 		context = LLVMGetModuleContext(env->header_mod);
 		env->body_mod = LLVMModuleCreateWithNameInContext("stdin", context);
+	}
+
+	// Instances of parametric types are laid out as the declared body
+	env->funcs = ir.funcs;
+	env->layouts->types = scope->types;
 
+	if (repl_mode)
+	{
 		// Create the repl variable
+		// The previous one is renamed instead of deleted, since the code of previous inputs still uses it
 		LLVMValueRef repl_last = LLVMGetNamedGlobal(env->header_mod, "repl.last");
-		if (repl_last != NULL) LLVMDeleteGlobal(repl_last);
+		if (repl_last != NULL) LLVMSetValueName2(repl_last, "repl.last.old", strlen("repl.last.old"));
 		LLVMTypeRef repl_last_type = internal_type_to_llvm(env, ir.expr[ir.expr_count - 1]->type);
 		repl_last = LLVMAddGlobal(env->header_mod, repl_last_type, "repl.last");
 		LLVMSetLinkage(repl_last, LLVMExternalWeakLinkage);
@@ -528,3 +1213,54 @@ llvm_codegen_env_t* generate_code(curly_ir_t ir, llvm_codegen_env_t* env)
 	LLVMDisposeBuilder(builder);
 	return env;
 }
+
+// optimize_code(llvm_codegen_env_t*) -> void
+// Runs the optimisation pipeline for the host machine over the generated code, which also lowers generators into state machines.
+void optimize_code(llvm_codegen_env_t* env)
+{
+	// Create the target machine
+	LLVMInitializeNativeTarget();
+	char* triple = LLVMGetDefaultTargetTriple();
+	char* error = NULL;
+	LLVMTargetRef target = NULL;
+	if (LLVMGetTargetFromTriple(triple, &target, &error))
+	{
+		fprintf(stderr, "target error: %s\n", error);
+		LLVMDisposeMessage(error);
+		LLVMDisposeMessage(triple);
+		return;
+	}
+	char* cpu = LLVMGetHostCPUName();
+	char* features = LLVMGetHostCPUFeatures();
+	LLVMTargetMachineRef machine = LLVMCreateTargetMachine(target, triple, cpu, features, LLVMCodeGenLevelDefault, LLVMRelocDefault, LLVMCodeModelJITDefault);
+	LLVMTargetDataRef data = LLVMCreateTargetDataLayout(machine);
+	char* layout = LLVMCopyStringRepOfTargetData(data);
+
+	// Set the layout of both modules
+	LLVMSetTarget(env->body_mod, triple);
+	LLVMSetDataLayout(env->body_mod, layout);
+	if (env->header_mod != env->body_mod)
+	{
+		LLVMSetTarget(env->header_mod, triple);
+		LLVMSetDataLayout(env->header_mod, layout);
+	}
+
+	// Run the passes (the default pipeline includes the coroutine passes)
+	LLVMPassBuilderOptionsRef options = LLVMCreatePassBuilderOptions();
+	LLVMErrorRef pass_error = LLVMRunPasses(env->body_mod, "default<O2>", machine, options);
+	if (pass_error != NULL)
+	{
+		char* message = LLVMGetErrorMessage(pass_error);
+		fprintf(stderr, "optimisation error: %s\n", message);
+		LLVMDisposeErrorMessage(message);
+	}
+
+	// Clean up
+	LLVMDisposePassBuilderOptions(options);
+	LLVMDisposeMessage(layout);
+	LLVMDisposeTargetData(data);
+	LLVMDisposeTargetMachine(machine);
+	LLVMDisposeMessage(features);
+	LLVMDisposeMessage(cpu);
+	LLVMDisposeMessage(triple);
+}
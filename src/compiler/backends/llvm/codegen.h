@@ -12,10 +12,15 @@
 #include <llvm-c/Core.h>
 
 #include "environment.h"
+#include "../../frontend/correctness/scope.h"
 #include "../../frontend/ir/generate_ir.h"
 
-// generate_code(curly_ir_t, llvm_codegen_env_t*) -> llvm_codegen_env_t*
+// generate_code(curly_ir_t, ir_scope_t*, llvm_codegen_env_t*) -> llvm_codegen_env_t*
 // Generates llvm ir code from an ast.
-llvm_codegen_env_t* generate_code(curly_ir_t ir, llvm_codegen_env_t* env);
+llvm_codegen_env_t* generate_code(curly_ir_t ir, ir_scope_t* scope, llvm_codegen_env_t* env);
+
+// optimize_code(llvm_codegen_env_t*) -> void
+// Runs the optimisation pipeline for the host machine over the generated code, which also lowers generators into state machines.
+void optimize_code(llvm_codegen_env_t* env);
 
 #endif /* LLVM_CODEGEN_H */
@@ -6,28 +6,22 @@
 // Created on September 29 2020.
 // 
 
+#include <stdlib.h>
+
 #include "environment.h"
 
-// push_llvm_scope(llvm_scope_t*) -> llvm_scope_t*
-// Pushes an LLVM scope onto the stack of scopes.
-llvm_scope_t* push_llvm_scope(llvm_scope_t* parent)
+// push_llvm_scope(llvm_codegen_env_t*) -> size_t
+// Enters a new LLVM scope, returning the number of local slots in the enclosing scopes.
+size_t push_llvm_scope(llvm_codegen_env_t* env)
 {
-	llvm_scope_t* scope = malloc(sizeof(llvm_scope_t));
-	scope->parent = parent;
-	scope->variables = init_hashmap();
-	scope->parameters = init_hashmap();
-	return scope;
+	return env->local_count;
 }
 
-// pop_llvm_scope(llvm_scope_t*) -> llvm_scope_t*
-// Pops an LLVM scope onto the stack of scopes.
-llvm_scope_t* pop_llvm_scope(llvm_scope_t* scope)
+// pop_llvm_scope(llvm_codegen_env_t*, size_t) -> void
+// Leaves an LLVM scope, restoring the number of local slots in the enclosing scopes.
+void pop_llvm_scope(llvm_codegen_env_t* env, size_t local_count)
 {
-	llvm_scope_t* parent = scope->parent;
-	del_hashmap(scope->variables);
-	del_hashmap(scope->parameters);
-	free(scope);
-	return parent;
+	env->local_count = local_count;
 }
 
 // create_llvm_codegen_environment(LLVMModuleRef) -> llvm_codegen_env_t*
@@ -35,115 +29,118 @@ llvm_scope_t* pop_llvm_scope(llvm_scope_t* scope)
 llvm_codegen_env_t* create_llvm_codegen_environment(LLVMModuleRef header_mod)
 {
 	llvm_codegen_env_t* env = malloc(sizeof(llvm_codegen_env_t));
-	env->local = NULL;
+	env->locals = NULL;
+	env->local_size = 0;
+	env->local_count = 0;
+	env->globals = NULL;
+	env->global_count = 0;
+	env->global_size = 0;
+	env->direct_funcs = NULL;
+	env->direct_func_count = 0;
+	env->direct_func_size = 0;
+	env->funcs = NULL;
+	env->layouts = init_llvm_layouts(NULL);
 	env->header_mod = header_mod;
 	env->body_mod = NULL;
 	env->main_func = NULL;
 	env->current_func = NULL;
 	env->current_block = NULL;
-
-	// Create necessary types
-	if (LLVMGetTypeByName(header_mod, "func.app.type") == NULL)
-	{
-		// Function application structure
-		// typedef struct s_func_app
-		// {
-		//	union
-		//	{
-		//		int32_t reference_count;
-		//		int64_t i64;
-		//		double f64;
-		//	};
-		//
-		// 	void* func;
-		// 	int8_t count;
-		// 	int64_t thunk_bitmap;
-		// 	struct s_func_app* args;
-		// } func_app_t;
-		LLVMContextRef context = LLVMGetModuleContext(header_mod);
-		LLVMTypeRef func_app = LLVMStructCreateNamed(context, "func.app.type");
-		LLVMTypeRef func_app_body[] = {LLVMInt32Type(), LLVMPointerType(LLVMInt64Type(), 0), LLVMInt8Type(), LLVMInt8Type(), LLVMInt64Type(), LLVMPointerType(func_app, 0)};
-		LLVMStructSetBody(func_app, func_app_body, 6, false);
-	}
+	env->current_self = NULL;
+	env->current_tail_calls = NULL;
 	return env;
 }
 
-// set_llvm_local(llvm_codegen_env_t*, char*, LLVMValueRef) -> void
-// Sets a local to the scope.
-void set_llvm_local(llvm_codegen_env_t* env, char* local, LLVMValueRef value)
+// grow_llvm_values(LLVMValueRef*, size_t*, size_t*, size_t) -> LLVMValueRef*
+// Grows an array of values to fit the given index, clearing the new values.
+LLVMValueRef* grow_llvm_values(LLVMValueRef* values, size_t* size, size_t* count, size_t index)
 {
-	if (env->local != NULL)
-		map_add(env->local->variables, local, value);
-}
+	if (index >= *size)
+	{
+		*size = *size != 0 ? *size : 8;
+		while (*size <= index)
+		{
+			*size <<= 1;
+		}
+		values = realloc(values, *size * sizeof(LLVMValueRef));
+	}
 
-// set_llvm_param(llvm_codegen_env_t*, char*, LLVMValueRef) -> void
-// Sets a parameter to the scope.
-void set_llvm_param(llvm_codegen_env_t* env, char* local, LLVMValueRef value, uint8_t param_index)
-{
-	if (env->local != NULL)
+	// Slots between the last value and the index are unset
+	for (size_t i = *count; i <= index; i++)
 	{
-		map_add(env->local->variables, local, value);
-		map_add(env->local->parameters, local, (void*) (uint64_t) param_index);
+		values[i] = NULL;
 	}
+	if (*count <= index)
+		*count = index + 1;
+	return values;
 }
 
-// lookup_llvm_local(llvm_codegen_env_t*, char*) -> LLVMValueRef
-// Looks up a local and returns its LLVMValueRef if available.
-LLVMValueRef lookup_llvm_local(llvm_codegen_env_t* env, char* local)
+// set_llvm_local(llvm_codegen_env_t*, size_t, LLVMValueRef) -> void
+// Sets the value of a local slot.
+void set_llvm_local(llvm_codegen_env_t* env, size_t slot, LLVMValueRef value)
 {
-	// Get most local scope
-	llvm_scope_t* scope = env->local;
-
-	// Iterate over all scopes in the linked list
-	while (scope != NULL)
-	{
-		// Get the value
-		LLVMValueRef value = map_get(scope->variables, local);
-		if (value != NULL)
-			return value;
+	env->locals = grow_llvm_values(env->locals, &env->local_size, &env->local_count, slot);
+	env->locals[slot] = value;
+}
 
-		// Parent scope
-		scope = scope->parent;
-	}
+// lookup_llvm_local(llvm_codegen_env_t*, size_t) -> LLVMValueRef
+// Looks up a local slot and returns its LLVMValueRef if available.
+LLVMValueRef lookup_llvm_local(llvm_codegen_env_t* env, size_t slot)
+{
+	return slot < env->local_count ? env->locals[slot] : NULL;
+}
 
-	// Local not found
-	return NULL;
+// set_llvm_global(llvm_codegen_env_t*, size_t, LLVMValueRef) -> void
+// Sets the LLVM global variable of a global.
+void set_llvm_global(llvm_codegen_env_t* env, size_t index, LLVMValueRef global)
+{
+	env->globals = grow_llvm_values(env->globals, &env->global_size, &env->global_count, index);
+	env->globals[index] = global;
 }
 
-// lookup_llvm_param(llvm_codegen_env_t*, char*) -> uint64_t
-// Looks up a parameter and returns its parameter index if available.
-uint64_t lookup_llvm_param(llvm_codegen_env_t* env, char* local)
+// lookup_llvm_global(llvm_codegen_env_t*, size_t) -> LLVMValueRef
+// Looks up the LLVM global variable of a global and returns it if it's been created.
+LLVMValueRef lookup_llvm_global(llvm_codegen_env_t* env, size_t index)
 {
-	// Get most local scope
-	llvm_scope_t* scope = env->local;
+	return index < env->global_count ? env->globals[index] : NULL;
+}
 
-	// Iterate over all scopes in the linked list
-	while (scope != NULL)
-	{
-		// Get the parameter index
-		if (map_contains(scope->parameters, local))
-			return (uint64_t) map_get(scope->parameters, local);
+// set_llvm_direct_function(llvm_codegen_env_t*, size_t, LLVMValueRef) -> void
+// Sets the direct function of a global bound to a function.
+void set_llvm_direct_function(llvm_codegen_env_t* env, size_t index, LLVMValueRef func)
+{
+	env->direct_funcs = grow_llvm_values(env->direct_funcs, &env->direct_func_size, &env->direct_func_count, index);
+	env->direct_funcs[index] = func;
+}
 
-		// Parent scope
-		scope = scope->parent;
-	}
+// lookup_llvm_direct_function(llvm_codegen_env_t*, size_t) -> LLVMValueRef
+// Looks up the direct function of a global and returns it if the global is bound to a function built in the current module.
+LLVMValueRef lookup_llvm_direct_function(llvm_codegen_env_t* env, size_t index)
+{
+	return index < env->direct_func_count ? env->direct_funcs[index] : NULL;
+}
 
-	// Parameter not found
-	return (uint64_t) -1;
+// forget_llvm_globals(llvm_codegen_env_t*, size_t) -> void
+// Forgets the LLVM global variables of every global after the first global_count, so that their indices can be reused.
+void forget_llvm_globals(llvm_codegen_env_t* env, size_t global_count)
+{
+	if (env->global_count > global_count)
+		env->global_count = global_count;
 }
 
 // empty_llvm_codegen_environment(llvm_codegen_env_t*) -> void
 // Emptys an LLVM codegen environment for reuse.
 void empty_llvm_codegen_environment(llvm_codegen_env_t* env)
 {
-	while (env->local != NULL)
-	{
-		env->local = pop_llvm_scope(env->local);
-	}
+	env->local_count = 0;
+	env->direct_func_count = 0;
+	env->funcs = NULL;
+	empty_llvm_layouts(env->layouts);
 	env->body_mod = NULL;
 	env->main_func = NULL;
 	env->current_func = NULL;
 	env->current_block = NULL;
+	env->current_self = NULL;
+	env->current_tail_calls = NULL;
 }
 
 // clean_llvm_codegen_environment(llvm_codegen_env_t)
@@ -152,9 +149,9 @@ void clean_llvm_codegen_environment(llvm_codegen_env_t* env)
 {
 	if (env->header_mod != NULL && env->header_mod != env->body_mod)
 		LLVMDisposeModule(env->header_mod);
-	while (env->local != NULL)
-	{
-		env->local = pop_llvm_scope(env->local);
-	}
+	free(env->locals);
+	free(env->globals);
+	free(env->direct_funcs);
+	del_llvm_layouts(env->layouts);
 	free(env);
 }
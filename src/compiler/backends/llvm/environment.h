@@ -9,23 +9,55 @@
 #ifndef LLVM_ENVIRONMENT_H
 #define LLVM_ENVIRONMENT_H
 
+#include <stdbool.h>
+#include <stdlib.h>
+
 #include "llvm-c/Core.h"
 
-#include "../../../utils/hashmap.h"
+#include "../../frontend/ir/generate_ir.h"
+#include "layouts.h"
 
-// Represents a scope
-typedef struct s_llvm_scope
+typedef struct
 {
-	hashmap_t* variables;
+	// The applications in tail position of the function being built.
+	ir_sexpr_t** applies;
+	size_t apply_count;
+	size_t apply_size;
 
-	hashmap_t* parameters;
+	// The calls built for the applications in tail position, which are marked as tail calls once the function is built.
+	LLVMValueRef* calls;
+	size_t call_count;
+	size_t call_size;
 
-	struct s_llvm_scope* parent;
-} llvm_scope_t;
+	// The block self tail calls branch back to and the phis of the arguments, or NULL if there are no self tail calls.
+	LLVMBasicBlockRef loop;
+	LLVMValueRef* args;
+} llvm_tail_calls_t;
 
 typedef struct
 {
-	llvm_scope_t* local;
+	// The values of the locals of the full expression being built, indexed by slot.
+	LLVMValueRef* locals;
+	size_t local_size;
+
+	// The number of local slots in the enclosing scopes.
+	size_t local_count;
+
+	// The globals, indexed by global index.
+	LLVMValueRef* globals;
+	size_t global_count;
+	size_t global_size;
+
+	// The direct functions of globals bound to functions built in the current module, indexed by global index.
+	LLVMValueRef* direct_funcs;
+	size_t direct_func_count;
+	size_t direct_func_size;
+
+	// The functions in the IR being built.
+	ir_sexpr_func_t** funcs;
+
+	// The layouts of the product, union, and enumeration types used.
+	llvm_layouts_t* layouts;
 
 	LLVMModuleRef header_mod;
 
@@ -36,35 +68,53 @@ typedef struct
 	LLVMValueRef current_func;
 
 	LLVMBasicBlockRef current_block;
+
+	// The value of the function being built if it is bound to a local, which calls of the local skip the stubs of.
+	LLVMValueRef current_self;
+
+	// The tail calls of the function being built, or NULL outside of functions.
+	llvm_tail_calls_t* current_tail_calls;
 } llvm_codegen_env_t;
 
-// push_llvm_scope(llvm_scope_t*) -> llvm_scope_t*
-// Pushes an LLVM scope onto the stack of scopes.
-llvm_scope_t* push_llvm_scope(llvm_scope_t* parent);
+// push_llvm_scope(llvm_codegen_env_t*) -> size_t
+// Enters a new LLVM scope, returning the number of local slots in the enclosing scopes.
+size_t push_llvm_scope(llvm_codegen_env_t* env);
 
-// pop_llvm_scope(llvm_scope_t*) -> llvm_scope_t*
-// Pops an LLVM scope onto the stack of scopes.
-llvm_scope_t* pop_llvm_scope(llvm_scope_t* scope);
+// pop_llvm_scope(llvm_codegen_env_t*, size_t) -> void
+// Leaves an LLVM scope, restoring the number of local slots in the enclosing scopes.
+void pop_llvm_scope(llvm_codegen_env_t* env, size_t local_count);
 
 // create_llvm_codegen_environment(LLVMModuleRef) -> llvm_codegen_env_t*
 // Creates an LLVM codegen environment.
 llvm_codegen_env_t* create_llvm_codegen_environment(LLVMModuleRef header_mod);
 
-// set_llvm_local(llvm_codegen_env_t*, char*, LLVMValueRef) -> void
-// Sets a local to the scope.
-void set_llvm_local(llvm_codegen_env_t* env, char* local, LLVMValueRef value);
+// set_llvm_local(llvm_codegen_env_t*, size_t, LLVMValueRef) -> void
+// Sets the value of a local slot.
+void set_llvm_local(llvm_codegen_env_t* env, size_t slot, LLVMValueRef value);
+
+// lookup_llvm_local(llvm_codegen_env_t*, size_t) -> LLVMValueRef
+// Looks up a local slot and returns its LLVMValueRef if available.
+LLVMValueRef lookup_llvm_local(llvm_codegen_env_t* env, size_t slot);
+
+// set_llvm_global(llvm_codegen_env_t*, size_t, LLVMValueRef) -> void
+// Sets the LLVM global variable of a global.
+void set_llvm_global(llvm_codegen_env_t* env, size_t index, LLVMValueRef global);
+
+// lookup_llvm_global(llvm_codegen_env_t*, size_t) -> LLVMValueRef
+// Looks up the LLVM global variable of a global and returns it if it's been created.
+LLVMValueRef lookup_llvm_global(llvm_codegen_env_t* env, size_t index);
 
-// set_llvm_param(llvm_codegen_env_t*, char*, LLVMValueRef) -> void
-// Sets a parameter to the scope.
-void set_llvm_param(llvm_codegen_env_t* env, char* local, LLVMValueRef value, uint8_t param_index);
+// set_llvm_direct_function(llvm_codegen_env_t*, size_t, LLVMValueRef) -> void
+// Sets the direct function of a global bound to a function.
+void set_llvm_direct_function(llvm_codegen_env_t* env, size_t index, LLVMValueRef func);
 
-// lookup_llvm_local(llvm_codegen_env_t*, char*) -> LLVMValueRef
-// Looks up a local and returns its LLVMValueRef if available.
-LLVMValueRef lookup_llvm_local(llvm_codegen_env_t* env, char* local);
+// lookup_llvm_direct_function(llvm_codegen_env_t*, size_t) -> LLVMValueRef
+// Looks up the direct function of a global and returns it if the global is bound to a function built in the current module.
+LLVMValueRef lookup_llvm_direct_function(llvm_codegen_env_t* env, size_t index);
 
-// lookup_llvm_param(llvm_codegen_env_t*, char*) -> uint64_t
-// Looks up a parameter and returns its parameter index if available.
-uint64_t lookup_llvm_param(llvm_codegen_env_t* env, char* local);
+// forget_llvm_globals(llvm_codegen_env_t*, size_t) -> void
+// Forgets the LLVM global variables of every global after the first global_count, so that their indices can be reused.
+void forget_llvm_globals(llvm_codegen_env_t* env, size_t global_count);
 
 // empty_llvm_codegen_environment(llvm_codegen_env_t*) -> void
 // Emptys an LLVM codegen environment for reuse.
@@ -6,68 +6,294 @@
 // Created on October 2 2020.
 // 
 
+#include <stdio.h>
 #include <string.h>
 
+#include "../../../utils/list.h"
 #include "functions.h"
+#include "lists.h"
+#include "memory.h"
+#include "reference_counting.h"
 
-// find_llvm_closure_locals(llvm_codegen_env_t*, ast_t*, hashmap_t*) -> void
-// Finds all locals the function closes over and adds them to the hash of closed locals.
-void find_llvm_closure_locals(llvm_codegen_env_t* env, ast_t* body, hashmap_t* closed_locals)
+// Functions are built as direct functions taking their environment and every argument at once. Function values hold
+// a stub taking the environment and the first argument, which for functions of more than one argument returns a new
+// function value holding a stub for the next argument and a partial environment with the arguments so far. The last
+// stub calls the direct function. Calls of global functions with enough arguments skip the stubs entirely, as do
+// recursive calls of functions bound to locals. Recursive calls in tail position with every argument branch back to the
+// start of the direct function instead, so that tail recursion runs as a loop.
+
+// function_value_type(void) -> LLVMTypeRef
+// Returns the type of a function value: {i8* code, i8* env}, where the code takes the environment and the first argument.
+LLVMTypeRef function_value_type()
+{
+	LLVMTypeRef i8_ptr = LLVMPointerType(LLVMInt8Type(), 0);
+	return LLVMStructType((LLVMTypeRef[]) {i8_ptr, i8_ptr}, 2, false);
+}
+
+// build_function_value(LLVMBuilderRef, LLVMValueRef, LLVMValueRef) -> LLVMValueRef
+// Builds a function value from the code for its first argument and its environment.
+LLVMValueRef build_function_value(LLVMBuilderRef builder, LLVMValueRef code, LLVMValueRef env_ptr)
+{
+	LLVMTypeRef i8_ptr = LLVMPointerType(LLVMInt8Type(), 0);
+	LLVMValueRef value = LLVMGetUndef(function_value_type());
+	value = LLVMBuildInsertValue(builder, value, LLVMBuildBitCast(builder, code, i8_ptr, ""), 0, "");
+	return LLVMBuildInsertValue(builder, value, LLVMBuildBitCast(builder, env_ptr, i8_ptr, ""), 1, "func");
+}
+
+// build_coerce_value(LLVMBuilderRef, LLVMValueRef, LLVMTypeRef) -> LLVMValueRef
+// Casts an empty list to a list with the element type of the given type. Other values are returned as they are.
+LLVMValueRef build_coerce_value(LLVMBuilderRef builder, LLVMValueRef value, LLVMTypeRef type)
 {
-	if (body->value.tag == LEX_TAG_OPERAND)
+	if (LLVMTypeOf(value) == type || !is_list_type(type) || !is_list_type(LLVMTypeOf(value)))
+		return value;
+
+	// Lists only differ in the type of their data pointer
+	LLVMValueRef list = LLVMGetUndef(type);
+	list = LLVMBuildInsertValue(builder, list, LLVMBuildExtractValue(builder, value, 0, ""), 0, "");
+	list = LLVMBuildInsertValue(builder, list, LLVMBuildExtractValue(builder, value, 1, ""), 1, "");
+	LLVMValueRef data = LLVMBuildBitCast(builder, LLVMBuildExtractValue(builder, value, 2, ""), LLVMStructGetTypeAtIndex(type, 2), "");
+	return LLVMBuildInsertValue(builder, list, data, 2, "");
+}
+
+// build_partial_env_type(LLVMValueRef, size_t) -> LLVMTypeRef
+// Returns the type of the partial environment holding a function value and its first count arguments.
+LLVMTypeRef build_partial_env_type(LLVMValueRef direct, size_t count)
+{
+	LLVMTypeRef* field_types = calloc(count + 1, sizeof(LLVMTypeRef));
+	field_types[0] = function_value_type();
+	for (size_t i = 0; i < count; i++)
 	{
-		// Local is closed from above scope
-		LLVMValueRef value = lookup_llvm_local(env, body->value.value);
-		if (body->value.type == LEX_TYPE_SYMBOL && value != NULL)
-			map_add(closed_locals, body->value.value, value);
-	} else if (!strcmp(body->value.value, "with"))
+		field_types[i + 1] = LLVMTypeOf(LLVMGetParam(direct, i + 1));
+	}
+	LLVMTypeRef type = LLVMStructType(field_types, count + 1, false);
+	free(field_types);
+	return type;
+}
+
+// build_function_stubs(llvm_codegen_env_t*, LLVMValueRef, char*) -> LLVMValueRef
+// Builds the functions that take each argument of a direct function in turn, returning the one that takes the first.
+LLVMValueRef build_function_stubs(llvm_codegen_env_t* env, LLVMValueRef direct, char* name)
+{
+	// Functions of one argument are their own stub
+	size_t arity = LLVMCountParams(direct) - 1;
+	if (arity == 1)
+		return direct;
+
+	// Save state
+	LLVMValueRef last_func = env->current_func;
+	LLVMBasicBlockRef last_block = env->current_block;
+	LLVMBuilderRef builder = LLVMCreateBuilder();
+	LLVMTypeRef i8_ptr = LLVMPointerType(LLVMInt8Type(), 0);
+	LLVMTypeRef ret_type = LLVMGetReturnType(LLVMGetElementType(LLVMTypeOf(direct)));
+	char* stub_name = malloc(strlen(name) + 6);
+	sprintf(stub_name, "%s.stub", name);
+
+	// Build the stubs from the last argument to the first, since each stub returns the next one
+	LLVMValueRef next = NULL;
+	for (size_t k = arity; k > 0; k--)
 	{
-		// Create a new scope
-		env->local = push_llvm_scope(env->local);
+		LLVMTypeRef arg_type = LLVMTypeOf(LLVMGetParam(direct, k));
+		LLVMTypeRef stub_type = LLVMFunctionType(k == arity ? ret_type : function_value_type(), (LLVMTypeRef[]) {i8_ptr, arg_type}, 2, false);
+		LLVMValueRef stub = LLVMAddFunction(LLVMGetGlobalParent(direct), stub_name, stub_type);
+		LLVMSetLinkage(stub, LLVMInternalLinkage);
+		env->current_func = stub;
+		env->current_block = LLVMAppendBasicBlock(stub, "entry");
+		LLVMPositionBuilderAtEnd(builder, env->current_block);
 
-		// Push variables
-		for (size_t i = 0; i < body->children_count - 1; i++)
+		// Load the function value and the arguments so far from the partial environment
+		LLVMValueRef* values = calloc(k + 1, sizeof(LLVMValueRef));
+		if (k == 1)
+			values[0] = build_function_value(builder, stub, LLVMGetParam(stub, 0));
+		else
 		{
-			// Get name
-			char* name = NULL;
-			ast_t* ast = body->children[i];
-			if (ast->children[0]->value.type == LEX_TYPE_SYMBOL)
-				name = ast->children[0]->value.value;
-			else if (ast->children[0]->value.type == LEX_TYPE_COLON)
-				name = ast->children[0]->children[0]->value.value;
-
-			// Set local
-			set_llvm_local(env, name, NULL);
-
-			// Set arguments if applicable
-			if (ast->children[0]->value.type == LEX_TYPE_SYMBOL && ast->children[0]->children_count != 0)
+			LLVMTypeRef partial_type = build_partial_env_type(direct, k - 1);
+			LLVMValueRef partial = LLVMBuildBitCast(builder, LLVMGetParam(stub, 0), LLVMPointerType(partial_type, 0), "");
+			for (size_t i = 0; i < k; i++)
 			{
-				for (size_t i = 0; i < ast->children[0]->children_count; i++)
-				{
-					ast_t* arg = ast->children[0]->children[i];
-					if (arg->value.type == LEX_TYPE_COLON)
-					{
-						set_llvm_local(env, arg->children[0]->value.value, NULL);
-					}
-				}
+				LLVMValueRef ptr = LLVMBuildStructGEP2(builder, partial_type, partial, i, "");
+				values[i] = LLVMBuildLoad2(builder, LLVMStructGetTypeAtIndex(partial_type, i), ptr, "");
 			}
+		}
+		values[k] = LLVMGetParam(stub, 1);
 
-			// Check value of the assignment
-			if (ast->value.type == LEX_TYPE_ASSIGN)
-				find_llvm_closure_locals(env, ast->children[1], closed_locals);
+		// The last stub calls the direct function
+		if (k == arity)
+		{
+			values[0] = LLVMBuildExtractValue(builder, values[0], 1, "");
+			LLVMValueRef result = LLVMBuildCall2(builder, LLVMGetElementType(LLVMTypeOf(direct)), direct, values, arity + 1, "");
+			LLVMSetTailCall(result, true);
+			LLVMBuildRet(builder, result);
+
+		// Other stubs hold new references to the arguments so far in a new partial environment
+		} else
+		{
+			LLVMTypeRef partial_type = build_partial_env_type(direct, k);
+			LLVMValueRef drop_func = build_drop_fields_function(env, partial_type, "func.partial.drop");
+			LLVMValueRef partial = build_rc_alloc(env, builder, LLVMSizeOf(partial_type), drop_func);
+			LLVMValueRef partial_ptr = LLVMBuildBitCast(builder, partial, LLVMPointerType(partial_type, 0), "func.partial");
+			for (size_t i = 0; i <= k; i++)
+			{
+				if (llvm_rc_type(LLVMTypeOf(values[i])))
+					build_dup(env, builder, values[i]);
+				LLVMBuildStore(builder, values[i], LLVMBuildStructGEP2(builder, partial_type, partial_ptr, i, ""));
+			}
+			LLVMBuildRet(builder, build_function_value(builder, next, partial));
 		}
+		free(values);
+		next = stub;
+	}
 
-		// Check value of scope
-		find_llvm_closure_locals(env, body->children[body->children_count - 1], closed_locals);
+	// Restore state
+	free(stub_name);
+	LLVMDisposeBuilder(builder);
+	env->current_func = last_func;
+	env->current_block = last_block;
+	return next;
+}
+
+// build_function_call(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef, LLVMValueRef, LLVMTypeRef, LLVMTypeRef) -> LLVMValueRef
+// Builds a call of a function value with one argument, returning a new reference to the result.
+LLVMValueRef build_function_call(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef func, LLVMValueRef arg, LLVMTypeRef arg_type, LLVMTypeRef ret_type)
+{
+	LLVMTypeRef i8_ptr = LLVMPointerType(LLVMInt8Type(), 0);
+	LLVMTypeRef code_type = LLVMFunctionType(ret_type, (LLVMTypeRef[]) {i8_ptr, arg_type}, 2, false);
+	LLVMValueRef code = LLVMBuildBitCast(builder, LLVMBuildExtractValue(builder, func, 0, ""), LLVMPointerType(code_type, 0), "");
+	LLVMValueRef func_env = LLVMBuildExtractValue(builder, func, 1, "");
+	return LLVMBuildCall2(builder, code_type, code, (LLVMValueRef[]) {func_env, build_coerce_value(builder, arg, arg_type)}, 2, "");
+}
 
-		// Pop scope
-		env->local = pop_llvm_scope(env->local);
-	} else
+// find_llvm_tail_calls(ir_sexpr_t*, llvm_tail_calls_t*, ir_binding_id_t*, size_t) -> bool
+// Finds the applications in tail position of a function body, returning whether any of them applies the variable the
+// function is bound to (if any) to every argument.
+bool find_llvm_tail_calls(ir_sexpr_t* body, llvm_tail_calls_t* tail_calls, ir_binding_id_t* binding, size_t arity)
+{
+	switch (body->tag)
 	{
-		// Find locals closed over in child nodes
-		for (size_t i = 0; i < body->children_count; i++)
+		case CURLY_IR_TAGS_LOCAL_SCOPE:
+			return find_llvm_tail_calls(body->local_scope.value, tail_calls, binding, arity);
+		case CURLY_IR_TAGS_IF:
 		{
-			find_llvm_closure_locals(env, body->children[i], closed_locals);
+			bool then = find_llvm_tail_calls(body->if_expr.then, tail_calls, binding, arity);
+			bool elsy = find_llvm_tail_calls(body->if_expr.elsy, tail_calls, binding, arity);
+			return then || elsy;
 		}
+		case CURLY_IR_TAGS_APPLY:
+		{
+			list_append_element(tail_calls->applies, tail_calls->apply_size, tail_calls->apply_count, ir_sexpr_t*, body);
+			size_t count = 0;
+			ir_sexpr_t* head = body;
+			for (; head->tag == CURLY_IR_TAGS_APPLY; head = head->apply.func)
+			{
+				count++;
+			}
+			return binding != NULL && count == arity && head->tag == CURLY_IR_TAGS_SYMBOL &&
+				head->binding.global == binding->global && head->binding.index == binding->index;
+		}
+
+		// Anything else (including reference counting operations) still has work to do after its value is built
+		default:
+			return false;
+	}
+}
+
+// is_llvm_tail_call(llvm_codegen_env_t*, ir_sexpr_t*) -> bool
+// Returns whether an application is in tail position of the function being built.
+bool is_llvm_tail_call(llvm_codegen_env_t* env, ir_sexpr_t* apply)
+{
+	if (env->current_tail_calls == NULL)
+		return false;
+	for (size_t i = 0; i < env->current_tail_calls->apply_count; i++)
+	{
+		if (env->current_tail_calls->applies[i] == apply)
+			return true;
+	}
+	return false;
+}
+
+// mark_llvm_tail_calls(llvm_codegen_env_t*, llvm_tail_calls_t*) -> void
+// Marks the calls built in tail position of the function being built as tail calls, unless the function has allocas
+// that the callees may refer to.
+void mark_llvm_tail_calls(llvm_codegen_env_t* env, llvm_tail_calls_t* tail_calls)
+{
+	LLVMBasicBlockRef entry = LLVMGetEntryBasicBlock(env->current_func);
+	for (LLVMValueRef inst = LLVMGetFirstInstruction(entry); inst != NULL; inst = LLVMGetNextInstruction(inst))
+	{
+		if (LLVMIsAAllocaInst(inst))
+			return;
+	}
+	for (size_t i = 0; i < tail_calls->call_count; i++)
+	{
+		LLVMSetTailCall(tail_calls->calls[i], true);
+	}
+}
+
+// find_llvm_closure_locals(llvm_codegen_env_t*, ir_sexpr_t*, char**) -> void
+// Finds all locals the function closes over and puts their names in their slots in the array of closed locals.
+void find_llvm_closure_locals(llvm_codegen_env_t* env, ir_sexpr_t* body, char** closed_locals)
+{
+	switch (body->tag)
+	{
+		case CURLY_IR_TAGS_SYMBOL:
+			// Locals from enclosing scopes have slots below the function's own locals
+			if (!body->binding.global && lookup_llvm_local(env, body->binding.index) != NULL)
+				closed_locals[body->binding.index] = body->symbol;
+			break;
+		case CURLY_IR_TAGS_INFIX:
+			find_llvm_closure_locals(env, body->infix.left, closed_locals);
+			find_llvm_closure_locals(env, body->infix.right, closed_locals);
+			break;
+		case CURLY_IR_TAGS_PREFIX:
+			find_llvm_closure_locals(env, body->prefix.operand, closed_locals);
+			break;
+		case CURLY_IR_TAGS_APPLY:
+			find_llvm_closure_locals(env, body->apply.func, closed_locals);
+			find_llvm_closure_locals(env, body->apply.arg, closed_locals);
+			break;
+		case CURLY_IR_TAGS_FUNC:
+			// Functions close over the locals their inner functions close over
+			find_llvm_closure_locals(env, env->funcs[body->func_id]->body, closed_locals);
+			break;
+		case CURLY_IR_TAGS_ASSIGN:
+			find_llvm_closure_locals(env, body->assign.value, closed_locals);
+			break;
+		case CURLY_IR_TAGS_LOCAL_SCOPE:
+			for (size_t i = 0; i < body->local_scope.assign_count; i++)
+			{
+				find_llvm_closure_locals(env, body->local_scope.assigns[i], closed_locals);
+			}
+			find_llvm_closure_locals(env, body->local_scope.value, closed_locals);
+			break;
+		case CURLY_IR_TAGS_IF:
+			find_llvm_closure_locals(env, body->if_expr.cond, closed_locals);
+			find_llvm_closure_locals(env, body->if_expr.then, closed_locals);
+			find_llvm_closure_locals(env, body->if_expr.elsy, closed_locals);
+			break;
+		case CURLY_IR_TAGS_LIST:
+			for (size_t i = 0; i < body->list.element_count; i++)
+			{
+				find_llvm_closure_locals(env, body->list.elements[i], closed_locals);
+			}
+			break;
+		case CURLY_IR_TAGS_SLICE:
+			find_llvm_closure_locals(env, body->slice.list, closed_locals);
+			find_llvm_closure_locals(env, body->slice.start, closed_locals);
+			find_llvm_closure_locals(env, body->slice.end, closed_locals);
+			break;
+		case CURLY_IR_TAGS_FOR:
+			find_llvm_closure_locals(env, body->for_loop.iter, closed_locals);
+			find_llvm_closure_locals(env, body->for_loop.body, closed_locals);
+			break;
+		case CURLY_IR_TAGS_RANGE:
+			find_llvm_closure_locals(env, body->range.start, closed_locals);
+			if (body->range.end != NULL)
+				find_llvm_closure_locals(env, body->range.end, closed_locals);
+			break;
+		case CURLY_IR_TAGS_DUP:
+		case CURLY_IR_TAGS_DROP:
+			// Dropped locals are always defined in the same scope
+			find_llvm_closure_locals(env, body->rc.value, closed_locals);
+			break;
+		default:
+			break;
 	}
 }
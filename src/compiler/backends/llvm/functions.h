@@ -11,12 +11,45 @@
 
 #include <llvm-c/Core.h>
 
-#include "../../frontend/parse/ast.h"
-#include "../../../utils/hashmap.h"
+#include "../../frontend/ir/generate_ir.h"
 #include "environment.h"
 
-// find_llvm_closure_locals(llvm_codegen_env_t*, ast_t*, hashmap_t*) -> void
-// Finds all locals the function closes over and adds them to the hash of closed locals.
-void find_llvm_closure_locals(llvm_codegen_env_t* env, ast_t* body, hashmap_t* closed_locals);
+// function_value_type(void) -> LLVMTypeRef
+// Returns the type of a function value: {i8* code, i8* env}, where the code takes the environment and the first argument.
+LLVMTypeRef function_value_type();
+
+// build_function_value(LLVMBuilderRef, LLVMValueRef, LLVMValueRef) -> LLVMValueRef
+// Builds a function value from the code for its first argument and its environment.
+LLVMValueRef build_function_value(LLVMBuilderRef builder, LLVMValueRef code, LLVMValueRef env_ptr);
+
+// build_coerce_value(LLVMBuilderRef, LLVMValueRef, LLVMTypeRef) -> LLVMValueRef
+// Casts an empty list to a list with the element type of the given type. Other values are returned as they are.
+LLVMValueRef build_coerce_value(LLVMBuilderRef builder, LLVMValueRef value, LLVMTypeRef type);
+
+// build_function_stubs(llvm_codegen_env_t*, LLVMValueRef, char*) -> LLVMValueRef
+// Builds the functions that take each argument of a direct function in turn, returning the one that takes the first.
+LLVMValueRef build_function_stubs(llvm_codegen_env_t* env, LLVMValueRef direct, char* name);
+
+// build_function_call(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef, LLVMValueRef, LLVMTypeRef, LLVMTypeRef) -> LLVMValueRef
+// Builds a call of a function value with one argument, returning a new reference to the result.
+LLVMValueRef build_function_call(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef func, LLVMValueRef arg, LLVMTypeRef arg_type, LLVMTypeRef ret_type);
+
+// find_llvm_tail_calls(ir_sexpr_t*, llvm_tail_calls_t*, ir_binding_id_t*, size_t) -> bool
+// Finds the applications in tail position of a function body, returning whether any of them applies the variable the
+// function is bound to (if any) to every argument.
+bool find_llvm_tail_calls(ir_sexpr_t* body, llvm_tail_calls_t* tail_calls, ir_binding_id_t* binding, size_t arity);
+
+// is_llvm_tail_call(llvm_codegen_env_t*, ir_sexpr_t*) -> bool
+// Returns whether an application is in tail position of the function being built.
+bool is_llvm_tail_call(llvm_codegen_env_t* env, ir_sexpr_t* apply);
+
+// mark_llvm_tail_calls(llvm_codegen_env_t*, llvm_tail_calls_t*) -> void
+// Marks the calls built in tail position of the function being built as tail calls, unless the function has allocas
+// that the callees may refer to.
+void mark_llvm_tail_calls(llvm_codegen_env_t* env, llvm_tail_calls_t* tail_calls);
+
+// find_llvm_closure_locals(llvm_codegen_env_t*, ir_sexpr_t*, char**) -> void
+// Finds all locals the function closes over and puts their names in their slots in the array of closed locals.
+void find_llvm_closure_locals(llvm_codegen_env_t* env, ir_sexpr_t* body, char** closed_locals);
 
 #endif /* LLVM_FUNCTIONS_H */
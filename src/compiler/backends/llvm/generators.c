@@ -0,0 +1,409 @@
+// 
+// llvm
+// generators.c: Implements generators as stackless coroutines using LLVM's coroutine intrinsics.
+// 
+// Created by jenra.
+// Created on October 18 2026.
+// 
+
+#include <string.h>
+
+#include "../../../runtime/memo.h"
+#include "generators.h"
+#include "memory.h"
+#include "reference_counting.h"
+
+// The alignment of a generator's promise.
+#define GENERATOR_PROMISE_ALIGN 8
+
+// build_coro_intrinsic(llvm_codegen_env_t*, LLVMBuilderRef, char*, LLVMTypeRef*, size_t, LLVMValueRef*, size_t) -> LLVMValueRef
+// Builds a call to a coroutine intrinsic.
+LLVMValueRef build_coro_intrinsic(llvm_codegen_env_t* env, LLVMBuilderRef builder, char* name, LLVMTypeRef* overloads, size_t overload_count, LLVMValueRef* args, size_t arg_count)
+{
+	LLVMModuleRef mod = LLVMGetGlobalParent(env->current_func);
+	unsigned id = LLVMLookupIntrinsicID(name, strlen(name));
+	LLVMValueRef func = LLVMGetIntrinsicDeclaration(mod, id, overloads, overload_count);
+	LLVMTypeRef type = LLVMIntrinsicGetType(LLVMGetModuleContext(mod), id, overloads, overload_count);
+	return LLVMBuildCall2(builder, type, func, args, arg_count, "");
+}
+
+// generator_ramp_type(void) -> LLVMTypeRef
+// Returns the type of the function that starts a generator: i8* (i8* env).
+LLVMTypeRef generator_ramp_type()
+{
+	LLVMTypeRef i8_ptr = LLVMPointerType(LLVMInt8Type(), 0);
+	return LLVMFunctionType(i8_ptr, (LLVMTypeRef[]) {i8_ptr}, 1, false);
+}
+
+// generator_value_type(void) -> LLVMTypeRef
+// Returns the type of a generator value: {ramp*, i8* env}.
+LLVMTypeRef generator_value_type()
+{
+	return LLVMStructType((LLVMTypeRef[]) {LLVMPointerType(generator_ramp_type(), 0), LLVMPointerType(LLVMInt8Type(), 0)}, 2, false);
+}
+
+// build_coro_begin(llvm_codegen_env_t*, LLVMBuilderRef, LLVMTypeRef) -> llvm_coro_t
+// Builds the start of a generator coroutine yielding the given type, leaving the builder after the initial suspension.
+llvm_coro_t build_coro_begin(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMTypeRef elem_type)
+{
+	llvm_coro_t coro;
+	LLVMTypeRef i8_ptr = LLVMPointerType(LLVMInt8Type(), 0);
+	LLVMValueRef null = LLVMConstNull(i8_ptr);
+
+	// Create the promise and coroutine id
+	coro.promise = build_entry_alloca(env, elem_type, "gen.promise");
+	LLVMSetAlignment(coro.promise, GENERATOR_PROMISE_ALIGN);
+	LLVMValueRef promise = LLVMBuildBitCast(builder, coro.promise, i8_ptr, "");
+	LLVMValueRef align = LLVMConstInt(LLVMInt32Type(), GENERATOR_PROMISE_ALIGN, false);
+	coro.id = build_coro_intrinsic(env, builder, "llvm.coro.id", NULL, 0, (LLVMValueRef[]) {align, promise, null, null}, 4);
+
+	// Create basic blocks to jump to
+	LLVMBasicBlockRef from = env->current_block;
+	LLVMBasicBlockRef alloc_block = LLVMAppendBasicBlock(env->current_func, "gen.alloc");
+	LLVMBasicBlockRef begin_block = LLVMAppendBasicBlock(env->current_func, "gen.begin");
+	LLVMBasicBlockRef start_block = LLVMAppendBasicBlock(env->current_func, "gen.start");
+	coro.cleanup_block = LLVMAppendBasicBlock(env->current_func, "gen.cleanup");
+	coro.suspend_block = LLVMAppendBasicBlock(env->current_func, "gen.suspend");
+
+	// Only allocate the frame on the heap if the allocation is not elided
+	LLVMValueRef need_alloc = build_coro_intrinsic(env, builder, "llvm.coro.alloc", NULL, 0, (LLVMValueRef[]) {coro.id}, 1);
+	LLVMBuildCondBr(builder, need_alloc, alloc_block, begin_block);
+	LLVMPositionBuilderAtEnd(builder, alloc_block);
+	env->current_block = alloc_block;
+	LLVMValueRef size = build_coro_intrinsic(env, builder, "llvm.coro.size", (LLVMTypeRef[]) {LLVMInt64Type()}, 1, NULL, 0);
+	LLVMValueRef mem = build_malloc(env, builder, size);
+	LLVMBuildBr(builder, begin_block);
+
+	// Begin the coroutine
+	LLVMPositionBuilderAtEnd(builder, begin_block);
+	env->current_block = begin_block;
+	LLVMValueRef phi = LLVMBuildPhi(builder, i8_ptr, "");
+	LLVMAddIncoming(phi, (LLVMValueRef[]) {null, mem}, (LLVMBasicBlockRef[]) {from, alloc_block}, 2);
+	coro.handle = build_coro_intrinsic(env, builder, "llvm.coro.begin", NULL, 0, (LLVMValueRef[]) {coro.id, phi}, 2);
+
+	// Free the frame on cleanup
+	LLVMPositionBuilderAtEnd(builder, coro.cleanup_block);
+	env->current_block = coro.cleanup_block;
+	LLVMValueRef frame = build_coro_intrinsic(env, builder, "llvm.coro.free", NULL, 0, (LLVMValueRef[]) {coro.id, coro.handle}, 2);
+	build_free(env, builder, frame);
+	LLVMBuildBr(builder, coro.suspend_block);
+
+	// Return the handle on suspension
+	LLVMPositionBuilderAtEnd(builder, coro.suspend_block);
+	env->current_block = coro.suspend_block;
+	build_coro_intrinsic(env, builder, "llvm.coro.end", NULL, 0, (LLVMValueRef[]) {coro.handle, LLVMConstInt(LLVMInt1Type(), 0, false)}, 2);
+	LLVMBuildRet(builder, coro.handle);
+
+	// Generators are lazy, so suspend before producing anything
+	LLVMPositionBuilderAtEnd(builder, begin_block);
+	env->current_block = begin_block;
+	LLVMValueRef none = LLVMConstNull(LLVMTokenTypeInContext(LLVMGetModuleContext(LLVMGetGlobalParent(env->current_func))));
+	LLVMValueRef state = build_coro_intrinsic(env, builder, "llvm.coro.suspend", NULL, 0, (LLVMValueRef[]) {none, LLVMConstInt(LLVMInt1Type(), 0, false)}, 2);
+	LLVMValueRef switchy = LLVMBuildSwitch(builder, state, coro.suspend_block, 2);
+	LLVMAddCase(switchy, LLVMConstInt(LLVMInt8Type(), 0, false), start_block);
+	LLVMAddCase(switchy, LLVMConstInt(LLVMInt8Type(), 1, false), coro.cleanup_block);
+
+	// Continue building from the start of the generator's body
+	LLVMMoveBasicBlockAfter(start_block, begin_block);
+	LLVMPositionBuilderAtEnd(builder, start_block);
+	env->current_block = start_block;
+	return coro;
+}
+
+// build_coro_yield(llvm_codegen_env_t*, LLVMBuilderRef, llvm_coro_t, LLVMValueRef) -> void
+// Yields a value from a generator coroutine, leaving the builder at the point of resumption.
+void build_coro_yield(llvm_codegen_env_t* env, LLVMBuilderRef builder, llvm_coro_t coro, LLVMValueRef value)
+{
+	build_coro_yield_cleanup(env, builder, coro, value, coro.cleanup_block);
+}
+
+// build_coro_yield_cleanup(llvm_codegen_env_t*, LLVMBuilderRef, llvm_coro_t, LLVMValueRef, LLVMBasicBlockRef) -> void
+// Yields a value from a generator coroutine, jumping to the given block if the coroutine is destroyed while suspended
+// there (which must end up at the coroutine's cleanup block). Leaves the builder at the point of resumption.
+void build_coro_yield_cleanup(llvm_codegen_env_t* env, LLVMBuilderRef builder, llvm_coro_t coro, LLVMValueRef value, LLVMBasicBlockRef cleanup_block)
+{
+	// Store the value and suspend
+	LLVMBuildStore(builder, value, coro.promise);
+	LLVMValueRef none = LLVMConstNull(LLVMTokenTypeInContext(LLVMGetModuleContext(LLVMGetGlobalParent(env->current_func))));
+	LLVMValueRef state = build_coro_intrinsic(env, builder, "llvm.coro.suspend", NULL, 0, (LLVMValueRef[]) {none, LLVMConstInt(LLVMInt1Type(), 0, false)}, 2);
+
+	// Resume or clean up
+	LLVMBasicBlockRef resume_block = LLVMAppendBasicBlock(env->current_func, "gen.resume");
+	LLVMMoveBasicBlockAfter(resume_block, env->current_block);
+	LLVMValueRef switchy = LLVMBuildSwitch(builder, state, coro.suspend_block, 2);
+	LLVMAddCase(switchy, LLVMConstInt(LLVMInt8Type(), 0, false), resume_block);
+	LLVMAddCase(switchy, LLVMConstInt(LLVMInt8Type(), 1, false), cleanup_block);
+	LLVMPositionBuilderAtEnd(builder, resume_block);
+	env->current_block = resume_block;
+}
+
+// build_coro_end(llvm_codegen_env_t*, LLVMBuilderRef, llvm_coro_t) -> void
+// Builds the final suspension of a generator coroutine.
+void build_coro_end(llvm_codegen_env_t* env, LLVMBuilderRef builder, llvm_coro_t coro)
+{
+	// Resuming a coroutine at its final suspension point is undefined, so only cleaning up is handled
+	LLVMValueRef none = LLVMConstNull(LLVMTokenTypeInContext(LLVMGetModuleContext(LLVMGetGlobalParent(env->current_func))));
+	LLVMValueRef state = build_coro_intrinsic(env, builder, "llvm.coro.suspend", NULL, 0, (LLVMValueRef[]) {none, LLVMConstInt(LLVMInt1Type(), 1, false)}, 2);
+	LLVMValueRef switchy = LLVMBuildSwitch(builder, state, coro.suspend_block, 1);
+	LLVMAddCase(switchy, LLVMConstInt(LLVMInt8Type(), 1, false), coro.cleanup_block);
+
+	// Move the cleanup and suspend blocks to the end
+	LLVMMoveBasicBlockAfter(coro.cleanup_block, LLVMGetLastBasicBlock(env->current_func));
+	LLVMMoveBasicBlockAfter(coro.suspend_block, coro.cleanup_block);
+}
+
+// build_generator_loop_start(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef, LLVMTypeRef) -> llvm_iter_loop_t
+// Starts a loop over the values of a generator coroutine, leaving the builder in the body of the loop.
+llvm_iter_loop_t build_generator_loop_start(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef handle, LLVMTypeRef elem_type)
+{
+	llvm_iter_loop_t loop;
+	loop.handle = handle;
+
+	// Create basic blocks to jump to
+	LLVMBasicBlockRef from = env->current_block;
+	loop.cond_block = LLVMAppendBasicBlock(env->current_func, "gen.cond");
+	LLVMMoveBasicBlockAfter(loop.cond_block, from);
+	LLVMBasicBlockRef body_block = LLVMAppendBasicBlock(env->current_func, "gen.body");
+	LLVMMoveBasicBlockAfter(body_block, loop.cond_block);
+	loop.post_block = LLVMAppendBasicBlock(env->current_func, "gen.post");
+	LLVMMoveBasicBlockAfter(loop.post_block, body_block);
+
+	// Resume the generator and exit if it's done
+	LLVMBuildBr(builder, loop.cond_block);
+	LLVMPositionBuilderAtEnd(builder, loop.cond_block);
+	loop.index = LLVMBuildPhi(builder, LLVMInt64Type(), "gen.i");
+	LLVMAddIncoming(loop.index, (LLVMValueRef[]) {LLVMConstInt(LLVMInt64Type(), 0, false)}, (LLVMBasicBlockRef[]) {from}, 1);
+	build_coro_intrinsic(env, builder, "llvm.coro.resume", NULL, 0, (LLVMValueRef[]) {handle}, 1);
+	LLVMValueRef done = build_coro_intrinsic(env, builder, "llvm.coro.done", NULL, 0, (LLVMValueRef[]) {handle}, 1);
+	LLVMBuildCondBr(builder, done, loop.post_block, body_block);
+
+	// Load the yielded value from the promise
+	LLVMPositionBuilderAtEnd(builder, body_block);
+	env->current_block = body_block;
+	LLVMValueRef align = LLVMConstInt(LLVMInt32Type(), GENERATOR_PROMISE_ALIGN, false);
+	LLVMValueRef promise = build_coro_intrinsic(env, builder, "llvm.coro.promise", NULL, 0, (LLVMValueRef[]) {handle, align, LLVMConstInt(LLVMInt1Type(), 0, false)}, 3);
+	promise = LLVMBuildBitCast(builder, promise, LLVMPointerType(elem_type, 0), "");
+	loop.element = LLVMBuildLoad2(builder, elem_type, promise, "gen.elem");
+	return loop;
+}
+
+// build_generator_destroy(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef) -> void
+// Destroys a generator coroutine.
+void build_generator_destroy(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef handle)
+{
+	build_coro_intrinsic(env, builder, "llvm.coro.destroy", NULL, 0, (LLVMValueRef[]) {handle}, 1);
+}
+
+// build_memo_drop_function(llvm_codegen_env_t*, LLVMTypeRef, LLVMValueRef) -> LLVMValueRef
+// Builds the function that drops the environment of a memoised generator, destroying the source if it was started.
+LLVMValueRef build_memo_drop_function(llvm_codegen_env_t* env, LLVMTypeRef memo_env_type)
+{
+	// Create the function
+	LLVMTypeRef i8_ptr = LLVMPointerType(LLVMInt8Type(), 0);
+	LLVMTypeRef func_type = LLVMFunctionType(LLVMVoidType(), (LLVMTypeRef[]) {i8_ptr}, 1, false);
+	LLVMValueRef func = LLVMAddFunction(env->body_mod, "gen.memo.drop", func_type);
+	LLVMSetLinkage(func, LLVMInternalLinkage);
+
+	// Save state and create a builder for the function
+	LLVMValueRef last_func = env->current_func;
+	LLVMBasicBlockRef last_block = env->current_block;
+	LLVMBuilderRef builder = LLVMCreateBuilder();
+	env->current_func = func;
+	env->current_block = LLVMAppendBasicBlock(func, "entry");
+	LLVMBasicBlockRef destroy_block = LLVMAppendBasicBlock(func, "memo.drop.destroy");
+	LLVMBasicBlockRef free_block = LLVMAppendBasicBlock(func, "memo.drop.free");
+	LLVMPositionBuilderAtEnd(builder, env->current_block);
+
+	// Destroy the source if a consumer started it
+	LLVMValueRef param = LLVMBuildBitCast(builder, LLVMGetParam(func, 0), LLVMPointerType(memo_env_type, 0), "");
+	LLVMValueRef memo = LLVMBuildLoad2(builder, i8_ptr, LLVMBuildStructGEP2(builder, memo_env_type, param, 0, ""), "memo");
+	LLVMValueRef source = build_runtime_call(env, builder, "curly_memo_source", i8_ptr, (LLVMTypeRef[]) {i8_ptr}, (LLVMValueRef[]) {memo}, 1);
+	LLVMBuildCondBr(builder, LLVMBuildIsNull(builder, source, ""), free_block, destroy_block);
+	LLVMPositionBuilderAtEnd(builder, destroy_block);
+	build_generator_destroy(env, builder, source);
+	LLVMBuildBr(builder, free_block);
+
+	// Drop the source generator and free the buffer
+	LLVMPositionBuilderAtEnd(builder, free_block);
+	env->current_block = free_block;
+	LLVMValueRef generator = LLVMGetUndef(generator_value_type());
+	generator = LLVMBuildInsertValue(builder, generator, LLVMBuildLoad2(builder, LLVMPointerType(generator_ramp_type(), 0), LLVMBuildStructGEP2(builder, memo_env_type, param, 1, ""), ""), 0, "");
+	generator = LLVMBuildInsertValue(builder, generator, LLVMBuildLoad2(builder, i8_ptr, LLVMBuildStructGEP2(builder, memo_env_type, param, 2, ""), ""), 1, "");
+	build_drop(env, builder, generator);
+	build_runtime_call(env, builder, "curly_memo_del", LLVMVoidType(), (LLVMTypeRef[]) {i8_ptr}, (LLVMValueRef[]) {memo}, 1);
+	LLVMBuildRetVoid(builder);
+
+	// Restore state
+	LLVMDisposeBuilder(builder);
+	env->current_func = last_func;
+	env->current_block = last_block;
+	return func;
+}
+
+// build_memo_generator(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef, LLVMTypeRef) -> LLVMValueRef
+// Wraps a generator in a generator that shares the values it produces with every consumer using a memo buffer.
+LLVMValueRef build_memo_generator(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef generator, LLVMTypeRef elem_type)
+{
+	LLVMTypeRef i8_ptr = LLVMPointerType(LLVMInt8Type(), 0);
+	LLVMTypeRef ramp_ptr = LLVMPointerType(generator_ramp_type(), 0);
+	LLVMTypeRef memo_env_type = LLVMStructType((LLVMTypeRef[]) {i8_ptr, ramp_ptr, i8_ptr}, 3, false);
+
+	// Store the memo buffer with the generator being memoised, which the memo's environment takes ownership of
+	LLVMValueRef elem_drop = build_drop_fields_function(env, LLVMStructType((LLVMTypeRef[]) {elem_type}, 1, false), "gen.memo.elem.drop");
+	elem_drop = elem_drop != NULL ? LLVMBuildBitCast(builder, elem_drop, i8_ptr, "") : LLVMConstNull(i8_ptr);
+	LLVMValueRef memo = build_runtime_call(env, builder, "curly_memo_new", i8_ptr, (LLVMTypeRef[]) {LLVMInt64Type(), i8_ptr}, (LLVMValueRef[]) {LLVMSizeOf(elem_type), elem_drop}, 2);
+	LLVMValueRef drop_func = build_memo_drop_function(env, memo_env_type);
+	LLVMValueRef env_ptr = LLVMBuildBitCast(builder, build_rc_alloc(env, builder, LLVMSizeOf(memo_env_type), drop_func), LLVMPointerType(memo_env_type, 0), "memo.env");
+	LLVMBuildStore(builder, memo, LLVMBuildStructGEP2(builder, memo_env_type, env_ptr, 0, ""));
+	LLVMBuildStore(builder, LLVMBuildExtractValue(builder, generator, 0, ""), LLVMBuildStructGEP2(builder, memo_env_type, env_ptr, 1, ""));
+	LLVMBuildStore(builder, LLVMBuildExtractValue(builder, generator, 1, ""), LLVMBuildStructGEP2(builder, memo_env_type, env_ptr, 2, ""));
+
+	// Create the ramp function
+	LLVMValueRef func = LLVMAddFunction(env->body_mod, "gen.memo", generator_ramp_type());
+	LLVMSetLinkage(func, LLVMInternalLinkage);
+	LLVMContextRef context = LLVMGetModuleContext(env->body_mod);
+	LLVMAddAttributeAtIndex(func, LLVMAttributeFunctionIndex, LLVMCreateStringAttribute(context, "coroutine.presplit", 18, "0", 1));
+
+	// Save state and move builder to the start of the function
+	LLVMValueRef last_func = env->current_func;
+	LLVMBasicBlockRef last_block = env->current_block;
+	env->current_func = func;
+	env->current_block = LLVMAppendBasicBlock(func, "entry");
+	LLVMPositionBuilderAtEnd(builder, env->current_block);
+
+	// Load the environment
+	LLVMValueRef param = LLVMBuildBitCast(builder, LLVMGetParam(func, 0), LLVMPointerType(memo_env_type, 0), "");
+	memo = LLVMBuildLoad2(builder, i8_ptr, LLVMBuildStructGEP2(builder, memo_env_type, param, 0, ""), "memo");
+	LLVMValueRef ramp = LLVMBuildLoad2(builder, ramp_ptr, LLVMBuildStructGEP2(builder, memo_env_type, param, 1, ""), "memo.ramp");
+	LLVMValueRef source_env = LLVMBuildLoad2(builder, i8_ptr, LLVMBuildStructGEP2(builder, memo_env_type, param, 2, ""), "memo.source.env");
+	llvm_coro_t coro = build_coro_begin(env, builder, elem_type);
+	LLVMValueRef out = build_entry_alloca(env, elem_type, "memo.elem");
+
+	// Create basic blocks to jump to
+	LLVMBasicBlockRef from = env->current_block;
+	LLVMBasicBlockRef get_block = LLVMAppendBasicBlock(func, "memo.get");
+	LLVMBasicBlockRef hit_block = LLVMAppendBasicBlock(func, "memo.hit");
+	LLVMBasicBlockRef miss_block = LLVMAppendBasicBlock(func, "memo.miss");
+	LLVMBasicBlockRef start_block = LLVMAppendBasicBlock(func, "memo.start");
+	LLVMBasicBlockRef advance_block = LLVMAppendBasicBlock(func, "memo.advance");
+	LLVMBasicBlockRef push_block = LLVMAppendBasicBlock(func, "memo.push");
+	LLVMBasicBlockRef finish_block = LLVMAppendBasicBlock(func, "memo.finish");
+	LLVMBasicBlockRef evicted_block = LLVMAppendBasicBlock(func, "memo.evicted");
+	LLVMBasicBlockRef end_block = LLVMAppendBasicBlock(func, "memo.end");
+
+	// Look up the next element in the buffer
+	LLVMBuildBr(builder, get_block);
+	LLVMPositionBuilderAtEnd(builder, get_block);
+	LLVMValueRef index = LLVMBuildPhi(builder, LLVMInt64Type(), "memo.i");
+	LLVMValueRef args[] = {memo, index, LLVMBuildBitCast(builder, out, i8_ptr, "")};
+	LLVMValueRef result = build_runtime_call(env, builder, "curly_memo_get", LLVMInt32Type(), (LLVMTypeRef[]) {i8_ptr, LLVMInt64Type(), i8_ptr}, args, 3);
+	LLVMValueRef switchy = LLVMBuildSwitch(builder, result, end_block, 3);
+	LLVMAddCase(switchy, LLVMConstInt(LLVMInt32Type(), CURLY_MEMO_HIT, false), hit_block);
+	LLVMAddCase(switchy, LLVMConstInt(LLVMInt32Type(), CURLY_MEMO_MISS, false), miss_block);
+	LLVMAddCase(switchy, LLVMConstInt(LLVMInt32Type(), CURLY_MEMO_EVICTED, false), evicted_block);
+
+	// Yield buffered elements, holding a reference in case another consumer evicts them
+	LLVMPositionBuilderAtEnd(builder, hit_block);
+	env->current_block = hit_block;
+	LLVMValueRef hit = LLVMBuildLoad2(builder, elem_type, out, "");
+	bool rc = llvm_rc_type(elem_type);
+	if (rc)
+	{
+		// Destroying the memo while it's suspended here releases the reference too
+		build_dup(env, builder, hit);
+		LLVMBasicBlockRef yield_block = env->current_block;
+		LLVMBasicBlockRef hit_cleanup_block = LLVMAppendBasicBlock(func, "memo.hit.cleanup");
+		LLVMPositionBuilderAtEnd(builder, hit_cleanup_block);
+		env->current_block = hit_cleanup_block;
+		build_drop(env, builder, hit);
+		LLVMBuildBr(builder, coro.cleanup_block);
+		LLVMPositionBuilderAtEnd(builder, yield_block);
+		env->current_block = yield_block;
+		build_coro_yield_cleanup(env, builder, coro, hit, hit_cleanup_block);
+		build_drop(env, builder, hit);
+	} else build_coro_yield(env, builder, coro, hit);
+	LLVMValueRef next = LLVMBuildAdd(builder, index, LLVMConstInt(LLVMInt64Type(), 1, false), "memo.next");
+	LLVMBasicBlockRef resumed_block = env->current_block;
+	LLVMBuildBr(builder, get_block);
+
+	// Start the source if no consumer has yet
+	LLVMPositionBuilderAtEnd(builder, miss_block);
+	LLVMValueRef source = build_runtime_call(env, builder, "curly_memo_source", i8_ptr, (LLVMTypeRef[]) {i8_ptr}, (LLVMValueRef[]) {memo}, 1);
+	LLVMBuildCondBr(builder, LLVMBuildIsNull(builder, source, ""), start_block, advance_block);
+	LLVMPositionBuilderAtEnd(builder, start_block);
+	LLVMValueRef started = LLVMBuildCall2(builder, generator_ramp_type(), ramp, (LLVMValueRef[]) {source_env}, 1, "memo.source");
+	build_runtime_call(env, builder, "curly_memo_set_source", LLVMVoidType(), (LLVMTypeRef[]) {i8_ptr, i8_ptr}, (LLVMValueRef[]) {memo, started}, 2);
+	LLVMBuildBr(builder, advance_block);
+
+	// Produce the next element from the source
+	LLVMPositionBuilderAtEnd(builder, advance_block);
+	LLVMValueRef handle = LLVMBuildPhi(builder, i8_ptr, "memo.handle");
+	LLVMAddIncoming(handle, (LLVMValueRef[]) {source, started}, (LLVMBasicBlockRef[]) {miss_block, start_block}, 2);
+	build_coro_intrinsic(env, builder, "llvm.coro.resume", NULL, 0, (LLVMValueRef[]) {handle}, 1);
+	LLVMValueRef done = build_coro_intrinsic(env, builder, "llvm.coro.done", NULL, 0, (LLVMValueRef[]) {handle}, 1);
+	LLVMBuildCondBr(builder, done, finish_block, push_block);
+
+	// Buffer the element and look it up again
+	LLVMPositionBuilderAtEnd(builder, push_block);
+	LLVMValueRef align = LLVMConstInt(LLVMInt32Type(), GENERATOR_PROMISE_ALIGN, false);
+	LLVMValueRef promise = build_coro_intrinsic(env, builder, "llvm.coro.promise", NULL, 0, (LLVMValueRef[]) {handle, align, LLVMConstInt(LLVMInt1Type(), 0, false)}, 3);
+	if (rc)
+	{
+		env->current_block = push_block;
+		build_dup(env, builder, LLVMBuildLoad2(builder, elem_type, LLVMBuildBitCast(builder, promise, LLVMPointerType(elem_type, 0), ""), ""));
+		push_block = env->current_block;
+	}
+	build_runtime_call(env, builder, "curly_memo_push", LLVMVoidType(), (LLVMTypeRef[]) {i8_ptr, i8_ptr}, (LLVMValueRef[]) {memo, promise}, 2);
+	LLVMBuildBr(builder, get_block);
+	LLVMAddIncoming(index, (LLVMValueRef[]) {LLVMConstInt(LLVMInt64Type(), 0, false), next, index}, (LLVMBasicBlockRef[]) {from, resumed_block, push_block}, 3);
+
+	// Destroy the source once it has produced everything
+	LLVMPositionBuilderAtEnd(builder, finish_block);
+	build_generator_destroy(env, builder, handle);
+	build_runtime_call(env, builder, "curly_memo_finish", LLVMVoidType(), (LLVMTypeRef[]) {i8_ptr}, (LLVMValueRef[]) {memo}, 1);
+	LLVMBuildBr(builder, end_block);
+
+	// Elements evicted from the buffer are recomputed by a private copy of the source
+	LLVMPositionBuilderAtEnd(builder, evicted_block);
+	env->current_block = evicted_block;
+	LLVMValueRef private = LLVMBuildCall2(builder, generator_ramp_type(), ramp, (LLVMValueRef[]) {source_env}, 1, "memo.private");
+	llvm_iter_loop_t loop = build_generator_loop_start(env, builder, private, elem_type);
+	LLVMBasicBlockRef yield_block = LLVMAppendBasicBlock(func, "memo.private.yield");
+	LLVMMoveBasicBlockAfter(yield_block, env->current_block);
+	LLVMBasicBlockRef skip_block = LLVMAppendBasicBlock(func, "memo.private.next");
+	LLVMMoveBasicBlockAfter(skip_block, yield_block);
+	LLVMBasicBlockRef private_cleanup_block = LLVMAppendBasicBlock(func, "memo.private.cleanup");
+	LLVMBuildCondBr(builder, LLVMBuildICmp(builder, LLVMIntUGE, loop.index, index, ""), yield_block, skip_block);
+
+	// Destroying the memo while it's suspended in the loop destroys the private source too
+	LLVMPositionBuilderAtEnd(builder, private_cleanup_block);
+	build_generator_destroy(env, builder, private);
+	LLVMBuildBr(builder, coro.cleanup_block);
+
+	LLVMPositionBuilderAtEnd(builder, yield_block);
+	env->current_block = yield_block;
+	build_coro_yield_cleanup(env, builder, coro, loop.element, private_cleanup_block);
+	LLVMBuildBr(builder, skip_block);
+	LLVMPositionBuilderAtEnd(builder, skip_block);
+	env->current_block = skip_block;
+	build_iter_loop_end(env, builder, loop);
+	build_generator_destroy(env, builder, private);
+	LLVMBuildBr(builder, end_block);
+
+	// End the coroutine
+	LLVMMoveBasicBlockAfter(end_block, LLVMGetLastBasicBlock(func));
+	LLVMPositionBuilderAtEnd(builder, end_block);
+	env->current_block = end_block;
+	build_coro_end(env, builder, coro);
+
+	// Restore state
+	env->current_func = last_func;
+	env->current_block = last_block;
+	LLVMPositionBuilderAtEnd(builder, last_block);
+
+	// Build the generator value
+	LLVMValueRef memoised = LLVMGetUndef(generator_value_type());
+	memoised = LLVMBuildInsertValue(builder, memoised, func, 0, "");
+	env_ptr = LLVMBuildBitCast(builder, env_ptr, i8_ptr, "");
+	return LLVMBuildInsertValue(builder, memoised, env_ptr, 1, "generator.memo");
+}
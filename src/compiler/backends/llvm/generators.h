@@ -0,0 +1,71 @@
+// 
+// llvm
+// generators.h: Header file for generators.c.
+// 
+// Created by jenra.
+// Created on October 18 2026.
+// 
+
+#ifndef LLVM_GENERATORS_H
+#define LLVM_GENERATORS_H
+
+#include <llvm-c/Core.h>
+
+#include "environment.h"
+#include "lists.h"
+
+// Represents a generator coroutine being built.
+typedef struct
+{
+	// The coroutine id token and handle.
+	LLVMValueRef id;
+	LLVMValueRef handle;
+
+	// The promise the yielded values are stored in.
+	LLVMValueRef promise;
+
+	// The block that frees the coroutine frame.
+	LLVMBasicBlockRef cleanup_block;
+
+	// The block that returns to the caller on suspension.
+	LLVMBasicBlockRef suspend_block;
+} llvm_coro_t;
+
+// generator_ramp_type(void) -> LLVMTypeRef
+// Returns the type of the function that starts a generator: i8* (i8* env).
+LLVMTypeRef generator_ramp_type();
+
+// generator_value_type(void) -> LLVMTypeRef
+// Returns the type of a generator value: {ramp*, i8* env}.
+LLVMTypeRef generator_value_type();
+
+// build_coro_begin(llvm_codegen_env_t*, LLVMBuilderRef, LLVMTypeRef) -> llvm_coro_t
+// Builds the start of a generator coroutine yielding the given type, leaving the builder after the initial suspension.
+llvm_coro_t build_coro_begin(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMTypeRef elem_type);
+
+// build_coro_yield(llvm_codegen_env_t*, LLVMBuilderRef, llvm_coro_t, LLVMValueRef) -> void
+// Yields a value from a generator coroutine, leaving the builder at the point of resumption.
+void build_coro_yield(llvm_codegen_env_t* env, LLVMBuilderRef builder, llvm_coro_t coro, LLVMValueRef value);
+
+// build_coro_yield_cleanup(llvm_codegen_env_t*, LLVMBuilderRef, llvm_coro_t, LLVMValueRef, LLVMBasicBlockRef) -> void
+// Yields a value from a generator coroutine, jumping to the given block if the coroutine is destroyed while suspended
+// there (which must end up at the coroutine's cleanup block). Leaves the builder at the point of resumption.
+void build_coro_yield_cleanup(llvm_codegen_env_t* env, LLVMBuilderRef builder, llvm_coro_t coro, LLVMValueRef value, LLVMBasicBlockRef cleanup_block);
+
+// build_coro_end(llvm_codegen_env_t*, LLVMBuilderRef, llvm_coro_t) -> void
+// Builds the final suspension of a generator coroutine.
+void build_coro_end(llvm_codegen_env_t* env, LLVMBuilderRef builder, llvm_coro_t coro);
+
+// build_generator_loop_start(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef, LLVMTypeRef) -> llvm_iter_loop_t
+// Starts a loop over the values of a generator coroutine, leaving the builder in the body of the loop.
+llvm_iter_loop_t build_generator_loop_start(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef handle, LLVMTypeRef elem_type);
+
+// build_generator_destroy(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef) -> void
+// Destroys a generator coroutine.
+void build_generator_destroy(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef handle);
+
+// build_memo_generator(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef, LLVMTypeRef) -> LLVMValueRef
+// Wraps a generator in a generator that shares the values it produces with every consumer using a memo buffer.
+LLVMValueRef build_memo_generator(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef generator, LLVMTypeRef elem_type);
+
+#endif /* LLVM_GENERATORS_H */
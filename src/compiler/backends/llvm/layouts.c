@@ -0,0 +1,499 @@
+// 
+// llvm
+// layouts.c: Lays out product, union, and enumeration types in memory.
+// 
+// Created by jenra.
+// Created on October 18 2026.
+// 
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../../frontend/correctness/infer.h"
+#include "../../../utils/list.h"
+#include "functions.h"
+#include "generators.h"
+#include "layouts.h"
+#include "lists.h"
+
+// Products store their fields from the most aligned to the least aligned, which leaves no padding between fields
+// since every size is a multiple of its alignment. Unions store the discriminant in a niche of their largest variant
+// (a range of values that never occur in it, like the values of a bool other than 0 and 1) if it has enough invalid
+// values and the other variants fit beside the niche, and otherwise store it after the largest variant, which reuses
+// the tail padding. Pointers have a niche of the small integers, so a variant holding a pointer can share its space
+// with small variants. A type that contains itself is boxed where it refers back to itself.
+
+// The number of invalid small integer values of a pointer (the first page is never mapped).
+#define LLVM_POINTER_NICHE 4096
+
+// init_llvm_layouts(hashmap_t*) -> llvm_layouts_t*
+// Creates an empty cache of layouts for the given declared types.
+llvm_layouts_t* init_llvm_layouts(hashmap_t* types)
+{
+	llvm_layouts_t* layouts = malloc(sizeof(llvm_layouts_t));
+	layouts->types = types;
+	layouts->cache = init_hashmap();
+	layouts->layouts = NULL;
+	layouts->layout_count = 0;
+	layouts->layout_size = 0;
+	return layouts;
+}
+
+// init_llvm_layout(llvm_layouts_t*, llvm_layout_kind_t, type_t*, size_t) -> llvm_layout_t*
+// Creates a layout with the given number of fields and adds it to the list of layouts.
+llvm_layout_t* init_llvm_layout(llvm_layouts_t* layouts, llvm_layout_kind_t kind, type_t* type, size_t field_count)
+{
+	llvm_layout_t* layout = calloc(1, sizeof(llvm_layout_t));
+	layout->kind = kind;
+	layout->type = type;
+	layout->align = 1;
+	layout->field_count = field_count;
+	layout->fields = calloc(field_count, sizeof(llvm_layout_t*));
+	layout->offsets = calloc(field_count, sizeof(uint64_t));
+	layout->indices = calloc(field_count, sizeof(size_t));
+	list_append_element(layouts->layouts, layouts->layout_size, layouts->layout_count, llvm_layout_t*, layout);
+	return layout;
+}
+
+// round_up_layout(uint64_t, uint64_t) -> uint64_t
+// Rounds a size up to a multiple of an alignment.
+uint64_t round_up_layout(uint64_t size, uint64_t align)
+{
+	return (size + align - 1) / align * align;
+}
+
+// set_layout_niche(llvm_layout_t*, uint64_t, uint64_t, uint64_t, uint64_t) -> void
+// Sets the niche of a layout.
+void set_layout_niche(llvm_layout_t* layout, uint64_t offset, uint64_t size, uint64_t start, uint64_t count)
+{
+	layout->niche_offset = offset;
+	layout->niche_size = size;
+	layout->niche_start = start;
+	layout->niche_count = count;
+}
+
+// set_tag_niche(llvm_layout_t*, uint64_t) -> void
+// Sets the niche of a layout to the values of its discriminant that don't name a variant.
+void set_tag_niche(llvm_layout_t* layout, uint64_t variant_count)
+{
+	uint64_t values = layout->tag_size < 8 ? (uint64_t) 1 << (layout->tag_size * 8) : UINT64_MAX;
+	set_layout_niche(layout, layout->tag_offset, layout->tag_size, variant_count, values - variant_count);
+}
+
+// tag_layout_size(size_t) -> uint64_t
+// Returns the size in bytes of the smallest integer that can tell apart the given number of variants.
+uint64_t tag_layout_size(size_t variant_count)
+{
+	if (variant_count <= UINT8_MAX + 1)
+		return 1;
+	else if (variant_count <= UINT16_MAX + 1)
+		return 2;
+	else if (variant_count <= (uint64_t) UINT32_MAX + 1)
+		return 4;
+	else return 8;
+}
+
+// opaque_layout_type(uint64_t, uint64_t) -> LLVMTypeRef
+// Returns an LLVM type with the given size and alignment that doesn't expose its contents.
+LLVMTypeRef opaque_layout_type(uint64_t size, uint64_t align)
+{
+	if (size == 0)
+		return LLVMStructType(NULL, 0, false);
+	LLVMTypeRef word = LLVMIntType(align * 8);
+	return LLVMStructType((LLVMTypeRef[]) {LLVMArrayType(word, size / align)}, 1, false);
+}
+
+// layout_scalar(llvm_layouts_t*, type_t*) -> llvm_layout_t*
+// Lays out a type without fields of its own in memory.
+llvm_layout_t* layout_scalar(llvm_layouts_t* layouts, type_t* type)
+{
+	llvm_layout_t* layout = init_llvm_layout(layouts, LLVM_LAYOUT_SCALAR, type, 0);
+	if (type->type_type == IR_TYPES_PRIMITIVE && !strcmp(type->type_name, "Int"))
+	{
+		layout->size = layout->align = 8;
+		layout->llvm_type = LLVMInt64Type();
+	} else if (type->type_type == IR_TYPES_PRIMITIVE && !strcmp(type->type_name, "Float"))
+	{
+		layout->size = layout->align = 8;
+		layout->llvm_type = LLVMDoubleType();
+	} else if (type->type_type == IR_TYPES_PRIMITIVE && !strcmp(type->type_name, "Bool"))
+	{
+		// Only 0 and 1 are valid bools
+		layout->size = layout->align = 1;
+		layout->llvm_type = LLVMInt1Type();
+		set_layout_niche(layout, 0, 1, 2, UINT8_MAX - 1);
+	} else if (type->type_type == IR_TYPES_LIST)
+	{
+		// Lists are {length, capacity, data*}, and the data of an empty list may be null
+		// Lists of a type being laid out point to bytes, since the elements aren't boxed
+		layout->size = 24;
+		layout->align = 8;
+		llvm_layout_t* elem = type->field_count != 0 ? llvm_type_layout(layouts, type->field_types[0]) : NULL;
+		layout->in_progress = elem != NULL && elem->kind == LLVM_LAYOUT_BOXED;
+		layout->llvm_type = list_type(elem == NULL ? LLVMInt64Type() : layout->in_progress ? LLVMInt8Type() : elem->llvm_type);
+	} else if (type->type_type == IR_TYPES_GENERATOR || type->type_type == IR_TYPES_FUNC)
+	{
+		// Generators and functions start with a code pointer that's never null
+		layout->size = 16;
+		layout->align = 8;
+		layout->llvm_type = type->type_type == IR_TYPES_GENERATOR ? generator_value_type() : function_value_type();
+		set_layout_niche(layout, 0, 8, 0, LLVM_POINTER_NICHE);
+	} else layout->llvm_type = opaque_layout_type(0, 1);
+	return layout;
+}
+
+// layout_boxed(llvm_layouts_t*, type_t*) -> llvm_layout_t*
+// Lays out a pointer to a value of a type.
+llvm_layout_t* layout_boxed(llvm_layouts_t* layouts, type_t* type)
+{
+	llvm_layout_t* layout = init_llvm_layout(layouts, LLVM_LAYOUT_BOXED, type, 0);
+	layout->size = layout->align = 8;
+	layout->llvm_type = LLVMPointerType(LLVMInt8Type(), 0);
+	set_layout_niche(layout, 0, 8, 0, LLVM_POINTER_NICHE);
+	return layout;
+}
+
+// layout_product(llvm_layouts_t*, llvm_layout_t*) -> void
+// Lays out the fields of a product type from the most aligned to the least aligned.
+void layout_product(llvm_layouts_t* layouts, llvm_layout_t* layout)
+{
+	type_t* type = layout->type;
+	size_t* order = calloc(type->field_count, sizeof(size_t));
+	for (size_t i = 0; i < type->field_count; i++)
+	{
+		layout->fields[i] = llvm_type_layout(layouts, type->field_types[i]);
+
+		// Insertion sort keeps fields with the same alignment in declaration order
+		size_t j = i;
+		for (; j > 0 && layout->fields[order[j - 1]]->align < layout->fields[i]->align; j--)
+		{
+			order[j] = order[j - 1];
+		}
+		order[j] = i;
+	}
+
+	// Place the fields in memory order
+	LLVMTypeRef* field_types = calloc(type->field_count, sizeof(LLVMTypeRef));
+	for (size_t i = 0; i < type->field_count; i++)
+	{
+		llvm_layout_t* field = layout->fields[order[i]];
+		layout->offsets[order[i]] = layout->size;
+		layout->indices[order[i]] = i;
+		field_types[i] = field->llvm_type;
+		layout->size += field->size;
+		if (field->align > layout->align)
+			layout->align = field->align;
+
+		// Keep the field niche with the most invalid values
+		if (field->niche_count > layout->niche_count)
+			set_layout_niche(layout, layout->offsets[order[i]] + field->niche_offset, field->niche_size, field->niche_start, field->niche_count);
+	}
+	layout->size = round_up_layout(layout->size, layout->align);
+	layout->llvm_type = LLVMStructType(field_types, type->field_count, false);
+	free(field_types);
+	free(order);
+}
+
+// fit_beside_niche(llvm_layout_t*, llvm_layout_t*, uint64_t*) -> bool
+// Places a variant before or after the niche of the dataful variant of a union. Returns false if the variant doesn't fit.
+bool fit_beside_niche(llvm_layout_t* dataful, llvm_layout_t* variant, uint64_t* offset)
+{
+	uint64_t after = round_up_layout(dataful->niche_offset + dataful->niche_size, variant->align);
+	if (variant->size <= dataful->niche_offset)
+		*offset = 0;
+	else if (after + variant->size <= dataful->size)
+		*offset = after;
+	else return false;
+	return true;
+}
+
+// layout_union(llvm_layouts_t*, llvm_layout_t*) -> void
+// Lays out the variants of a union type and decides where its discriminant is stored.
+void layout_union(llvm_layouts_t* layouts, llvm_layout_t* layout)
+{
+	type_t* type = layout->type;
+	size_t count = type->field_count;
+	uint64_t max_size = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		layout->fields[i] = llvm_type_layout(layouts, type->field_types[i]);
+		if (layout->fields[i]->align > layout->align)
+			layout->align = layout->fields[i]->align;
+		if (layout->fields[i]->size > layout->fields[layout->dataful]->size)
+			layout->dataful = i;
+	}
+	if (count != 0)
+		max_size = layout->fields[layout->dataful]->size;
+
+	// Unions of empty variants are just their discriminant
+	if (max_size == 0)
+	{
+		layout->kind = LLVM_LAYOUT_TAG;
+		layout->tag_size = count > 1 ? tag_layout_size(count) : 0;
+		layout->size = layout->tag_size;
+		layout->align = layout->tag_size > 0 ? layout->tag_size : 1;
+		layout->llvm_type = layout->tag_size > 0 ? LLVMIntType(layout->tag_size * 8) : opaque_layout_type(0, 1);
+		if (layout->tag_size > 0)
+			set_tag_niche(layout, count);
+		return;
+	}
+
+	// Store the discriminant in the niche of the largest variant if it has enough invalid values
+	llvm_layout_t* dataful = layout->fields[layout->dataful];
+	bool niche = dataful->niche_count >= count - 1;
+	for (size_t i = 0; niche && i < count; i++)
+	{
+		if (i != layout->dataful)
+			niche = fit_beside_niche(dataful, layout->fields[i], &layout->offsets[i]);
+	}
+	if (niche)
+	{
+		layout->kind = LLVM_LAYOUT_NICHE;
+		layout->size = round_up_layout(max_size, layout->align);
+		layout->tag_offset = dataful->niche_offset;
+		layout->tag_size = dataful->niche_size;
+		set_layout_niche(layout, dataful->niche_offset, dataful->niche_size, dataful->niche_start + count - 1, dataful->niche_count - (count - 1));
+	} else
+	{
+		// Otherwise store it after the largest variant, in its tail padding if there's room
+		layout->kind = LLVM_LAYOUT_TAGGED;
+		memset(layout->offsets, 0, count * sizeof(uint64_t));
+		layout->tag_size = tag_layout_size(count);
+		if (layout->tag_size > layout->align)
+			layout->align = layout->tag_size;
+		layout->tag_offset = round_up_layout(max_size, layout->tag_size);
+		layout->size = round_up_layout(layout->tag_offset + layout->tag_size, layout->align);
+		set_tag_niche(layout, count);
+	}
+	layout->llvm_type = opaque_layout_type(layout->size, layout->align);
+}
+
+// expand_instance(llvm_layouts_t*, type_t*) -> type_t*
+// Returns the body of the parametric type an instance is of with the type arguments substituted in, or NULL if the
+// parametric type isn't declared.
+type_t* expand_instance(llvm_layouts_t* layouts, type_t* instance)
+{
+	type_t* parametric = layouts->types != NULL ? map_get(layouts->types, instance->type_name) : NULL;
+	if (parametric == NULL || parametric->type_type != IR_TYPES_PARAMETRIC || parametric->field_count != instance->field_count + 1)
+		return NULL;
+	return resolve_type(substitute_type(parametric->field_types[instance->field_count], parametric->field_types, instance->field_types, instance->field_count));
+}
+
+// llvm_type_layout(llvm_layouts_t*, type_t*) -> llvm_layout_t*
+// Returns the layout of a type, computing it if it hasn't been already.
+llvm_layout_t* llvm_type_layout(llvm_layouts_t* layouts, type_t* type)
+{
+	// Types are keyed on their ids
+	char key[24];
+	snprintf(key, sizeof(key), "%zu", type->id);
+	llvm_layout_t* layout = map_get(layouts->cache, key);
+	if (layout != NULL)
+		return layout->in_progress ? layout_boxed(layouts, type) : layout;
+
+	switch (type->type_type)
+	{
+		case IR_TYPES_PRODUCT:
+		case IR_TYPES_UNION:
+			layout = init_llvm_layout(layouts, type->type_type == IR_TYPES_PRODUCT ? LLVM_LAYOUT_STRUCT : LLVM_LAYOUT_TAGGED, type, type->field_count);
+			layout->in_progress = true;
+			map_add(layouts->cache, key, layout);
+			if (type->type_type == IR_TYPES_PRODUCT)
+				layout_product(layouts, layout);
+			else layout_union(layouts, layout);
+			layout->in_progress = false;
+			return layout;
+		case IR_TYPES_ENUMERATION:
+			// Enum values carry no data
+			layout = init_llvm_layout(layouts, LLVM_LAYOUT_TAG, type, 0);
+			layout->llvm_type = opaque_layout_type(0, 1);
+			break;
+		case IR_TYPES_INSTANCE:
+		{
+			// Instances are laid out as their body, which may refer back to the instance
+			type_t* body = expand_instance(layouts, type);
+			if (body == NULL || body->has_vars)
+			{
+				layout = layout_scalar(layouts, type);
+				break;
+			}
+			llvm_layout_t* placeholder = init_llvm_layout(layouts, LLVM_LAYOUT_BOXED, type, 0);
+			placeholder->in_progress = true;
+			map_add(layouts->cache, key, placeholder);
+			layout = llvm_type_layout(layouts, body);
+			placeholder->in_progress = false;
+			break;
+		}
+		default:
+			// Lists of a type being laid out aren't cached
+			layout = layout_scalar(layouts, type);
+			if (layout->in_progress)
+			{
+				layout->in_progress = false;
+				return layout;
+			}
+			break;
+	}
+	map_add(layouts->cache, key, layout);
+	return layout;
+}
+
+// print_layout_field(type_t*, size_t) -> void
+// Prints out the name of a field or variant of a type.
+void print_layout_field(type_t* type, size_t index)
+{
+	type_t* field = type->field_types[index];
+	if (type->field_names != NULL && type->field_names[index] != NULL)
+		printf("%s", type->field_names[index]);
+
+	// Fields declared as name: type are named after their only field
+	else if (field->type_type == IR_TYPES_PRODUCT && field->field_count == 1
+		&& field->field_names != NULL && field->field_names[0] != NULL)
+		printf("%s", field->field_names[0]);
+	else printf("%zu", index);
+}
+
+// print_layout(char*, type_t*, llvm_layout_t*) -> void
+// Prints out the layout of a type under its name, or the type itself if it has no name.
+void print_layout(char* name, type_t* type, llvm_layout_t* layout)
+{
+	if (name != NULL)
+		printf("%s", name);
+	else print_type_inline(type);
+	printf(": size %" PRIu64 ", align %" PRIu64, layout->size, layout->align);
+	switch (layout->kind)
+	{
+		case LLVM_LAYOUT_SCALAR:
+		case LLVM_LAYOUT_BOXED:
+			break;
+		case LLVM_LAYOUT_STRUCT:
+			printf(", product");
+			break;
+		case LLVM_LAYOUT_TAG:
+			printf(", enumeration");
+			break;
+		case LLVM_LAYOUT_TAGGED:
+			printf(", tagged union (%" PRIu64 " byte tag at %" PRIu64 "%s)", layout->tag_size, layout->tag_offset,
+				layout->size == round_up_layout(layout->fields[layout->dataful]->size, layout->fields[layout->dataful]->align) ? " in tail padding" : "");
+			break;
+		case LLVM_LAYOUT_NICHE:
+			printf(", niche union (tag in %" PRIu64 " byte niche of ", layout->tag_size);
+			print_layout_field(layout->type, layout->dataful);
+			printf(" at %" PRIu64 ")", layout->tag_offset);
+			break;
+	}
+	if (layout->niche_count != 0)
+		printf(", %" PRIu64 " spare values at %" PRIu64, layout->niche_count, layout->niche_offset);
+	puts("");
+
+	// Print the fields in declaration order
+	for (size_t i = 0; i < layout->field_count; i++)
+	{
+		llvm_layout_t* field = layout->fields[i];
+		printf("\t");
+		print_layout_field(layout->type, i);
+		printf(" at %" PRIu64 ", size %" PRIu64 "%s\n", layout->offsets[i], field->size, field->kind == LLVM_LAYOUT_BOXED ? " (boxed)" : "");
+	}
+}
+
+// collect_instances(type_t*, type_t***, size_t*, size_t*) -> void
+// Appends the instances of parametric types in a type that aren't in the list already to the list.
+void collect_instances(type_t* type, type_t*** instances, size_t* size, size_t* count)
+{
+	if (type == NULL || type->has_vars || type->printing)
+		return;
+	else if (type->type_type == IR_TYPES_INSTANCE)
+	{
+		for (size_t i = 0; i < *count; i++)
+		{
+			if ((*instances)[i] == type)
+				return;
+		}
+		list_append_element(*instances, *size, *count, type_t*, type);
+	}
+
+	// Recursive types refer back to themselves
+	type->printing = true;
+	for (size_t i = 0; i < type->field_count; i++)
+	{
+		collect_instances(type->field_types[i], instances, size, count);
+	}
+	type->printing = false;
+}
+
+// compare_layout_names(const void*, const void*) -> int
+// Compares two type names for sorting.
+int compare_layout_names(const void* a, const void* b)
+{
+	return strcmp(*(char**) a, *(char**) b);
+}
+
+// print_type_layouts(hashmap_t*, curly_ir_t) -> void
+// Prints out the layouts of the declared types and the instances of parametric types used in the IR.
+void print_type_layouts(hashmap_t* types, curly_ir_t ir)
+{
+	llvm_layouts_t* layouts = init_llvm_layouts(types);
+	type_t** instances = NULL;
+	size_t instance_size = 0;
+	size_t instance_count = 0;
+
+	// Print the declared types in alphabetical order
+	size_t name_count = 0;
+	char** names = map_keys(types, &name_count, NULL);
+	qsort(names, name_count, sizeof(char*), compare_layout_names);
+	for (size_t i = 0; i < name_count; i++)
+	{
+		type_t* type = map_get(types, names[i]);
+		if (type->type_type == IR_TYPES_PRIMITIVE || type->type_type == IR_TYPES_VAR)
+			continue;
+		else if (type->type_type == IR_TYPES_PARAMETRIC)
+			printf("%s: parametric, laid out per instance\n", names[i]);
+		else print_layout(names[i], type, llvm_type_layout(layouts, type));
+	}
+	free(names);
+
+	// Print the instances used by functions and top level expressions
+	for (size_t i = 0; i < ir.func_count; i++)
+	{
+		for (size_t j = 0; j < ir.funcs[i]->arg_count; j++)
+		{
+			collect_instances(ir.funcs[i]->args[j].type, &instances, &instance_size, &instance_count);
+		}
+	}
+	for (size_t i = 0; i < ir.expr_count; i++)
+	{
+		collect_instances(ir.expr[i]->type, &instances, &instance_size, &instance_count);
+	}
+	for (size_t i = 0; i < instance_count; i++)
+	{
+		print_layout(NULL, instances[i], llvm_type_layout(layouts, instances[i]));
+	}
+	free(instances);
+	del_llvm_layouts(layouts);
+}
+
+// empty_llvm_layouts(llvm_layouts_t*) -> void
+// Removes every layout from a cache of layouts.
+void empty_llvm_layouts(llvm_layouts_t* layouts)
+{
+	for (size_t i = 0; i < layouts->layout_count; i++)
+	{
+		free(layouts->layouts[i]->fields);
+		free(layouts->layouts[i]->offsets);
+		free(layouts->layouts[i]->indices);
+		free(layouts->layouts[i]);
+	}
+	layouts->layout_count = 0;
+	del_hashmap(layouts->cache);
+	layouts->cache = init_hashmap();
+}
+
+// del_llvm_layouts(llvm_layouts_t*) -> void
+// Deletes a cache of layouts.
+void del_llvm_layouts(llvm_layouts_t* layouts)
+{
+	empty_llvm_layouts(layouts);
+	del_hashmap(layouts->cache);
+	free(layouts->layouts);
+	free(layouts);
+}
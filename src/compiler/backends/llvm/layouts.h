@@ -0,0 +1,116 @@
+// 
+// llvm
+// layouts.h: Header file for layouts.c.
+// 
+// Created by jenra.
+// Created on October 18 2026.
+// 
+
+#ifndef LLVM_LAYOUTS_H
+#define LLVM_LAYOUTS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <llvm-c/Core.h>
+
+#include "../../frontend/correctness/types.h"
+#include "../../frontend/ir/generate_ir.h"
+#include "../../../utils/hashmap.h"
+
+// Represents the kinds of layouts.
+typedef enum
+{
+	// A value with no fields, such as an integer or a list.
+	LLVM_LAYOUT_SCALAR,
+
+	// A pointer to a value laid out elsewhere, used where a type contains itself.
+	LLVM_LAYOUT_BOXED,
+
+	// A product type, with its fields reordered to minimise padding.
+	LLVM_LAYOUT_STRUCT,
+
+	// A union whose variants are all empty, so the value is just the discriminant.
+	LLVM_LAYOUT_TAG,
+
+	// A union with an explicit discriminant placed after the largest variant.
+	LLVM_LAYOUT_TAGGED,
+
+	// A union whose discriminant is stored in the invalid values of a field of its largest variant.
+	LLVM_LAYOUT_NICHE
+} llvm_layout_kind_t;
+
+// Represents the memory layout of a type.
+typedef struct s_llvm_layout
+{
+	// The kind of layout and the type laid out.
+	llvm_layout_kind_t kind;
+	type_t* type;
+
+	// The size and alignment of the type in bytes.
+	uint64_t size;
+	uint64_t align;
+
+	// The LLVM type of values of the type.
+	LLVMTypeRef llvm_type;
+
+	// The niche of the type: niche_count values starting at niche_start of the niche_size byte integer at niche_offset
+	// never occur in a valid value. niche_count is 0 if the type has no niche.
+	uint64_t niche_offset;
+	uint64_t niche_size;
+	uint64_t niche_start;
+	uint64_t niche_count;
+
+	// The layouts and offsets of the fields or variants, in declaration order.
+	struct s_llvm_layout** fields;
+	uint64_t* offsets;
+	size_t field_count;
+
+	// The index of each field in the LLVM struct of a product type.
+	size_t* indices;
+
+	// The offset and size of the discriminant of a union, and the index of the variant stored without a discriminant
+	// in a niche layout.
+	uint64_t tag_offset;
+	uint64_t tag_size;
+	size_t dataful;
+
+	// Whether the type is being laid out.
+	bool in_progress;
+} llvm_layout_t;
+
+// Represents a cache of layouts.
+typedef struct
+{
+	// The declared types, used to expand instances of parametric types.
+	hashmap_t* types;
+
+	// The layouts keyed on the type ids, and every layout created.
+	hashmap_t* cache;
+	llvm_layout_t** layouts;
+	size_t layout_count;
+	size_t layout_size;
+} llvm_layouts_t;
+
+// init_llvm_layouts(hashmap_t*) -> llvm_layouts_t*
+// Creates an empty cache of layouts for the given declared types.
+llvm_layouts_t* init_llvm_layouts(hashmap_t* types);
+
+// llvm_type_layout(llvm_layouts_t*, type_t*) -> llvm_layout_t*
+// Returns the layout of a type, computing it if it hasn't been already.
+llvm_layout_t* llvm_type_layout(llvm_layouts_t* layouts, type_t* type);
+
+// print_type_layouts(hashmap_t*, curly_ir_t) -> void
+// Prints out the layouts of the declared types and the instances of parametric types used in the IR.
+void print_type_layouts(hashmap_t* types, curly_ir_t ir);
+
+// empty_llvm_layouts(llvm_layouts_t*) -> void
+// Removes every layout from a cache of layouts.
+void empty_llvm_layouts(llvm_layouts_t* layouts);
+
+// del_llvm_layouts(llvm_layouts_t*) -> void
+// Deletes a cache of layouts.
+void del_llvm_layouts(llvm_layouts_t* layouts);
+
+#endif /* LLVM_LAYOUTS_H */
@@ -0,0 +1,217 @@
+// 
+// llvm
+// lists.c: Implements lists as length prefixed arrays of unboxed values.
+// 
+// Created by jenra.
+// Created on October 18 2026.
+// 
+
+#include "lists.h"
+#include "memory.h"
+#include "reference_counting.h"
+
+// Lists are represented as {i64 length, i64 capacity, T* data}, where data is a reference counted flat array of unboxed elements.
+
+// list_type(LLVMTypeRef) -> LLVMTypeRef
+// Returns the type of a list with the given element type.
+LLVMTypeRef list_type(LLVMTypeRef elem_type)
+{
+	return LLVMStructType((LLVMTypeRef[]) {LLVMInt64Type(), LLVMInt64Type(), LLVMPointerType(elem_type, 0)}, 3, false);
+}
+
+// is_list_type(LLVMTypeRef) -> bool
+// Returns whether a type is the type of a list.
+bool is_list_type(LLVMTypeRef type)
+{
+	return LLVMGetTypeKind(type) == LLVMStructTypeKind && LLVMCountStructElementTypes(type) == 3
+		&& LLVMGetTypeKind(LLVMStructGetTypeAtIndex(type, 2)) == LLVMPointerTypeKind
+		&& type == list_type(LLVMGetElementType(LLVMStructGetTypeAtIndex(type, 2)));
+}
+
+// build_list_alloc(llvm_codegen_env_t*, LLVMBuilderRef, LLVMTypeRef, LLVMValueRef) -> LLVMValueRef
+// Allocates a list with the given element type and length.
+LLVMValueRef build_list_alloc(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMTypeRef elem_type, LLVMValueRef length)
+{
+	LLVMValueRef size = LLVMBuildMul(builder, length, LLVMSizeOf(elem_type), "");
+	LLVMValueRef data = LLVMBuildBitCast(builder, build_rc_alloc(env, builder, size, NULL), LLVMPointerType(elem_type, 0), "list.data");
+	LLVMValueRef list = LLVMGetUndef(list_type(elem_type));
+	list = LLVMBuildInsertValue(builder, list, length, 0, "");
+	list = LLVMBuildInsertValue(builder, list, length, 1, "");
+	return LLVMBuildInsertValue(builder, list, data, 2, "list");
+}
+
+// build_list_literal(llvm_codegen_env_t*, LLVMBuilderRef, LLVMTypeRef, LLVMValueRef*, size_t) -> LLVMValueRef
+// Builds a list out of an array of values.
+LLVMValueRef build_list_literal(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMTypeRef elem_type, LLVMValueRef* elements, size_t count)
+{
+	LLVMValueRef list = build_list_alloc(env, builder, elem_type, LLVMConstInt(LLVMInt64Type(), count, false));
+	LLVMValueRef data = LLVMBuildExtractValue(builder, list, 2, "");
+
+	// Store every element
+	for (size_t i = 0; i < count; i++)
+	{
+		LLVMValueRef ptr = LLVMBuildGEP2(builder, elem_type, data, (LLVMValueRef[]) {LLVMConstInt(LLVMInt64Type(), i, false)}, 1, "");
+		LLVMBuildStore(builder, elements[i], ptr);
+	}
+	return list;
+}
+
+// build_list_append(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef, LLVMValueRef) -> void
+// Appends a value to a list stored at the given pointer, growing the list if necessary.
+void build_list_append(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef list_ptr, LLVMValueRef value)
+{
+	// Load the list
+	LLVMTypeRef elem_type = LLVMTypeOf(value);
+	LLVMTypeRef type = list_type(elem_type);
+	LLVMValueRef length_ptr = LLVMBuildStructGEP2(builder, type, list_ptr, 0, "");
+	LLVMValueRef capacity_ptr = LLVMBuildStructGEP2(builder, type, list_ptr, 1, "");
+	LLVMValueRef data_ptr = LLVMBuildStructGEP2(builder, type, list_ptr, 2, "");
+	LLVMValueRef length = LLVMBuildLoad2(builder, LLVMInt64Type(), length_ptr, "list.len");
+	LLVMValueRef capacity = LLVMBuildLoad2(builder, LLVMInt64Type(), capacity_ptr, "list.cap");
+	LLVMValueRef data = LLVMBuildLoad2(builder, LLVMPointerType(elem_type, 0), data_ptr, "list.data");
+
+	// Create basic blocks to jump to
+	LLVMBasicBlockRef from = env->current_block;
+	LLVMBasicBlockRef grow_block = LLVMAppendBasicBlock(env->current_func, "list.grow");
+	LLVMMoveBasicBlockAfter(grow_block, from);
+	LLVMBasicBlockRef store_block = LLVMAppendBasicBlock(env->current_func, "list.store");
+	LLVMMoveBasicBlockAfter(store_block, grow_block);
+
+	// Double the capacity if the list is full
+	LLVMValueRef full = LLVMBuildICmp(builder, LLVMIntEQ, length, capacity, "");
+	LLVMBuildCondBr(builder, full, grow_block, store_block);
+	LLVMPositionBuilderAtEnd(builder, grow_block);
+	LLVMValueRef empty = LLVMBuildICmp(builder, LLVMIntEQ, capacity, LLVMConstInt(LLVMInt64Type(), 0, false), "");
+	LLVMValueRef doubled = LLVMBuildShl(builder, capacity, LLVMConstInt(LLVMInt64Type(), 1, false), "");
+	LLVMValueRef new_capacity = LLVMBuildSelect(builder, empty, LLVMConstInt(LLVMInt64Type(), 8, false), doubled, "list.cap.new");
+	LLVMValueRef size = LLVMBuildMul(builder, new_capacity, LLVMSizeOf(elem_type), "");
+	LLVMValueRef raw = build_rc_realloc(env, builder, LLVMBuildBitCast(builder, data, LLVMPointerType(LLVMInt8Type(), 0), ""), size);
+	LLVMValueRef new_data = LLVMBuildBitCast(builder, raw, LLVMTypeOf(data), "list.data.new");
+	LLVMBuildStore(builder, new_capacity, capacity_ptr);
+	LLVMBuildStore(builder, new_data, data_ptr);
+	LLVMBuildBr(builder, store_block);
+
+	// Store the value
+	LLVMPositionBuilderAtEnd(builder, store_block);
+	env->current_block = store_block;
+	LLVMValueRef phi = LLVMBuildPhi(builder, LLVMTypeOf(data), "");
+	LLVMAddIncoming(phi, (LLVMValueRef[]) {data, new_data}, (LLVMBasicBlockRef[]) {from, grow_block}, 2);
+	LLVMValueRef ptr = LLVMBuildGEP2(builder, elem_type, phi, (LLVMValueRef[]) {length}, 1, "");
+	LLVMBuildStore(builder, value, ptr);
+	LLVMBuildStore(builder, LLVMBuildAdd(builder, length, LLVMConstInt(LLVMInt64Type(), 1, false), ""), length_ptr);
+}
+
+// build_bounds_check(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef, char*, LLVMValueRef*, size_t) -> void
+// Builds a branch to a call to the given runtime error if a bounds check fails, leaving the builder where it passed.
+void build_bounds_check(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef in_bounds, char* error, LLVMValueRef* args, size_t arg_count)
+{
+	// Create basic blocks to jump to
+	LLVMBasicBlockRef from = env->current_block;
+	LLVMBasicBlockRef error_block = LLVMAppendBasicBlock(env->current_func, "bounds.error");
+	LLVMMoveBasicBlockAfter(error_block, from);
+	LLVMBasicBlockRef pass_block = LLVMAppendBasicBlock(env->current_func, "bounds.pass");
+	LLVMMoveBasicBlockAfter(pass_block, error_block);
+	LLVMBuildCondBr(builder, in_bounds, pass_block, error_block);
+
+	// Report the error; the runtime never returns from it
+	LLVMPositionBuilderAtEnd(builder, error_block);
+	LLVMTypeRef arg_types[3] = {LLVMInt64Type(), LLVMInt64Type(), LLVMInt64Type()};
+	LLVMValueRef call = build_runtime_call(env, builder, error, LLVMVoidType(), arg_types, args, arg_count);
+	LLVMValueRef func = LLVMGetCalledValue(call);
+	LLVMContextRef context = LLVMGetModuleContext(LLVMGetGlobalParent(func));
+	LLVMAddAttributeAtIndex(func, LLVMAttributeFunctionIndex, LLVMCreateEnumAttribute(context, LLVMGetEnumAttributeKindForName("noreturn", 8), 0));
+	LLVMAddAttributeAtIndex(func, LLVMAttributeFunctionIndex, LLVMCreateEnumAttribute(context, LLVMGetEnumAttributeKindForName("cold", 4), 0));
+	LLVMBuildUnreachable(builder);
+
+	LLVMPositionBuilderAtEnd(builder, pass_block);
+	env->current_block = pass_block;
+}
+
+// build_list_index(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef, LLVMValueRef) -> LLVMValueRef
+// Builds an indexing operation on a list, raising an error if the index is out of bounds.
+LLVMValueRef build_list_index(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef list, LLVMValueRef index)
+{
+	// Negative indices are out of bounds as unsigned integers too
+	LLVMValueRef length = LLVMBuildExtractValue(builder, list, 0, "list.len");
+	LLVMValueRef in_bounds = LLVMBuildICmp(builder, LLVMIntULT, index, length, "");
+	build_bounds_check(env, builder, in_bounds, "curly_error_index", (LLVMValueRef[]) {index, length}, 2);
+
+	LLVMValueRef data = LLVMBuildExtractValue(builder, list, 2, "");
+	LLVMTypeRef elem_type = LLVMGetElementType(LLVMTypeOf(data));
+	LLVMValueRef ptr = LLVMBuildGEP2(builder, elem_type, data, (LLVMValueRef[]) {index}, 1, "");
+	return LLVMBuildLoad2(builder, elem_type, ptr, "");
+}
+
+// build_list_slice(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef, LLVMValueRef, LLVMValueRef) -> LLVMValueRef
+// Builds a copy of the elements of a list in the range [start, end), raising an error if the range is out of bounds.
+LLVMValueRef build_list_slice(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef list, LLVMValueRef start, LLVMValueRef end)
+{
+	// As unsigned integers, end <= length and start <= end also rule out negative bounds
+	LLVMValueRef list_length = LLVMBuildExtractValue(builder, list, 0, "list.len");
+	LLVMValueRef in_bounds = LLVMBuildAnd(builder,
+		LLVMBuildICmp(builder, LLVMIntULE, start, end, ""),
+		LLVMBuildICmp(builder, LLVMIntULE, end, list_length, ""), "");
+	build_bounds_check(env, builder, in_bounds, "curly_error_slice", (LLVMValueRef[]) {start, end, list_length}, 3);
+
+	// Allocate the new list
+	LLVMValueRef data = LLVMBuildExtractValue(builder, list, 2, "");
+	LLVMTypeRef elem_type = LLVMGetElementType(LLVMTypeOf(data));
+	LLVMValueRef length = LLVMBuildSub(builder, end, start, "slice.len");
+	LLVMValueRef slice = build_list_alloc(env, builder, elem_type, length);
+
+	// Copy the elements over in bulk
+	LLVMValueRef src = LLVMBuildGEP2(builder, elem_type, data, (LLVMValueRef[]) {start}, 1, "");
+	LLVMValueRef dest = LLVMBuildExtractValue(builder, slice, 2, "");
+	LLVMValueRef size = LLVMBuildMul(builder, length, LLVMSizeOf(elem_type), "");
+	LLVMBuildMemCpy(builder, dest, 1, src, 1, size);
+	return slice;
+}
+
+// build_list_loop_start(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef) -> llvm_iter_loop_t
+// Starts a loop over the elements of a list, leaving the builder in the body of the loop.
+llvm_iter_loop_t build_list_loop_start(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef list)
+{
+	llvm_iter_loop_t loop;
+	loop.handle = NULL;
+	LLVMValueRef length = LLVMBuildExtractValue(builder, list, 0, "list.len");
+	LLVMValueRef data = LLVMBuildExtractValue(builder, list, 2, "list.data");
+	LLVMTypeRef elem_type = LLVMGetElementType(LLVMTypeOf(data));
+
+	// Create basic blocks to jump to
+	LLVMBasicBlockRef from = env->current_block;
+	loop.cond_block = LLVMAppendBasicBlock(env->current_func, "list.cond");
+	LLVMMoveBasicBlockAfter(loop.cond_block, from);
+	LLVMBasicBlockRef body_block = LLVMAppendBasicBlock(env->current_func, "list.body");
+	LLVMMoveBasicBlockAfter(body_block, loop.cond_block);
+	loop.post_block = LLVMAppendBasicBlock(env->current_func, "list.post");
+	LLVMMoveBasicBlockAfter(loop.post_block, body_block);
+
+	// Build the loop condition
+	LLVMBuildBr(builder, loop.cond_block);
+	LLVMPositionBuilderAtEnd(builder, loop.cond_block);
+	loop.index = LLVMBuildPhi(builder, LLVMInt64Type(), "list.i");
+	LLVMAddIncoming(loop.index, (LLVMValueRef[]) {LLVMConstInt(LLVMInt64Type(), 0, false)}, (LLVMBasicBlockRef[]) {from}, 1);
+	LLVMValueRef cond = LLVMBuildICmp(builder, LLVMIntSLT, loop.index, length, "");
+	LLVMBuildCondBr(builder, cond, body_block, loop.post_block);
+
+	// Load the current element
+	LLVMPositionBuilderAtEnd(builder, body_block);
+	env->current_block = body_block;
+	LLVMValueRef ptr = LLVMBuildGEP2(builder, elem_type, data, (LLVMValueRef[]) {loop.index}, 1, "");
+	loop.element = LLVMBuildLoad2(builder, elem_type, ptr, "list.elem");
+	return loop;
+}
+
+// build_iter_loop_end(llvm_codegen_env_t*, LLVMBuilderRef, llvm_iter_loop_t) -> void
+// Ends a loop over a list or generator, leaving the builder after the loop.
+void build_iter_loop_end(llvm_codegen_env_t* env, LLVMBuilderRef builder, llvm_iter_loop_t loop)
+{
+	// Increment the index and jump back to the condition
+	LLVMValueRef next = LLVMBuildAdd(builder, loop.index, LLVMConstInt(LLVMInt64Type(), 1, false), "iter.next");
+	LLVMAddIncoming(loop.index, (LLVMValueRef[]) {next}, (LLVMBasicBlockRef[]) {env->current_block}, 1);
+	LLVMBuildBr(builder, loop.cond_block);
+
+	// Move to the end of the loop
+	LLVMPositionBuilderAtEnd(builder, loop.post_block);
+	env->current_block = loop.post_block;
+}
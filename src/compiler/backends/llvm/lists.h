@@ -0,0 +1,73 @@
+// 
+// llvm
+// lists.h: Header file for lists.c.
+// 
+// Created by jenra.
+// Created on October 18 2026.
+// 
+
+#ifndef LLVM_LISTS_H
+#define LLVM_LISTS_H
+
+#include <llvm-c/Core.h>
+
+#include "environment.h"
+
+// Represents a loop over the elements of a list or the values of a generator.
+typedef struct
+{
+	// The current index and element of the loop.
+	LLVMValueRef index;
+	LLVMValueRef element;
+
+	// The coroutine handle of the generator being iterated over (NULL for lists).
+	LLVMValueRef handle;
+
+	// The block that checks the loop condition.
+	LLVMBasicBlockRef cond_block;
+
+	// The block after the loop.
+	LLVMBasicBlockRef post_block;
+} llvm_iter_loop_t;
+
+// list_type(LLVMTypeRef) -> LLVMTypeRef
+// Returns the type of a list with the given element type.
+LLVMTypeRef list_type(LLVMTypeRef elem_type);
+
+// is_list_type(LLVMTypeRef) -> bool
+// Returns whether a type is the type of a list.
+bool is_list_type(LLVMTypeRef type);
+
+// build_list_alloc(llvm_codegen_env_t*, LLVMBuilderRef, LLVMTypeRef, LLVMValueRef) -> LLVMValueRef
+// Allocates a list with the given element type and length.
+LLVMValueRef build_list_alloc(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMTypeRef elem_type, LLVMValueRef length);
+
+// build_list_literal(llvm_codegen_env_t*, LLVMBuilderRef, LLVMTypeRef, LLVMValueRef*, size_t) -> LLVMValueRef
+// Builds a list out of an array of values.
+LLVMValueRef build_list_literal(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMTypeRef elem_type, LLVMValueRef* elements, size_t count);
+
+// build_list_append(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef, LLVMValueRef) -> void
+// Appends a value to a list stored at the given pointer, growing the list if necessary.
+void build_list_append(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef list_ptr, LLVMValueRef value);
+
+// build_bounds_check(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef, char*, LLVMValueRef*, size_t) -> void
+// Builds a branch to a call to the given runtime error if a bounds check fails, leaving the builder where it passed.
+void build_bounds_check(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef in_bounds, char* error, LLVMValueRef* args, size_t arg_count);
+
+// build_list_index(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef, LLVMValueRef) -> LLVMValueRef
+// Builds an indexing operation on a list, raising an error if the index is out of bounds.
+LLVMValueRef build_list_index(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef list, LLVMValueRef index);
+
+// build_list_slice(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef, LLVMValueRef, LLVMValueRef) -> LLVMValueRef
+// Builds a copy of the elements of a list in the range [start, end), raising an error if the range is out of bounds.
+LLVMValueRef build_list_slice(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef list, LLVMValueRef start, LLVMValueRef end);
+
+// build_list_loop_start(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef) -> llvm_iter_loop_t
+// Starts a loop over the elements of a list, leaving the builder in the body of the loop.
+llvm_iter_loop_t build_list_loop_start(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef list);
+
+// build_iter_loop_end(llvm_codegen_env_t*, LLVMBuilderRef, llvm_iter_loop_t) -> void
+// Ends a loop over a list or generator, leaving the builder after the loop.
+void build_iter_loop_end(llvm_codegen_env_t* env, LLVMBuilderRef builder, llvm_iter_loop_t loop);
+
+#endif /* LLVM_LISTS_H */
@@ -8,6 +8,10 @@
 
 #include <string.h>
 
+#include "functions.h"
+#include "generators.h"
+#include "layouts.h"
+#include "lists.h"
 #include "llvm_types.h"
 
 // internal_type_to_llvm(llvm_codegen_env_t*, type_t*) -> LLVMTypeRef
@@ -21,6 +25,19 @@ LLVMTypeRef internal_type_to_llvm(llvm_codegen_env_t* env, type_t* type)
 	else if (type->type_type == IR_TYPES_PRIMITIVE && !strcmp(type->type_name, "Bool"))
 		return LLVMInt1Type();
 	else if (type->type_type == IR_TYPES_FUNC)
-		return LLVMGetTypeByName(env->header_mod, "func.app.type");
+		return function_value_type();
+	else if (type->type_type == IR_TYPES_LIST)
+	{
+		// Lists are {length, capacity, data*} with unboxed elements
+		LLVMTypeRef elem_type = type->field_count != 0 ? internal_type_to_llvm(env, type->field_types[0]) : LLVMInt64Type();
+		return list_type(elem_type);
+	}
+	else if (type->type_type == IR_TYPES_GENERATOR)
+		return generator_value_type();
+
+	// Products, unions, and enumerations are laid out compactly
+	else if (type->type_type == IR_TYPES_ENUMERATION || type->type_type == IR_TYPES_PRODUCT || type->type_type == IR_TYPES_UNION
+		|| type->type_type == IR_TYPES_INSTANCE)
+		return llvm_type_layout(env->layouts, type)->llvm_type;
 	else return LLVMVoidType();
 }
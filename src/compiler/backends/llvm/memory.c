@@ -0,0 +1,78 @@
+// 
+// llvm
+// memory.c: Implements helper functions for allocating memory in generated code.
+// 
+// Created by jenra.
+// Created on October 18 2026.
+// 
+
+#include "memory.h"
+
+// get_llvm_function(llvm_codegen_env_t*, char*, LLVMTypeRef) -> LLVMValueRef
+// Gets a function declared in the current module, declaring it if necessary.
+LLVMValueRef get_llvm_function(llvm_codegen_env_t* env, char* name, LLVMTypeRef type)
+{
+	LLVMModuleRef mod = LLVMGetGlobalParent(env->current_func);
+	LLVMValueRef func = LLVMGetNamedFunction(mod, name);
+	if (func == NULL)
+		func = LLVMAddFunction(mod, name, type);
+	return func;
+}
+
+// build_runtime_call(llvm_codegen_env_t*, LLVMBuilderRef, char*, LLVMTypeRef, LLVMTypeRef*, LLVMValueRef*, size_t) -> LLVMValueRef
+// Builds a call to a function in the runtime.
+LLVMValueRef build_runtime_call(llvm_codegen_env_t* env, LLVMBuilderRef builder, char* name, LLVMTypeRef ret_type, LLVMTypeRef* arg_types, LLVMValueRef* args, size_t arg_count)
+{
+	LLVMTypeRef type = LLVMFunctionType(ret_type, arg_types, arg_count, false);
+	return LLVMBuildCall2(builder, type, get_llvm_function(env, name, type), args, arg_count, "");
+}
+
+// build_malloc(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef) -> LLVMValueRef
+// Builds a heap allocation of the given size in bytes using the runtime allocator, returning an i8*.
+LLVMValueRef build_malloc(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef size)
+{
+	LLVMTypeRef type = LLVMFunctionType(LLVMPointerType(LLVMInt8Type(), 0), (LLVMTypeRef[]) {LLVMInt64Type()}, 1, false);
+	LLVMValueRef func = get_llvm_function(env, "curly_alloc", type);
+
+	// Fresh blocks don't alias anything else
+	LLVMContextRef context = LLVMGetModuleContext(LLVMGetGlobalParent(func));
+	unsigned noalias = LLVMGetEnumAttributeKindForName("noalias", 7);
+	LLVMAddAttributeAtIndex(func, LLVMAttributeReturnIndex, LLVMCreateEnumAttribute(context, noalias, 0));
+	return LLVMBuildCall2(builder, type, func, (LLVMValueRef[]) {size}, 1, "");
+}
+
+// build_realloc(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef, LLVMValueRef) -> LLVMValueRef
+// Builds a reallocation of an i8* to the given size in bytes using the runtime allocator.
+LLVMValueRef build_realloc(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef ptr, LLVMValueRef size)
+{
+	LLVMTypeRef i8_ptr = LLVMPointerType(LLVMInt8Type(), 0);
+	LLVMTypeRef type = LLVMFunctionType(i8_ptr, (LLVMTypeRef[]) {i8_ptr, LLVMInt64Type()}, 2, false);
+	LLVMValueRef func = get_llvm_function(env, "curly_alloc_realloc", type);
+	return LLVMBuildCall2(builder, type, func, (LLVMValueRef[]) {ptr, size}, 2, "");
+}
+
+// build_free(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef) -> void
+// Builds a deallocation of an i8* using the runtime allocator.
+void build_free(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef ptr)
+{
+	LLVMTypeRef type = LLVMFunctionType(LLVMVoidType(), (LLVMTypeRef[]) {LLVMPointerType(LLVMInt8Type(), 0)}, 1, false);
+	LLVMValueRef func = get_llvm_function(env, "curly_alloc_free", type);
+	LLVMBuildCall2(builder, type, func, (LLVMValueRef[]) {ptr}, 1, "");
+}
+
+// build_entry_alloca(llvm_codegen_env_t*, LLVMTypeRef, char*) -> LLVMValueRef
+// Builds a stack allocation in the entry block of the current function.
+LLVMValueRef build_entry_alloca(llvm_codegen_env_t* env, LLVMTypeRef type, char* name)
+{
+	// Allocas in the entry block are only done once per call, even when used in a loop
+	LLVMBuilderRef builder = LLVMCreateBuilder();
+	LLVMBasicBlockRef entry = LLVMGetEntryBasicBlock(env->current_func);
+	LLVMValueRef first = LLVMGetFirstInstruction(entry);
+	if (first != NULL)
+		LLVMPositionBuilderBefore(builder, first);
+	else LLVMPositionBuilderAtEnd(builder, entry);
+
+	LLVMValueRef alloca = LLVMBuildAlloca(builder, type, name);
+	LLVMDisposeBuilder(builder);
+	return alloca;
+}
@@ -0,0 +1,40 @@
+// 
+// llvm
+// memory.h: Header file for memory.c.
+// 
+// Created by jenra.
+// Created on October 18 2026.
+// 
+
+#ifndef LLVM_MEMORY_H
+#define LLVM_MEMORY_H
+
+#include <llvm-c/Core.h>
+
+#include "environment.h"
+
+// get_llvm_function(llvm_codegen_env_t*, char*, LLVMTypeRef) -> LLVMValueRef
+// Gets a function declared in the current module, declaring it if necessary.
+LLVMValueRef get_llvm_function(llvm_codegen_env_t* env, char* name, LLVMTypeRef type);
+
+// build_runtime_call(llvm_codegen_env_t*, LLVMBuilderRef, char*, LLVMTypeRef, LLVMTypeRef*, LLVMValueRef*, size_t) -> LLVMValueRef
+// Builds a call to a function in the runtime.
+LLVMValueRef build_runtime_call(llvm_codegen_env_t* env, LLVMBuilderRef builder, char* name, LLVMTypeRef ret_type, LLVMTypeRef* arg_types, LLVMValueRef* args, size_t arg_count);
+
+// build_malloc(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef) -> LLVMValueRef
+// Builds a heap allocation of the given size in bytes, returning an i8*.
+LLVMValueRef build_malloc(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef size);
+
+// build_realloc(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef, LLVMValueRef) -> LLVMValueRef
+// Builds a reallocation of an i8* to the given size in bytes.
+LLVMValueRef build_realloc(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef ptr, LLVMValueRef size);
+
+// build_free(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef) -> void
+// Builds a deallocation of an i8*.
+void build_free(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef ptr);
+
+// build_entry_alloca(llvm_codegen_env_t*, LLVMTypeRef, char*) -> LLVMValueRef
+// Builds a stack allocation in the entry block of the current function.
+LLVMValueRef build_entry_alloca(llvm_codegen_env_t* env, LLVMTypeRef type, char* name);
+
+#endif /* LLVM_MEMORY_H */
@@ -0,0 +1,200 @@
+// 
+// llvm
+// reference_counting.c: Implements reference counting operations on lists, generators and functions.
+// 
+// Created by jenra.
+// Created on October 18 2026.
+// 
+
+#include "functions.h"
+#include "generators.h"
+#include "lists.h"
+#include "memory.h"
+#include "reference_counting.h"
+
+// Reference counted objects are preceded by a curly_rc_header_t, so the count is two words before the payload.
+#define RC_COUNT_OFFSET -2
+
+// llvm_rc_type(LLVMTypeRef) -> bool
+// Returns whether values of an llvm type hold a reference counted object.
+bool llvm_rc_type(LLVMTypeRef type)
+{
+	return type == generator_value_type() || type == function_value_type() || is_list_type(type);
+}
+
+// build_rc_payload(LLVMBuilderRef, LLVMValueRef) -> LLVMValueRef
+// Returns the pointer to the reference counted object held by a value as an i8*.
+LLVMValueRef build_rc_payload(LLVMBuilderRef builder, LLVMValueRef value)
+{
+	// Lists hold their data, and generators and functions hold their environment
+	LLVMTypeRef type = LLVMTypeOf(value);
+	LLVMValueRef payload = LLVMBuildExtractValue(builder, value, is_list_type(type) ? 2 : 1, "rc.payload");
+	return LLVMBuildBitCast(builder, payload, LLVMPointerType(LLVMInt8Type(), 0), "");
+}
+
+// build_rc_count_ptr(LLVMBuilderRef, LLVMValueRef) -> LLVMValueRef
+// Returns a pointer to the reference count of an object.
+LLVMValueRef build_rc_count_ptr(LLVMBuilderRef builder, LLVMValueRef payload)
+{
+	LLVMValueRef words = LLVMBuildBitCast(builder, payload, LLVMPointerType(LLVMInt64Type(), 0), "");
+	return LLVMBuildGEP2(builder, LLVMInt64Type(), words, (LLVMValueRef[]) {LLVMConstInt(LLVMInt64Type(), RC_COUNT_OFFSET, true)}, 1, "rc.count.ptr");
+}
+
+// build_rc_alloc(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef, LLVMValueRef) -> LLVMValueRef
+// Builds an allocation of a reference counted object of the given size in bytes, returning an i8*. drop_func may be NULL.
+LLVMValueRef build_rc_alloc(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef size, LLVMValueRef drop_func)
+{
+	LLVMTypeRef i8_ptr = LLVMPointerType(LLVMInt8Type(), 0);
+	LLVMValueRef drop = drop_func != NULL ? LLVMBuildBitCast(builder, drop_func, i8_ptr, "") : LLVMConstNull(i8_ptr);
+	return build_runtime_call(env, builder, "curly_rc_alloc", i8_ptr, (LLVMTypeRef[]) {LLVMInt64Type(), i8_ptr}, (LLVMValueRef[]) {size, drop}, 2);
+}
+
+// build_rc_realloc(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef, LLVMValueRef) -> LLVMValueRef
+// Builds a reallocation of a uniquely referenced object to the given size in bytes.
+LLVMValueRef build_rc_realloc(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef ptr, LLVMValueRef size)
+{
+	LLVMTypeRef i8_ptr = LLVMPointerType(LLVMInt8Type(), 0);
+	return build_runtime_call(env, builder, "curly_rc_realloc", i8_ptr, (LLVMTypeRef[]) {i8_ptr, LLVMInt64Type()}, (LLVMValueRef[]) {ptr, size}, 2);
+}
+
+// build_rc_is_unique(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef) -> LLVMValueRef
+// Builds a check for whether a value holds the only reference to its object.
+LLVMValueRef build_rc_is_unique(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef value)
+{
+	// Null payloads (empty lists) are never unique
+	LLVMValueRef payload = build_rc_payload(builder, value);
+	LLVMBasicBlockRef from = env->current_block;
+	LLVMBasicBlockRef check_block = LLVMAppendBasicBlock(env->current_func, "rc.unique.check");
+	LLVMMoveBasicBlockAfter(check_block, from);
+	LLVMBasicBlockRef post_block = LLVMAppendBasicBlock(env->current_func, "rc.unique.post");
+	LLVMMoveBasicBlockAfter(post_block, check_block);
+	LLVMBuildCondBr(builder, LLVMBuildIsNull(builder, payload, ""), post_block, check_block);
+
+	// Check the count
+	LLVMPositionBuilderAtEnd(builder, check_block);
+	LLVMValueRef count = LLVMBuildLoad2(builder, LLVMInt64Type(), build_rc_count_ptr(builder, payload), "rc.count");
+	LLVMValueRef unique = LLVMBuildICmp(builder, LLVMIntEQ, count, LLVMConstInt(LLVMInt64Type(), 1, false), "");
+	LLVMBuildBr(builder, post_block);
+
+	// Merge the results
+	LLVMPositionBuilderAtEnd(builder, post_block);
+	env->current_block = post_block;
+	LLVMValueRef phi = LLVMBuildPhi(builder, LLVMInt1Type(), "rc.unique");
+	LLVMAddIncoming(phi, (LLVMValueRef[]) {LLVMConstInt(LLVMInt1Type(), 0, false), unique}, (LLVMBasicBlockRef[]) {from, check_block}, 2);
+	return phi;
+}
+
+// build_dup(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef) -> void
+// Builds an increment of the reference count of a value.
+void build_dup(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef value)
+{
+	// Create basic blocks to jump to
+	LLVMValueRef payload = build_rc_payload(builder, value);
+	LLVMBasicBlockRef inc_block = LLVMAppendBasicBlock(env->current_func, "rc.dup");
+	LLVMMoveBasicBlockAfter(inc_block, env->current_block);
+	LLVMBasicBlockRef post_block = LLVMAppendBasicBlock(env->current_func, "rc.dup.post");
+	LLVMMoveBasicBlockAfter(post_block, inc_block);
+
+	// Increment the count if there is an object
+	LLVMBuildCondBr(builder, LLVMBuildIsNull(builder, payload, ""), post_block, inc_block);
+	LLVMPositionBuilderAtEnd(builder, inc_block);
+	LLVMValueRef count_ptr = build_rc_count_ptr(builder, payload);
+	LLVMValueRef count = LLVMBuildLoad2(builder, LLVMInt64Type(), count_ptr, "rc.count");
+	LLVMBuildStore(builder, LLVMBuildAdd(builder, count, LLVMConstInt(LLVMInt64Type(), 1, false), ""), count_ptr);
+	LLVMBuildBr(builder, post_block);
+
+	LLVMPositionBuilderAtEnd(builder, post_block);
+	env->current_block = post_block;
+}
+
+// build_drop(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef) -> void
+// Builds a decrement of the reference count of a value, freeing it when it reaches zero.
+void build_drop(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef value)
+{
+	// Create basic blocks to jump to
+	LLVMTypeRef i8_ptr = LLVMPointerType(LLVMInt8Type(), 0);
+	LLVMValueRef payload = build_rc_payload(builder, value);
+	LLVMBasicBlockRef check_block = LLVMAppendBasicBlock(env->current_func, "rc.drop");
+	LLVMMoveBasicBlockAfter(check_block, env->current_block);
+	LLVMBasicBlockRef dec_block = LLVMAppendBasicBlock(env->current_func, "rc.drop.dec");
+	LLVMMoveBasicBlockAfter(dec_block, check_block);
+	LLVMBasicBlockRef free_block = LLVMAppendBasicBlock(env->current_func, "rc.drop.free");
+	LLVMMoveBasicBlockAfter(free_block, dec_block);
+	LLVMBasicBlockRef post_block = LLVMAppendBasicBlock(env->current_func, "rc.drop.post");
+	LLVMMoveBasicBlockAfter(post_block, free_block);
+
+	// Decrement the count if there is an object and it isn't the last reference
+	LLVMBuildCondBr(builder, LLVMBuildIsNull(builder, payload, ""), post_block, check_block);
+	LLVMPositionBuilderAtEnd(builder, check_block);
+	LLVMValueRef count_ptr = build_rc_count_ptr(builder, payload);
+	LLVMValueRef count = LLVMBuildLoad2(builder, LLVMInt64Type(), count_ptr, "rc.count");
+	LLVMValueRef last = LLVMBuildICmp(builder, LLVMIntEQ, count, LLVMConstInt(LLVMInt64Type(), 1, false), "");
+	LLVMBuildCondBr(builder, last, free_block, dec_block);
+	LLVMPositionBuilderAtEnd(builder, dec_block);
+	LLVMBuildStore(builder, LLVMBuildSub(builder, count, LLVMConstInt(LLVMInt64Type(), 1, false), ""), count_ptr);
+	LLVMBuildBr(builder, post_block);
+
+	// Lists own their elements, so they are dropped before the list is freed
+	LLVMPositionBuilderAtEnd(builder, free_block);
+	env->current_block = free_block;
+	LLVMTypeRef type = LLVMTypeOf(value);
+	if (is_list_type(type) && llvm_rc_type(LLVMGetElementType(LLVMStructGetTypeAtIndex(type, 2))))
+	{
+		llvm_iter_loop_t loop = build_list_loop_start(env, builder, value);
+		build_drop(env, builder, loop.element);
+		build_iter_loop_end(env, builder, loop);
+	}
+
+	// Free the object
+	build_runtime_call(env, builder, "curly_rc_free", LLVMVoidType(), (LLVMTypeRef[]) {i8_ptr}, (LLVMValueRef[]) {payload}, 1);
+	LLVMBuildBr(builder, post_block);
+	LLVMPositionBuilderAtEnd(builder, post_block);
+	env->current_block = post_block;
+}
+
+// build_drop_fields_function(llvm_codegen_env_t*, LLVMTypeRef, char*) -> LLVMValueRef
+// Builds a function that drops every reference counted field of the struct its i8* argument points to, or returns NULL if there are none.
+LLVMValueRef build_drop_fields_function(llvm_codegen_env_t* env, LLVMTypeRef struct_type, char* name)
+{
+	// Objects without references don't need a drop function
+	size_t count = LLVMCountStructElementTypes(struct_type);
+	bool has_rc = false;
+	for (size_t i = 0; i < count; i++)
+	{
+		has_rc = has_rc || llvm_rc_type(LLVMStructGetTypeAtIndex(struct_type, i));
+	}
+	if (!has_rc)
+		return NULL;
+
+	// Create the function
+	LLVMTypeRef i8_ptr = LLVMPointerType(LLVMInt8Type(), 0);
+	LLVMTypeRef func_type = LLVMFunctionType(LLVMVoidType(), (LLVMTypeRef[]) {i8_ptr}, 1, false);
+	LLVMValueRef func = LLVMAddFunction(LLVMGetGlobalParent(env->current_func), name, func_type);
+	LLVMSetLinkage(func, LLVMInternalLinkage);
+
+	// Save state and create a builder for the function
+	LLVMValueRef last_func = env->current_func;
+	LLVMBasicBlockRef last_block = env->current_block;
+	LLVMBuilderRef builder = LLVMCreateBuilder();
+	env->current_func = func;
+	env->current_block = LLVMAppendBasicBlock(func, "entry");
+	LLVMPositionBuilderAtEnd(builder, env->current_block);
+
+	// Drop every reference counted field
+	LLVMValueRef ptr = LLVMBuildBitCast(builder, LLVMGetParam(func, 0), LLVMPointerType(struct_type, 0), "");
+	for (size_t i = 0; i < count; i++)
+	{
+		LLVMTypeRef field_type = LLVMStructGetTypeAtIndex(struct_type, i);
+		if (!llvm_rc_type(field_type))
+			continue;
+		LLVMValueRef field = LLVMBuildLoad2(builder, field_type, LLVMBuildStructGEP2(builder, struct_type, ptr, i, ""), "");
+		build_drop(env, builder, field);
+	}
+	LLVMBuildRetVoid(builder);
+
+	// Restore state
+	LLVMDisposeBuilder(builder);
+	env->current_func = last_func;
+	env->current_block = last_block;
+	return func;
+}
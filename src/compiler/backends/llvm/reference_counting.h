@@ -0,0 +1,44 @@
+// 
+// llvm
+// reference_counting.h: Header file for reference_counting.c.
+// 
+// Created by jenra.
+// Created on October 18 2026.
+// 
+
+#ifndef LLVM_REFERENCE_COUNTING_H
+#define LLVM_REFERENCE_COUNTING_H
+
+#include <llvm-c/Core.h>
+
+#include "environment.h"
+
+// llvm_rc_type(LLVMTypeRef) -> bool
+// Returns whether values of an llvm type hold a reference counted object.
+bool llvm_rc_type(LLVMTypeRef type);
+
+// build_rc_alloc(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef, LLVMValueRef) -> LLVMValueRef
+// Builds an allocation of a reference counted object of the given size in bytes, returning an i8*. drop_func may be NULL.
+LLVMValueRef build_rc_alloc(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef size, LLVMValueRef drop_func);
+
+// build_rc_realloc(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef, LLVMValueRef) -> LLVMValueRef
+// Builds a reallocation of a uniquely referenced object to the given size in bytes.
+LLVMValueRef build_rc_realloc(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef ptr, LLVMValueRef size);
+
+// build_rc_is_unique(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef) -> LLVMValueRef
+// Builds a check for whether a value holds the only reference to its object.
+LLVMValueRef build_rc_is_unique(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef value);
+
+// build_dup(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef) -> void
+// Builds an increment of the reference count of a value.
+void build_dup(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef value);
+
+// build_drop(llvm_codegen_env_t*, LLVMBuilderRef, LLVMValueRef) -> void
+// Builds a decrement of the reference count of a value, freeing it when it reaches zero.
+void build_drop(llvm_codegen_env_t* env, LLVMBuilderRef builder, LLVMValueRef value);
+
+// build_drop_fields_function(llvm_codegen_env_t*, LLVMTypeRef, char*) -> LLVMValueRef
+// Builds a function that drops every reference counted field of the struct its i8* argument points to, or returns NULL if there are none.
+LLVMValueRef build_drop_fields_function(llvm_codegen_env_t* env, LLVMTypeRef struct_type, char* name);
+
+#endif /* LLVM_REFERENCE_COUNTING_H */
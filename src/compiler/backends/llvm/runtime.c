@@ -0,0 +1,36 @@
+// 
+// llvm
+// runtime.c: Makes the runtime available to jitted code.
+// 
+// Created by jenra.
+// Created on October 18 2026.
+// 
+
+#include <llvm-c/Support.h>
+
+#include "../../../runtime/alloc.h"
+#include "../../../runtime/errors.h"
+#include "../../../runtime/memo.h"
+#include "../../../runtime/rc.h"
+#include "runtime.h"
+
+// register_llvm_runtime(void) -> void
+// Registers the functions of the runtime so that jitted code can call them.
+void register_llvm_runtime()
+{
+	LLVMAddSymbol("curly_alloc", curly_alloc);
+	LLVMAddSymbol("curly_alloc_realloc", curly_alloc_realloc);
+	LLVMAddSymbol("curly_alloc_free", curly_alloc_free);
+	LLVMAddSymbol("curly_error_index", curly_error_index);
+	LLVMAddSymbol("curly_error_slice", curly_error_slice);
+	LLVMAddSymbol("curly_memo_new", curly_memo_new);
+	LLVMAddSymbol("curly_memo_get", curly_memo_get);
+	LLVMAddSymbol("curly_memo_push", curly_memo_push);
+	LLVMAddSymbol("curly_memo_source", curly_memo_source);
+	LLVMAddSymbol("curly_memo_set_source", curly_memo_set_source);
+	LLVMAddSymbol("curly_memo_finish", curly_memo_finish);
+	LLVMAddSymbol("curly_memo_del", curly_memo_del);
+	LLVMAddSymbol("curly_rc_alloc", curly_rc_alloc);
+	LLVMAddSymbol("curly_rc_realloc", curly_rc_realloc);
+	LLVMAddSymbol("curly_rc_free", curly_rc_free);
+}
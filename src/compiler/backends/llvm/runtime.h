@@ -0,0 +1,16 @@
+// 
+// llvm
+// runtime.h: Header file for runtime.c.
+// 
+// Created by jenra.
+// Created on October 18 2026.
+// 
+
+#ifndef LLVM_RUNTIME_H
+#define LLVM_RUNTIME_H
+
+// register_llvm_runtime(void) -> void
+// Registers the functions of the runtime so that jitted code can call them.
+void register_llvm_runtime();
+
+#endif /* LLVM_RUNTIME_H */
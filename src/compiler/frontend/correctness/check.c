@@ -11,11 +11,28 @@
 
 #include "../../../utils/list.h"
 #include "check.h"
+#include "dependencies.h"
+#include "infer.h"
+#include "parallel.h"
 #include "type_generators.h"
 
-// check_correctness_helper(ast_t*, ir_scope_t* /*, bool, bool*/) -> void
+// iterator_type(type_t*, ir_scope_t*) -> type_t*
+// Returns the type of an operand that should be iterable, making it a list if it isn't known yet.
+type_t* iterator_type(type_t* type, ir_scope_t* scope)
+{
+	type = find_type(type);
+	if (type->type_type == IR_TYPES_VAR)
+	{
+		type_t* list = make_type(IR_TYPES_LIST, NULL, 1, (type_t*[]) {new_type_var(scope->level)}, NULL);
+		unify_types(type, list);
+		type = list;
+	}
+	return type;
+}
+
+// check_correctness_helper(ir_sexpr_t*, ir_scope_t*, curly_ir_t*) -> bool
 // Helper function for check_correctness.
-bool check_correctness_helper(ir_sexpr_t* sexpr, ir_scope_t* scope /*, bool get_real_type, bool disable_new_vars*/)
+bool check_correctness_helper(ir_sexpr_t* sexpr, ir_scope_t* scope, curly_ir_t* ir)
 {
 	// Match the sum type
 	switch (sexpr->tag)
@@ -30,86 +47,171 @@ bool check_correctness_helper(ir_sexpr_t* sexpr, ir_scope_t* scope /*, bool get_
 			sexpr->type = scope_lookup_type(scope, "Bool");
 			return true;
 		case CURLY_IR_TAGS_SYMBOL:
-			// Get type from variable list
-			sexpr->type = scope_lookup_var_type(scope, sexpr->symbol);
+			// Get type from the variable the symbol refers to
+			sexpr->type = scope_var(scope, sexpr->binding)->type;
 
 			// If variable isn't found, report an error
 			if (sexpr->type == NULL)
+			{
 				printf("Undeclared variable %s found at %i:%i\n", sexpr->symbol, sexpr->lino, sexpr->charpos);
-			return sexpr->type != NULL;
+				return false;
+			}
+
+			// Every use of a generic variable gets its own type variables
+			sexpr->type = instantiate_type(sexpr->type, scope->level);
+			return true;
 
 		case CURLY_IR_TAGS_ASSIGN:
-			// Check value
-			if (!check_correctness_helper(sexpr->assign.value, scope))
+		{
+			// New variables start with their declared type, and functions can refer to themselves, so they start with an unknown type
+			ir_var_t* var = scope_var(scope, sexpr->assign.binding);
+			bool fresh = var->type == NULL;
+			if (fresh && sexpr->type != NULL)
+				var->type = sexpr->type;
+			else if (fresh && sexpr->assign.value->tag == CURLY_IR_TAGS_FUNC)
+				var->type = new_type_var(scope->level + 1);
+
+			// Check value one let level deeper so that its type can be generalised
+			scope->level++;
+			bool valid = check_correctness_helper(sexpr->assign.value, scope, ir);
+			scope->level--;
+			var = scope_var(scope, sexpr->assign.binding);
+			if (!valid)
+			{
+				if (fresh)
+					var->type = NULL;
 				return false;
+			}
 
 			// Check type doesn't change on reassignment
-			type_t* type = map_get(scope->var_types, sexpr->assign.name);
-			if (type != NULL && !type_subtype(type, sexpr->assign.value->type))
+			type_t* type = var->type;
+			if (type != NULL && !unify_subtype(fresh ? type : instantiate_type(type, scope->level + 1), sexpr->assign.value->type))
 			{
 				printf("Assigning incompatible type to %s found at %i:%i\n", sexpr->assign.name, sexpr->lino, sexpr->charpos);
+				if (fresh)
+					var->type = NULL;
 				return false;
 			} else sexpr->type = type;
 
-			// Assert the type is empty or matches
-			if (sexpr->type == NULL)
+			// New variables take the type of their value, and so do generic variables, since the value is only valid at its own type
+			if (sexpr->type == NULL || sexpr->type->has_vars)
 				sexpr->type = sexpr->assign.value->type;
-			else if (!type_subtype(sexpr->type, sexpr->assign.value->type))
-			{
-				printf("Assigning incompatible type to %s found at %i:%i\n", sexpr->assign.name, sexpr->lino, sexpr->charpos);
-				return false;
-			}
+
+			// Make the type variables only the value constrains generic (only functions, since they're the only values that can
+			// be specialised for every type they're used at)
+			if (sexpr->assign.value->tag == CURLY_IR_TAGS_FUNC)
+				generalise_type(sexpr->type, scope->level);
+			sexpr->type = resolve_type(sexpr->type);
 
 			// Add the value and return
-			map_add(scope->var_types, sexpr->assign.name, sexpr->type);
-			map_add(scope->var_vals, sexpr->assign.name, sexpr->assign.value);
+			*var = (ir_var_t) {sexpr->type, sexpr->assign.value};
 			return true;
+		}
 
 		case CURLY_IR_TAGS_DECLARE:
-			map_add(scope->var_types, sexpr->declare.name, sexpr->type);
+			*scope_var(scope, sexpr->declare.binding) = (ir_var_t) {sexpr->type, NULL};
 			return true;
 
-		case CURLY_IR_TAGS_LOCAL_SCOPE:
-			// Create a new scope
-			scope = push_scope(scope);
+		case CURLY_IR_TAGS_FUNC:
+		{
+			// Arguments without a declared type get a type variable
+			ir_sexpr_func_t* func = ir->funcs[sexpr->func_id];
+			for (size_t i = 0; i < func->arg_count; i++)
+			{
+				if (func->args[i].type == NULL)
+					func->args[i].type = new_type_var(scope->level);
+				*scope_var(scope, func->args[i].binding) = (ir_var_t) {func->args[i].type, NULL};
+			}
+
+			// Check the body
+			if (!check_correctness_helper(func->body, scope, ir))
+				return false;
+
+			// Create the curried function type and forget the arguments
+			sexpr->type = func->body->type;
+			for (size_t i = func->arg_count; i > 0; i--)
+			{
+				sexpr->type = make_type(IR_TYPES_FUNC, NULL, 2, (type_t*[]) {func->args[i - 1].type, sexpr->type}, NULL);
+				*scope_var(scope, func->args[i - 1].binding) = (ir_var_t) {NULL, NULL};
+			}
+			return true;
+		}
+
+		case CURLY_IR_TAGS_APPLY:
+		{
+			// Check the function and argument
+			if (!check_correctness_helper(sexpr->apply.func, scope, ir))
+				return false;
+			if (!check_correctness_helper(sexpr->apply.arg, scope, ir))
+				return false;
+
+			// Functions of unknown type get a function type
+			type_t* func_type = find_type(sexpr->apply.func->type);
+			if (func_type->type_type == IR_TYPES_VAR)
+			{
+				type_t* fresh = make_type(IR_TYPES_FUNC, NULL, 2, (type_t*[]) {new_type_var(scope->level), new_type_var(scope->level)}, NULL);
+				unify_types(func_type, fresh);
+				func_type = fresh;
+			}
+
+			// Assert a function is applied to an argument it accepts
+			if (func_type->type_type != IR_TYPES_FUNC)
+			{
+				printf("Applying a nonfunction found at %i:%i\n", sexpr->apply.func->lino, sexpr->apply.func->charpos);
+				return false;
+			} else if (!unify_subtype(func_type->field_types[0], sexpr->apply.arg->type))
+			{
+				printf("Mismatched argument type found at %i:%i\n", sexpr->apply.arg->lino, sexpr->apply.arg->charpos);
+				return false;
+			}
+
+			// The result is the function's return type
+			sexpr->type = func_type->field_types[1];
+			return true;
+		}
 
+		case CURLY_IR_TAGS_LOCAL_SCOPE:
 			// Deal with assignments
 			for (size_t i = 0; i < sexpr->local_scope.assign_count; i++)
 			{
-				if (!check_correctness_helper(sexpr->local_scope.assigns[i], scope))
+				if (!check_correctness_helper(sexpr->local_scope.assigns[i], scope, ir))
 					return false;
 			}
 
 			// Deal with the expression
-			if (!check_correctness_helper(sexpr->local_scope.value, scope))
+			if (!check_correctness_helper(sexpr->local_scope.value, scope, ir))
 				return false;
 
-			// Pop scope and set the type
-			scope = pop_scope(scope);
+			// Forget the locals so that their slots can be reused and set the type
+			for (size_t i = 0; i < sexpr->local_scope.assign_count; i++)
+			{
+				ir_sexpr_t* assign = sexpr->local_scope.assigns[i];
+				*scope_var(scope, assign->tag == CURLY_IR_TAGS_ASSIGN ? assign->assign.binding : assign->declare.binding) = (ir_var_t) {NULL, NULL};
+			}
 			sexpr->type = sexpr->local_scope.value->type;
 			return true;
 
 		case CURLY_IR_TAGS_IF:
 			// Check that the condition is a boolean
-			if (!check_correctness_helper(sexpr->if_expr.cond, scope))
+			if (!check_correctness_helper(sexpr->if_expr.cond, scope, ir))
 				return false;
-			if (!types_equal(sexpr->if_expr.cond->type, scope_lookup_type(scope, "Bool")))
+			if (!unify_types(sexpr->if_expr.cond->type, scope_lookup_type(scope, "Bool")))
 			{
 				printf("Nonboolean condition found at %i:%i\n", sexpr->if_expr.cond->lino, sexpr->if_expr.cond->charpos);
 				return false;
 			}
 
 			// Check the then clause
-			if (!check_correctness_helper(sexpr->if_expr.then, scope))
+			if (!check_correctness_helper(sexpr->if_expr.then, scope, ir))
 				return false;
 			sexpr->type = sexpr->if_expr.then->type;
 
 			// Check the else clause
-			if (!check_correctness_helper(sexpr->if_expr.elsy, scope))
+			if (!check_correctness_helper(sexpr->if_expr.elsy, scope, ir))
 				return false;
 
 			// Else clause should have the same type as the body
-			if (!types_equal(sexpr->type, sexpr->if_expr.elsy->type))
+			if (!unify_types(sexpr->type, sexpr->if_expr.elsy->type))
 			{
 				printf("If statement with different types for bodies at %i:%i\n", sexpr->lino, sexpr->charpos);
 				return false;
@@ -123,25 +225,51 @@ bool check_correctness_helper(ir_sexpr_t* sexpr, ir_scope_t* scope /*, bool get_
 			{
 				case IR_BINOPS_CMPIN:
 					// Check the operands
-					if (!check_correctness_helper(sexpr->infix.right, scope))
+					if (!check_correctness_helper(sexpr->infix.left, scope, ir))
+						return false;
+					if (!check_correctness_helper(sexpr->infix.right, scope, ir))
 						return false;
 
 					// Assert that the second operand is an iterator
-					if (sexpr->infix.right->type->type_type != IR_TYPES_LIST && sexpr->infix.right->type->type_type != IR_TYPES_GENERATOR)
+					type_t* iter_type = iterator_type(sexpr->infix.right->type, scope);
+					if (iter_type->type_type != IR_TYPES_LIST && iter_type->type_type != IR_TYPES_GENERATOR)
 					{
 						printf("Noniterator used in in expression found at %i:%i\n", sexpr->infix.right->lino, sexpr->infix.right->charpos);
 						return false;
 					}
 
 					// Assert the type makes sense
-					if (!types_equal(sexpr->infix.left->type, sexpr->infix.right->type->field_types[0]))
+					if (iter_type->field_count != 0 && !unify_types(sexpr->infix.left->type, iter_type->field_types[0]))
 					{
-						printf("Mismatched types found at %i:%i", sexpr->lino, sexpr->charpos);
+						printf("Mismatched types found at %i:%i\n", sexpr->lino, sexpr->charpos);
 						return false;
 					}
 					sexpr->type = scope_lookup_type(scope, "Bool");
 					return true;
 
+				case IR_BINOPS_INDEX:
+					// Check the operands
+					if (!check_correctness_helper(sexpr->infix.left, scope, ir))
+						return false;
+					if (!check_correctness_helper(sexpr->infix.right, scope, ir))
+						return false;
+
+					// Assert that a nonempty list is indexed by an integer
+					type_t* list_type = iterator_type(sexpr->infix.left->type, scope);
+					if (list_type->type_type != IR_TYPES_LIST || list_type->field_count == 0)
+					{
+						printf("Indexing a nonlist found at %i:%i\n", sexpr->infix.left->lino, sexpr->infix.left->charpos);
+						return false;
+					} else if (!unify_types(sexpr->infix.right->type, scope_lookup_type(scope, "Int")))
+					{
+						printf("Noninteger index found at %i:%i\n", sexpr->infix.right->lino, sexpr->infix.right->charpos);
+						return false;
+					}
+
+					// Set the type to the element type and return success
+					sexpr->type = list_type->field_types[0];
+					return true;
+
 				case IR_BINOPS_CMPEQ:
 				case IR_BINOPS_CMPNEQ:
 				case IR_BINOPS_CMPGT:
@@ -149,11 +277,15 @@ bool check_correctness_helper(ir_sexpr_t* sexpr, ir_scope_t* scope /*, bool get_
 				case IR_BINOPS_CMPLT:
 				case IR_BINOPS_CMPLTE:
 					// Check the operands
-					if (!check_correctness_helper(sexpr->infix.left, scope))
+					if (!check_correctness_helper(sexpr->infix.left, scope, ir))
 						return false;
-					if (!check_correctness_helper(sexpr->infix.right, scope))
+					if (!check_correctness_helper(sexpr->infix.right, scope, ir))
 						return false;
 
+					// Operands of unknown type must have the same type as the other operand
+					if (find_type(sexpr->infix.left->type)->type_type == IR_TYPES_VAR || find_type(sexpr->infix.right->type)->type_type == IR_TYPES_VAR)
+						unify_types(sexpr->infix.left->type, sexpr->infix.right->type);
+
 					// Set the type of the s expression to bool and return success
 					sexpr->type = scope_lookup_type(scope, "Bool");
 					return true;
@@ -163,18 +295,18 @@ bool check_correctness_helper(ir_sexpr_t* sexpr, ir_scope_t* scope /*, bool get_
 				case IR_BINOPS_BOOLXOR:
 				{
 					// Check the operands
-					if (!check_correctness_helper(sexpr->infix.left, scope))
+					if (!check_correctness_helper(sexpr->infix.left, scope, ir))
 						return false;
-					if (!check_correctness_helper(sexpr->infix.right, scope))
+					if (!check_correctness_helper(sexpr->infix.right, scope, ir))
 						return false;
 
 					// Assert that both operands are booleans
 					type_t* boolean = scope_lookup_type(scope, "Bool");
-					if (!types_equal(sexpr->infix.left->type, boolean))
+					if (!unify_types(sexpr->infix.left->type, boolean))
 					{
 						printf("Nonboolean used for logical expression found at %i:%i\n", sexpr->infix.left->lino, sexpr->infix.left->charpos);
 						return false;
-					} else if (!types_equal(sexpr->infix.right->type, boolean))
+					} else if (!unify_types(sexpr->infix.right->type, boolean))
 					{
 						printf("Nonboolean used for logical expression found at %i:%i\n", sexpr->infix.right->lino, sexpr->infix.right->charpos);
 						return false;
@@ -187,18 +319,36 @@ bool check_correctness_helper(ir_sexpr_t* sexpr, ir_scope_t* scope /*, bool get_
 
 				default:
 					// Check the operands
-					if (!check_correctness_helper(sexpr->infix.left, scope))
+					if (!check_correctness_helper(sexpr->infix.left, scope, ir))
 						return false;
-					if (!check_correctness_helper(sexpr->infix.right, scope))
+					if (!check_correctness_helper(sexpr->infix.right, scope, ir))
 						return false;
 
+					// Operands of unknown type take the type of the other operand, or Int if both are unknown
+					type_t* left = find_type(sexpr->infix.left->type);
+					type_t* right = find_type(sexpr->infix.right->type);
+					if (left->type_type == IR_TYPES_VAR && right->type_type == IR_TYPES_VAR)
+						unify_types(left, scope_lookup_type(scope, "Int"));
+					if (left->type_type == IR_TYPES_VAR)
+						unify_types(left, right);
+					else if (right->type_type == IR_TYPES_VAR)
+						unify_types(right, left);
+					left = find_type(left);
+					right = find_type(right);
+
+					// Reuse the resolution from the last check of this expression if the operand types haven't changed
+					if (sexpr->type != NULL && sexpr->infix.resolved_left == left && sexpr->infix.resolved_right == right)
+						return true;
+
 					// Find the type of the resulting infix expression
-					sexpr->type = scope_lookup_infix(scope, sexpr->infix.op, sexpr->infix.left->type, sexpr->infix.right->type);
+					sexpr->type = scope_lookup_infix(scope, sexpr->infix.op, left, right);
 					if (sexpr->type == NULL)
 					{
 						printf("Undefined infix operator found at %i:%i\n", sexpr->lino, sexpr->charpos);
 						return false;
 					}
+					sexpr->infix.resolved_left = left;
+					sexpr->infix.resolved_right = right;
 					return true;
 			}
 
@@ -207,76 +357,302 @@ bool check_correctness_helper(ir_sexpr_t* sexpr, ir_scope_t* scope /*, bool get_
 			{
 				case IR_BINOPS_SPAN:
 					// Check the child node
-					if (!check_correctness_helper(sexpr->prefix.operand, scope))
+					if (!check_correctness_helper(sexpr->prefix.operand, scope, ir))
 						return false;
 
 					// Assert the type is a list or generator
-					if (sexpr->prefix.operand->type->type_type != IR_TYPES_PRODUCT)
+					type_t* operand = find_type(sexpr->prefix.operand->type);
+					if (operand->type_type != IR_TYPES_PRODUCT)
 					{
 						printf("Curry on invalid operand found at %i:%i\n", sexpr->lino, sexpr->charpos);
 						return false;
 					}
 
 					// Create the type and return success
-					sexpr->type = init_type(IR_TYPES_CURRY, NULL, sexpr->prefix.operand->type->field_count);
-					for (size_t i = 0; i < sexpr->type->field_count; i++)
-					{
-						sexpr->type->field_types[i] = sexpr->prefix.operand->type->field_types[i];
-					}
+					sexpr->type = make_type(IR_TYPES_CURRY, NULL, operand->field_count, operand->field_types, NULL);
 					return true;
 				case IR_BINOPS_NEG:
 					// Check the operand
-					if (!check_correctness_helper(sexpr->prefix.operand, scope))
+					if (!check_correctness_helper(sexpr->prefix.operand, scope, ir))
 						return false;
 
+					// Operands of unknown type are integers
+					operand = find_type(sexpr->prefix.operand->type);
+					if (operand->type_type == IR_TYPES_VAR)
+					{
+						unify_types(operand, scope_lookup_type(scope, "Int"));
+						operand = find_type(operand);
+					}
+
+					// Reuse the resolution from the last check of this expression if the operand type hasn't changed
+					if (sexpr->type != NULL && sexpr->prefix.resolved_operand == operand)
+						return true;
+
 					// Find the type of the resulting prefix expression
-					sexpr->type = scope_lookup_prefix(scope, sexpr->prefix.operand->type);
+					sexpr->type = scope_lookup_prefix(scope, operand);
 					if (sexpr->type == NULL)
 					{
 						printf("Negative sign on invalid operand found at %i:%i\n", sexpr->lino, sexpr->charpos);
 						return false;
 					}
+					sexpr->prefix.resolved_operand = operand;
 					return true;
 				default:
 					printf("Unsupported prefix operator found at %i:%i\n", sexpr->lino, sexpr->charpos);
 					return false;
 			}
 
+		case CURLY_IR_TAGS_LIST:
+		{
+			// Check the elements
+			type_t* elem_type = NULL;
+			for (size_t i = 0; i < sexpr->list.element_count; i++)
+			{
+				ir_sexpr_t* elem = sexpr->list.elements[i];
+				if (!check_correctness_helper(elem, scope, ir))
+					return false;
+
+				// Every element must have the same type
+				if (elem_type == NULL)
+					elem_type = elem->type;
+				else if (!unify_types(elem_type, elem->type))
+				{
+					printf("List element of mismatched type found at %i:%i\n", elem->lino, elem->charpos);
+					return false;
+				}
+			}
+
+			// Create the type and return success (empty lists have no fields)
+			sexpr->type = make_type(IR_TYPES_LIST, NULL, elem_type != NULL, &elem_type, NULL);
+			return true;
+		}
+
+		case CURLY_IR_TAGS_SLICE:
+		{
+			// Check the operands
+			if (!check_correctness_helper(sexpr->slice.list, scope, ir))
+				return false;
+			if (!check_correctness_helper(sexpr->slice.start, scope, ir))
+				return false;
+			if (!check_correctness_helper(sexpr->slice.end, scope, ir))
+				return false;
+
+			// Assert that a list is sliced by an integer range
+			type_t* integer = scope_lookup_type(scope, "Int");
+			type_t* list_type = iterator_type(sexpr->slice.list->type, scope);
+			if (list_type->type_type != IR_TYPES_LIST)
+			{
+				printf("Slicing a nonlist found at %i:%i\n", sexpr->slice.list->lino, sexpr->slice.list->charpos);
+				return false;
+			} else if (!unify_types(sexpr->slice.start->type, integer) || !unify_types(sexpr->slice.end->type, integer))
+			{
+				printf("Noninteger slice bounds found at %i:%i\n", sexpr->lino, sexpr->charpos);
+				return false;
+			}
+
+			// Slices have the same type as the list
+			sexpr->type = list_type;
+			return true;
+		}
+
+		case CURLY_IR_TAGS_FOR:
+		{
+			// Check the iterator
+			if (!check_correctness_helper(sexpr->for_loop.iter, scope, ir))
+				return false;
+
+			// Assert that the iterator is a nonempty list or a generator
+			type_t* iter_type = iterator_type(sexpr->for_loop.iter->type, scope);
+			if ((iter_type->type_type != IR_TYPES_LIST && iter_type->type_type != IR_TYPES_GENERATOR) || iter_type->field_count == 0)
+			{
+				printf("Noniterator used in for loop found at %i:%i\n", sexpr->for_loop.iter->lino, sexpr->for_loop.iter->charpos);
+				return false;
+			}
+
+			// Check the body with the loop variable in scope
+			*scope_var(scope, sexpr->for_loop.var_binding) = (ir_var_t) {iter_type->field_types[0], NULL};
+			if (!check_correctness_helper(sexpr->for_loop.body, scope, ir))
+				return false;
+			*scope_var(scope, sexpr->for_loop.var_binding) = (ir_var_t) {NULL, NULL};
+
+			// Comprehensions create a list or generator of the body's type
+			type_t* body_type = sexpr->for_loop.body->type;
+			type_t* boolean = scope_lookup_type(scope, "Bool");
+			switch (sexpr->for_loop.loop_type)
+			{
+				case IR_LOOP_LIST:
+				case IR_LOOP_GENERATOR:
+					sexpr->type = make_type(sexpr->for_loop.loop_type == IR_LOOP_LIST ? IR_TYPES_LIST : IR_TYPES_GENERATOR, NULL, 1, &body_type, NULL);
+					return true;
+
+				case IR_LOOP_WHERE:
+					// Where expressions filter the iterator
+					sexpr->type = make_type(IR_TYPES_GENERATOR, NULL, 1, iter_type->field_types, NULL);
+					break;
+
+				default:
+					// Quantifiers return a boolean
+					sexpr->type = boolean;
+					break;
+			}
+
+			// Predicates must have a boolean body
+			if (!unify_types(body_type, boolean))
+			{
+				printf("Nonboolean predicate found at %i:%i\n", sexpr->for_loop.body->lino, sexpr->for_loop.body->charpos);
+				return false;
+			}
+			return true;
+		}
+
+		case CURLY_IR_TAGS_RANGE:
+		{
+			// Check the bounds
+			type_t* integer = scope_lookup_type(scope, "Int");
+			if (!check_correctness_helper(sexpr->range.start, scope, ir))
+				return false;
+			if (sexpr->range.end != NULL && !check_correctness_helper(sexpr->range.end, scope, ir))
+				return false;
+
+			// Assert the bounds are integers
+			if (!unify_types(sexpr->range.start->type, integer) || (sexpr->range.end != NULL && !unify_types(sexpr->range.end->type, integer)))
+			{
+				printf("Noninteger range bounds found at %i:%i\n", sexpr->lino, sexpr->charpos);
+				return false;
+			}
+
+			// Ranges are generators of integers
+			sexpr->type = make_type(IR_TYPES_GENERATOR, NULL, 1, &integer, NULL);
+			return true;
+		}
+
 		default:
 			printf("Unsupported s expression found at %i:%i\n", sexpr->lino, sexpr->charpos);
 			return false;
 	}
 }
 
-// check_correctness(curly_ir_t, ir_scope_t*) -> void
-// Checks the correctness of IR.
-bool check_correctness(curly_ir_t ir, ir_scope_t* scope)
+// resolve_sexpr_types(ir_sexpr_t*, curly_ir_t*) -> void
+// Replaces the bound type variables in the types of an S expression and its children with the types they stand for.
+void resolve_sexpr_types(ir_sexpr_t* sexpr, curly_ir_t* ir)
+{
+	sexpr->type = resolve_type(sexpr->type);
+	switch (sexpr->tag)
+	{
+		case CURLY_IR_TAGS_INFIX:
+			resolve_sexpr_types(sexpr->infix.left, ir);
+			resolve_sexpr_types(sexpr->infix.right, ir);
+			break;
+		case CURLY_IR_TAGS_PREFIX:
+			resolve_sexpr_types(sexpr->prefix.operand, ir);
+			break;
+		case CURLY_IR_TAGS_APPLY:
+			resolve_sexpr_types(sexpr->apply.func, ir);
+			resolve_sexpr_types(sexpr->apply.arg, ir);
+			break;
+		case CURLY_IR_TAGS_ASSIGN:
+			resolve_sexpr_types(sexpr->assign.value, ir);
+			break;
+		case CURLY_IR_TAGS_FUNC:
+		{
+			ir_sexpr_func_t* func = ir->funcs[sexpr->func_id];
+			for (size_t i = 0; i < func->arg_count; i++)
+			{
+				func->args[i].type = resolve_type(func->args[i].type);
+			}
+			resolve_sexpr_types(func->body, ir);
+			break;
+		}
+		case CURLY_IR_TAGS_LOCAL_SCOPE:
+			for (size_t i = 0; i < sexpr->local_scope.assign_count; i++)
+			{
+				resolve_sexpr_types(sexpr->local_scope.assigns[i], ir);
+			}
+			resolve_sexpr_types(sexpr->local_scope.value, ir);
+			break;
+		case CURLY_IR_TAGS_IF:
+			resolve_sexpr_types(sexpr->if_expr.cond, ir);
+			resolve_sexpr_types(sexpr->if_expr.then, ir);
+			resolve_sexpr_types(sexpr->if_expr.elsy, ir);
+			break;
+		case CURLY_IR_TAGS_LIST:
+			for (size_t i = 0; i < sexpr->list.element_count; i++)
+			{
+				resolve_sexpr_types(sexpr->list.elements[i], ir);
+			}
+			break;
+		case CURLY_IR_TAGS_SLICE:
+			resolve_sexpr_types(sexpr->slice.list, ir);
+			resolve_sexpr_types(sexpr->slice.start, ir);
+			resolve_sexpr_types(sexpr->slice.end, ir);
+			break;
+		case CURLY_IR_TAGS_FOR:
+			resolve_sexpr_types(sexpr->for_loop.iter, ir);
+			resolve_sexpr_types(sexpr->for_loop.body, ir);
+			break;
+		case CURLY_IR_TAGS_RANGE:
+			resolve_sexpr_types(sexpr->range.start, ir);
+			if (sexpr->range.end != NULL)
+				resolve_sexpr_types(sexpr->range.end, ir);
+			break;
+		default:
+			break;
+	}
+}
+
+// check_correctness(curly_ir_t*, ir_scope_t*) -> void
+// Checks the correctness of IR whose symbols have been resolved in the given scope, inferring the types of functions.
+// When the type of a global changes, the definitions that depend on it are inserted after it to be checked again.
+bool check_correctness(curly_ir_t* ir, ir_scope_t* scope)
 {
-	// Create global scope
-	bool temp_scope = scope == NULL;
-	if (temp_scope)
-		scope = push_scope(NULL);
 	create_primatives(scope);
+	scope->level = 0;
 
-	// Iterate over every root S expression
-	for (size_t i = 0; i < ir.expr_count; i++)
+	// A failed check leaves the types of globals and the definitions as they were
+	size_t global_count = scope->global_count;
+	ir_var_t* globals = NULL;
+	if (global_count != 0)
 	{
-		// Check the S expression
-		if (!check_correctness_helper(ir.expr[i], scope))
+		globals = calloc(global_count, sizeof(ir_var_t));
+		memcpy(globals, scope->globals, global_count * sizeof(ir_var_t));
+	}
+	size_t def_count = ir->def_count;
+
+	// Independent root S expressions are checked on several threads if there are enough of them
+	bool valid = true;
+	if (!check_parallel(ir, scope, &valid))
+	{
+		// Iterate over every root S expression
+		for (size_t i = 0; valid && i < ir->expr_count; i++)
 		{
-			// Pop scopes if failed
-			while (scope->parent != NULL)
+			ir_sexpr_t* sexpr = ir->expr[i];
+			bool global = sexpr->tag == CURLY_IR_TAGS_ASSIGN && sexpr->assign.binding.global;
+			type_t* old_type = global ? scope_var(scope, sexpr->assign.binding)->type : NULL;
+			ir_definition_t def = save_definition(ir, sexpr);
+			if (!check_correctness_helper(sexpr, scope, ir))
 			{
-				scope = pop_scope(scope);
+				// Definitions checked again report what they were checked again for
+				ir_definition_t* pending = global ? find_definition(ir, sexpr->assign.binding.index) : NULL;
+				if (pending != NULL && pending->pending)
+					printf("Definition of %s depends on a global whose type changed found at %i:%i\n", sexpr->assign.name, sexpr->lino, sexpr->charpos);
+				clean_definition(&def);
+				valid = false;
+				break;
 			}
-			if (temp_scope)
-				pop_scope(scope);
-			return false;
+
+			// Every type variable the expression constrains is known by the end of it
+			resolve_sexpr_types(sexpr, ir);
+			commit_definition(ir, def, sexpr);
+
+			// Globals bound to generic functions get a new type when they're assigned a more specific function
+			if (old_type != NULL && old_type->has_vars && sexpr->type != old_type)
+				schedule_dependents(ir, sexpr->assign.binding.index, i);
 		}
 	}
 
-	// Pop scopes and return success
-	if (temp_scope)
-		pop_scope(scope);
-	return true;
+	if (!valid && global_count != 0)
+		memcpy(scope->globals, globals, global_count * sizeof(ir_var_t));
+	free(globals);
+	finish_definitions(ir, def_count, valid);
+	return valid;
 }
@@ -12,8 +12,9 @@
 #include "../ir/generate_ir.h"
 #include "scope.h"
 
-// check_correctness(curly_ir_t, ir_scope_t*) -> void
-// Checks the correctness of IR.
-bool check_correctness(curly_ir_t ir, ir_scope_t* scope);
+// check_correctness(curly_ir_t*, ir_scope_t*) -> void
+// Checks the correctness of IR whose symbols have been resolved in the given scope. When the type of a global changes,
+// the definitions that depend on it are inserted after it to be checked again.
+bool check_correctness(curly_ir_t* ir, ir_scope_t* scope);
 
 #endif /* CHECK_H */
@@ -9,11 +9,16 @@
 #ifndef CHECK_HELPER_H
 #define CHECK_HELPER_H
 
+#include "../ir/generate_ir.h"
 #include "scope.h"
 #include "types.h"
 
-// check_correctness_helper(ast_t*, ir_scope_t*, bool, bool) -> void
+// check_correctness_helper(ir_sexpr_t*, ir_scope_t*, curly_ir_t*) -> bool
 // Helper function for check_correctness.
-bool check_correctness_helper(ast_t* ast, ir_scope_t* scope, bool get_real_type, bool disable_new_vars);
+bool check_correctness_helper(ir_sexpr_t* sexpr, ir_scope_t* scope, curly_ir_t* ir);
+
+// resolve_sexpr_types(ir_sexpr_t*, curly_ir_t*) -> void
+// Replaces the bound type variables in the types of an S expression and its children with the types they stand for.
+void resolve_sexpr_types(ir_sexpr_t* sexpr, curly_ir_t* ir);
 
 #endif /* CHECK_HELPER_H */
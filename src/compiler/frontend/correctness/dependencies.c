@@ -0,0 +1,276 @@
+// 
+// correctness
+// dependencies.c: Tracks the globals that the definitions of generic functions depend on.
+// 
+// Created by jenra.
+// Created on October 18 2026.
+// 
+
+#include <string.h>
+
+#include "../../../utils/list.h"
+#include "dependencies.h"
+
+// The type of a global only changes when a global bound to a generic function is assigned a function of a more specific
+// type, and only generic functions can have a type that depends on the type of another global. So the checker keeps the
+// unchecked definition of every global bound to a generic function along with the globals the definition refers to, and
+// when the type of a global changes only the definitions that depend on it are checked again.
+
+// clone_definition_sexpr(ir_sexpr_t*, ir_sexpr_func_t**, ir_sexpr_func_t***, size_t*, size_t*) -> ir_sexpr_t*
+// Clones an unchecked S expression, appending clones of the functions it refers to in one table of functions to another.
+ir_sexpr_t* clone_definition_sexpr(ir_sexpr_t* sexpr, ir_sexpr_func_t** funcs, ir_sexpr_func_t*** clones, size_t* clone_size, size_t* clone_count)
+{
+	ir_sexpr_t* clone = malloc(sizeof(ir_sexpr_t));
+	*clone = *sexpr;
+	switch (sexpr->tag)
+	{
+		case CURLY_IR_TAGS_SYMBOL:
+			clone->symbol = strdup(sexpr->symbol);
+			break;
+		case CURLY_IR_TAGS_INFIX:
+			clone->infix.left = clone_definition_sexpr(sexpr->infix.left, funcs, clones, clone_size, clone_count);
+			clone->infix.right = clone_definition_sexpr(sexpr->infix.right, funcs, clones, clone_size, clone_count);
+			clone->infix.resolved_left = NULL;
+			clone->infix.resolved_right = NULL;
+			break;
+		case CURLY_IR_TAGS_PREFIX:
+			clone->prefix.operand = clone_definition_sexpr(sexpr->prefix.operand, funcs, clones, clone_size, clone_count);
+			clone->prefix.resolved_operand = NULL;
+			break;
+		case CURLY_IR_TAGS_APPLY:
+			clone->apply.func = clone_definition_sexpr(sexpr->apply.func, funcs, clones, clone_size, clone_count);
+			clone->apply.arg = clone_definition_sexpr(sexpr->apply.arg, funcs, clones, clone_size, clone_count);
+			break;
+		case CURLY_IR_TAGS_FUNC:
+		{
+			// Functions are cloned into the other table
+			ir_sexpr_func_t* func = funcs[sexpr->func_id];
+			ir_sexpr_func_t* func_clone = malloc(sizeof(ir_sexpr_func_t));
+			func_clone->arg_count = func->arg_count;
+			func_clone->args = calloc(func->arg_count, sizeof(ir_sexpr_func_arg_t));
+			for (size_t i = 0; i < func->arg_count; i++)
+			{
+				func_clone->args[i] = (ir_sexpr_func_arg_t) {func->args[i].type, strdup(func->args[i].name), func->args[i].binding};
+			}
+			func_clone->body = clone_definition_sexpr(func->body, funcs, clones, clone_size, clone_count);
+			list_append_element(*clones, *clone_size, *clone_count, ir_sexpr_func_t*, func_clone);
+			clone->func_id = *clone_count - 1;
+			break;
+		}
+		case CURLY_IR_TAGS_ASSIGN:
+			clone->assign.name = strdup(sexpr->assign.name);
+			clone->assign.value = clone_definition_sexpr(sexpr->assign.value, funcs, clones, clone_size, clone_count);
+			break;
+		case CURLY_IR_TAGS_DECLARE:
+			clone->declare.name = strdup(sexpr->declare.name);
+			break;
+		case CURLY_IR_TAGS_LOCAL_SCOPE:
+			clone->local_scope.assigns = calloc(sexpr->local_scope.assign_count, sizeof(ir_sexpr_t*));
+			for (size_t i = 0; i < sexpr->local_scope.assign_count; i++)
+			{
+				clone->local_scope.assigns[i] = clone_definition_sexpr(sexpr->local_scope.assigns[i], funcs, clones, clone_size, clone_count);
+			}
+			clone->local_scope.value = clone_definition_sexpr(sexpr->local_scope.value, funcs, clones, clone_size, clone_count);
+			break;
+		case CURLY_IR_TAGS_IF:
+			clone->if_expr.cond = clone_definition_sexpr(sexpr->if_expr.cond, funcs, clones, clone_size, clone_count);
+			clone->if_expr.then = clone_definition_sexpr(sexpr->if_expr.then, funcs, clones, clone_size, clone_count);
+			clone->if_expr.elsy = clone_definition_sexpr(sexpr->if_expr.elsy, funcs, clones, clone_size, clone_count);
+			break;
+		case CURLY_IR_TAGS_LIST:
+			clone->list.elements = calloc(sexpr->list.element_count, sizeof(ir_sexpr_t*));
+			for (size_t i = 0; i < sexpr->list.element_count; i++)
+			{
+				clone->list.elements[i] = clone_definition_sexpr(sexpr->list.elements[i], funcs, clones, clone_size, clone_count);
+			}
+			break;
+		case CURLY_IR_TAGS_SLICE:
+			clone->slice.list = clone_definition_sexpr(sexpr->slice.list, funcs, clones, clone_size, clone_count);
+			clone->slice.start = clone_definition_sexpr(sexpr->slice.start, funcs, clones, clone_size, clone_count);
+			clone->slice.end = clone_definition_sexpr(sexpr->slice.end, funcs, clones, clone_size, clone_count);
+			break;
+		case CURLY_IR_TAGS_FOR:
+			clone->for_loop.var = strdup(sexpr->for_loop.var);
+			clone->for_loop.iter = clone_definition_sexpr(sexpr->for_loop.iter, funcs, clones, clone_size, clone_count);
+			clone->for_loop.body = clone_definition_sexpr(sexpr->for_loop.body, funcs, clones, clone_size, clone_count);
+			break;
+		case CURLY_IR_TAGS_RANGE:
+			clone->range.start = clone_definition_sexpr(sexpr->range.start, funcs, clones, clone_size, clone_count);
+			if (sexpr->range.end != NULL)
+				clone->range.end = clone_definition_sexpr(sexpr->range.end, funcs, clones, clone_size, clone_count);
+			break;
+		default:
+			break;
+	}
+	return clone;
+}
+
+// find_dependencies(ir_definition_t*, ir_sexpr_t*, ir_sexpr_func_t**) -> void
+// Adds the globals an S expression refers to that aren't in the dependencies of a definition already.
+void find_dependencies(ir_definition_t* def, ir_sexpr_t* sexpr, ir_sexpr_func_t** funcs)
+{
+	switch (sexpr->tag)
+	{
+		case CURLY_IR_TAGS_SYMBOL:
+			if (!sexpr->binding.global)
+				break;
+			for (size_t i = 0; i < def->dep_count; i++)
+			{
+				if (def->deps[i] == sexpr->binding.index)
+					return;
+			}
+			list_append_element(def->deps, def->dep_size, def->dep_count, size_t, sexpr->binding.index);
+			break;
+		case CURLY_IR_TAGS_INFIX:
+			find_dependencies(def, sexpr->infix.left, funcs);
+			find_dependencies(def, sexpr->infix.right, funcs);
+			break;
+		case CURLY_IR_TAGS_PREFIX:
+			find_dependencies(def, sexpr->prefix.operand, funcs);
+			break;
+		case CURLY_IR_TAGS_APPLY:
+			find_dependencies(def, sexpr->apply.func, funcs);
+			find_dependencies(def, sexpr->apply.arg, funcs);
+			break;
+		case CURLY_IR_TAGS_FUNC:
+			find_dependencies(def, funcs[sexpr->func_id]->body, funcs);
+			break;
+		case CURLY_IR_TAGS_ASSIGN:
+			find_dependencies(def, sexpr->assign.value, funcs);
+			break;
+		case CURLY_IR_TAGS_LOCAL_SCOPE:
+			for (size_t i = 0; i < sexpr->local_scope.assign_count; i++)
+			{
+				find_dependencies(def, sexpr->local_scope.assigns[i], funcs);
+			}
+			find_dependencies(def, sexpr->local_scope.value, funcs);
+			break;
+		case CURLY_IR_TAGS_IF:
+			find_dependencies(def, sexpr->if_expr.cond, funcs);
+			find_dependencies(def, sexpr->if_expr.then, funcs);
+			find_dependencies(def, sexpr->if_expr.elsy, funcs);
+			break;
+		case CURLY_IR_TAGS_LIST:
+			for (size_t i = 0; i < sexpr->list.element_count; i++)
+			{
+				find_dependencies(def, sexpr->list.elements[i], funcs);
+			}
+			break;
+		case CURLY_IR_TAGS_SLICE:
+			find_dependencies(def, sexpr->slice.list, funcs);
+			find_dependencies(def, sexpr->slice.start, funcs);
+			find_dependencies(def, sexpr->slice.end, funcs);
+			break;
+		case CURLY_IR_TAGS_FOR:
+			find_dependencies(def, sexpr->for_loop.iter, funcs);
+			find_dependencies(def, sexpr->for_loop.body, funcs);
+			break;
+		case CURLY_IR_TAGS_RANGE:
+			find_dependencies(def, sexpr->range.start, funcs);
+			if (sexpr->range.end != NULL)
+				find_dependencies(def, sexpr->range.end, funcs);
+			break;
+		default:
+			break;
+	}
+}
+
+// save_definition(curly_ir_t*, ir_sexpr_t*) -> ir_definition_t
+// Copies a root S expression that assigns a function to a global before it's checked. The copy has no source if the S
+// expression isn't such an assignment.
+ir_definition_t save_definition(curly_ir_t* ir, ir_sexpr_t* sexpr)
+{
+	ir_definition_t def = {0};
+	if (sexpr->tag != CURLY_IR_TAGS_ASSIGN || !sexpr->assign.binding.global || sexpr->assign.value->tag != CURLY_IR_TAGS_FUNC)
+		return def;
+	def.global = sexpr->assign.binding.index;
+	def.source = clone_definition_sexpr(sexpr, ir->funcs, &def.funcs, &def.func_size, &def.func_count);
+	return def;
+}
+
+// find_definition(curly_ir_t*, size_t) -> ir_definition_t*
+// Returns the current definition of a global, or NULL if it isn't bound to a generic function.
+ir_definition_t* find_definition(curly_ir_t* ir, size_t global)
+{
+	for (size_t i = 0; i < ir->def_count; i++)
+	{
+		if (!ir->defs[i].stale && ir->defs[i].global == global)
+			return ir->defs + i;
+	}
+	return NULL;
+}
+
+// commit_definition(curly_ir_t*, ir_definition_t, ir_sexpr_t*) -> void
+// Replaces the definition of the global a checked root S expression assigns. Only definitions of generic functions are
+// kept, since their types are the only types of globals that can change.
+void commit_definition(curly_ir_t* ir, ir_definition_t def, ir_sexpr_t* sexpr)
+{
+	// The old definition is removed once the whole check succeeds
+	if (sexpr->tag == CURLY_IR_TAGS_ASSIGN && sexpr->assign.binding.global)
+	{
+		ir_definition_t* old = find_definition(ir, sexpr->assign.binding.index);
+		if (old != NULL)
+			old->stale = true;
+	}
+
+	if (def.source == NULL)
+		return;
+	else if (!sexpr->type->has_vars)
+	{
+		clean_definition(&def);
+		return;
+	}
+	find_dependencies(&def, sexpr, ir->funcs);
+	list_append_element(ir->defs, ir->def_size, ir->def_count, ir_definition_t, def);
+}
+
+// schedule_dependents(curly_ir_t*, size_t, size_t) -> size_t
+// Inserts copies of the definitions that depend on a global after the root S expression at the given index, so that
+// they're checked again with the new type of the global. Returns the number of definitions inserted.
+size_t schedule_dependents(curly_ir_t* ir, size_t global, size_t index)
+{
+	size_t count = 0;
+	for (size_t i = 0; i < ir->def_count; i++)
+	{
+		ir_definition_t* def = ir->defs + i;
+		if (def->stale || def->pending || def->global == global)
+			continue;
+
+		for (size_t j = 0; j < def->dep_count; j++)
+		{
+			if (def->deps[j] != global)
+				continue;
+
+			// Check a copy of the definition with new functions
+			ir_sexpr_t* sexpr = clone_definition_sexpr(def->source, def->funcs, &ir->funcs, &ir->func_size, &ir->func_count);
+			ir->expr = realloc(ir->expr, (ir->expr_count + 1) * sizeof(ir_sexpr_t*));
+			memmove(ir->expr + index + count + 2, ir->expr + index + count + 1, (ir->expr_count - index - count - 1) * sizeof(ir_sexpr_t*));
+			ir->expr[index + ++count] = sexpr;
+			ir->expr_count++;
+			def->pending = true;
+			break;
+		}
+	}
+	return count;
+}
+
+// finish_definitions(curly_ir_t*, size_t, bool) -> void
+// Removes the definitions replaced during a check that succeeded, or the definitions added during a check that failed.
+// def_count is the number of definitions before the check.
+void finish_definitions(curly_ir_t* ir, size_t def_count, bool succeeded)
+{
+	size_t count = 0;
+	for (size_t i = 0; i < ir->def_count; i++)
+	{
+		ir_definition_t* def = ir->defs + i;
+		if (succeeded ? def->stale : i >= def_count)
+		{
+			clean_definition(def);
+			continue;
+		}
+		def->stale = false;
+		def->pending = false;
+		ir->defs[count++] = *def;
+	}
+	ir->def_count = count;
+}
@@ -0,0 +1,42 @@
+// 
+// correctness
+// dependencies.h: Header file for dependencies.c.
+// 
+// Created by jenra.
+// Created on October 18 2026.
+// 
+
+#ifndef DEPENDENCIES_H
+#define DEPENDENCIES_H
+
+#include "../ir/generate_ir.h"
+
+// find_dependencies(ir_definition_t*, ir_sexpr_t*, ir_sexpr_func_t**) -> void
+// Adds the globals an S expression refers to that aren't in the dependencies of a definition already.
+void find_dependencies(ir_definition_t* def, ir_sexpr_t* sexpr, ir_sexpr_func_t** funcs);
+
+// save_definition(curly_ir_t*, ir_sexpr_t*) -> ir_definition_t
+// Copies a root S expression that assigns a function to a global before it's checked. The copy has no source if the S
+// expression isn't such an assignment.
+ir_definition_t save_definition(curly_ir_t* ir, ir_sexpr_t* sexpr);
+
+// find_definition(curly_ir_t*, size_t) -> ir_definition_t*
+// Returns the current definition of a global, or NULL if it isn't bound to a generic function.
+ir_definition_t* find_definition(curly_ir_t* ir, size_t global);
+
+// commit_definition(curly_ir_t*, ir_definition_t, ir_sexpr_t*) -> void
+// Replaces the definition of the global a checked root S expression assigns. Only definitions of generic functions are
+// kept, since their types are the only types of globals that can change.
+void commit_definition(curly_ir_t* ir, ir_definition_t def, ir_sexpr_t* sexpr);
+
+// schedule_dependents(curly_ir_t*, size_t, size_t) -> size_t
+// Inserts copies of the definitions that depend on a global after the root S expression at the given index, so that
+// they're checked again with the new type of the global. Returns the number of definitions inserted.
+size_t schedule_dependents(curly_ir_t* ir, size_t global, size_t index);
+
+// finish_definitions(curly_ir_t*, size_t, bool) -> void
+// Removes the definitions replaced during a check that succeeded, or the definitions added during a check that failed.
+// def_count is the number of definitions before the check.
+void finish_definitions(curly_ir_t* ir, size_t def_count, bool succeeded);
+
+#endif /* DEPENDENCIES_H */
@@ -0,0 +1,255 @@
+// 
+// correctness
+// infer.c: Implements type inference with union-find type variables.
+// 
+// Created by jenra.
+// Created on October 18 2026.
+// 
+
+#include <string.h>
+
+#include "../../../utils/list.h"
+#include "infer.h"
+
+// Type variables form a union-find forest: unifying a variable links it to another type, and finding a variable's type
+// follows the links and compresses the path. Every variable has the let level it was created at. Binding a variable
+// lowers the levels of the variables in its type to its own, so after checking a let binding, variables deeper than
+// the binding were only constrained by its value and can be made generic. Types without type variables are skipped
+// entirely, which keeps inference close to linear in the size of the program.
+
+// new_type_var(size_t) -> type_t*
+// Creates a new unbound type variable at the given let level.
+type_t* new_type_var(size_t level)
+{
+	type_t* var = init_type(IR_TYPES_VAR, NULL, 0);
+	var->level = level;
+	return var;
+}
+
+// find_type(type_t*) -> type_t*
+// Returns the type a type variable stands for, or the type itself if it isn't a bound type variable.
+type_t* find_type(type_t* type)
+{
+	// Find the root
+	type_t* root = type;
+	while (root != NULL && root->type_type == IR_TYPES_VAR && root->link != NULL)
+	{
+		root = root->link;
+	}
+
+	// Point every variable on the path at the root
+	while (type != root)
+	{
+		type_t* next = type->link;
+		type->link = root;
+		type = next;
+	}
+	return root;
+}
+
+// occurs_adjust(type_t*, type_t*) -> bool
+// Returns false if a type variable occurs in a type, and lowers the levels of the type's variables to the variable's level.
+bool occurs_adjust(type_t* var, type_t* type)
+{
+	type = find_type(type);
+	if (type == var)
+		return false;
+	else if (type->type_type == IR_TYPES_VAR)
+	{
+		if (type->level > var->level)
+			type->level = var->level;
+		return true;
+	} else if (!type->has_vars)
+		return true;
+
+	for (size_t i = 0; i < type->field_count; i++)
+	{
+		if (!occurs_adjust(var, type->field_types[i]))
+			return false;
+	}
+	return true;
+}
+
+// bind_type_var(type_t*, type_t*) -> bool
+// Binds an unbound type variable to a type, returning false if the type contains the variable.
+bool bind_type_var(type_t* var, type_t* type)
+{
+	if (!occurs_adjust(var, type))
+		return false;
+	var->link = type;
+	return true;
+}
+
+// unify_helper(type_t*, type_t*, bool) -> bool
+// Unifies two types so that they are equal, or so that the second is a valid type under the first if subtype is true.
+bool unify_helper(type_t* t1, type_t* t2, bool subtype)
+{
+	t1 = find_type(t1);
+	t2 = find_type(t2);
+	if (t1 == t2)
+		return true;
+	else if (t1 == NULL || t2 == NULL)
+		return false;
+
+	// Unbound variables are bound to the other type
+	else if (t1->type_type == IR_TYPES_VAR)
+		return bind_type_var(t1, t2);
+	else if (t2->type_type == IR_TYPES_VAR)
+		return bind_type_var(t2, t1);
+
+	// Types without variables are compared as they are
+	else if (!t1->has_vars && !t2->has_vars)
+		return subtype ? type_subtype(t1, t2) : types_equal(t1, t2);
+
+	// Empty lists are valid subtypes of populated lists
+	else if (subtype && t1->type_type == IR_TYPES_LIST && t2->type_type == IR_TYPES_LIST && t2->field_count == 0)
+		return true;
+
+	// Otherwise the types must have the same structure
+	if (t1->type_type != t2->type_type || t1->field_count != t2->field_count)
+		return false;
+	else if ((t1->type_name == NULL) != (t2->type_name == NULL) || (t1->type_name != NULL && strcmp(t1->type_name, t2->type_name)))
+		return false;
+	for (size_t i = 0; i < t1->field_count; i++)
+	{
+		if (t1->field_names[i] != NULL && t2->field_names[i] != NULL && strcmp(t1->field_names[i], t2->field_names[i]))
+			return false;
+		else if (!unify_helper(t1->field_types[i], t2->field_types[i], subtype))
+			return false;
+	}
+	return true;
+}
+
+// unify_types(type_t*, type_t*) -> bool
+// Unifies two types so that they are equal, binding type variables as needed. Returns false if they can't be unified.
+bool unify_types(type_t* t1, type_t* t2) { return unify_helper(t1, t2, false); }
+
+// unify_subtype(type_t*, type_t*) -> bool
+// Unifies two types so that the second is a valid type under the first, binding type variables as needed.
+bool unify_subtype(type_t* super, type_t* sub) { return unify_helper(super, sub, true); }
+
+// generalise_type(type_t*, size_t) -> void
+// Makes every unbound type variable in a type created deeper than the given let level generic.
+void generalise_type(type_t* type, size_t level)
+{
+	type = find_type(type);
+	if (type == NULL)
+		return;
+	else if (type->type_type == IR_TYPES_VAR)
+	{
+		if (type->level > level)
+			type->level = IR_TYPE_GENERIC_LEVEL;
+		return;
+	} else if (!type->has_vars)
+		return;
+
+	for (size_t i = 0; i < type->field_count; i++)
+	{
+		generalise_type(type->field_types[i], level);
+	}
+}
+
+// find_generic_vars(type_t*, type_t***, size_t*, size_t*) -> void
+// Appends the generic type variables in a type that aren't in the list already to the list.
+void find_generic_vars(type_t* type, type_t*** vars, size_t* vars_size, size_t* var_count)
+{
+	type = find_type(type);
+	if (type == NULL)
+		return;
+	else if (type->type_type == IR_TYPES_VAR)
+	{
+		if (type->level != IR_TYPE_GENERIC_LEVEL)
+			return;
+		for (size_t i = 0; i < *var_count; i++)
+		{
+			if ((*vars)[i] == type)
+				return;
+		}
+		list_append_element(*vars, *vars_size, *var_count, type_t*, type);
+		return;
+	} else if (!type->has_vars)
+		return;
+
+	for (size_t i = 0; i < type->field_count; i++)
+	{
+		find_generic_vars(type->field_types[i], vars, vars_size, var_count);
+	}
+}
+
+// instantiate_type(type_t*, size_t) -> type_t*
+// Replaces the generic type variables in a type with new type variables at the given let level.
+type_t* instantiate_type(type_t* type, size_t level)
+{
+	type = find_type(type);
+	if (type == NULL || !type->has_vars)
+		return type;
+
+	// Find the generic variables
+	type_t** vars = NULL;
+	size_t vars_size = 0;
+	size_t var_count = 0;
+	find_generic_vars(type, &vars, &vars_size, &var_count);
+	if (var_count == 0)
+		return type;
+
+	// Replace them with new variables
+	type_t** fresh = calloc(var_count, sizeof(type_t*));
+	for (size_t i = 0; i < var_count; i++)
+	{
+		fresh[i] = new_type_var(level);
+	}
+	type = substitute_type(type, vars, fresh, var_count);
+	free(vars);
+	free(fresh);
+	return type;
+}
+
+// substitute_type(type_t*, type_t**, type_t**, size_t) -> type_t*
+// Replaces the type variables in one array with the types at the same index in another array.
+type_t* substitute_type(type_t* type, type_t** vars, type_t** types, size_t count)
+{
+	type = find_type(type);
+	if (type == NULL)
+		return NULL;
+	else if (type->type_type == IR_TYPES_VAR)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			if (vars[i] == type)
+				return types[i];
+		}
+		return type;
+	} else if (!type->has_vars)
+		return type;
+
+	// Rebuild the type from its substituted fields
+	type_t** fields = calloc(type->field_count, sizeof(type_t*));
+	for (size_t i = 0; i < type->field_count; i++)
+	{
+		fields[i] = substitute_type(type->field_types[i], vars, types, count);
+	}
+	type_t* result = make_type(type->type_type, type->type_name, type->field_count, fields, type->field_names);
+	free(fields);
+	return result;
+}
+
+// resolve_type(type_t*) -> type_t*
+// Replaces the bound type variables in a type with the types they stand for, interning the result if it has no type variables left.
+type_t* resolve_type(type_t* type)
+{
+	type = find_type(type);
+	if (type == NULL || type->type_type == IR_TYPES_VAR || !type->has_vars)
+		return type;
+
+	// Resolve the fields, keeping the type if none of them changed
+	type_t** fields = calloc(type->field_count, sizeof(type_t*));
+	bool changed = false;
+	for (size_t i = 0; i < type->field_count; i++)
+	{
+		fields[i] = resolve_type(type->field_types[i]);
+		changed = changed || fields[i] != type->field_types[i];
+	}
+	type_t* result = changed ? make_type(type->type_type, type->type_name, type->field_count, fields, type->field_names) : type;
+	free(fields);
+	return result;
+}
@@ -0,0 +1,50 @@
+// 
+// correctness
+// infer.h: Header file for infer.c.
+// 
+// Created by jenra.
+// Created on October 18 2026.
+// 
+
+#ifndef INFER_H
+#define INFER_H
+
+#include "types.h"
+
+// new_type_var(size_t) -> type_t*
+// Creates a new unbound type variable at the given let level.
+type_t* new_type_var(size_t level);
+
+// find_type(type_t*) -> type_t*
+// Returns the type a type variable stands for, or the type itself if it isn't a bound type variable.
+type_t* find_type(type_t* type);
+
+// unify_types(type_t*, type_t*) -> bool
+// Unifies two types so that they are equal, binding type variables as needed. Returns false if they can't be unified.
+bool unify_types(type_t* t1, type_t* t2);
+
+// unify_subtype(type_t*, type_t*) -> bool
+// Unifies two types so that the second is a valid type under the first, binding type variables as needed.
+bool unify_subtype(type_t* super, type_t* sub);
+
+// generalise_type(type_t*, size_t) -> void
+// Makes every unbound type variable in a type created deeper than the given let level generic.
+void generalise_type(type_t* type, size_t level);
+
+// find_generic_vars(type_t*, type_t***, size_t*, size_t*) -> void
+// Appends the generic type variables in a type that aren't in the list already to the list.
+void find_generic_vars(type_t* type, type_t*** vars, size_t* vars_size, size_t* var_count);
+
+// instantiate_type(type_t*, size_t) -> type_t*
+// Replaces the generic type variables in a type with new type variables at the given let level.
+type_t* instantiate_type(type_t* type, size_t level);
+
+// substitute_type(type_t*, type_t**, type_t**, size_t) -> type_t*
+// Replaces the type variables in one array with the types at the same index in another array.
+type_t* substitute_type(type_t* type, type_t** vars, type_t** types, size_t count);
+
+// resolve_type(type_t*) -> type_t*
+// Replaces the bound type variables in a type with the types they stand for, interning the result if it has no type variables left.
+type_t* resolve_type(type_t* type);
+
+#endif /* INFER_H */
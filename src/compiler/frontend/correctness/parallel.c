@@ -0,0 +1,266 @@
+// 
+// correctness
+// parallel.c: Checks independent root S expressions on several threads.
+// 
+// Created by jenra.
+// Created on October 18 2026.
+// 
+
+#include <pthread.h>
+#include <string.h>
+
+#include "../../../utils/list.h"
+#include "check_helper.h"
+#include "dependencies.h"
+#include "parallel.h"
+
+// Represents a root S expression in the graph of which root S expressions must be checked before which.
+typedef struct
+{
+	// The number of root S expressions that must be checked before this one.
+	size_t waiting;
+
+	// The root S expressions waiting for this one.
+	size_t* successors;
+	size_t successor_count;
+	size_t successor_size;
+} check_node_t;
+
+// Represents the work shared by the threads checking root S expressions.
+typedef struct
+{
+	// The IR being checked, the scope the threads fork, and the graph of root S expressions.
+	curly_ir_t* ir;
+	ir_scope_t* scope;
+	check_node_t* nodes;
+
+	// The stack of root S expressions ready to be checked, and the number of root S expressions being checked.
+	size_t* ready;
+	size_t ready_count;
+	size_t running;
+
+	// The index of the first incorrect root S expression, or the number of root S expressions if there isn't one.
+	size_t failure;
+
+	// Guards the fields above and signals when they change.
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+} check_pool_t;
+
+// add_check_edge(check_node_t*, size_t, size_t) -> void
+// Makes a root S expression wait for another to be checked.
+void add_check_edge(check_node_t* nodes, size_t from, size_t to)
+{
+	list_append_element(nodes[from].successors, nodes[from].successor_size, nodes[from].successor_count, size_t, to);
+	nodes[to].waiting++;
+}
+
+// del_check_graph(check_node_t*, size_t) -> void
+// Deletes a graph of root S expressions.
+void del_check_graph(check_node_t* nodes, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		free(nodes[i].successors);
+	}
+	free(nodes);
+}
+
+// build_check_graph(curly_ir_t*, ir_scope_t*) -> check_node_t*
+// Builds the graph of which root S expressions must be checked before which, or returns NULL if a global is assigned
+// more than once or read before it's assigned. Root S expressions that read globals whose types can still change are
+// checked one at a time in order.
+check_node_t* build_check_graph(curly_ir_t* ir, ir_scope_t* scope)
+{
+	size_t count = ir->expr_count;
+	size_t global_count = scope->global_count;
+	check_node_t* nodes = calloc(count, sizeof(check_node_t));
+
+	// Find one plus the index of the root S expression that declares and the one that last assigns each global
+	size_t* declarers = calloc(global_count, sizeof(size_t));
+	size_t* writers = calloc(global_count, sizeof(size_t));
+	bool supported = true;
+	for (size_t i = 0; supported && i < count; i++)
+	{
+		ir_sexpr_t* sexpr = ir->expr[i];
+		if (sexpr->tag == CURLY_IR_TAGS_DECLARE && sexpr->declare.binding.global)
+		{
+			size_t global = sexpr->declare.binding.index;
+			supported = writers[global] == 0 && scope->globals[global].type == NULL;
+			declarers[global] = writers[global] = i + 1;
+		}
+		else if (sexpr->tag == CURLY_IR_TAGS_ASSIGN && sexpr->assign.binding.global)
+		{
+			size_t global = sexpr->assign.binding.index;
+			supported = writers[global] == declarers[global] && (declarers[global] != 0 || scope->globals[global].type == NULL);
+			writers[global] = i + 1;
+		}
+	}
+
+	// Globals from earlier checks can only change type if they have type variables
+	bool* mutable = calloc(global_count, sizeof(bool));
+	for (size_t i = 0; i < global_count; i++)
+	{
+		type_t* type = scope->globals[i].type;
+		mutable[i] = writers[i] == 0 && type != NULL && type->has_vars;
+	}
+
+	// Every root S expression waits for the globals it reads to be assigned
+	size_t last_mutable_reader = 0;
+	for (size_t i = 0; supported && i < count; i++)
+	{
+		ir_sexpr_t* sexpr = ir->expr[i];
+		ir_definition_t reads = {0};
+		find_dependencies(&reads, sexpr, ir->funcs);
+		bool reads_mutable = false;
+		for (size_t j = 0; supported && j < reads.dep_count; j++)
+		{
+			size_t global = reads.deps[j];
+			if (writers[global] == i + 1)
+				continue;
+			supported = writers[global] <= i;
+			if (writers[global] != 0)
+				add_check_edge(nodes, writers[global] - 1, i);
+			reads_mutable |= mutable[global];
+		}
+		free(reads.deps);
+
+		// Assignments wait for the declaration of their global
+		if (sexpr->tag == CURLY_IR_TAGS_ASSIGN && sexpr->assign.binding.global && declarers[sexpr->assign.binding.index] != 0)
+			add_check_edge(nodes, declarers[sexpr->assign.binding.index] - 1, i);
+
+		// Reading a global whose type can change may change it, so such reads happen in order
+		if (reads_mutable)
+		{
+			if (last_mutable_reader != 0)
+				add_check_edge(nodes, last_mutable_reader - 1, i);
+			last_mutable_reader = i + 1;
+		}
+
+		// Globals can change type unless they're functions that only read globals that can't
+		if (sexpr->tag == CURLY_IR_TAGS_ASSIGN && sexpr->assign.binding.global)
+			mutable[sexpr->assign.binding.index] = reads_mutable || sexpr->assign.value->tag != CURLY_IR_TAGS_FUNC;
+		else if (sexpr->tag == CURLY_IR_TAGS_DECLARE && sexpr->declare.binding.global)
+			mutable[sexpr->declare.binding.index] = sexpr->type != NULL && sexpr->type->has_vars;
+	}
+
+	free(declarers);
+	free(writers);
+	free(mutable);
+	if (!supported)
+	{
+		del_check_graph(nodes, count);
+		return NULL;
+	}
+	return nodes;
+}
+
+// check_worker(void*) -> void*
+// Checks root S expressions as they become ready until none are left to check.
+void* check_worker(void* data)
+{
+	check_pool_t* pool = data;
+	ir_scope_t* scope = fork_scope(pool->scope);
+	pthread_mutex_lock(&pool->lock);
+	while (true)
+	{
+		// Wait for a root S expression to be ready, unless none are being checked
+		while (pool->ready_count == 0 && pool->running != 0)
+		{
+			pthread_cond_wait(&pool->cond, &pool->lock);
+		}
+		if (pool->ready_count == 0)
+			break;
+
+		// Root S expressions after an incorrect one aren't checked, as in a sequential check
+		size_t index = pool->ready[--pool->ready_count];
+		if (index > pool->failure)
+			continue;
+		pool->running++;
+		pthread_mutex_unlock(&pool->lock);
+
+		// Check it on the fork of the scope, resolving the types it constrains
+		ir_sexpr_t* sexpr = pool->ir->expr[index];
+		bool valid = check_correctness_helper(sexpr, scope, pool->ir);
+		if (valid)
+			resolve_sexpr_types(sexpr, pool->ir);
+
+		// Release the root S expressions waiting for this one
+		pthread_mutex_lock(&pool->lock);
+		pool->running--;
+		if (!valid && index < pool->failure)
+			pool->failure = index;
+		check_node_t* node = pool->nodes + index;
+		for (size_t i = 0; valid && i < node->successor_count; i++)
+		{
+			if (--pool->nodes[node->successors[i]].waiting == 0)
+				pool->ready[pool->ready_count++] = node->successors[i];
+		}
+		pthread_cond_broadcast(&pool->cond);
+	}
+	pthread_mutex_unlock(&pool->lock);
+	del_forked_scope(scope);
+	return NULL;
+}
+
+// check_parallel(curly_ir_t*, ir_scope_t*, bool*) -> bool
+// Checks the root S expressions of IR on several threads, checking each one once the ones it depends on have been
+// checked. Returns false without checking anything if the IR is too small or reassigns globals, and otherwise sets valid
+// to whether every root S expression is correct.
+bool check_parallel(curly_ir_t* ir, ir_scope_t* scope, bool* valid)
+{
+	size_t count = ir->expr_count;
+	if (ir->check_threads < 2 || count < CURLY_PARALLEL_CHECK_MIN)
+		return false;
+	check_node_t* nodes = build_check_graph(ir, scope);
+	if (nodes == NULL)
+		return false;
+
+	// Definitions are copied before they're checked
+	ir_definition_t* defs = calloc(count, sizeof(ir_definition_t));
+	for (size_t i = 0; i < count; i++)
+	{
+		defs[i] = save_definition(ir, ir->expr[i]);
+	}
+
+	// Start with the root S expressions that don't wait for any other, earliest on top
+	check_pool_t pool = {ir, scope, nodes, calloc(count, sizeof(size_t)), 0, 0, count, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER};
+	for (size_t i = count; i > 0; i--)
+	{
+		if (nodes[i - 1].waiting == 0)
+			pool.ready[pool.ready_count++] = i - 1;
+	}
+
+	// Check on as many threads as there can be, or on this one if none can be started
+	size_t thread_count = ir->check_threads < count ? ir->check_threads : count;
+	pthread_t* threads = calloc(thread_count, sizeof(pthread_t));
+	size_t started = 0;
+	for (size_t i = 0; i < thread_count; i++)
+	{
+		if (!pthread_create(threads + started, NULL, check_worker, &pool))
+			started++;
+	}
+	if (started == 0)
+		check_worker(&pool);
+	for (size_t i = 0; i < started; i++)
+	{
+		pthread_join(threads[i], NULL);
+	}
+
+	// Definitions are committed in order so that they're kept as if they were checked in order
+	*valid = pool.failure == count;
+	for (size_t i = 0; i < count; i++)
+	{
+		if (*valid)
+			commit_definition(ir, defs[i], ir->expr[i]);
+		else clean_definition(defs + i);
+	}
+
+	free(defs);
+	free(threads);
+	free(pool.ready);
+	pthread_mutex_destroy(&pool.lock);
+	pthread_cond_destroy(&pool.cond);
+	del_check_graph(nodes, count);
+	return true;
+}
@@ -0,0 +1,23 @@
+// 
+// correctness
+// parallel.h: Header file for parallel.c.
+// 
+// Created by jenra.
+// Created on October 18 2026.
+// 
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stdbool.h>
+
+#include "../ir/generate_ir.h"
+#include "scope.h"
+
+// check_parallel(curly_ir_t*, ir_scope_t*, bool*) -> bool
+// Checks the root S expressions of IR on several threads, checking each one once the ones it depends on have been
+// checked. Returns false without checking anything if the IR is too small or reassigns globals, and otherwise sets valid
+// to whether every root S expression is correct.
+bool check_parallel(curly_ir_t* ir, ir_scope_t* scope, bool* valid);
+
+#endif /* PARALLEL_H */
@@ -6,221 +6,320 @@
 // Created on August 29 2020.
 // 
 
+#include <string.h>
+
+#include "../../../utils/list.h"
 #include "scope.h"
 
-// push_scope(ir_scope_t*) -> ir_scope_t*
-// Initialises a scope and pushes it onto the stack of scopes.
-ir_scope_t* push_scope(ir_scope_t* parent)
+// The number of slots an operator index starts with.
+#define OP_INDEX_INITIAL_SIZE 32
+
+// init_scope(void) -> ir_scope_t*
+// Initialises a global scope.
+ir_scope_t* init_scope()
 {
 	ir_scope_t* scope = malloc(sizeof(ir_scope_t));
-	scope->var_types = init_hashmap();
-	scope->var_vals = init_hashmap();
+	scope->bindings = NULL;
+	scope->binding_count = 0;
+	scope->binding_size = 0;
+	scope->base = 0;
+	scope->depth = 0;
+	scope->level = 0;
+	scope->var_indices = init_hashmap();
+	scope->globals = NULL;
+	scope->global_count = 0;
+	scope->global_size = 0;
+	scope->locals = NULL;
+	scope->local_size = 0;
 	scope->types = init_hashmap();
 
 	for (int i = 0; i < INFIX_OP_COUNT; i++)
 	{
-		scope->infix_ops[i] = NULL;
+		scope->infix_ops[i] = (ir_op_index_t) {NULL, 0, 0, NULL, 0, 0};
 	}
 
-	scope->parent = parent;
 	return scope;
 }
 
-// add_prefix_op(ir_scope_t*, type_t*, type_t*) -> void
-// Adds a new prefix operator to the scope.
-void add_prefix_op(ir_scope_t* scope, type_t* operand, type_t* out)
+// push_scope(ir_scope_t*) -> size_t
+// Enters a new innermost scope, returning the base of the enclosing scope.
+size_t push_scope(ir_scope_t* scope)
 {
-	// Create the type
-	type_t* type = init_type(IR_TYPES_FUNC, NULL, 2);
-	type->field_types[0] = operand;
-	type->field_types[1] = out;
-
-	// Create the prefix operator
-	ir_infix_type_t* prefix = malloc(sizeof(ir_infix_type_t));
-	prefix->type = type;
-	prefix->next = NULL;
+	size_t base = scope->base;
+	scope->base = scope->binding_count;
+	scope->depth++;
+	return base;
+}
 
-	// Append the new operator
-	if (scope->infix_ops[0] == NULL)
-		scope->infix_ops[0] = prefix;
-	else
+// unbind_vars(ir_scope_t*, size_t) -> void
+// Removes every binding after the first binding_count bindings.
+void unbind_vars(ir_scope_t* scope, size_t binding_count)
+{
+	// Unbind in reverse order so that every name ends up mapped to the binding it shadowed
+	while (scope->binding_count > binding_count)
 	{
-		// Find the last element in the linked list
-		ir_infix_type_t* head = scope->infix_ops[0];
-		while (head->next != NULL)
-		{
-			head = head->next;
-		}
-		head->next = prefix;
+		ir_binding_t* binding = scope->bindings + --scope->binding_count;
+		map_add(scope->var_indices, binding->name, (void*) binding->shadowed);
+		free(binding->name);
 	}
 }
 
-// add_infix_op(ir_scope_t*, ir_binops_t, type_t*, type_t*, type_t*) -> void
-// Adds an infix operation to the scope.
-void add_infix_op(ir_scope_t* scope, ir_binops_t op, type_t* left, type_t* right, type_t* out)
+// pop_scope(ir_scope_t*, size_t) -> void
+// Removes the bindings of the innermost scope and returns to the enclosing scope with the given base.
+void pop_scope(ir_scope_t* scope, size_t base)
+{
+	unbind_vars(scope, scope->base);
+	scope->base = base;
+	scope->depth--;
+}
+
+// restore_scope(ir_scope_t*, size_t) -> void
+// Removes every binding after the first binding_count bindings and returns to the global scope.
+void restore_scope(ir_scope_t* scope, size_t binding_count)
 {
-	// Create the type
-	type_t* type = init_type(IR_TYPES_FUNC, NULL, 3);
-	type->field_types[0] = left;
-	type->field_types[1] = right;
-	type->field_types[2] = out;
-
-	// Create the infix operator
-	ir_infix_type_t* infix = malloc(sizeof(ir_infix_type_t));
-	infix->type = type;
-	infix->next = NULL;
-
-	// Append the new operator
-	if (scope->infix_ops[op] == NULL)
-		scope->infix_ops[op] = infix;
-	else
+	unbind_vars(scope, binding_count);
+	scope->base = 0;
+	scope->depth = 0;
+	scope->level = 0;
+	if (scope->global_count > binding_count)
+		scope->global_count = binding_count;
+	if (scope->locals != NULL)
+		memset(scope->locals, 0, scope->local_size * sizeof(ir_var_t));
+}
+
+// bind_var(ir_scope_t*, char*) -> ir_binding_id_t
+// Binds a name in the innermost scope and returns the variable it refers to. Names already bound in the innermost scope keep their variable.
+ir_binding_id_t bind_var(ir_scope_t* scope, char* name)
+{
+	// Keep the variable if the name is bound in the innermost scope
+	size_t index = (size_t) map_get(scope->var_indices, name);
+	if (index > scope->base)
+		return scope->bindings[index - 1].id;
+
+	// Names bound outside of local scopes are globals, and locals take the slot after the locals enclosing them
+	ir_binding_id_t id = {scope->depth == 0, scope->binding_count - scope->global_count};
+	if (id.global)
 	{
-		// Find the last element in the linked list
-		ir_infix_type_t* head = scope->infix_ops[op];
-		while (head->next != NULL)
-		{
-			head = head->next;
-		}
-		head->next = infix;
+		id.index = scope->global_count;
+		list_append_element(scope->globals, scope->global_size, scope->global_count, ir_var_t, ((ir_var_t) {NULL, NULL}));
 	}
+
+	// Push a binding that shadows the current one
+	ir_binding_t binding = {strdup(name), id, index};
+	list_append_element(scope->bindings, scope->binding_size, scope->binding_count, ir_binding_t, binding);
+	map_add(scope->var_indices, name, (void*) scope->binding_count);
+	return id;
 }
 
-// scope_lookup_prefix(ir_scope_t*, type_t*) -> type_t*
-// Looks up a prefix operator based on the argument type and returns the result type.
-type_t* scope_lookup_prefix(ir_scope_t* scope, type_t* operand)
+// scope_lookup_binding(ir_scope_t*, char*, ir_binding_id_t*) -> bool
+// Looks up the variable a name refers to, returning false if the name is unbound.
+bool scope_lookup_binding(ir_scope_t* scope, char* name, ir_binding_id_t* id)
 {
-	// Iterate over the scopes
-	ir_scope_t* top = scope;
-	while (top != NULL)
+	size_t index = (size_t) map_get(scope->var_indices, name);
+	if (index == 0)
+		return false;
+	*id = scope->bindings[index - 1].id;
+	return true;
+}
+
+// scope_var(ir_scope_t*, ir_binding_id_t) -> ir_var_t*
+// Returns the type and value of a variable.
+ir_var_t* scope_var(ir_scope_t* scope, ir_binding_id_t id)
+{
+	if (id.global)
+		return scope->globals + id.index;
+
+	// Grow the locals to fit the slot
+	if (id.index >= scope->local_size)
 	{
-		// Search for the prefix operator
-		ir_infix_type_t* current = top->infix_ops[0];
-		while (current != NULL)
+		size_t size = scope->local_size != 0 ? scope->local_size : 8;
+		while (size <= id.index)
 		{
-			if (type_subtype(current->type->field_types[0], operand))
-				return current->type->field_types[1];
-			current = current->next;
+			size <<= 1;
 		}
-
-		// Get parent scope
-		top = top->parent;
+		scope->locals = realloc(scope->locals, size * sizeof(ir_var_t));
+		memset(scope->locals + scope->local_size, 0, (size - scope->local_size) * sizeof(ir_var_t));
+		scope->local_size = size;
 	}
+	return scope->locals + id.index;
+}
 
-	// No operator found
-	return NULL;
+// op_entry_slot(ir_op_index_t*, size_t, size_t) -> ir_op_entry_t*
+// Returns the slot in an operator index for a pair of operand type ids, which is empty if the pair hasn't been resolved.
+ir_op_entry_t* op_entry_slot(ir_op_index_t* index, size_t left, size_t right)
+{
+	size_t hash = (left * 31 + right) * 1099511628211UL;
+	size_t i = (hash >> 4) % index->entry_size;
+	while (index->entries[i].left != 0 && (index->entries[i].left != left || index->entries[i].right != right))
+	{
+		i = (i + 1) % index->entry_size;
+	}
+	return index->entries + i;
 }
 
-// scope_lookup_infix(ir_scope_t*, ir_binops_t, type_t*, type_t*) -> type_t*
-// Looks up an infix operator based on the argument types and returns the result type.
-type_t* scope_lookup_infix(ir_scope_t* scope, ir_binops_t op, type_t* left, type_t* right)
+// cache_op_entry(ir_op_index_t*, ir_op_entry_t) -> void
+// Adds a resolution to an operator index, growing the table if it's half full.
+void cache_op_entry(ir_op_index_t* index, ir_op_entry_t entry)
 {
-	// Iterate over the scopes
-	ir_scope_t* top = scope;
-	while (top != NULL)
+	if (index->entry_count * 2 >= index->entry_size)
 	{
-		// Search for the infix operator in topmost scope
-		ir_infix_type_t* current = top->infix_ops[op];
-		while (current != NULL)
+		// Rehash every entry into a larger table
+		ir_op_entry_t* old = index->entries;
+		size_t old_size = index->entry_size;
+		index->entry_size = old_size != 0 ? old_size * 2 : OP_INDEX_INITIAL_SIZE;
+		index->entries = calloc(index->entry_size, sizeof(ir_op_entry_t));
+		for (size_t i = 0; i < old_size; i++)
 		{
-			if (type_subtype(current->type->field_types[0], left) && type_subtype(current->type->field_types[1], right))
-				return current->type->field_types[2];
-			current = current->next;
+			if (old[i].left != 0)
+				*op_entry_slot(index, old[i].left, old[i].right) = old[i];
 		}
-
-		// Get parent scope
-		top = top->parent;
+		free(old);
 	}
 
-	// No operator found
-	return NULL;
+	ir_op_entry_t* slot = op_entry_slot(index, entry.left, entry.right);
+	if (slot->left == 0)
+		index->entry_count++;
+	*slot = entry;
 }
 
-// scope_lookup_var_type(ir_scope_t*, char*) -> type_t*
-// Looks up the type of a variable in the scope.
-type_t* scope_lookup_var_type(ir_scope_t* scope, char* name)
+// add_op_signature(ir_op_index_t*, type_t*) -> void
+// Adds a signature to an operator index, invalidating the resolutions made without it.
+void add_op_signature(ir_op_index_t* index, type_t* type)
 {
-	// Iterate over every scope
-	while (scope != NULL)
+	list_append_element(index->signatures, index->signature_size, index->signature_count, type_t*, type);
+	if (index->entry_count != 0)
 	{
-		// Get the type in the current scope
-		type_t* type = map_get(scope->var_types, name);
+		memset(index->entries, 0, index->entry_size * sizeof(ir_op_entry_t));
+		index->entry_count = 0;
+	}
+}
 
-		// Return the type if found
-		if (type != NULL)
-			return type;
+// resolve_op(ir_op_index_t*, type_t*, type_t*) -> ir_op_entry_t*
+// Resolves an operator against the signatures in a single scope. right is NULL for prefix operators.
+ir_op_entry_t* resolve_op(ir_op_index_t* index, type_t* left, type_t* right)
+{
+	// Check for a previous resolution
+	size_t right_id = right != NULL ? right->id : 0;
+	if (index->entry_count != 0)
+	{
+		ir_op_entry_t* slot = op_entry_slot(index, left->id, right_id);
+		if (slot->left != 0)
+			return slot;
+	}
 
-		// Get parent scope
-		scope = scope->parent;
+	// Find the first declared signature that accepts the operands
+	ir_op_entry_t entry = {left->id, right_id, NULL};
+	for (size_t i = 0; i < index->signature_count; i++)
+	{
+		type_t* signature = index->signatures[i];
+		if (type_subtype(signature->field_types[0], left) && (right == NULL || type_subtype(signature->field_types[1], right)))
+		{
+			entry.out = signature->field_types[signature->field_count - 1];
+			break;
+		}
 	}
 
-	// No type was found
-	return NULL;
+	// Save the resolution
+	cache_op_entry(index, entry);
+	return op_entry_slot(index, entry.left, entry.right);
 }
 
-// scope_lookup_var_val(ir_scope_t*, char*) -> ir_sexpr_t*
-// Looks up the value of a variable in the scope.
-ir_sexpr_t* scope_lookup_var_val(ir_scope_t* scope, char* name)
+// add_prefix_op(ir_scope_t*, type_t*, type_t*) -> void
+// Adds a new prefix operator to the scope.
+void add_prefix_op(ir_scope_t* scope, type_t* operand, type_t* out)
 {
-	// Iterate over every scope
-	while (scope != NULL)
-	{
-		// Get the S expression in the current scope
-		ir_sexpr_t* sexpr = map_get(scope->var_vals, name);
+	type_t* type = make_type(IR_TYPES_FUNC, NULL, 2, (type_t*[]) {operand, out}, NULL);
+	add_op_signature(&scope->infix_ops[IR_BINOPS_NEG], type);
+}
 
-		// Return the S expression if found
-		if (sexpr != NULL)
-			return sexpr;
+// add_infix_op(ir_scope_t*, ir_binops_t, type_t*, type_t*, type_t*) -> void
+// Adds an infix operation to the scope.
+void add_infix_op(ir_scope_t* scope, ir_binops_t op, type_t* left, type_t* right, type_t* out)
+{
+	type_t* type = make_type(IR_TYPES_FUNC, NULL, 3, (type_t*[]) {left, right, out}, NULL);
+	add_op_signature(&scope->infix_ops[op], type);
+}
 
-		// Get parent scope
-		scope = scope->parent;
-	}
+// scope_lookup_prefix(ir_scope_t*, type_t*) -> type_t*
+// Looks up a prefix operator based on the argument type and returns the result type.
+type_t* scope_lookup_prefix(ir_scope_t* scope, type_t* operand)
+{
+	if (operand == NULL)
+		return NULL;
 
-	// No S expression was found
-	return NULL;
+	ir_op_index_t* index = &scope->infix_ops[IR_BINOPS_NEG];
+	return index->signature_count != 0 ? resolve_op(index, operand, NULL)->out : NULL;
+}
+
+// scope_lookup_infix(ir_scope_t*, ir_binops_t, type_t*, type_t*) -> type_t*
+// Looks up an infix operator based on the argument types and returns the result type.
+type_t* scope_lookup_infix(ir_scope_t* scope, ir_binops_t op, type_t* left, type_t* right)
+{
+	if (left == NULL || right == NULL)
+		return NULL;
+
+	ir_op_index_t* index = &scope->infix_ops[op];
+	return index->signature_count != 0 ? resolve_op(index, left, right)->out : NULL;
 }
 
 // scope_lookup_type(ir_scope_t*, char*) -> type_t*
 // Looks up a type in the scope.
 type_t* scope_lookup_type(ir_scope_t* scope, char* name)
 {
-	// Iterate over every scope
-	while (scope != NULL)
-	{
-		// Get the type in the current scope
-		type_t* type = map_get(scope->types, name);
+	return map_get(scope->types, name);
+}
 
-		// Return the type if found
-		if (type != NULL)
-			return type;
+// fork_scope(ir_scope_t*) -> ir_scope_t*
+// Creates a scope for checking a root S expression on another thread. The fork shares the bindings, globals, types,
+// and operator signatures of the scope, but has its own locals and operator resolutions.
+ir_scope_t* fork_scope(ir_scope_t* scope)
+{
+	ir_scope_t* fork = malloc(sizeof(ir_scope_t));
+	*fork = *scope;
+	fork->level = 0;
+	fork->locals = NULL;
+	fork->local_size = 0;
 
-		// Get parent scope
-		scope = scope->parent;
+	for (int i = 0; i < INFIX_OP_COUNT; i++)
+	{
+		ir_op_index_t* index = &fork->infix_ops[i];
+		if (index->entry_size == 0)
+			continue;
+		index->entries = malloc(index->entry_size * sizeof(ir_op_entry_t));
+		memcpy(index->entries, scope->infix_ops[i].entries, index->entry_size * sizeof(ir_op_entry_t));
 	}
 
-	// No type was found
-	return NULL;
+	return fork;
+}
+
+// del_forked_scope(ir_scope_t*) -> void
+// Deletes a scope created by fork_scope.
+void del_forked_scope(ir_scope_t* fork)
+{
+	free(fork->locals);
+	for (int i = 0; i < INFIX_OP_COUNT; i++)
+	{
+		free(fork->infix_ops[i].entries);
+	}
+	free(fork);
 }
 
-// pop_scope(ir_scope_t* scope)
-// Deletes a scope and returns its parent.
-ir_scope_t* pop_scope(ir_scope_t* scope)
+// del_scope(ir_scope_t*) -> void
+// Deletes a global scope.
+void del_scope(ir_scope_t* scope)
 {
-	del_hashmap(scope->var_types);
-	del_hashmap(scope->var_vals);
+	restore_scope(scope, 0);
+	free(scope->bindings);
+	free(scope->globals);
+	free(scope->locals);
+	del_hashmap(scope->var_indices);
 	del_hashmap(scope->types);
 
 	for (int i = 0; i < INFIX_OP_COUNT; i++)
 	{
-		ir_infix_type_t* head = scope->infix_ops[i];
-		while (head != NULL)
-		{
-			ir_infix_type_t* next = head->next;
-			free(head);
-			head = next;
-		}
+		free(scope->infix_ops[i].signatures);
+		free(scope->infix_ops[i].entries);
 	}
 
-	ir_scope_t* parent = scope->parent;
 	free(scope);
-	return parent;
 }
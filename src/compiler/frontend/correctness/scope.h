@@ -13,40 +13,116 @@
 #include "../ir/generate_ir.h"
 #include "types.h"
 
-#define INFIX_OP_COUNT 11
+// The number of operators that can be indexed. Prefix operators are stored under IR_BINOPS_NEG.
+#define INFIX_OP_COUNT (IR_BINOPS_INDEX + 1)
 
-// Represents an infix operator's type
-typedef struct s_ir_infix_type
+// Represents an operator resolution in an operator index.
+typedef struct
 {
-	// The type of the infix value
-	type_t* type;
+	// The ids of the operand types. left is 0 for empty slots and right is 0 for prefix operators.
+	size_t left;
+	size_t right;
+
+	// The result type, or NULL if no signature in the scope accepts the operands.
+	type_t* out;
+} ir_op_entry_t;
+
+// Represents the signatures of an operator.
+typedef struct
+{
+	// The function types of the signatures in the order they were declared.
+	type_t** signatures;
+	size_t signature_count;
+	size_t signature_size;
+
+	// Open addressing hash table of resolutions keyed on the operand type ids.
+	ir_op_entry_t* entries;
+	size_t entry_count;
+	size_t entry_size;
+} ir_op_index_t;
+
+// Represents the binding of a variable name.
+typedef struct
+{
+	// The name of the variable.
+	char* name;
+
+	// The variable the name refers to.
+	ir_binding_id_t id;
 
-	// The next infix type in the linked list.
-	struct s_ir_infix_type* next;
-} ir_infix_type_t;
+	// One plus the index of the binding of the same name this binding shadows, or 0 if there is none.
+	size_t shadowed;
+} ir_binding_t;
 
-// Represents a scope.
+// Represents the type and value of a variable (the value can be null).
+typedef struct
+{
+	type_t* type;
+	ir_sexpr_t* value;
+} ir_var_t;
+
+// Represents a chain of nested scopes. Names are bound on a single stack and each name maps to its innermost binding,
+// so entering and leaving a scope only moves the base of the innermost scope. Variables are stored by binding id.
 typedef struct s_ir_scope
 {
-	// A hashmap of all variable names mapped to their types in the current scope.
-	hashmap_t* var_types;
+	// The stack of name bindings, innermost last. Global bindings are at the bottom of the stack.
+	ir_binding_t* bindings;
+	size_t binding_count;
+	size_t binding_size;
 
-	// A hashmap of all variable names mapped to their values in the current scope.
-	hashmap_t* var_vals;
+	// The index of the first binding in the innermost scope, and the number of local scopes entered.
+	size_t base;
+	size_t depth;
 
-	// A hashmap of all the types mapped by their names in the current scope.
-	hashmap_t* types;
+	// The let level of the binding being checked, which decides which type variables can be generalised.
+	size_t level;
+
+	// A hashmap of all variable names mapped to one plus the index of their innermost binding, or NULL if they're unbound.
+	hashmap_t* var_indices;
+
+	// The global variables, indexed by global index.
+	ir_var_t* globals;
+	size_t global_count;
+	size_t global_size;
 
-	// The infix operations defined for the current scope.
-	ir_infix_type_t* infix_ops[INFIX_OP_COUNT];
+	// The local variables of the full expression being checked, indexed by slot.
+	ir_var_t* locals;
+	size_t local_size;
 
-	// The parent scope.
-	struct s_ir_scope* parent;
+	// A hashmap of all the types mapped by their names.
+	hashmap_t* types;
+
+	// The operator signatures defined for the scope, indexed by operator.
+	ir_op_index_t infix_ops[INFIX_OP_COUNT];
 } ir_scope_t;
 
-// push_scope(ir_scope_t*) -> ir_scope_t*
-// Initialises a scope and pushes it onto the stack of scopes.
-ir_scope_t* push_scope(ir_scope_t* parent);
+// init_scope(void) -> ir_scope_t*
+// Initialises a global scope.
+ir_scope_t* init_scope(void);
+
+// push_scope(ir_scope_t*) -> size_t
+// Enters a new innermost scope, returning the base of the enclosing scope.
+size_t push_scope(ir_scope_t* scope);
+
+// pop_scope(ir_scope_t*, size_t) -> void
+// Removes the bindings of the innermost scope and returns to the enclosing scope with the given base.
+void pop_scope(ir_scope_t* scope, size_t base);
+
+// restore_scope(ir_scope_t*, size_t) -> void
+// Removes every binding after the first binding_count bindings and returns to the global scope.
+void restore_scope(ir_scope_t* scope, size_t binding_count);
+
+// bind_var(ir_scope_t*, char*) -> ir_binding_id_t
+// Binds a name in the innermost scope and returns the variable it refers to. Names already bound in the innermost scope keep their variable.
+ir_binding_id_t bind_var(ir_scope_t* scope, char* name);
+
+// scope_lookup_binding(ir_scope_t*, char*, ir_binding_id_t*) -> bool
+// Looks up the variable a name refers to, returning false if the name is unbound.
+bool scope_lookup_binding(ir_scope_t* scope, char* name, ir_binding_id_t* id);
+
+// scope_var(ir_scope_t*, ir_binding_id_t) -> ir_var_t*
+// Returns the type and value of a variable.
+ir_var_t* scope_var(ir_scope_t* scope, ir_binding_id_t id);
 
 // add_prefix_op(ir_scope_t*, type_t*, type_t*) -> void
 // Adds a new prefix operator to the scope.
@@ -64,20 +140,21 @@ type_t* scope_lookup_prefix(ir_scope_t* scope, type_t* operand);
 // Looks up an infix operator based on the argument types and returns the result type.
 type_t* scope_lookup_infix(ir_scope_t* scope, ir_binops_t op, type_t* left, type_t* right);
 
-// scope_lookup_var_type(ir_scope_t*, char*) -> type_t*
-// Looks up the type of a variable in the scope.
-type_t* scope_lookup_var_type(ir_scope_t* scope, char* name);
-
-// scope_lookup_var_val(ir_scope_t*, char*) -> ir_sexpr_t*
-// Looks up the value of a variable in the scope.
-ir_sexpr_t* scope_lookup_var_val(ir_scope_t* scope, char* name);
-
 // scope_lookup_type(ir_scope_t*, char*) -> type_t*
 // Looks up a type in the scope.
 type_t* scope_lookup_type(ir_scope_t* scope, char* name);
 
-// pop_scope(ir_scope_t* scope)
-// Deletes a scope and returns its parent.
-ir_scope_t* pop_scope(ir_scope_t* scope);
+// fork_scope(ir_scope_t*) -> ir_scope_t*
+// Creates a scope for checking a root S expression on another thread. The fork shares the bindings, globals, types,
+// and operator signatures of the scope, but has its own locals and operator resolutions.
+ir_scope_t* fork_scope(ir_scope_t* scope);
+
+// del_forked_scope(ir_scope_t*) -> void
+// Deletes a scope created by fork_scope.
+void del_forked_scope(ir_scope_t* fork);
+
+// del_scope(ir_scope_t*) -> void
+// Deletes a global scope.
+void del_scope(ir_scope_t* scope);
 
 #endif /* SCOPE_H */
@@ -10,6 +10,7 @@
 #include <string.h>
 
 #include "../../../utils/list.h"
+#include "infer.h"
 #include "type_generators.h"
 
 // generate_type(ast_t*, ir_scope_t*, ast_t*, type_t*) -> type_t*
@@ -37,8 +38,31 @@ type_t* generate_type(ast_t* ast, ir_scope_t* scope, ast_t* self, type_t* head)
 		{
 			printf("Undeclared type %s found at %i:%i\n", ast->value.value, ast->value.lino, ast->value.charpos);
 			return NULL;
+		} else if (type->type_type != IR_TYPES_PARAMETRIC && ast->children_count == 0)
+			return type;
+
+		// Parametric types must be given an argument for every parameter
+		size_t param_count = type->type_type == IR_TYPES_PARAMETRIC ? type->field_count - 1 : 0;
+		if (ast->children_count != param_count)
+		{
+			printf("Type %s given %zu arguments instead of %zu found at %i:%i\n", ast->value.value, ast->children_count, param_count, ast->value.lino, ast->value.charpos);
+			return NULL;
 		}
-		return type;
+
+		// Create the instance of the parametric type
+		type_t** args = calloc(param_count, sizeof(type_t*));
+		for (size_t i = 0; i < param_count; i++)
+		{
+			args[i] = generate_type(ast->children[i], scope, self, head);
+			if (args[i] == NULL)
+			{
+				free(args);
+				return NULL;
+			}
+		}
+		type_t* instance = make_type(IR_TYPES_INSTANCE, type->type_name, param_count, args, NULL);
+		free(args);
+		return instance;
 
 	// Functions
 	} else if (ast->value.type == LEX_TYPE_SYMBOL)
@@ -63,11 +87,14 @@ type_t* generate_type(ast_t* ast, ir_scope_t* scope, ast_t* self, type_t* head)
 		ast_t* field_type = ast->children[1];
 		type_t* subtype = generate_type(field_type, scope, self, head);
 
-		// Create a new type
-		type->field_names[0] = strdup(field_name->value.value);
+		// Create a new type, borrowing the name until it's known not to be a duplicate (which is freed without its names)
+		type->field_names[0] = field_name->value.value;
 		type->field_types[0] = subtype;
 		ast->type = scope_lookup_type(scope, "Type");
-		return type;
+		type_t* interned = intern_type(type);
+		if (interned == type)
+			type->field_names[0] = strdup(field_name->value.value);
+		return interned;
 
 	// Generator types
 	} else if (!strcmp(ast->value.value, "*") && ast->children_count == 1)
@@ -78,7 +105,7 @@ type_t* generate_type(ast_t* ast, ir_scope_t* scope, ast_t* self, type_t* head)
 		type_t* subtype = generate_type(ast->children[0], scope, self, head);
 		if (subtype == NULL) return NULL;
 		type->field_types[0] = subtype;
-		return type;
+		return intern_type(type);
 
 	// Product types
 	} else if (!strcmp(ast->value.value, "*"))
@@ -115,7 +142,7 @@ type_t* generate_type(ast_t* ast, ir_scope_t* scope, ast_t* self, type_t* head)
 		{
 			type->field_types[i] = types[count - i - 1];
 		}
-		return type;
+		return intern_type(type);
 
 	// Union types
 	} else if (!strcmp(ast->value.value, "|"))
@@ -175,7 +202,7 @@ type_t* generate_type(ast_t* ast, ir_scope_t* scope, ast_t* self, type_t* head)
 			type->field_types[i] = types[count - i - 1];
 			type->field_names[i] = names[count - i - 1];
 		}
-		return type;
+		return intern_type(type);
 
 	// Intersection types
 	} else if (!strcmp(ast->value.value, "&"))
@@ -243,7 +270,7 @@ type_t* generate_type(ast_t* ast, ir_scope_t* scope, ast_t* self, type_t* head)
 			type->field_types[i] = types[count - i - 1];
 			type->field_names[i] = names[count - i - 1];
 		}
-		return type;
+		return intern_type(type);
 
 	// Function types
 	} else if (ast->value.type == LEX_TYPE_RIGHT_ARROW)
@@ -255,7 +282,7 @@ type_t* generate_type(ast_t* ast, ir_scope_t* scope, ast_t* self, type_t* head)
 		if (type->field_types[0] == NULL) return NULL;
 		type->field_types[1] = generate_type(ast->children[1], scope, self, head);
 		if (type->field_types[1] == NULL) return NULL;
-		return type;
+		return intern_type(type);
 
 	// List types
 	} else if (!strcmp(ast->value.value, "[") && ast->children_count == 1)
@@ -266,7 +293,7 @@ type_t* generate_type(ast_t* ast, ir_scope_t* scope, ast_t* self, type_t* head)
 		type_t* subtype = generate_type(ast->children[0], scope, self, head);
 		if (subtype == NULL) return NULL;
 		type->field_types[0] = subtype;
-		return type;
+		return intern_type(type);
 
 	// Error on anything else
 	} else
@@ -276,6 +303,54 @@ type_t* generate_type(ast_t* ast, ir_scope_t* scope, ast_t* self, type_t* head)
 	}
 }
 
+// generate_declared_type(ast_t*, ast_t*, ir_scope_t*) -> type_t*
+// Generates the type declared by name = type and adds it to the scope. The parameters of parametric types (T => type)
+// are generic type variables, and the body refers to the parametric type through instances of it.
+type_t* generate_declared_type(ast_t* name, ast_t* ast, ir_scope_t* scope)
+{
+	// Nonparametric types can refer to themselves directly
+	if (ast->value.type != LEX_TYPE_THICC_ARROW)
+	{
+		type_t* type = generate_type(ast, scope, name, NULL);
+		if (type != NULL)
+			map_add(scope->types, name->value.value, type);
+		return type;
+	}
+
+	// Bind the parameters while the body is generated
+	size_t param_count = ast->children_count - 1;
+	type_t* parametric = init_type(IR_TYPES_PARAMETRIC, name->value.value, param_count + 1);
+	type_t** shadowed = calloc(param_count, sizeof(type_t*));
+	for (size_t i = 0; i < param_count; i++)
+	{
+		char* param = ast->children[i]->value.value;
+		parametric->field_names[i] = strdup(param);
+		parametric->field_types[i] = new_type_var(IR_TYPE_GENERIC_LEVEL);
+		shadowed[i] = scope_lookup_type(scope, param);
+		map_add(scope->types, param, parametric->field_types[i]);
+	}
+	map_add(scope->types, name->value.value, parametric);
+	type_t* body = generate_type(ast->children[param_count], scope, NULL, NULL);
+
+	// Unbind the parameters
+	for (size_t i = param_count; i-- > 0;)
+	{
+		if (shadowed[i] != NULL)
+			map_add(scope->types, parametric->field_names[i], shadowed[i]);
+		else map_remove(scope->types, parametric->field_names[i]);
+	}
+	free(shadowed);
+
+	// Remove the type if its body is invalid
+	if (body == NULL)
+	{
+		map_remove(scope->types, name->value.value);
+		return NULL;
+	}
+	parametric->field_types[param_count] = body;
+	return parametric;
+}
+
 // generate_enum(ast_t*, ir_scope_t*, type_t*) -> type_t*
 // Generates an enum type from a given ast.
 type_t* generate_enum(ast_t* ast, ir_scope_t* scope, type_t* head)
@@ -284,11 +359,10 @@ type_t* generate_enum(ast_t* ast, ir_scope_t* scope, type_t* head)
 	if (ast->value.type == LEX_TYPE_SYMBOL && ast->children_count == 0)
 	{
 		// Create the enum
-		type_t* enumy = init_type(IR_TYPES_ENUMERATION, ast->value.value, 0); // ast->children_count);
+		type_t* enumy = make_type(IR_TYPES_ENUMERATION, ast->value.value, 0, NULL, NULL); // ast->children_count);
 		ast->type = enumy;
 
-		map_add(scope->var_types, ast->value.value, head);
-		map_add(scope->var_vals, ast->value.value, ast);
+		scope_var(scope, bind_var(scope, ast->value.value))->type = head;
 
 		return enumy;
 
@@ -16,6 +16,10 @@
 // Generates a type from an infix expression.
 type_t* generate_type(ast_t* ast, ir_scope_t* scope, ast_t* self, type_t* head);
 
+// generate_declared_type(ast_t*, ast_t*, ir_scope_t*) -> type_t*
+// Generates the type declared by name = type and adds it to the scope.
+type_t* generate_declared_type(ast_t* name, ast_t* ast, ir_scope_t* scope);
+
 // generate_enum(ast_t*, ir_scope_t*, type_t*) -> type_t*
 // Generates an enum type from a given ast.
 type_t* generate_enum(ast_t* ast, ir_scope_t* scope, type_t* head);
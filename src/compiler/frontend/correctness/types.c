@@ -6,14 +6,60 @@
 // Created on August 29 2020.
 // 
 
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
+#include "../../../utils/list.h"
 #include "scope.h"
 #include "types.h"
 
+// Guards every type store below, since independent definitions are checked on several threads at once.
+static pthread_mutex_t type_store_lock = PTHREAD_MUTEX_INITIALIZER;
+
 static type_t* type_linked_list_head = NULL;
 
+// The id given to the next type created. Ids are never reused, so cached ids stay unambiguous across compilations.
+static size_t next_type_id = 1;
+
+// The table of interned types, chained through bucket_next.
+static type_t** type_table = NULL;
+static size_t type_table_size = 0;
+static size_t type_table_count = 0;
+
+// The initial number of buckets in the interned type table.
+#define TYPE_TABLE_INITIAL_SIZE 64
+
+// Represents a memoised subtype check.
+typedef struct
+{
+	type_t* super;
+	type_t* sub;
+	bool result;
+} subtype_entry_t;
+
+// The cache of subtype results, using open addressing. Empty slots have a NULL super type.
+static subtype_entry_t* subtype_cache = NULL;
+static size_t subtype_cache_size = 0;
+static size_t subtype_cache_count = 0;
+
+// The subtype checks in progress, which are assumed to hold if they are reached again (for recursive types).
+static subtype_entry_t* subtype_assumptions = NULL;
+static size_t subtype_assumptions_size = 0;
+static size_t subtype_assumptions_count = 0;
+
+// The successes found during the subtype checks in progress that relied on assumptions not yet known to hold.
+static subtype_entry_t* subtype_pending = NULL;
+static size_t subtype_pending_size = 0;
+static size_t subtype_pending_count = 0;
+
+// The index of the outermost assumption the subtype check in progress has relied on, or SIZE_MAX if none.
+static size_t subtype_lowest_assumption = SIZE_MAX;
+
+// The initial number of slots in the subtype cache.
+#define SUBTYPE_CACHE_INITIAL_SIZE 256
+
 // create_primatives(ir_scope_t*) -> void
 // Creates the builtin primative types.
 void create_primatives(ir_scope_t* scope)
@@ -23,12 +69,12 @@ void create_primatives(ir_scope_t* scope)
 		return;
 
 	// Create primatives
-	type_t* _int = init_type(IR_TYPES_PRIMITIVE, "Int", 0);
-	type_t* _float = init_type(IR_TYPES_PRIMITIVE, "Float", 0);
-	init_type(IR_TYPES_PRIMITIVE, "String", 0);
-	init_type(IR_TYPES_PRIMITIVE, "Bool", 0);
-	//init_type(IR_TYPES_PRIMITIVE, "Dict", 0);
-	init_type(IR_TYPES_PRIMITIVE, "Enum", 0);
+	type_t* _int = make_type(IR_TYPES_PRIMITIVE, "Int", 0, NULL, NULL);
+	type_t* _float = make_type(IR_TYPES_PRIMITIVE, "Float", 0, NULL, NULL);
+	make_type(IR_TYPES_PRIMITIVE, "String", 0, NULL, NULL);
+	make_type(IR_TYPES_PRIMITIVE, "Bool", 0, NULL, NULL);
+	//make_type(IR_TYPES_PRIMITIVE, "Dict", 0, NULL, NULL);
+	make_type(IR_TYPES_PRIMITIVE, "Enum", 0, NULL, NULL);
 
 	// Add to scope
 	type_t* head = type_linked_list_head;
@@ -67,9 +113,20 @@ void create_primatives(ir_scope_t* scope)
 	add_prefix_op(scope, _float, _float);
 }
 
-// init_type(ir_type_types_t, char*, size_t, type_t) -> type_t*
-// Initialises a new type.
-type_t* init_type(ir_type_types_t type_type, char* name, size_t field_count)
+// reserve_type_ids(size_t) -> size_t
+// Reserves count consecutive type ids for types that weren't created by init_type, returning the first.
+size_t reserve_type_ids(size_t count)
+{
+	pthread_mutex_lock(&type_store_lock);
+	size_t first = next_type_id;
+	next_type_id += count;
+	pthread_mutex_unlock(&type_store_lock);
+	return first;
+}
+
+// init_type_helper(ir_type_types_t, char*, size_t) -> type_t*
+// Helper function for init_type that expects the type store to be locked.
+type_t* init_type_helper(ir_type_types_t type_type, char* name, size_t field_count)
 {
 	type_t* type = malloc(sizeof(type_t));
 	type->printing = false;
@@ -79,20 +136,295 @@ type_t* init_type(ir_type_types_t type_type, char* name, size_t field_count)
 	type->field_types = calloc(field_count, sizeof(type_t*));
 	type->field_names = calloc(field_count, sizeof(char*));
 	type->field_count = field_count;
+	type->link = NULL;
+	type->level = 0;
+	type->has_vars = false;
+	type->id = next_type_id++;
+	type->interned = false;
+	type->hash = 0;
+	type->bucket_next = NULL;
 
 	// Add to linked list
 	type->next = type_linked_list_head;
+	type->prev = NULL;
+	if (type_linked_list_head != NULL)
+		type_linked_list_head->prev = type;
 	type_linked_list_head = type;
 	return type;
 }
 
-// type_subtype(type_t*, type_t*) -> bool
-// Returns true if the second type is a valid type under the first type.
-bool type_subtype(type_t* super, type_t* sub)
+// init_type(ir_type_types_t, char*, size_t) -> type_t*
+// Initialises a new type.
+type_t* init_type(ir_type_types_t type_type, char* name, size_t field_count)
 {
-	if (super == NULL || sub == NULL)
-		return super == sub;
+	pthread_mutex_lock(&type_store_lock);
+	type_t* type = init_type_helper(type_type, name, field_count);
+	pthread_mutex_unlock(&type_store_lock);
+	return type;
+}
 
+// hash_type(ir_type_types_t, char*, size_t, type_t**, char**) -> size_t
+// Hashes the structure of a type whose fields are interned.
+size_t hash_type(ir_type_types_t type_type, char* name, size_t field_count, type_t** field_types, char** field_names)
+{
+	// FNV-1a over the type of type, the names, and the field pointers
+	size_t hash = 14695981039346656037UL;
+	hash = (hash ^ type_type) * 1099511628211UL;
+	hash = (hash ^ field_count) * 1099511628211UL;
+	for (char* c = name; c != NULL && *c != '\0'; c++)
+	{
+		hash = (hash ^ (unsigned char) *c) * 1099511628211UL;
+	}
+	for (size_t i = 0; i < field_count; i++)
+	{
+		hash = (hash ^ (size_t) field_types[i]) * 1099511628211UL;
+		for (char* c = field_names != NULL ? field_names[i] : NULL; c != NULL && *c != '\0'; c++)
+		{
+			hash = (hash ^ (unsigned char) *c) * 1099511628211UL;
+		}
+	}
+	return hash;
+}
+
+// names_equal(char*, char*) -> bool
+// Returns whether two names that may be NULL are equal.
+bool names_equal(char* n1, char* n2)
+{
+	if (n1 == NULL || n2 == NULL)
+		return n1 == n2;
+	return !strcmp(n1, n2);
+}
+
+// type_has_structure(type_t*, ir_type_types_t, char*, size_t, type_t**, char**) -> bool
+// Returns whether a type has the given structure.
+bool type_has_structure(type_t* type, ir_type_types_t type_type, char* name, size_t field_count, type_t** field_types, char** field_names)
+{
+	if (type->type_type != type_type || type->field_count != field_count || !names_equal(type->type_name, name))
+		return false;
+	for (size_t i = 0; i < field_count; i++)
+	{
+		if (type->field_types[i] != field_types[i] || !names_equal(type->field_names[i], field_names != NULL ? field_names[i] : NULL))
+			return false;
+	}
+	return true;
+}
+
+// lookup_interned_type(size_t, ir_type_types_t, char*, size_t, type_t**, char**) -> type_t*
+// Looks up the interned type with the given structure, returning NULL if there isn't one.
+type_t* lookup_interned_type(size_t hash, ir_type_types_t type_type, char* name, size_t field_count, type_t** field_types, char** field_names)
+{
+	if (type_table_size == 0)
+		return NULL;
+	for (type_t* type = type_table[hash % type_table_size]; type != NULL; type = type->bucket_next)
+	{
+		if (type->hash == hash && type_has_structure(type, type_type, name, field_count, field_types, field_names))
+			return type;
+	}
+	return NULL;
+}
+
+// add_interned_type(type_t*, size_t) -> void
+// Adds a type to the table of interned types, growing the table if necessary.
+void add_interned_type(type_t* type, size_t hash)
+{
+	// Grow the table once there are as many types as buckets
+	if (type_table_count >= type_table_size)
+	{
+		size_t size = type_table_size != 0 ? type_table_size * 2 : TYPE_TABLE_INITIAL_SIZE;
+		type_t** table = calloc(size, sizeof(type_t*));
+		for (size_t i = 0; i < type_table_size; i++)
+		{
+			type_t* bucket = type_table[i];
+			while (bucket != NULL)
+			{
+				type_t* next = bucket->bucket_next;
+				bucket->bucket_next = table[bucket->hash % size];
+				table[bucket->hash % size] = bucket;
+				bucket = next;
+			}
+		}
+		free(type_table);
+		type_table = table;
+		type_table_size = size;
+	}
+
+	// Add the type to its bucket
+	type->interned = true;
+	type->hash = hash;
+	type->bucket_next = type_table[hash % type_table_size];
+	type_table[hash % type_table_size] = type;
+	type_table_count++;
+}
+
+// fields_interned(size_t, type_t**) -> bool
+// Returns whether every field type is interned.
+bool fields_interned(size_t field_count, type_t** field_types)
+{
+	for (size_t i = 0; i < field_count; i++)
+	{
+		if (field_types[i] == NULL || !field_types[i]->interned)
+			return false;
+	}
+	return true;
+}
+
+// fields_have_vars(size_t, type_t**) -> bool
+// Returns whether any field type is or contains a type variable.
+bool fields_have_vars(size_t field_count, type_t** field_types)
+{
+	for (size_t i = 0; i < field_count; i++)
+	{
+		if (field_types[i] != NULL && (field_types[i]->type_type == IR_TYPES_VAR || field_types[i]->has_vars))
+			return true;
+	}
+	return false;
+}
+
+// make_type_helper(ir_type_types_t, char*, size_t, type_t**, char**) -> type_t*
+// Helper function for make_type that expects the type store to be locked.
+type_t* make_type_helper(ir_type_types_t type_type, char* name, size_t field_count, type_t** field_types, char** field_names)
+{
+	// Look up the type if it can be interned
+	bool internable = fields_interned(field_count, field_types);
+	size_t hash = 0;
+	if (internable)
+	{
+		hash = hash_type(type_type, name, field_count, field_types, field_names);
+		type_t* type = lookup_interned_type(hash, type_type, name, field_count, field_types, field_names);
+		if (type != NULL)
+			return type;
+	}
+
+	// Create a new type
+	type_t* type = init_type_helper(type_type, name, field_count);
+	for (size_t i = 0; i < field_count; i++)
+	{
+		type->field_types[i] = field_types[i];
+		type->field_names[i] = field_names != NULL && field_names[i] != NULL ? strdup(field_names[i]) : NULL;
+	}
+	if (internable)
+		add_interned_type(type, hash);
+	else type->has_vars = fields_have_vars(field_count, field_types);
+	return type;
+}
+
+// make_type(ir_type_types_t, char*, size_t, type_t**, char**) -> type_t*
+// Returns the unique type with the given structure, creating it if it doesn't exist yet. field_names may be NULL.
+type_t* make_type(ir_type_types_t type_type, char* name, size_t field_count, type_t** field_types, char** field_names)
+{
+	pthread_mutex_lock(&type_store_lock);
+	type_t* type = make_type_helper(type_type, name, field_count, field_types, field_names);
+	pthread_mutex_unlock(&type_store_lock);
+	return type;
+}
+
+// intern_type_helper(type_t*) -> type_t*
+// Helper function for intern_type that expects the type store to be locked.
+type_t* intern_type_helper(type_t* type)
+{
+	if (type == NULL || type->interned)
+		return type;
+	else if (!fields_interned(type->field_count, type->field_types))
+	{
+		type->has_vars = fields_have_vars(type->field_count, type->field_types);
+		return type;
+	}
+
+	// Add the type if it's new
+	size_t hash = hash_type(type->type_type, type->type_name, type->field_count, type->field_types, type->field_names);
+	type_t* interned = lookup_interned_type(hash, type->type_type, type->type_name, type->field_count, type->field_types, type->field_names);
+	if (interned == NULL)
+	{
+		add_interned_type(type, hash);
+		return type;
+	}
+
+	// Remove the duplicate from the linked list and free it. Its field names are borrowed from other types (or from the
+	// ast), so only the array holding them is freed
+	if (type->prev != NULL)
+		type->prev->next = type->next;
+	else type_linked_list_head = type->next;
+	if (type->next != NULL)
+		type->next->prev = type->prev;
+	free(type->type_name);
+	free(type->field_types);
+	free(type->field_names);
+	free(type);
+	return interned;
+}
+
+// intern_loaded_type(type_t*) -> void
+// Adds a type that wasn't created by init_type (such as a type loaded from an IR image) to the table of interned types
+// if its fields are interned and no type with the same structure is interned yet. Otherwise the type isn't interned.
+void intern_loaded_type(type_t* type)
+{
+	pthread_mutex_lock(&type_store_lock);
+	type->interned = false;
+	type->bucket_next = NULL;
+	if (fields_interned(type->field_count, type->field_types))
+	{
+		size_t hash = hash_type(type->type_type, type->type_name, type->field_count, type->field_types, type->field_names);
+		if (lookup_interned_type(hash, type->type_type, type->type_name, type->field_count, type->field_types, type->field_names) == NULL)
+			add_interned_type(type, hash);
+	}
+	pthread_mutex_unlock(&type_store_lock);
+}
+
+// intern_type(type_t*) -> type_t*
+// Replaces a type created by init_type with the unique type with the same structure, freeing it if one already exists.
+// Types that refer to types not yet interned (such as recursive types) are left as they are.
+type_t* intern_type(type_t* type)
+{
+	pthread_mutex_lock(&type_store_lock);
+	type = intern_type_helper(type);
+	pthread_mutex_unlock(&type_store_lock);
+	return type;
+}
+
+// subtype_slot(type_t*, type_t*) -> subtype_entry_t*
+// Returns the slot in the subtype cache for a pair of types, which is empty if the pair isn't cached.
+subtype_entry_t* subtype_slot(type_t* super, type_t* sub)
+{
+	size_t hash = ((size_t) super * 31 + (size_t) sub) * 1099511628211UL;
+	size_t i = (hash >> 4) % subtype_cache_size;
+	while (subtype_cache[i].super != NULL && (subtype_cache[i].super != super || subtype_cache[i].sub != sub))
+	{
+		i = (i + 1) % subtype_cache_size;
+	}
+	return subtype_cache + i;
+}
+
+// cache_subtype(subtype_entry_t) -> void
+// Adds a subtype result to the cache, growing the cache if it's half full.
+void cache_subtype(subtype_entry_t entry)
+{
+	if (subtype_cache_count * 2 >= subtype_cache_size)
+	{
+		// Rehash every entry into a larger cache
+		subtype_entry_t* old = subtype_cache;
+		size_t old_size = subtype_cache_size;
+		subtype_cache_size = old_size != 0 ? old_size * 2 : SUBTYPE_CACHE_INITIAL_SIZE;
+		subtype_cache = calloc(subtype_cache_size, sizeof(subtype_entry_t));
+		for (size_t i = 0; i < old_size; i++)
+		{
+			if (old[i].super != NULL)
+				*subtype_slot(old[i].super, old[i].sub) = old[i];
+		}
+		free(old);
+	}
+
+	subtype_entry_t* slot = subtype_slot(entry.super, entry.sub);
+	if (slot->super == NULL)
+		subtype_cache_count++;
+	*slot = entry;
+}
+
+bool type_subtype_helper(type_t* super, type_t* sub);
+
+// type_subtype_uncached(type_t*, type_t*) -> bool
+// Checks whether the second type is a valid type under the first type without looking up the pair in the cache.
+bool type_subtype_uncached(type_t* super, type_t* sub)
+{
 	// Empty lists are valid subtypes of populated lists
 	if (super->type_type == IR_TYPES_LIST && sub->type_type == IR_TYPES_LIST && sub->field_count == 0)
 		return true;
@@ -101,10 +433,6 @@ bool type_subtype(type_t* super, type_t* sub)
 	else if (super->type_type != IR_TYPES_UNION && (super->type_type != sub->type_type || super->field_count != sub->field_count))
 		return false;
 
-	// Every type is equal to itself
-	else if (super == sub)
-		return true;
-
 	// Check the contents of the type
 	switch (super->type_type)
 	{
@@ -112,11 +440,21 @@ bool type_subtype(type_t* super, type_t* sub)
 		case IR_TYPES_ENUMERATION:
 			// Primatives and enums check if they have the same name and number of subtypes
 			return !strcmp(super->type_name, sub->type_name);
+		case IR_TYPES_INSTANCE:
+			// Instances of the same parametric type are subtypes if their arguments are equal
+			if (strcmp(super->type_name, sub->type_name))
+				return false;
+			for (size_t i = 0; i < super->field_count; i++)
+			{
+				if (!types_equal(super->field_types[i], sub->field_types[i]))
+					return false;
+			}
+			return true;
 		case IR_TYPES_UNION:
 			// Union types check its subtypes against the passed subtype
 			for (size_t i = 0; i < super->field_count; i++)
 			{
-				bool equal = type_subtype(super->field_types[i], sub);
+				bool equal = type_subtype_helper(super->field_types[i], sub);
 				if (equal)
 					return true;
 			}
@@ -129,7 +467,7 @@ bool type_subtype(type_t* super, type_t* sub)
 			// Compound types are equal if their field types are the same
 			for (size_t i = 0; i < super->field_count; i++)
 			{
-				bool equal = (super->field_names[i] != NULL && sub->field_names[i] != NULL ? !strcmp(super->field_names[i], sub->field_names[i]) : true) && type_subtype(super->field_types[i], sub->field_types[i]);
+				bool equal = (super->field_names[i] != NULL && sub->field_names[i] != NULL ? !strcmp(super->field_names[i], sub->field_names[i]) : true) && type_subtype_helper(super->field_types[i], sub->field_types[i]);
 				if (!equal) return false;
 			}
 
@@ -139,20 +477,100 @@ bool type_subtype(type_t* super, type_t* sub)
 	}
 }
 
+// type_subtype_helper(type_t*, type_t*) -> bool
+// Helper function for type_subtype that expects the type store to be locked.
+bool type_subtype_helper(type_t* super, type_t* sub)
+{
+	// Every type is equal to itself
+	if (super == sub)
+		return true;
+	else if (super == NULL || sub == NULL)
+		return false;
+
+	// Look up the pair in the cache
+	if (subtype_cache_size != 0)
+	{
+		subtype_entry_t* slot = subtype_slot(super, sub);
+		if (slot->super != NULL)
+			return slot->result;
+	}
+
+	// A pair already being checked is assumed to hold, since recursive types are checked coinductively
+	for (size_t i = 0; i < subtype_assumptions_count; i++)
+	{
+		if (subtype_assumptions[i].super == super && subtype_assumptions[i].sub == sub)
+		{
+			if (i < subtype_lowest_assumption)
+				subtype_lowest_assumption = i;
+			return true;
+		}
+	}
+
+	// Check the pair under the assumption that it holds
+	size_t depth = subtype_assumptions_count;
+	size_t pending_start = subtype_pending_count;
+	size_t outer_lowest = subtype_lowest_assumption;
+	subtype_lowest_assumption = SIZE_MAX;
+	list_append_element(subtype_assumptions, subtype_assumptions_size, subtype_assumptions_count, subtype_entry_t, ((subtype_entry_t) {super, sub, true}));
+	bool result = type_subtype_uncached(super, sub);
+	subtype_assumptions_count--;
+	size_t lowest = subtype_lowest_assumption;
+	subtype_lowest_assumption = outer_lowest;
+
+	// Assuming more pairs hold never turns a success into a failure, so failures are certain. The successes found
+	// while checking a failed pair may have relied on it holding though, so they're dropped.
+	if (!result)
+	{
+		subtype_pending_count = pending_start;
+		cache_subtype((subtype_entry_t) {super, sub, false});
+	}
+
+	// A success that relied on no pairs checked outside of it holds along with every success found while checking it
+	else if (lowest >= depth)
+	{
+		for (size_t i = pending_start; i < subtype_pending_count; i++)
+		{
+			cache_subtype(subtype_pending[i]);
+		}
+		subtype_pending_count = pending_start;
+		cache_subtype((subtype_entry_t) {super, sub, true});
+	}
+
+	// Otherwise it waits until the outermost pair it relied on is known to hold
+	else
+	{
+		list_append_element(subtype_pending, subtype_pending_size, subtype_pending_count, subtype_entry_t, ((subtype_entry_t) {super, sub, true}));
+		if (lowest < subtype_lowest_assumption)
+			subtype_lowest_assumption = lowest;
+	}
+	return result;
+}
+
+// type_subtype(type_t*, type_t*) -> bool
+// Returns true if the second type is a valid type under the first type.
+bool type_subtype(type_t* super, type_t* sub)
+{
+	pthread_mutex_lock(&type_store_lock);
+	bool result = type_subtype_helper(super, sub);
+	pthread_mutex_unlock(&type_store_lock);
+	return result;
+}
+
 // types_equal(type_t*, type_t*) -> bool
 // Returns whether the two types are equal or not.
 bool types_equal(type_t* t1, type_t* t2)
 {
-	if (t1 == NULL || t2 == NULL)
-		return t1 == t2;
+	// Every type is equal to itself, and interned types are equal to no other interned type
+	if (t1 == t2)
+		return true;
+	else if (t1 == NULL || t2 == NULL || (t1->interned && t2->interned))
+		return false;
 
-	// Types must be the same type of type and have the same number of fields
+	// Types must be the same type of type and have the same number of fields, and instances must be of the same parametric type
 	if (t1->type_type != t2->type_type || t1->field_count != t2->field_count)
 		return false;
-
-	// Every type is equal to itself
-	else if (t1 == t2)
-		return true;
+	else if (t1->type_type == IR_TYPES_INSTANCE && strcmp(t1->type_name, t2->type_name))
+		return false;
 
 	// Check the contents of the type
 	switch (t1->type_type)
@@ -167,6 +585,7 @@ bool types_equal(type_t* t1, type_t* t2)
 		case IR_TYPES_GENERATOR:
 		case IR_TYPES_FUNC:
 		case IR_TYPES_CURRY:
+		case IR_TYPES_INSTANCE:
 			// Compound types are equal if their field types are the same
 			for (size_t i = 0; i < t1->field_count; i++)
 			{
@@ -224,6 +643,15 @@ void print_type_helper(type_t* type, char* name, int level)
 		case IR_TYPES_FUNC:
 			printf("func");
 			break;
+		case IR_TYPES_VAR:
+			printf("var");
+			break;
+		case IR_TYPES_PARAMETRIC:
+			printf("parametric");
+			break;
+		case IR_TYPES_INSTANCE:
+			printf("instance");
+			break;
 		default:
 			printf("type");
 			break;
@@ -260,6 +688,67 @@ void print_type_helper(type_t* type, char* name, int level)
 // Prints out a type.
 void print_type(type_t* type) { print_type_helper(type, NULL, 0); }
 
+// print_type_inline_helper(type_t*, type_t***, size_t*, size_t*) -> void
+// Prints out a type on one line, naming type variables in the order they appear.
+void print_type_inline_helper(type_t* type, type_t*** vars, size_t* vars_size, size_t* var_count)
+{
+	// Follow bound type variables
+	while (type != NULL && type->type_type == IR_TYPES_VAR && type->link != NULL)
+	{
+		type = type->link;
+	}
+
+	if (type == NULL)
+		printf("?");
+	else if (type->type_type == IR_TYPES_VAR)
+	{
+		// Find the name of the variable
+		size_t index = 0;
+		while (index < *var_count && (*vars)[index] != type)
+		{
+			index++;
+		}
+		if (index == *var_count)
+			list_append_element(*vars, *vars_size, *var_count, type_t*, type);
+		printf("'%c", (char) ('a' + index % 26));
+	} else if (type->type_type == IR_TYPES_INSTANCE)
+	{
+		printf("(%s", type->type_name);
+		for (size_t i = 0; i < type->field_count; i++)
+		{
+			printf(" ");
+			print_type_inline_helper(type->field_types[i], vars, vars_size, var_count);
+		}
+		printf(")");
+	} else if (type->type_name != NULL)
+		printf("%s", type->type_name);
+	else if (type->type_type == IR_TYPES_FUNC)
+	{
+		printf("(");
+		print_type_inline_helper(type->field_types[0], vars, vars_size, var_count);
+		printf(" -> ");
+		print_type_inline_helper(type->field_types[1], vars, vars_size, var_count);
+		printf(")");
+	} else if (type->type_type == IR_TYPES_LIST || type->type_type == IR_TYPES_GENERATOR)
+	{
+		printf(type->type_type == IR_TYPES_LIST ? "[" : "gen [");
+		if (type->field_count != 0)
+			print_type_inline_helper(type->field_types[0], vars, vars_size, var_count);
+		printf("]");
+	} else printf("type");
+}
+
+// print_type_inline(type_t*) -> void
+// Prints out a type on one line.
+void print_type_inline(type_t* type)
+{
+	type_t** vars = NULL;
+	size_t vars_size = 0;
+	size_t var_count = 0;
+	print_type_inline_helper(type, &vars, &vars_size, &var_count);
+	free(vars);
+}
+
 // clean_types(void) -> void
 // Frees every type created.
 void clean_types()
@@ -277,4 +766,22 @@ void clean_types()
 		free(type_linked_list_head);
 		type_linked_list_head = tail;
 	}
+
+	// Empty the interned type table
+	free(type_table);
+	type_table = NULL;
+	type_table_size = 0;
+	type_table_count = 0;
+
+	// Empty the subtype cache, since its keys are the types just freed
+	free(subtype_cache);
+	subtype_cache = NULL;
+	subtype_cache_size = 0;
+	subtype_cache_count = 0;
+	free(subtype_assumptions);
+	subtype_assumptions = NULL;
+	subtype_assumptions_size = 0;
+	free(subtype_pending);
+	subtype_pending = NULL;
+	subtype_pending_size = 0;
 }
@@ -11,6 +11,7 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "../../../utils/hashmap.h"
 
@@ -24,7 +25,10 @@ typedef enum
 	IR_TYPES_LIST,
 	IR_TYPES_GENERATOR,
 	IR_TYPES_FUNC,
-	IR_TYPES_CURRY
+	IR_TYPES_CURRY,
+	IR_TYPES_VAR,
+	IR_TYPES_PARAMETRIC,
+	IR_TYPES_INSTANCE
 } ir_type_types_t;
 
 // Represents a curly type in the intermediate representation.
@@ -43,24 +47,67 @@ typedef struct s_type
 	char* type_name;
 
 	// Array of field names (names can be null)
+	// Parametric types have their parameters followed by their body as fields, and instances of parametric types
+	// are named after the parametric type and have the type arguments as fields.
 	char** field_names;
 	struct s_type** field_types;
 	size_t field_count;
 
+	// The type a type variable was unified with, or NULL if the variable is unbound.
+	struct s_type* link;
+
+	// The let level a type variable was created at. Generic variables have the level IR_TYPE_GENERIC_LEVEL.
+	size_t level;
+
+	// Whether the type contains type variables. Such types are never interned.
+	bool has_vars;
+
+	// A unique id for the type, used to key operator indices.
+	size_t id;
+
+	// Whether the type is in the table of interned types. Interned types are equal if and only if they are the same pointer.
+	bool interned;
+
+	// The hash of the type and the next type in its bucket of the interned type table.
+	size_t hash;
+	struct s_type* bucket_next;
+
 	// Linked list of types
 	struct s_type* next;
+	struct s_type* prev;
 } type_t;
 
+// The level of generic type variables, which are replaced with new variables wherever their type is used.
+#define IR_TYPE_GENERIC_LEVEL SIZE_MAX
+
 typedef struct s_ir_scope ir_scope_t;
 
 // create_primatives(ir_scope_t*) -> void
 // Creates the builtin primative types.
 void create_primatives(ir_scope_t* scope);
 
+// reserve_type_ids(size_t) -> size_t
+// Reserves count consecutive type ids for types that weren't created by init_type, returning the first.
+size_t reserve_type_ids(size_t count);
+
 // init_type(ir_type_types_t, char*, size_t) -> type_t*
 // Initialises a new type.
 type_t* init_type(ir_type_types_t type_type, char* name, size_t field_count);
 
+// make_type(ir_type_types_t, char*, size_t, type_t**, char**) -> type_t*
+// Returns the unique type with the given structure, creating it if it doesn't exist yet. field_names may be NULL.
+type_t* make_type(ir_type_types_t type_type, char* name, size_t field_count, type_t** field_types, char** field_names);
+
+// intern_type(type_t*) -> type_t*
+// Replaces a type created by init_type with the unique type with the same structure, freeing it if one already exists.
+// Types that refer to types not yet interned (such as recursive types) are left as they are.
+type_t* intern_type(type_t* type);
+
+// intern_loaded_type(type_t*) -> void
+// Adds a type that wasn't created by init_type (such as a type loaded from an IR image) to the table of interned types
+// if its fields are interned and no type with the same structure is interned yet. Otherwise the type isn't interned.
+void intern_loaded_type(type_t* type);
+
 // type_subtype(type_t*, type_t*) -> bool
 // Returns true if the second type is a valid type under the first type.
 bool type_subtype(type_t* super, type_t* sub);
@@ -73,6 +120,10 @@ bool types_equal(type_t* t1, type_t* t2);
 // Prints out a type.
 void print_type(type_t* type);
 
+// print_type_inline(type_t*) -> void
+// Prints out a type on one line.
+void print_type_inline(type_t* type);
+
 // clean_types(void) -> void
 // Frees every type created.
 void clean_types();
@@ -8,6 +8,7 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <unistd.h>
 
 #include "../../../utils/list.h"
 #include "../correctness/type_generators.h"
@@ -45,16 +46,49 @@ ir_sexpr_t* convert_ast_node(curly_ir_t* root, ast_t* ast, ir_scope_t* scope)
 				sexpr->symbol = strdup(ast->value.value);
 				break;
 			default:
-				puts("Unimplemented operand!");
-				break;
+				printf("Unimplemented operand found at %i:%i\n", ast->value.lino, ast->value.charpos);
+				free(sexpr);
+				return NULL;
 		}
 
+	// List slices
+	} else if (ast->value.type == LEX_TYPE_DOT && ast->children[1]->value.type == LEX_TYPE_APPLICATION
+			&& ast->children[1]->children[0]->value.type == LEX_TYPE_APPLICATION
+			&& !strcmp(ast->children[1]->children[0]->children[0]->value.value, "range"))
+	{
+		sexpr->tag = CURLY_IR_TAGS_SLICE;
+		sexpr->slice.list  = convert_ast_node(root, ast->children[0], scope);
+		sexpr->slice.start = convert_ast_node(root, ast->children[1]->children[0]->children[1], scope);
+		sexpr->slice.end   = convert_ast_node(root, ast->children[1]->children[1], scope);
+
+	// Ranges
+	} else if (ast->value.type == LEX_TYPE_APPLICATION && ast->children[0]->value.type == LEX_TYPE_APPLICATION
+			&& !strcmp(ast->children[0]->children[0]->value.value, "range"))
+	{
+		sexpr->tag = CURLY_IR_TAGS_RANGE;
+		sexpr->range.start = convert_ast_node(root, ast->children[0]->children[1], scope);
+		sexpr->range.end   = convert_ast_node(root, ast->children[1], scope);
+	} else if (ast->value.type == LEX_TYPE_APPLICATION && !strcmp(ast->children[0]->value.value, "from"))
+	{
+		sexpr->tag = CURLY_IR_TAGS_RANGE;
+		sexpr->range.start = convert_ast_node(root, ast->children[1], scope);
+		sexpr->range.end   = NULL;
+
+	// Function applications
+	} else if (ast->value.type == LEX_TYPE_APPLICATION)
+	{
+		sexpr->tag = CURLY_IR_TAGS_APPLY;
+		sexpr->apply.func = convert_ast_node(root, ast->children[0], scope);
+		sexpr->apply.arg  = convert_ast_node(root, ast->children[1], scope);
+
 	// Infix operators
 	} else if (ast->value.tag == LEX_TAG_INFIX_OPERATOR)
 	{
 		sexpr->tag = CURLY_IR_TAGS_INFIX;
 		sexpr->infix.left  = convert_ast_node(root, ast->children[0], scope);
 		sexpr->infix.right = convert_ast_node(root, ast->children[1], scope);
+		sexpr->infix.resolved_left  = NULL;
+		sexpr->infix.resolved_right = NULL;
 		sexpr->infix.op = !strcmp(ast->value.value, "*")   ? IR_BINOPS_MUL
 						: !strcmp(ast->value.value, "/")   ? IR_BINOPS_DIV
 						: !strcmp(ast->value.value, "%")   ? IR_BINOPS_MOD
@@ -74,6 +108,8 @@ ir_sexpr_t* convert_ast_node(curly_ir_t* root, ast_t* ast, ir_scope_t* scope)
 						: !strcmp(ast->value.value, "and") ? IR_BINOPS_BOOLAND
 						: !strcmp(ast->value.value, "or")  ? IR_BINOPS_BOOLOR
 						: !strcmp(ast->value.value, "xor") ? IR_BINOPS_BOOLXOR
+						: !strcmp(ast->value.value, "in")  ? IR_BINOPS_CMPIN
+						: !strcmp(ast->value.value, ".")   ? IR_BINOPS_INDEX
 						: -1;
 
 	// Prefix operators
@@ -81,6 +117,7 @@ ir_sexpr_t* convert_ast_node(curly_ir_t* root, ast_t* ast, ir_scope_t* scope)
 	{
 		sexpr->tag = CURLY_IR_TAGS_PREFIX;
 		sexpr->prefix.operand = convert_ast_node(root, ast->children[0], scope);
+		sexpr->prefix.resolved_operand = NULL;
 		sexpr->prefix.op = !strcmp(ast->value.value, "*") ? IR_BINOPS_SPAN
 						 : !strcmp(ast->value.value, "-") ? IR_BINOPS_NEG
 						 : -1;
@@ -112,19 +149,32 @@ ir_sexpr_t* convert_ast_node(curly_ir_t* root, ast_t* ast, ir_scope_t* scope)
 			func->args = calloc(func->arg_count, sizeof(ir_sexpr_func_arg_t));
 			for (size_t i = 0; i < func->arg_count; i++)
 			{
-				func->args[i].name = strdup(head->children[i]->children[0]->value.value);
-				func->args[i].type = generate_type(head->children[i]->children[1], scope, NULL, NULL);
+				// Arguments without a type have their type inferred
+				ast_t* arg = head->children[i];
+				if (arg->value.type == LEX_TYPE_COLON)
+				{
+					func->args[i].name = strdup(arg->children[0]->value.value);
+					func->args[i].type = generate_type(arg->children[1], scope, NULL, NULL);
+				} else if (arg->value.type == LEX_TYPE_SYMBOL)
+				{
+					func->args[i].name = strdup(arg->value.value);
+					func->args[i].type = NULL;
+				} else
+				{
+					printf("Unsupported function argument found at %i:%i\n", arg->value.lino, arg->value.charpos);
+					return NULL;
+				}
 			}
 
 			// Generate body and add function
 			func->body = convert_ast_node(root, ast->children[1], scope);
-			list_append_element(root->funcs, root->func_size, root->func_count, ir_sexpr_func_arg_t, func);
+			list_append_element(root->funcs, root->func_size, root->func_count, ir_sexpr_func_t*, func);
 
 			// Create wrapper s expression
 			ir_sexpr_t* value = malloc(sizeof(ir_sexpr_t));
 			value->tag = CURLY_IR_TAGS_FUNC;
 			value->func_id = root->func_count - 1;
-			value->type = NULL; // generate_function_type(func, scope)
+			value->type = NULL;
 			value->lino = ast->children[1]->value.lino;
 			value->charpos = ast->children[1]->value.charpos;
 			value->pos = ast->children[1]->value.pos;
@@ -135,9 +185,10 @@ ir_sexpr_t* convert_ast_node(curly_ir_t* root, ast_t* ast, ir_scope_t* scope)
 			return sexpr;
 
 		// TODO attributes, and head/tail
-		} else puts("Unsupported assignment!");
+		} else printf("Unsupported assignment found at %i:%i\n", head->value.lino, head->value.charpos);
 
-		sexpr->assign.name = strdup(name);
+		// The statement fails to convert since the name is missing
+		sexpr->assign.name = name != NULL ? strdup(name) : NULL;
 		sexpr->assign.value = convert_ast_node(root, ast->children[1], scope);
 
 	// Declarations
@@ -170,10 +221,84 @@ ir_sexpr_t* convert_ast_node(curly_ir_t* root, ast_t* ast, ir_scope_t* scope)
 		sexpr->if_expr.then = convert_ast_node(root, ast->children[1], scope);
 		sexpr->if_expr.elsy = convert_ast_node(root, ast->children[2], scope);
 
+	// List comprehensions
+	} else if (!strcmp(ast->value.value, "[") && ast->children_count == 1 && !strcmp(ast->children[0]->value.value, "for")
+			&& ast->children[0]->children_count == 3)
+	{
+		ast_t* fory = ast->children[0];
+		sexpr->tag = CURLY_IR_TAGS_FOR;
+		sexpr->for_loop.loop_type = IR_LOOP_LIST;
+		sexpr->for_loop.var = strdup(fory->children[0]->value.value);
+		sexpr->for_loop.iter = convert_ast_node(root, fory->children[1], scope);
+		sexpr->for_loop.body = convert_ast_node(root, fory->children[2], scope);
+		sexpr->for_loop.consume = false;
+
+	// Filtered list comprehensions
+	} else if (!strcmp(ast->value.value, "[") && ast->children_count == 1 && !strcmp(ast->children[0]->value.value, "where"))
+	{
+		sexpr->tag = CURLY_IR_TAGS_FOR;
+		sexpr->for_loop.loop_type = IR_LOOP_LIST;
+		sexpr->for_loop.var = strdup(ast->children[0]->children[0]->children[0]->value.value);
+		sexpr->for_loop.iter = convert_ast_node(root, ast->children[0], scope);
+
+		// The body is the filtered variable
+		ir_sexpr_t* body = malloc(sizeof(ir_sexpr_t));
+		body->type = NULL;
+		body->lino = sexpr->lino;
+		body->charpos = sexpr->charpos;
+		body->pos = sexpr->pos;
+		body->tag = CURLY_IR_TAGS_SYMBOL;
+		body->symbol = strdup(sexpr->for_loop.var);
+		sexpr->for_loop.body = body;
+		sexpr->for_loop.consume = false;
+
+	// List literals
+	} else if (!strcmp(ast->value.value, "["))
+	{
+		sexpr->tag = CURLY_IR_TAGS_LIST;
+		sexpr->list.element_count = ast->children_count;
+		sexpr->list.elements = calloc(sexpr->list.element_count, sizeof(ir_sexpr_t*));
+
+		for (size_t i = 0; i < sexpr->list.element_count; i++)
+		{
+			sexpr->list.elements[i] = convert_ast_node(root, ast->children[i], scope);
+		}
+
+	// Quantifiers
+	} else if (!strcmp(ast->value.value, "for") && ast->children_count == 4)
+	{
+		sexpr->tag = CURLY_IR_TAGS_FOR;
+		sexpr->for_loop.loop_type = !strcmp(ast->children[0]->value.value, "all") ? IR_LOOP_ALL : IR_LOOP_SOME;
+		sexpr->for_loop.var = strdup(ast->children[1]->value.value);
+		sexpr->for_loop.iter = convert_ast_node(root, ast->children[2], scope);
+		sexpr->for_loop.body = convert_ast_node(root, ast->children[3], scope);
+		sexpr->for_loop.consume = false;
+
+	// Generators
+	} else if (!strcmp(ast->value.value, "for"))
+	{
+		sexpr->tag = CURLY_IR_TAGS_FOR;
+		sexpr->for_loop.loop_type = IR_LOOP_GENERATOR;
+		sexpr->for_loop.var = strdup(ast->children[0]->value.value);
+		sexpr->for_loop.iter = convert_ast_node(root, ast->children[1], scope);
+		sexpr->for_loop.body = convert_ast_node(root, ast->children[2], scope);
+		sexpr->for_loop.consume = false;
+
+	// Where expressions
+	} else if (!strcmp(ast->value.value, "where"))
+	{
+		sexpr->tag = CURLY_IR_TAGS_FOR;
+		sexpr->for_loop.loop_type = IR_LOOP_WHERE;
+		sexpr->for_loop.var = strdup(ast->children[0]->children[0]->value.value);
+		sexpr->for_loop.iter = convert_ast_node(root, ast->children[0]->children[1], scope);
+		sexpr->for_loop.body = convert_ast_node(root, ast->children[1], scope);
+		sexpr->for_loop.consume = false;
+
 	// Unsupported syntax
 	} else
 	{
-		puts("Unsupported syntax!");
+		printf("Unsupported syntax found at %i:%i\n", ast->value.lino, ast->value.charpos);
+		free(sexpr);
 		return NULL;
 	}
 
@@ -189,19 +314,104 @@ void init_ir(curly_ir_t* ir)
 	ir->func_size = 0;
 	ir->expr = NULL;
 	ir->expr_count = 0;
+	ir->specs = NULL;
+	ir->spec_count = 0;
+	ir->spec_size = 0;
+	ir->spec_indices = init_hashmap();
+	ir->spec_limit = CURLY_SPECIALISATION_LIMIT;
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	ir->check_threads = cores > 0 ? cores : 1;
+	ir->generics = NULL;
+	ir->generic_count = 0;
+	ir->generic_size = 0;
+	ir->defs = NULL;
+	ir->def_count = 0;
+	ir->def_size = 0;
 }
 
-// convert_ast_to_ir(ast_t*, ir_scope_t*, curly_ir_t*) -> void
-// Converts a given ast root to IR.
-void convert_ast_to_ir(ast_t* ast, ir_scope_t* scope, curly_ir_t* ir)
+// sexpr_converted(curly_ir_t*, ir_sexpr_t*) -> bool
+// Returns whether every part of an S expression (including the bodies of functions in it) was converted.
+bool sexpr_converted(curly_ir_t* root, ir_sexpr_t* sexpr)
 {
-	ir->expr_count = ast->children_count;
-	ir->expr = calloc(ir->expr_count, sizeof(ir_sexpr_t*));
+	if (sexpr == NULL)
+		return false;
 
-	for (size_t i = 0; i < ir->expr_count; i++)
+	switch (sexpr->tag)
+	{
+		case CURLY_IR_TAGS_FUNC:
+			return sexpr_converted(root, root->funcs[sexpr->func_id]->body);
+		case CURLY_IR_TAGS_INFIX:
+			return sexpr_converted(root, sexpr->infix.left) && sexpr_converted(root, sexpr->infix.right);
+		case CURLY_IR_TAGS_APPLY:
+			return sexpr_converted(root, sexpr->apply.func) && sexpr_converted(root, sexpr->apply.arg);
+		case CURLY_IR_TAGS_PREFIX:
+			return sexpr_converted(root, sexpr->prefix.operand);
+		case CURLY_IR_TAGS_ASSIGN:
+			return sexpr->assign.name != NULL && sexpr_converted(root, sexpr->assign.value);
+		case CURLY_IR_TAGS_LOCAL_SCOPE:
+			for (size_t i = 0; i < sexpr->local_scope.assign_count; i++)
+			{
+				if (!sexpr_converted(root, sexpr->local_scope.assigns[i]))
+					return false;
+			}
+			return sexpr_converted(root, sexpr->local_scope.value);
+		case CURLY_IR_TAGS_IF:
+			return sexpr_converted(root, sexpr->if_expr.cond) && sexpr_converted(root, sexpr->if_expr.then)
+				&& sexpr_converted(root, sexpr->if_expr.elsy);
+		case CURLY_IR_TAGS_LIST:
+			for (size_t i = 0; i < sexpr->list.element_count; i++)
+			{
+				if (!sexpr_converted(root, sexpr->list.elements[i]))
+					return false;
+			}
+			return true;
+		case CURLY_IR_TAGS_SLICE:
+			return sexpr_converted(root, sexpr->slice.list) && sexpr_converted(root, sexpr->slice.start)
+				&& sexpr_converted(root, sexpr->slice.end);
+		case CURLY_IR_TAGS_FOR:
+			return sexpr_converted(root, sexpr->for_loop.iter) && sexpr_converted(root, sexpr->for_loop.body);
+		case CURLY_IR_TAGS_RANGE:
+			return sexpr_converted(root, sexpr->range.start) && (sexpr->range.end == NULL || sexpr_converted(root, sexpr->range.end));
+		default:
+			return true;
+	}
+}
+
+// convert_ast_to_ir(ast_t*, ir_scope_t*, curly_ir_t*) -> bool
+// Converts a given ast root to IR, adding its statements after the root S expressions already in the IR. Statements
+// that use unsupported syntax are left out, and false is returned if there were any.
+bool convert_ast_to_ir(ast_t* ast, ir_scope_t* scope, curly_ir_t* ir)
+{
+	ir->expr = realloc(ir->expr, (ir->expr_count + ast->children_count) * sizeof(ir_sexpr_t*));
+
+	bool valid = true;
+	for (size_t i = 0; i < ast->children_count; i++)
 	{
-		ir->expr[i] = convert_ast_node(ir, ast->children[i], scope);
+		// Type declarations only add the type to the scope
+		ast_t* child = ast->children[i];
+		if (child->value.type == LEX_TYPE_ASSIGN && child->children[1]->children_count == 1 && !strcmp(child->children[1]->value.value, "type"))
+		{
+			generate_declared_type(child->children[0], child->children[1]->children[0], scope);
+			continue;
+		}
+
+		// A statement with a part that couldn't be converted is removed along with the functions it created
+		size_t func_count = ir->func_count;
+		ir_sexpr_t* sexpr = convert_ast_node(ir, child, scope);
+		if (sexpr_converted(ir, sexpr))
+		{
+			ir->expr[ir->expr_count++] = sexpr;
+			continue;
+		}
+
+		clean_ir_sexpr(sexpr);
+		while (ir->func_count > func_count)
+		{
+			clean_function(ir->funcs[--ir->func_count]);
+		}
+		valid = false;
 	}
+	return valid;
 }
 
 // print_ir_sexpr(ir_sexpr_t*, int, bool) -> void
@@ -230,7 +440,10 @@ void print_ir_sexpr(ir_sexpr_t* sexpr, int indent, bool newline)
 			printf("%s: Bool", sexpr->i1 ? "true" : "false");
 			break;
 		case CURLY_IR_TAGS_SYMBOL:
-			printf("%s: %s", sexpr->symbol, sexpr->type != NULL ? sexpr->type->type_name : "(null)");
+			printf("%s: ", sexpr->symbol);
+			if (sexpr->type != NULL)
+				print_type_inline(sexpr->type);
+			else printf("(null)");
 			break;
 		case CURLY_IR_TAGS_INFIX:
 			printf("call(2) ");
@@ -296,6 +509,9 @@ void print_ir_sexpr(ir_sexpr_t* sexpr, int indent, bool newline)
 				case IR_BINOPS_BOOLXOR:
 					printf("xor");
 					break;
+				case IR_BINOPS_INDEX:
+					printf(".");
+					break;
 				default:
 					printf("???");
 					break;
@@ -353,7 +569,82 @@ void print_ir_sexpr(ir_sexpr_t* sexpr, int indent, bool newline)
 			newline = true;
 			break;
 		case CURLY_IR_TAGS_FUNC:
-			printf("func-ref %li: (func)", sexpr->func_id);
+			printf("func-ref %li: ", sexpr->func_id);
+			print_type_inline(sexpr->type);
+			break;
+		case CURLY_IR_TAGS_APPLY:
+			printf("apply ");
+			print_ir_sexpr(sexpr->apply.func, indent, false);
+			printf(" ");
+			print_ir_sexpr(sexpr->apply.arg, indent, false);
+			printf(": ");
+			print_type_inline(sexpr->type);
+			break;
+		case CURLY_IR_TAGS_LIST:
+			printf("list");
+			for (size_t i = 0; i < sexpr->list.element_count; i++)
+			{
+				printf(" ");
+				print_ir_sexpr(sexpr->list.elements[i], indent, false);
+			}
+			break;
+		case CURLY_IR_TAGS_SLICE:
+			printf("slice ");
+			print_ir_sexpr(sexpr->slice.list, indent, false);
+			printf(" ");
+			print_ir_sexpr(sexpr->slice.start, indent, false);
+			printf(" ");
+			print_ir_sexpr(sexpr->slice.end, indent, false);
+			break;
+		case CURLY_IR_TAGS_FOR:
+			switch (sexpr->for_loop.loop_type)
+			{
+				case IR_LOOP_LIST:
+					printf(sexpr->for_loop.consume ? "for list reuse " : "for list ");
+					break;
+				case IR_LOOP_GENERATOR:
+					printf("for gen ");
+					break;
+				case IR_LOOP_WHERE:
+					printf("for where ");
+					break;
+				case IR_LOOP_ALL:
+					printf("for all ");
+					break;
+				case IR_LOOP_SOME:
+					printf("for some ");
+					break;
+			}
+			printf("%s in ", sexpr->for_loop.var);
+			print_ir_sexpr(sexpr->for_loop.iter, indent, false);
+			puts("");
+			print_ir_sexpr(sexpr->for_loop.body, indent + 1, true);
+			puts("");
+			newline = true;
+			break;
+		case CURLY_IR_TAGS_RANGE:
+			printf("range ");
+			print_ir_sexpr(sexpr->range.start, indent, false);
+			if (sexpr->range.end != NULL)
+			{
+				printf(" ");
+				print_ir_sexpr(sexpr->range.end, indent, false);
+			}
+			break;
+		case CURLY_IR_TAGS_DUP:
+			printf("dup ");
+			print_ir_sexpr(sexpr->rc.value, indent, false);
+			break;
+		case CURLY_IR_TAGS_DROP:
+			printf("drop");
+			for (size_t i = 0; i < sexpr->rc.drop_count; i++)
+			{
+				printf(" %s", sexpr->rc.drops[i]->symbol);
+			}
+			puts("");
+			print_ir_sexpr(sexpr->rc.value, indent + 1, true);
+			puts("");
+			newline = true;
 			break;
 		default:
 			printf("???");
@@ -381,7 +672,8 @@ void print_ir(curly_ir_t ir)
 
 		for (size_t j = 0; j < ir.funcs[i]->arg_count; j++)
 		{
-			printf(" %s: type", ir.funcs[i]->args[j].name);
+			printf(" %s: ", ir.funcs[i]->args[j].name);
+			print_type_inline(ir.funcs[i]->args[j].type);
 		}
 		puts(".");
 
@@ -406,6 +698,10 @@ void print_ir(curly_ir_t ir)
 // Cleans up an IR S expression.
 void clean_ir_sexpr(ir_sexpr_t* sexpr)
 {
+	// Unsupported syntax converts to NULL
+	if (sexpr == NULL)
+		return;
+
 	switch (sexpr->tag)
 	{
 		case CURLY_IR_TAGS_SYMBOL:
@@ -415,6 +711,10 @@ void clean_ir_sexpr(ir_sexpr_t* sexpr)
 			clean_ir_sexpr(sexpr->infix.left);
 			clean_ir_sexpr(sexpr->infix.right);
 			break;
+		case CURLY_IR_TAGS_APPLY:
+			clean_ir_sexpr(sexpr->apply.func);
+			clean_ir_sexpr(sexpr->apply.arg);
+			break;
 		case CURLY_IR_TAGS_PREFIX:
 			clean_ir_sexpr(sexpr->prefix.operand);
 			break;
@@ -438,6 +738,39 @@ void clean_ir_sexpr(ir_sexpr_t* sexpr)
 			clean_ir_sexpr(sexpr->if_expr.then);
 			clean_ir_sexpr(sexpr->if_expr.elsy);
 			break;
+		case CURLY_IR_TAGS_LIST:
+			for (size_t i = 0; i < sexpr->list.element_count; i++)
+			{
+				clean_ir_sexpr(sexpr->list.elements[i]);
+			}
+			free(sexpr->list.elements);
+			break;
+		case CURLY_IR_TAGS_SLICE:
+			clean_ir_sexpr(sexpr->slice.list);
+			clean_ir_sexpr(sexpr->slice.start);
+			clean_ir_sexpr(sexpr->slice.end);
+			break;
+		case CURLY_IR_TAGS_FOR:
+			free(sexpr->for_loop.var);
+			clean_ir_sexpr(sexpr->for_loop.iter);
+			clean_ir_sexpr(sexpr->for_loop.body);
+			break;
+		case CURLY_IR_TAGS_RANGE:
+			clean_ir_sexpr(sexpr->range.start);
+			if (sexpr->range.end != NULL)
+				clean_ir_sexpr(sexpr->range.end);
+			break;
+		case CURLY_IR_TAGS_DUP:
+			clean_ir_sexpr(sexpr->rc.value);
+			break;
+		case CURLY_IR_TAGS_DROP:
+			clean_ir_sexpr(sexpr->rc.value);
+			for (size_t i = 0; i < sexpr->rc.drop_count; i++)
+			{
+				clean_ir_sexpr(sexpr->rc.drops[i]);
+			}
+			free(sexpr->rc.drops);
+			break;
 		default:
 			break;
 	}
@@ -459,22 +792,71 @@ void clean_ir(curly_ir_t* ir)
 	ir->expr_count = 0;
 }
 
+// clean_function(ir_sexpr_func_t*) -> void
+// Cleans up a function.
+void clean_function(ir_sexpr_func_t* func)
+{
+	for (size_t i = 0; i < func->arg_count; i++)
+	{
+		free(func->args[i].name);
+	}
+	free(func->args);
+	clean_ir_sexpr(func->body);
+	free(func);
+}
+
+// clean_definition(ir_definition_t*) -> void
+// Cleans up the definition of a global.
+void clean_definition(ir_definition_t* def)
+{
+	free(def->deps);
+	if (def->source != NULL)
+		clean_ir_sexpr(def->source);
+	for (size_t i = 0; i < def->func_count; i++)
+	{
+		clean_function(def->funcs[i]);
+	}
+	free(def->funcs);
+}
+
 // clean_functions(curly_ir_t*) -> void
 // Cleans up a list of functions.
 void clean_functions(curly_ir_t* ir)
 {
 	for (size_t i = 0; i < ir->func_count; i++)
 	{
-		for (size_t j = 0; j < ir->funcs[i]->arg_count; j++)
-		{
-			free(ir->funcs[i]->args[j].name);
-		}
-		free(ir->funcs[i]->args);
-		clean_ir_sexpr(ir->funcs[i]->body);
-		free(ir->funcs[i]);
+		clean_function(ir->funcs[i]);
 	}
 	free(ir->funcs);
 	ir->funcs = NULL;
 	ir->func_count = 0;
 	ir->func_size = 0;
+
+	// Specialisations and generics refer to functions
+	for (size_t i = 0; i < ir->spec_count; i++)
+	{
+		free(ir->specs[i].name);
+	}
+	free(ir->specs);
+	ir->specs = NULL;
+	ir->spec_count = 0;
+	ir->spec_size = 0;
+	del_hashmap(ir->spec_indices);
+	ir->spec_indices = NULL;
+	for (size_t i = 0; i < ir->generic_count; i++)
+	{
+		free(ir->generics[i].name);
+	}
+	free(ir->generics);
+	ir->generics = NULL;
+	ir->generic_count = 0;
+	ir->generic_size = 0;
+	for (size_t i = 0; i < ir->def_count; i++)
+	{
+		clean_definition(ir->defs + i);
+	}
+	free(ir->defs);
+	ir->defs = NULL;
+	ir->def_count = 0;
+	ir->def_size = 0;
 }
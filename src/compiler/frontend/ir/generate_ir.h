@@ -11,6 +11,7 @@
 
 #include <inttypes.h>
 
+#include "../../../utils/hashmap.h"
 #include "../correctness/types.h"
 #include "../parse/ast.h"
 
@@ -21,13 +22,20 @@ typedef enum
 	CURLY_IR_TAGS_FLOAT,
 	CURLY_IR_TAGS_BOOL,
 	CURLY_IR_TAGS_FUNC,
+	CURLY_IR_TAGS_APPLY,
 	CURLY_IR_TAGS_SYMBOL,
 	CURLY_IR_TAGS_INFIX,
 	CURLY_IR_TAGS_PREFIX,
 	CURLY_IR_TAGS_ASSIGN,
 	CURLY_IR_TAGS_DECLARE,
 	CURLY_IR_TAGS_LOCAL_SCOPE,
-	CURLY_IR_TAGS_IF
+	CURLY_IR_TAGS_IF,
+	CURLY_IR_TAGS_LIST,
+	CURLY_IR_TAGS_SLICE,
+	CURLY_IR_TAGS_FOR,
+	CURLY_IR_TAGS_RANGE,
+	CURLY_IR_TAGS_DUP,
+	CURLY_IR_TAGS_DROP
 } ir_types_t;
 
 // Represents an infix operation.
@@ -54,16 +62,38 @@ typedef enum
 	IR_BINOPS_BOOLAND,
 	IR_BINOPS_BOOLOR,
 	IR_BINOPS_BOOLXOR,
-	IR_BINOPS_SPAN
+	IR_BINOPS_SPAN,
+	IR_BINOPS_INDEX
 } ir_binops_t;
 
+// Represents what a for loop produces.
+typedef enum
+{
+	IR_LOOP_LIST,
+	IR_LOOP_GENERATOR,
+	IR_LOOP_WHERE,
+	IR_LOOP_ALL,
+	IR_LOOP_SOME
+} ir_loop_types_t;
+
 typedef struct s_ir_sexpr ir_sexpr_t;
 
-// Function argument
+// Represents the variable a name refers to.
+typedef struct
+{
+	// Whether the variable is global.
+	bool global;
+
+	// The index of a global, or the slot of a local. Locals are numbered by how many locals enclose them in their full expression.
+	size_t index;
+} ir_binding_id_t;
+
+// Function argument (undeclared types are NULL until they're inferred)
 typedef struct
 {
 	type_t* type;
 	char* name;
+	ir_binding_id_t binding;
 } ir_sexpr_func_arg_t;
 
 // A function
@@ -95,7 +125,13 @@ typedef struct s_ir_sexpr
 		int64_t i64;
 		double f64;
 		bool i1;
-		char* symbol;
+
+		// Symbols.
+		struct
+		{
+			char* symbol;
+			ir_binding_id_t binding;
+		};
 
 		// Infix expressions.
 		struct
@@ -103,19 +139,34 @@ typedef struct s_ir_sexpr
 			ir_binops_t op;
 			struct s_ir_sexpr* left;
 			struct s_ir_sexpr* right;
+
+			// The operand types the operator was last resolved for.
+			type_t* resolved_left;
+			type_t* resolved_right;
 		} infix;
 
+		// Function applications.
+		struct
+		{
+			struct s_ir_sexpr* func;
+			struct s_ir_sexpr* arg;
+		} apply;
+
 		// Prefix expressions.
 		struct
 		{
 			ir_binops_t op;
 			struct s_ir_sexpr* operand;
+
+			// The operand type the operator was last resolved for.
+			type_t* resolved_operand;
 		} prefix;
 
 		// Assignments.
 		struct
 		{
 			char* name;
+			ir_binding_id_t binding;
 			struct s_ir_sexpr* value;
 		} assign;
 
@@ -123,6 +174,7 @@ typedef struct s_ir_sexpr
 		struct
 		{
 			char* name;
+			ir_binding_id_t binding;
 		} declare;
 
 		// Local scopes.
@@ -142,11 +194,105 @@ typedef struct s_ir_sexpr
 			struct s_ir_sexpr* elsy;
 		} if_expr;
 
+		// List literals.
+		struct
+		{
+			struct s_ir_sexpr** elements;
+			size_t element_count;
+		} list;
+
+		// List slices (list.(range start end)).
+		struct
+		{
+			struct s_ir_sexpr* list;
+			struct s_ir_sexpr* start;
+			struct s_ir_sexpr* end;
+		} slice;
+
+		// For loops and quantifiers.
+		struct
+		{
+			ir_loop_types_t loop_type;
+			char* var;
+			ir_binding_id_t var_binding;
+			struct s_ir_sexpr* iter;
+			struct s_ir_sexpr* body;
+
+			// Whether the loop owns the iterated list and may reuse its memory.
+			bool consume;
+		} for_loop;
+
+		// Ranges (range start end and from start).
+		struct
+		{
+			struct s_ir_sexpr* start;
+			struct s_ir_sexpr* end;
+		} range;
+
+		// Reference counting operations (dup value, or value then drop locals).
+		struct
+		{
+			struct s_ir_sexpr* value;
+			struct s_ir_sexpr** drops;
+			size_t drop_count;
+		} rc;
+
 		// Functions
 		size_t func_id;
 	};
 } ir_sexpr_t;
 
+// The number of specialisations a generic function can have before monomorphisation fails, unless the environment
+// variable overrides it.
+#define CURLY_SPECIALISATION_LIMIT 64
+#define CURLY_SPECIALISATION_LIMIT_ENV "CURLY_SPECIALISATION_LIMIT"
+
+// The number of threads that check independent root S expressions defaults to the number of cores, unless the
+// environment variable overrides it. IR with fewer root S expressions than the minimum is checked on one thread.
+#define CURLY_PARALLEL_CHECK_MIN 64
+#define CURLY_CHECK_THREADS_ENV "CURLY_CHECK_THREADS"
+
+// Represents a specialisation of a generic function for a concrete type.
+typedef struct
+{
+	// The generic function and the type it was specialised for.
+	size_t func_id;
+	type_t* type;
+
+	// The name of the variable the specialisation is bound to.
+	char* name;
+} ir_specialisation_t;
+
+// Represents a global variable bound to a generic function (the type is NULL once it's reassigned to a value that isn't generic).
+typedef struct
+{
+	ir_binding_id_t binding;
+	size_t func_id;
+	type_t* type;
+	char* name;
+} ir_generic_t;
+
+// Represents the definition of a global bound to a generic function. Definitions are kept unchecked so that they can be
+// checked again when the type of a global they depend on changes.
+typedef struct
+{
+	// The global the definition assigns and the globals its value refers to.
+	size_t global;
+	size_t* deps;
+	size_t dep_count;
+	size_t dep_size;
+
+	// The unchecked definition and the functions it refers to, which are numbered by their index in funcs.
+	ir_sexpr_t* source;
+	ir_sexpr_func_t** funcs;
+	size_t func_count;
+	size_t func_size;
+
+	// Whether a newer definition of the global was checked, and whether the definition is waiting to be checked again.
+	bool stale;
+	bool pending;
+} ir_definition_t;
+
 // Represents the IR.
 typedef struct
 {
@@ -158,24 +304,59 @@ typedef struct
 	// The list of all expressions.
 	ir_sexpr_t** expr;
 	size_t expr_count;
+
+	// The specialisations of generic functions, and a hashmap of "func_id:type_id" keys mapped to one plus their index.
+	ir_specialisation_t* specs;
+	size_t spec_count;
+	size_t spec_size;
+	hashmap_t* spec_indices;
+
+	// The most specialisations a generic function can have.
+	size_t spec_limit;
+
+	// The most threads that check root S expressions at once.
+	size_t check_threads;
+
+	// The global variables bound to generic functions.
+	ir_generic_t* generics;
+	size_t generic_count;
+	size_t generic_size;
+
+	// The definitions of globals bound to generic functions, in the order they were checked.
+	ir_definition_t* defs;
+	size_t def_count;
+	size_t def_size;
 } curly_ir_t;
 
 // init_ir(curly_ir_t*) -> void
 // Initialises an ir structure.
 void init_ir(curly_ir_t* ir);
 
-// convert_ast_to_ir(ast_t*, ir_scope_t*, curly_ir_t*) -> void
-// Converts a given ast root to IR.
-void convert_ast_to_ir(ast_t* ast, ir_scope_t* scope, curly_ir_t* ir);
+// convert_ast_to_ir(ast_t*, ir_scope_t*, curly_ir_t*) -> bool
+// Converts a given ast root to IR, adding its statements after the root S expressions already in the IR. Statements
+// that use unsupported syntax are left out, and false is returned if there were any.
+bool convert_ast_to_ir(ast_t* ast, ir_scope_t* scope, curly_ir_t* ir);
 
 // print_ir(curly_ir_t) -> void
 // Prints out IR to stdout.
 void print_ir(curly_ir_t ir);
 
+// clean_ir_sexpr(ir_sexpr_t*) -> void
+// Cleans up an IR S expression.
+void clean_ir_sexpr(ir_sexpr_t* sexpr);
+
 // clean_ir(curly_ir_t*) -> void
 // Cleans up Curly IR.
 void clean_ir(curly_ir_t* ir);
 
+// clean_function(ir_sexpr_func_t*) -> void
+// Cleans up a function.
+void clean_function(ir_sexpr_func_t* func);
+
+// clean_definition(ir_definition_t*) -> void
+// Cleans up the definition of a global.
+void clean_definition(ir_definition_t* def);
+
 // clean_functions(curly_ir_t*) -> void
 // Cleans up a list of functions.
 void clean_functions(curly_ir_t* ir);
@@ -0,0 +1,483 @@
+// 
+// ir
+// serialise.c: Saves checked IR to images that can be mapped into memory and used in place.
+// 
+// Created by jenra.
+// Created on October 18 2026.
+// 
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../../../utils/list.h"
+#include "serialise.h"
+
+// An image holds the S expressions, functions, types, and strings of the IR with the same layout as in memory, except
+// that pointers hold offsets from the start of the image (with 0 for NULL). The header lists where every pointer is, so
+// loading an image maps it into memory and adds the address of the image to each pointer, without allocating or
+// walking the IR. Strings are shared by every pointer to the same text, and types are written once however many
+// S expressions refer to them. Types are saved with their index in the list of types as their id, so that types which
+// were interned can be interned again (after their fields, since types are hashed on the addresses of their fields)
+// before every type gets a new id that can't be mistaken for the id of a type created by the compiler.
+
+// Represents an image being written.
+typedef struct
+{
+	// The contents of the image.
+	char* data;
+	size_t size;
+	size_t count;
+
+	// The offsets of the pointers in the image.
+	uint64_t* relocs;
+	size_t reloc_size;
+	size_t reloc_count;
+
+	// The offsets of the types in the image.
+	uint64_t* types;
+	size_t type_size;
+	size_t type_count;
+
+	// The offsets of the strings written, keyed by their text, and of the types written, keyed by their address.
+	hashmap_t* strings;
+	hashmap_t* written_types;
+} ir_image_writer_t;
+
+// image_reserve(ir_image_writer_t*, size_t) -> size_t
+// Reserves zeroed space aligned to 8 bytes at the end of the image, returning its offset.
+size_t image_reserve(ir_image_writer_t* writer, size_t size)
+{
+	size_t offset = writer->count;
+	size_t count = offset + ((size + 7) & ~(size_t) 7);
+	if (count > writer->size)
+	{
+		while (writer->size < count)
+		{
+			writer->size <<= 1;
+		}
+		writer->data = realloc(writer->data, writer->size);
+	}
+	memset(writer->data + offset, 0, count - offset);
+	writer->count = count;
+	return offset;
+}
+
+// image_write(ir_image_writer_t*, void*, size_t) -> size_t
+// Copies a value to the end of the image, returning its offset.
+size_t image_write(ir_image_writer_t* writer, void* value, size_t size)
+{
+	size_t offset = image_reserve(writer, size);
+	memcpy(writer->data + offset, value, size);
+	return offset;
+}
+
+// image_set_pointer(ir_image_writer_t*, size_t, size_t) -> void
+// Points the pointer at an offset in the image to the value at another offset, or to NULL if the offset is 0.
+void image_set_pointer(ir_image_writer_t* writer, size_t at, size_t target)
+{
+	uint64_t value = target;
+	memcpy(writer->data + at, &value, sizeof(uint64_t));
+	if (target != 0)
+		list_append_element(writer->relocs, writer->reloc_size, writer->reloc_count, uint64_t, at);
+}
+
+// image_set_string(ir_image_writer_t*, size_t, char*) -> void
+// Points the pointer at an offset in the image to a string, writing the string if its text isn't in the image yet.
+void image_set_string(ir_image_writer_t* writer, size_t at, char* string)
+{
+	if (string == NULL)
+	{
+		image_set_pointer(writer, at, 0);
+		return;
+	}
+
+	size_t offset = (size_t) map_get(writer->strings, string);
+	if (offset == 0)
+	{
+		offset = image_write(writer, string, strlen(string) + 1);
+		map_add(writer->strings, string, (void*) offset);
+	}
+	image_set_pointer(writer, at, offset);
+}
+
+// image_set_type(ir_image_writer_t*, size_t, type_t*) -> void
+// Points the pointer at an offset in the image to a type, writing the type if it isn't in the image yet.
+void image_set_type(ir_image_writer_t* writer, size_t at, type_t* type)
+{
+	if (type == NULL)
+	{
+		image_set_pointer(writer, at, 0);
+		return;
+	}
+
+	// Types are keyed on their address, and are remembered before their fields are written since types can be recursive
+	char key[24];
+	snprintf(key, sizeof(key), "%p", (void*) type);
+	size_t offset = (size_t) map_get(writer->written_types, key);
+	if (offset != 0)
+	{
+		image_set_pointer(writer, at, offset);
+		return;
+	}
+	type_t copy = *type;
+	copy.printing = false;
+	copy.name_carry = NULL;
+	copy.id = writer->type_count;
+	copy.bucket_next = NULL;
+	copy.next = NULL;
+	copy.prev = NULL;
+	offset = image_write(writer, &copy, sizeof(type_t));
+	map_add(writer->written_types, key, (void*) offset);
+	list_append_element(writer->types, writer->type_size, writer->type_count, uint64_t, offset);
+	image_set_pointer(writer, at, offset);
+
+	// Write the fields
+	image_set_string(writer, offset + offsetof(type_t, type_name), type->type_name);
+	size_t count = type->field_count;
+	size_t names = count != 0 ? image_reserve(writer, count * sizeof(char*)) : 0;
+	size_t types = count != 0 ? image_reserve(writer, count * sizeof(type_t*)) : 0;
+	image_set_pointer(writer, offset + offsetof(type_t, field_names), names);
+	image_set_pointer(writer, offset + offsetof(type_t, field_types), types);
+	for (size_t i = 0; i < count; i++)
+	{
+		image_set_string(writer, names + i * sizeof(char*), type->field_names[i]);
+		image_set_type(writer, types + i * sizeof(type_t*), type->field_types[i]);
+	}
+	image_set_type(writer, offset + offsetof(type_t, link), type->link);
+}
+
+// image_set_sexpr(ir_image_writer_t*, size_t, ir_sexpr_t*) -> void
+// Points the pointer at an offset in the image to a new copy of an S expression.
+void image_set_sexpr(ir_image_writer_t* writer, size_t at, ir_sexpr_t* sexpr);
+
+// image_set_sexprs(ir_image_writer_t*, size_t, ir_sexpr_t**, size_t) -> void
+// Points the pointer at an offset in the image to a new array of S expressions.
+void image_set_sexprs(ir_image_writer_t* writer, size_t at, ir_sexpr_t** sexprs, size_t count)
+{
+	size_t offset = count != 0 ? image_reserve(writer, count * sizeof(ir_sexpr_t*)) : 0;
+	image_set_pointer(writer, at, offset);
+	for (size_t i = 0; i < count; i++)
+	{
+		image_set_sexpr(writer, offset + i * sizeof(ir_sexpr_t*), sexprs[i]);
+	}
+}
+
+// image_set_sexpr(ir_image_writer_t*, size_t, ir_sexpr_t*) -> void
+// Points the pointer at an offset in the image to a new copy of an S expression.
+void image_set_sexpr(ir_image_writer_t* writer, size_t at, ir_sexpr_t* sexpr)
+{
+	if (sexpr == NULL)
+	{
+		image_set_pointer(writer, at, 0);
+		return;
+	}
+
+	size_t offset = image_write(writer, sexpr, sizeof(ir_sexpr_t));
+	image_set_pointer(writer, at, offset);
+	image_set_type(writer, offset + offsetof(ir_sexpr_t, type), sexpr->type);
+	switch (sexpr->tag)
+	{
+		case CURLY_IR_TAGS_SYMBOL:
+			image_set_string(writer, offset + offsetof(ir_sexpr_t, symbol), sexpr->symbol);
+			break;
+		case CURLY_IR_TAGS_INFIX:
+			image_set_sexpr(writer, offset + offsetof(ir_sexpr_t, infix.left), sexpr->infix.left);
+			image_set_sexpr(writer, offset + offsetof(ir_sexpr_t, infix.right), sexpr->infix.right);
+			image_set_type(writer, offset + offsetof(ir_sexpr_t, infix.resolved_left), sexpr->infix.resolved_left);
+			image_set_type(writer, offset + offsetof(ir_sexpr_t, infix.resolved_right), sexpr->infix.resolved_right);
+			break;
+		case CURLY_IR_TAGS_PREFIX:
+			image_set_sexpr(writer, offset + offsetof(ir_sexpr_t, prefix.operand), sexpr->prefix.operand);
+			image_set_type(writer, offset + offsetof(ir_sexpr_t, prefix.resolved_operand), sexpr->prefix.resolved_operand);
+			break;
+		case CURLY_IR_TAGS_APPLY:
+			image_set_sexpr(writer, offset + offsetof(ir_sexpr_t, apply.func), sexpr->apply.func);
+			image_set_sexpr(writer, offset + offsetof(ir_sexpr_t, apply.arg), sexpr->apply.arg);
+			break;
+		case CURLY_IR_TAGS_ASSIGN:
+			image_set_string(writer, offset + offsetof(ir_sexpr_t, assign.name), sexpr->assign.name);
+			image_set_sexpr(writer, offset + offsetof(ir_sexpr_t, assign.value), sexpr->assign.value);
+			break;
+		case CURLY_IR_TAGS_DECLARE:
+			image_set_string(writer, offset + offsetof(ir_sexpr_t, declare.name), sexpr->declare.name);
+			break;
+		case CURLY_IR_TAGS_LOCAL_SCOPE:
+			image_set_sexprs(writer, offset + offsetof(ir_sexpr_t, local_scope.assigns), sexpr->local_scope.assigns, sexpr->local_scope.assign_count);
+			image_set_sexpr(writer, offset + offsetof(ir_sexpr_t, local_scope.value), sexpr->local_scope.value);
+			break;
+		case CURLY_IR_TAGS_IF:
+			image_set_sexpr(writer, offset + offsetof(ir_sexpr_t, if_expr.cond), sexpr->if_expr.cond);
+			image_set_sexpr(writer, offset + offsetof(ir_sexpr_t, if_expr.then), sexpr->if_expr.then);
+			image_set_sexpr(writer, offset + offsetof(ir_sexpr_t, if_expr.elsy), sexpr->if_expr.elsy);
+			break;
+		case CURLY_IR_TAGS_LIST:
+			image_set_sexprs(writer, offset + offsetof(ir_sexpr_t, list.elements), sexpr->list.elements, sexpr->list.element_count);
+			break;
+		case CURLY_IR_TAGS_SLICE:
+			image_set_sexpr(writer, offset + offsetof(ir_sexpr_t, slice.list), sexpr->slice.list);
+			image_set_sexpr(writer, offset + offsetof(ir_sexpr_t, slice.start), sexpr->slice.start);
+			image_set_sexpr(writer, offset + offsetof(ir_sexpr_t, slice.end), sexpr->slice.end);
+			break;
+		case CURLY_IR_TAGS_FOR:
+			image_set_string(writer, offset + offsetof(ir_sexpr_t, for_loop.var), sexpr->for_loop.var);
+			image_set_sexpr(writer, offset + offsetof(ir_sexpr_t, for_loop.iter), sexpr->for_loop.iter);
+			image_set_sexpr(writer, offset + offsetof(ir_sexpr_t, for_loop.body), sexpr->for_loop.body);
+			break;
+		case CURLY_IR_TAGS_RANGE:
+			image_set_sexpr(writer, offset + offsetof(ir_sexpr_t, range.start), sexpr->range.start);
+			image_set_sexpr(writer, offset + offsetof(ir_sexpr_t, range.end), sexpr->range.end);
+			break;
+		case CURLY_IR_TAGS_DUP:
+		case CURLY_IR_TAGS_DROP:
+			image_set_sexpr(writer, offset + offsetof(ir_sexpr_t, rc.value), sexpr->rc.value);
+			image_set_sexprs(writer, offset + offsetof(ir_sexpr_t, rc.drops), sexpr->rc.drops, sexpr->rc.drop_count);
+			break;
+		default:
+			break;
+	}
+}
+
+// image_set_func(ir_image_writer_t*, size_t, ir_sexpr_func_t*) -> void
+// Points the pointer at an offset in the image to a new copy of a function.
+void image_set_func(ir_image_writer_t* writer, size_t at, ir_sexpr_func_t* func)
+{
+	size_t offset = image_write(writer, func, sizeof(ir_sexpr_func_t));
+	image_set_pointer(writer, at, offset);
+	size_t args = func->arg_count != 0 ? image_write(writer, func->args, func->arg_count * sizeof(ir_sexpr_func_arg_t)) : 0;
+	image_set_pointer(writer, offset + offsetof(ir_sexpr_func_t, args), args);
+	for (size_t i = 0; i < func->arg_count; i++)
+	{
+		size_t arg = args + i * sizeof(ir_sexpr_func_arg_t);
+		image_set_type(writer, arg + offsetof(ir_sexpr_func_arg_t, type), func->args[i].type);
+		image_set_string(writer, arg + offsetof(ir_sexpr_func_arg_t, name), func->args[i].name);
+	}
+	image_set_sexpr(writer, offset + offsetof(ir_sexpr_func_t, body), func->body);
+}
+
+// is_ir_image_path(char*) -> bool
+// Returns whether a file name has the extension of IR images.
+bool is_ir_image_path(char* path)
+{
+	size_t length = strlen(path);
+	size_t ext_length = strlen(CURLY_IR_EXTENSION);
+	return length > ext_length && !strcmp(path + length - ext_length, CURLY_IR_EXTENSION);
+}
+
+// save_ir(curly_ir_t*, ir_scope_t*, char*) -> bool
+// Saves checked IR and the types its scope names to an image at the given path, returning whether it succeeded.
+bool save_ir(curly_ir_t* ir, ir_scope_t* scope, char* path)
+{
+	ir_image_writer_t writer = {0};
+	writer.size = 4096;
+	writer.data = malloc(writer.size);
+	writer.strings = init_hashmap();
+	writer.written_types = init_hashmap();
+	image_reserve(&writer, sizeof(curly_ir_header_t));
+
+	// Write the root S expressions and functions
+	size_t exprs = ir->expr_count != 0 ? image_reserve(&writer, ir->expr_count * sizeof(ir_sexpr_t*)) : 0;
+	for (size_t i = 0; i < ir->expr_count; i++)
+	{
+		image_set_sexpr(&writer, exprs + i * sizeof(ir_sexpr_t*), ir->expr[i]);
+	}
+	size_t funcs = ir->func_count != 0 ? image_reserve(&writer, ir->func_count * sizeof(ir_sexpr_func_t*)) : 0;
+	for (size_t i = 0; i < ir->func_count; i++)
+	{
+		image_set_func(&writer, funcs + i * sizeof(ir_sexpr_func_t*), ir->funcs[i]);
+	}
+
+	// Write the types the scope names
+	size_t key_count = 0;
+	size_t key_size = 0;
+	char** keys = map_keys(scope->types, &key_count, &key_size);
+	size_t names = key_count != 0 ? image_reserve(&writer, key_count * sizeof(char*)) : 0;
+	size_t named = key_count != 0 ? image_reserve(&writer, key_count * sizeof(type_t*)) : 0;
+	for (size_t i = 0; i < key_count; i++)
+	{
+		image_set_string(&writer, names + i * sizeof(char*), keys[i]);
+		image_set_type(&writer, named + i * sizeof(type_t*), map_get(scope->types, keys[i]));
+	}
+	free(keys);
+
+	// Write the list of types, then the list of pointers (the list of types adds more pointers)
+	size_t types = writer.type_count != 0 ? image_reserve(&writer, writer.type_count * sizeof(type_t*)) : 0;
+	for (size_t i = 0; i < writer.type_count; i++)
+	{
+		image_set_pointer(&writer, types + i * sizeof(type_t*), writer.types[i]);
+	}
+	size_t relocs = image_write(&writer, writer.relocs, writer.reloc_count * sizeof(uint64_t));
+
+	// Fill in the header
+	curly_ir_header_t header = {
+		.magic = CURLY_IR_MAGIC,
+		.version = CURLY_IR_VERSION,
+		.pointer_size = sizeof(void*),
+		.sexpr_size = sizeof(ir_sexpr_t),
+		.func_size = sizeof(ir_sexpr_func_t),
+		.arg_size = sizeof(ir_sexpr_func_arg_t),
+		.type_size = sizeof(type_t),
+		.size = writer.count,
+		.exprs = exprs,
+		.expr_count = ir->expr_count,
+		.funcs = funcs,
+		.func_count = ir->func_count,
+		.type_names = names,
+		.named_types = named,
+		.named_type_count = key_count,
+		.types = types,
+		.type_count = writer.type_count,
+		.relocs = relocs,
+		.reloc_count = writer.reloc_count
+	};
+	memcpy(writer.data, &header, sizeof(curly_ir_header_t));
+
+	// Save the image
+	FILE* file = fopen(path, "wb");
+	bool saved = file != NULL && fwrite(writer.data, 1, writer.count, file) == writer.count;
+	if (file != NULL)
+		saved = !fclose(file) && saved;
+	free(writer.data);
+	free(writer.relocs);
+	free(writer.types);
+	del_hashmap(writer.strings);
+	del_hashmap(writer.written_types);
+	return saved;
+}
+
+// image_array_in_bounds(curly_ir_header_t*, uint64_t, uint64_t, size_t) -> bool
+// Returns whether an array of count elements of the given size at an offset fits in an image.
+bool image_array_in_bounds(curly_ir_header_t* header, uint64_t offset, uint64_t count, size_t size)
+{
+	return count == 0 || (offset >= sizeof(curly_ir_header_t) && offset <= header->size && count <= (header->size - offset) / size);
+}
+
+// intern_image_type(type_t**, size_t, bool*, size_t) -> void
+// Interns a type loaded from an image if it was interned when it was saved, interning its fields first.
+void intern_image_type(type_t** types, size_t type_count, bool* visited, size_t index)
+{
+	if (index >= type_count || visited[index])
+		return;
+	visited[index] = true;
+	type_t* type = types[index];
+	if (!type->interned)
+		return;
+	for (size_t i = 0; i < type->field_count; i++)
+	{
+		if (type->field_types[i] != NULL)
+			intern_image_type(types, type_count, visited, type->field_types[i]->id);
+	}
+	intern_loaded_type(type);
+}
+
+// load_ir(char*, curly_ir_t*, ir_scope_t*, curly_ir_image_t*) -> bool
+// Maps an IR image into memory and points the IR at the S expressions and functions in it, adding the types it names to
+// the scope. Returns whether the image is valid. The IR is used in place, so it must not be cleaned or grown.
+bool load_ir(char* path, curly_ir_t* ir, ir_scope_t* scope, curly_ir_image_t* image)
+{
+	// Map the image (privately, since loading writes to it)
+	int fd = open(path, O_RDONLY);
+	struct stat info;
+	if (fd < 0 || fstat(fd, &info) < 0 || (size_t) info.st_size < sizeof(curly_ir_header_t))
+	{
+		if (fd >= 0)
+			close(fd);
+		printf("Could not read IR image %s\n", path);
+		return false;
+	}
+	image->size = info.st_size;
+	image->data = mmap(NULL, image->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (image->data == MAP_FAILED)
+	{
+		image->data = NULL;
+		printf("Could not read IR image %s\n", path);
+		return false;
+	}
+
+	// Images from other versions or from compilers with other layouts can't be used
+	char* base = image->data;
+	curly_ir_header_t* header = image->data;
+	if (memcmp(header->magic, CURLY_IR_MAGIC, sizeof(CURLY_IR_MAGIC)) || header->version != CURLY_IR_VERSION
+	 || header->pointer_size != sizeof(void*) || header->sexpr_size != sizeof(ir_sexpr_t) || header->func_size != sizeof(ir_sexpr_func_t)
+	 || header->arg_size != sizeof(ir_sexpr_func_arg_t) || header->type_size != sizeof(type_t) || header->size != image->size
+	 || !image_array_in_bounds(header, header->exprs, header->expr_count, sizeof(ir_sexpr_t*))
+	 || !image_array_in_bounds(header, header->funcs, header->func_count, sizeof(ir_sexpr_func_t*))
+	 || !image_array_in_bounds(header, header->type_names, header->named_type_count, sizeof(char*))
+	 || !image_array_in_bounds(header, header->named_types, header->named_type_count, sizeof(type_t*))
+	 || !image_array_in_bounds(header, header->types, header->type_count, sizeof(type_t*))
+	 || !image_array_in_bounds(header, header->relocs, header->reloc_count, sizeof(uint64_t)))
+	{
+		printf("%s is not a compatible IR image\n", path);
+		unload_ir(image);
+		return false;
+	}
+
+	// Turn the offsets into pointers
+	uint64_t* relocs = (uint64_t*) (base + header->relocs);
+	for (size_t i = 0; i < header->reloc_count; i++)
+	{
+		uint64_t* pointer = (uint64_t*) (base + relocs[i]);
+		if (relocs[i] < sizeof(curly_ir_header_t) || relocs[i] > image->size - sizeof(uint64_t) || relocs[i] % sizeof(uint64_t) != 0 || *pointer >= image->size)
+		{
+			printf("%s is not a compatible IR image\n", path);
+			unload_ir(image);
+			return false;
+		}
+		*pointer = (uintptr_t) (base + *pointer);
+	}
+
+	// Every type's id is its index in the list of types until it's interned again
+	type_t** types = (type_t**) (base + header->types);
+	for (size_t i = 0; i < header->type_count; i++)
+	{
+		if (types[i]->id != i)
+		{
+			printf("%s is not a compatible IR image\n", path);
+			unload_ir(image);
+			return false;
+		}
+	}
+	bool* visited = calloc(header->type_count, sizeof(bool));
+	for (size_t i = 0; i < header->type_count; i++)
+	{
+		intern_image_type(types, header->type_count, visited, i);
+	}
+	free(visited);
+
+	// Give the types new ids and add the named types to the scope
+	size_t first_id = reserve_type_ids(header->type_count);
+	for (size_t i = 0; i < header->type_count; i++)
+	{
+		types[i]->id = first_id + i;
+	}
+	char** names = (char**) (base + header->type_names);
+	type_t** named_types = (type_t**) (base + header->named_types);
+	for (size_t i = 0; i < header->named_type_count; i++)
+	{
+		map_add(scope->types, names[i], named_types[i]);
+	}
+
+	// Use the S expressions and functions in place
+	memset(ir, 0, sizeof(curly_ir_t));
+	ir->expr = (ir_sexpr_t**) (base + header->exprs);
+	ir->expr_count = header->expr_count;
+	ir->funcs = (ir_sexpr_func_t**) (base + header->funcs);
+	ir->func_count = header->func_count;
+	ir->func_size = header->func_count;
+	return true;
+}
+
+// unload_ir(curly_ir_image_t*) -> void
+// Unmaps an IR image, after which nothing loaded from it can be used.
+void unload_ir(curly_ir_image_t* image)
+{
+	if (image->data != NULL)
+		munmap(image->data, image->size);
+	image->data = NULL;
+	image->size = 0;
+}
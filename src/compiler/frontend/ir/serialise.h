@@ -0,0 +1,84 @@
+// 
+// ir
+// serialise.h: Header file for serialise.c.
+// 
+// Created by jenra.
+// Created on October 18 2026.
+// 
+
+#ifndef SERIALISE_H
+#define SERIALISE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../correctness/scope.h"
+#include "generate_ir.h"
+
+// The file extension, magic number, and version of IR images. The version changes whenever the layout of the IR does.
+#define CURLY_IR_EXTENSION ".curlyir"
+#define CURLY_IR_MAGIC "CURLYIR"
+#define CURLY_IR_VERSION 1
+
+// The header at the start of an IR image. Every offset is from the start of the image.
+typedef struct
+{
+	// The magic number and version of the format.
+	char magic[8];
+	uint32_t version;
+
+	// The sizes of pointers and of the structures in the image, which must match the sizes in the loading compiler.
+	uint32_t pointer_size;
+	uint32_t sexpr_size;
+	uint32_t func_size;
+	uint32_t arg_size;
+	uint32_t type_size;
+
+	// The size of the whole image.
+	uint64_t size;
+
+	// The arrays of root S expressions and functions.
+	uint64_t exprs;
+	uint64_t expr_count;
+	uint64_t funcs;
+	uint64_t func_count;
+
+	// The arrays of the names of the types in the scope and the types they name.
+	uint64_t type_names;
+	uint64_t named_types;
+	uint64_t named_type_count;
+
+	// The array of every type in the image. Types are saved with their index in the array as their id.
+	uint64_t types;
+	uint64_t type_count;
+
+	// The array of the offsets of every pointer in the image. Pointers are stored as offsets until the image is loaded.
+	uint64_t relocs;
+	uint64_t reloc_count;
+} curly_ir_header_t;
+
+// Represents an IR image mapped into memory.
+typedef struct
+{
+	void* data;
+	size_t size;
+} curly_ir_image_t;
+
+// is_ir_image_path(char*) -> bool
+// Returns whether a file name has the extension of IR images.
+bool is_ir_image_path(char* path);
+
+// save_ir(curly_ir_t*, ir_scope_t*, char*) -> bool
+// Saves checked IR and the types its scope names to an image at the given path, returning whether it succeeded.
+bool save_ir(curly_ir_t* ir, ir_scope_t* scope, char* path);
+
+// load_ir(char*, curly_ir_t*, ir_scope_t*, curly_ir_image_t*) -> bool
+// Maps an IR image into memory and points the IR at the S expressions and functions in it, adding the types it names to
+// the scope. Returns whether the image is valid. The IR is used in place, so it must not be cleaned or grown.
+bool load_ir(char* path, curly_ir_t* ir, ir_scope_t* scope, curly_ir_image_t* image);
+
+// unload_ir(curly_ir_image_t*) -> void
+// Unmaps an IR image, after which nothing loaded from it can be used.
+void unload_ir(curly_ir_image_t* image);
+
+#endif /* SERIALISE_H */
@@ -415,6 +415,25 @@ token_t* lex_next(lexer_t* lex)
 	return lex->tokens + lex->count - 1;
 }
 
+// discard_tokens(lexer_t*) -> void
+// Frees the tokens before the current position, which the parser can no longer backtrack to.
+void discard_tokens(lexer_t* lex)
+{
+	// Tokens are only moved once there are fewer lexed ahead than discarded, so discarding stays linear overall
+	if (lex->count - lex->token_pos > lex->token_pos)
+		return;
+
+	for (size_t i = 0; i < lex->token_pos; i++)
+	{
+		free(lex->tokens[i].value);
+	}
+
+	// Move the tokens lexed ahead to the start of the list
+	memmove(lex->tokens, lex->tokens + lex->token_pos, (lex->count - lex->token_pos) * sizeof(token_t));
+	lex->count -= lex->token_pos;
+	lex->token_pos = 0;
+}
+
 // cleanup_lexer(lexer_t*) -> void
 // Frees memory associated with the lexer.
 void cleanup_lexer(lexer_t* lex)
@@ -102,6 +102,10 @@ char* lex_type_string(lex_type_t type);
 // Consumes the next token in the string.
 token_t* lex_next(lexer_t* lex);
 
+// discard_tokens(lexer_t*) -> void
+// Frees the tokens before the current position, which the parser can no longer backtrack to.
+void discard_tokens(lexer_t* lex);
+
 // cleanup_lexer(lexer_t*) -> void
 // Frees memory associated with the lexer.
 void cleanup_lexer(lexer_t* lex);
@@ -1419,39 +1419,67 @@ parse_result_t statement(lexer_t* lex)
 	return expr;
 }
 
+// lang_parser_next(lexer_t*, bool*) -> parse_result_t
+// Parses the next top level statement, returning a root with the statement as its only child (or no children for an
+// empty line). Sets done once the end of the file is reached. Tokens before the next statement can be discarded after.
+// lang_parser_next: statement? (newline | EOF)
+parse_result_t lang_parser_next(lexer_t* lex, bool* done)
+{
+	// Push the lexer
+	push_lexer(lex);
+	parse_result_t result = succ_result(init_ast((token_t) {0, 0, NULL, 0, 0, 0}));
+
+	// Consume one statement
+	call(state, false, statement, lex, result, false);
+	if (!state.succ)
+		clean_parse_result(state);
+	else list_append_element(result.ast->children, result.ast->children_size, result.ast->children_count, ast_t*, state.ast);
+
+	// Consume a newline
+	repush_lexer(lex);
+	consume(newline, false, type, lex, LEX_TYPE_NEWLINE, result, false);
+	if (newline.succ)
+	{
+		clean_parse_result(newline);
+		*done = false;
+		return result;
+	}
+	clean_parse_result(newline);
+
+	// Assert that the end of file has been reached if there's no newline
+	consume(eof, true, type, lex, LEX_TYPE_EOF, result, true);
+	clean_parse_result(eof);
+	*done = true;
+	return result;
+}
+
 // lang_parser(lexer_t*) -> parse_result_t
 // Parses the curly language.
 // lang_parser: statement*
 parse_result_t lang_parser(lexer_t* lex)
 {
-	// Push the lexer
-	push_lexer(lex);
 	parse_result_t result = succ_result(init_ast((token_t) {0, 0, NULL, 0, 0, 0}));
+	bool done = false;
 
-	while (true)
+	while (!done)
 	{
-		// Push the lexer
-		push_lexer(lex);
-
-		// Consume one statement
-		call(state, false, statement, lex, result, false);
-		if (!state.succ)
-			clean_parse_result(state);
-		else list_append_element(result.ast->children, result.ast->children_size, result.ast->children_count, ast_t*, state.ast);
+		// Parse one statement
+		parse_result_t next = lang_parser_next(lex, &done);
+		if (!next.succ)
+		{
+			clean_parse_result(result);
+			return next;
+		}
 
-		// Consume a newline
-		repush_lexer(lex);
-		consume(newline, false, type, lex, LEX_TYPE_NEWLINE, result, false);
-		if (!newline.succ)
+		// Move the statement to the result
+		for (size_t i = 0; i < next.ast->children_count; i++)
 		{
-			clean_parse_result(newline);
-			break;
+			list_append_element(result.ast->children, result.ast->children_size, result.ast->children_count, ast_t*, next.ast->children[i]);
 		}
+		next.ast->children_count = 0;
+		clean_parse_result(next);
 	}
 
-	// Assert that the end of file has been reached
-	consume(eof, true, type, lex, LEX_TYPE_EOF, result, true);
-	clean_parse_result(eof);
 	return result;
 }
 
@@ -9,6 +9,8 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include <stdbool.h>
+
 #include "ast.h"
 #include "lexer.h"
 
@@ -17,4 +19,10 @@
 // lang_parser: statement*
 parse_result_t lang_parser(lexer_t* lex);
 
+// lang_parser_next(lexer_t*, bool*) -> parse_result_t
+// Parses the next top level statement, returning a root with the statement as its only child (or no children for an
+// empty line). Sets done once the end of the file is reached. Tokens before the next statement can be discarded after.
+// lang_parser_next: statement? (newline | EOF)
+parse_result_t lang_parser_next(lexer_t* lex, bool* done);
+
 #endif /* PARSER_H */
@@ -0,0 +1,475 @@
+//
+// passes
+// common_subexpressions.c: Shares S expressions that are evaluated more than once in IR.
+//
+// Created by jenra.
+// Created on October 18 2026.
+//
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../../../utils/list.h"
+#include "common_subexpressions.h"
+#include "resolve_symbols.h"
+
+// IR is split into regions. The S expressions in a region that aren't in a region nested in it (its spine) are
+// evaluated exactly once whenever the region is, and function bodies, loop bodies, the branches of if expressions, the
+// right operands of boolean operators, and the values of local scopes are regions of their own. S expressions in the
+// spine of a region that are structurally equal (hashed by tag, type, operator, and children, with locals compared by
+// slot) are bound to a local at the start of the region, largest first, so nothing is evaluated that wasn't already.
+// Only S expressions that bind nothing and refer to no local bound in the region are shared. Functions aren't shared,
+// since sharing a partial application only adds work, and neither are values that can hold generators, since sharing a
+// generator shares its position.
+
+// Represents an S expression in the spine of a region that can be shared.
+typedef struct
+{
+	ir_sexpr_t* sexpr;
+	uint64_t hash;
+	size_t size;
+} cse_candidate_t;
+
+// Represents the structure of an S expression.
+typedef struct
+{
+	uint64_t hash;
+	size_t size;
+
+	// Whether the S expression binds nothing and refers to no local bound in its region.
+	bool shareable;
+} cse_info_t;
+
+// Represents the S expressions in the spine of a region that can be shared.
+typedef struct
+{
+	cse_candidate_t* candidates;
+	size_t candidate_size;
+	size_t candidate_count;
+} cse_candidates_t;
+
+// The number of locals bound to shared S expressions.
+size_t cse_count = 0;
+
+// The largest number of nested types checked for generators. Deeper types are assumed to hold them.
+#define CSE_TYPE_DEPTH 4
+
+// cse_mix(uint64_t, uint64_t) -> uint64_t
+// Mixes a value into a hash.
+uint64_t cse_mix(uint64_t hash, uint64_t value)
+{
+	return (hash ^ value) * 1099511628211ull;
+}
+
+// cse_add_child(cse_info_t*, cse_info_t) -> void
+// Adds the structure of a child to the structure of an S expression.
+void cse_add_child(cse_info_t* info, cse_info_t child)
+{
+	info->hash = cse_mix(info->hash, child.hash);
+	info->size += child.size;
+	info->shareable = info->shareable && child.shareable;
+}
+
+// cse_holds_generators(type_t*, size_t) -> bool
+// Returns whether values of a type can hold generators.
+bool cse_holds_generators(type_t* type, size_t depth)
+{
+	if (depth == 0 || type->type_type == IR_TYPES_GENERATOR)
+		return true;
+	for (size_t i = 0; i < type->field_count; i++)
+	{
+		if (type->field_types[i] != NULL && cse_holds_generators(type->field_types[i], depth - 1))
+			return true;
+	}
+	return false;
+}
+
+// cse_keep_operand(ir_sexpr_t*, ir_sexpr_t*, cse_candidates_t*) -> void
+// Removes the operand of a comparison from the candidates if it was just added and isn't a primitive, since the backend
+// only compares values that aren't primitives as they're written.
+void cse_keep_operand(ir_sexpr_t* sexpr, ir_sexpr_t* operand, cse_candidates_t* found)
+{
+	bool compare = sexpr->infix.op >= IR_BINOPS_CMPEQ && sexpr->infix.op <= IR_BINOPS_CMPGTE;
+	type_t* type = operand->type;
+	if (compare && type != NULL && type->type_type != IR_TYPES_PRIMITIVE && found->candidate_count != 0
+		&& found->candidates[found->candidate_count - 1].sexpr == operand)
+		found->candidate_count--;
+}
+
+// cse_collect(ir_sexpr_t*, size_t, bool, cse_candidates_t*) -> cse_info_t
+// Finds the structure of an S expression, adding it and its children to the candidates if they're in the spine of a
+// region and can be shared. Locals bound in the region are in the slots from base.
+cse_info_t cse_collect(ir_sexpr_t* sexpr, size_t base, bool spine, cse_candidates_t* found)
+{
+	cse_info_t info = {cse_mix(cse_mix(14695981039346656037ull, sexpr->tag), (uintptr_t) sexpr->type), 1, true};
+	switch (sexpr->tag)
+	{
+		case CURLY_IR_TAGS_INT:
+			info.hash = cse_mix(info.hash, sexpr->i64);
+			break;
+		case CURLY_IR_TAGS_FLOAT:
+		{
+			uint64_t bits;
+			memcpy(&bits, &sexpr->f64, sizeof(bits));
+			info.hash = cse_mix(info.hash, bits);
+			break;
+		}
+		case CURLY_IR_TAGS_BOOL:
+			info.hash = cse_mix(info.hash, sexpr->i1);
+			break;
+		case CURLY_IR_TAGS_SYMBOL:
+			info.hash = cse_mix(cse_mix(info.hash, sexpr->binding.global), sexpr->binding.index);
+			info.shareable = sexpr->binding.global || sexpr->binding.index < base;
+			break;
+
+		case CURLY_IR_TAGS_INFIX:
+		{
+			// The right operand of a boolean operator isn't always evaluated
+			bool lazy = sexpr->infix.op == IR_BINOPS_BOOLAND || sexpr->infix.op == IR_BINOPS_BOOLOR;
+			info.hash = cse_mix(info.hash, sexpr->infix.op);
+			cse_add_child(&info, cse_collect(sexpr->infix.left, base, spine, found));
+			cse_keep_operand(sexpr, sexpr->infix.left, found);
+			cse_add_child(&info, cse_collect(sexpr->infix.right, base, spine && !lazy, found));
+			cse_keep_operand(sexpr, sexpr->infix.right, found);
+			break;
+		}
+
+		case CURLY_IR_TAGS_PREFIX:
+			info.hash = cse_mix(info.hash, sexpr->prefix.op);
+			cse_add_child(&info, cse_collect(sexpr->prefix.operand, base, spine, found));
+			break;
+		case CURLY_IR_TAGS_APPLY:
+			cse_add_child(&info, cse_collect(sexpr->apply.func, base, spine, found));
+			cse_add_child(&info, cse_collect(sexpr->apply.arg, base, spine, found));
+			break;
+		case CURLY_IR_TAGS_IF:
+			cse_add_child(&info, cse_collect(sexpr->if_expr.cond, base, spine, found));
+			cse_add_child(&info, cse_collect(sexpr->if_expr.then, base, false, found));
+			cse_add_child(&info, cse_collect(sexpr->if_expr.elsy, base, false, found));
+			break;
+
+		case CURLY_IR_TAGS_LIST:
+			info.hash = cse_mix(info.hash, sexpr->list.element_count);
+			for (size_t i = 0; i < sexpr->list.element_count; i++)
+			{
+				cse_add_child(&info, cse_collect(sexpr->list.elements[i], base, spine, found));
+			}
+			break;
+
+		case CURLY_IR_TAGS_SLICE:
+			cse_add_child(&info, cse_collect(sexpr->slice.list, base, spine, found));
+			cse_add_child(&info, cse_collect(sexpr->slice.start, base, spine, found));
+			cse_add_child(&info, cse_collect(sexpr->slice.end, base, spine, found));
+			break;
+		case CURLY_IR_TAGS_RANGE:
+			cse_add_child(&info, cse_collect(sexpr->range.start, base, spine, found));
+			if (sexpr->range.end != NULL)
+				cse_add_child(&info, cse_collect(sexpr->range.end, base, spine, found));
+			break;
+
+		// S expressions that bind locals are never shared, but the S expressions in the spine of the region are searched
+		case CURLY_IR_TAGS_ASSIGN:
+			info.shareable = false;
+			cse_collect(sexpr->assign.value, base, spine, found);
+			break;
+		case CURLY_IR_TAGS_LOCAL_SCOPE:
+			info.shareable = false;
+			for (size_t i = 0; i < sexpr->local_scope.assign_count; i++)
+			{
+				cse_collect(sexpr->local_scope.assigns[i], base, spine, found);
+			}
+			break;
+		case CURLY_IR_TAGS_FOR:
+			info.shareable = false;
+			cse_collect(sexpr->for_loop.iter, base, spine, found);
+			break;
+
+		default:
+			info.shareable = false;
+			break;
+	}
+
+	// Only S expressions that do work are shared
+	type_t* type = sexpr->type;
+	bool work = sexpr->tag != CURLY_IR_TAGS_RANGE && info.size > 1;
+	if (spine && work && info.shareable && type != NULL && type->type_type != IR_TYPES_FUNC && type->type_type != IR_TYPES_CURRY
+		&& !cse_holds_generators(type, CSE_TYPE_DEPTH))
+		list_append_element(found->candidates, found->candidate_size, found->candidate_count, cse_candidate_t, ((cse_candidate_t) {sexpr, info.hash, info.size}));
+	return info;
+}
+
+// cse_equal(ir_sexpr_t*, ir_sexpr_t*) -> bool
+// Returns whether two S expressions that can be shared are structurally equal.
+bool cse_equal(ir_sexpr_t* a, ir_sexpr_t* b)
+{
+	if (a->tag != b->tag || a->type != b->type)
+		return false;
+	switch (a->tag)
+	{
+		case CURLY_IR_TAGS_INT:
+			return a->i64 == b->i64;
+		case CURLY_IR_TAGS_FLOAT:
+			return !memcmp(&a->f64, &b->f64, sizeof(double));
+		case CURLY_IR_TAGS_BOOL:
+			return a->i1 == b->i1;
+		case CURLY_IR_TAGS_SYMBOL:
+			return a->binding.global == b->binding.global && a->binding.index == b->binding.index;
+		case CURLY_IR_TAGS_INFIX:
+			return a->infix.op == b->infix.op && cse_equal(a->infix.left, b->infix.left) && cse_equal(a->infix.right, b->infix.right);
+		case CURLY_IR_TAGS_PREFIX:
+			return a->prefix.op == b->prefix.op && cse_equal(a->prefix.operand, b->prefix.operand);
+		case CURLY_IR_TAGS_APPLY:
+			return cse_equal(a->apply.func, b->apply.func) && cse_equal(a->apply.arg, b->apply.arg);
+		case CURLY_IR_TAGS_IF:
+			return cse_equal(a->if_expr.cond, b->if_expr.cond) && cse_equal(a->if_expr.then, b->if_expr.then)
+				&& cse_equal(a->if_expr.elsy, b->if_expr.elsy);
+
+		case CURLY_IR_TAGS_LIST:
+			if (a->list.element_count != b->list.element_count)
+				return false;
+			for (size_t i = 0; i < a->list.element_count; i++)
+			{
+				if (!cse_equal(a->list.elements[i], b->list.elements[i]))
+					return false;
+			}
+			return true;
+
+		case CURLY_IR_TAGS_SLICE:
+			return cse_equal(a->slice.list, b->slice.list) && cse_equal(a->slice.start, b->slice.start) && cse_equal(a->slice.end, b->slice.end);
+		case CURLY_IR_TAGS_RANGE:
+			if ((a->range.end == NULL) != (b->range.end == NULL))
+				return false;
+			return cse_equal(a->range.start, b->range.start) && (a->range.end == NULL || cse_equal(a->range.end, b->range.end));
+
+		default:
+			return false;
+	}
+}
+
+// cse_compare(const void*, const void*) -> int
+// Orders candidates from largest to smallest, and then by hash.
+int cse_compare(const void* a, const void* b)
+{
+	const cse_candidate_t* x = a;
+	const cse_candidate_t* y = b;
+	if (x->size != y->size)
+		return x->size > y->size ? -1 : 1;
+	if (x->hash != y->hash)
+		return x->hash < y->hash ? -1 : 1;
+	return 0;
+}
+
+// cse_share(cse_candidate_t*, size_t, ir_sexpr_t**, size_t*, size_t*) -> bool
+// Shares the largest candidate that's in the spine of a region more than once, binding it to a new local assigned in
+// assigns. Returns false if no candidate is repeated.
+bool cse_share(cse_candidate_t* candidates, size_t count, ir_sexpr_t*** assigns, size_t* assign_size, size_t* assign_count)
+{
+	// Find the largest candidate equal to another
+	if (count == 0)
+		return false;
+	qsort(candidates, count, sizeof(cse_candidate_t), cse_compare);
+	for (size_t i = 0; i < count; i++)
+	{
+		ir_sexpr_t* first = candidates[i].sexpr;
+		if (first == NULL)
+			continue;
+		size_t uses = 1;
+		for (size_t j = i + 1; j < count && candidates[j].hash == candidates[i].hash && candidates[j].size == candidates[i].size; j++)
+		{
+			if (candidates[j].sexpr != NULL && cse_equal(first, candidates[j].sexpr))
+				uses++;
+		}
+		if (uses == 1)
+			continue;
+
+		// Bind a copy of it to a new local
+		char name[32];
+		snprintf(name, sizeof(name), ".cse%zu", cse_count++);
+		ir_sexpr_t* assign = malloc(sizeof(ir_sexpr_t));
+		ir_sexpr_t* value = malloc(sizeof(ir_sexpr_t));
+		*value = *first;
+		assign->tag = CURLY_IR_TAGS_ASSIGN;
+		assign->type = first->type;
+		assign->pos = first->pos;
+		assign->lino = first->lino;
+		assign->charpos = first->charpos;
+		assign->assign.name = strdup(name);
+		assign->assign.binding = (ir_binding_id_t) {false, SIZE_MAX};
+		assign->assign.value = value;
+		list_append_element(*assigns, *assign_size, *assign_count, ir_sexpr_t*, assign);
+
+		// Replace every occurrence with the local, which isn't resolved until the end
+		for (size_t j = i; j < count && candidates[j].hash == candidates[i].hash && candidates[j].size == candidates[i].size; j++)
+		{
+			ir_sexpr_t* sexpr = candidates[j].sexpr;
+			if (sexpr == NULL || (j != i && !cse_equal(value, sexpr)))
+				continue;
+			if (j != i)
+			{
+				ir_sexpr_t* old = malloc(sizeof(ir_sexpr_t));
+				*old = *sexpr;
+				clean_ir_sexpr(old);
+			}
+			sexpr->tag = CURLY_IR_TAGS_SYMBOL;
+			sexpr->symbol = strdup(name);
+			sexpr->binding = (ir_binding_id_t) {false, SIZE_MAX};
+		}
+		return true;
+	}
+	return false;
+}
+
+void cse_regions(ir_sexpr_t* sexpr, size_t base, curly_ir_t* ir);
+
+// cse_region(ir_sexpr_t**, size_t, curly_ir_t*) -> void
+// Shares the S expressions repeated in the spine of a region, and then in the regions nested in it. Locals bound in the
+// region are in the slots from base.
+void cse_region(ir_sexpr_t** region, size_t base, curly_ir_t* ir)
+{
+	// Share the largest repeated S expression until none are left, looking in the values already shared as well
+	ir_sexpr_t** assigns = NULL;
+	size_t assign_size = 0;
+	size_t assign_count = 0;
+	while (true)
+	{
+		cse_candidates_t found = {NULL, 0, 0};
+		cse_collect(*region, base, true, &found);
+		for (size_t i = 0; i < assign_count; i++)
+		{
+			cse_collect(assigns[i]->assign.value, base, true, &found);
+		}
+		bool shared = cse_share(found.candidates, found.candidate_count, &assigns, &assign_size, &assign_count);
+		free(found.candidates);
+		if (!shared)
+			break;
+	}
+
+	// Share the S expressions in the nested regions
+	cse_regions(*region, base, ir);
+	for (size_t i = 0; i < assign_count; i++)
+	{
+		cse_regions(assigns[i]->assign.value, base, ir);
+	}
+	if (assign_count == 0)
+		return;
+
+	// Bind the locals around the region, with the values shared later first since earlier values can refer to them
+	ir_sexpr_t* scope = malloc(sizeof(ir_sexpr_t));
+	scope->tag = CURLY_IR_TAGS_LOCAL_SCOPE;
+	scope->type = (*region)->type;
+	scope->pos = (*region)->pos;
+	scope->lino = (*region)->lino;
+	scope->charpos = (*region)->charpos;
+	scope->local_scope.assigns = calloc(assign_count, sizeof(ir_sexpr_t*));
+	scope->local_scope.assign_count = assign_count;
+	for (size_t i = 0; i < assign_count; i++)
+	{
+		scope->local_scope.assigns[i] = assigns[assign_count - i - 1];
+	}
+	scope->local_scope.value = *region;
+	*region = scope;
+	free(assigns);
+}
+
+// cse_regions(ir_sexpr_t*, size_t, curly_ir_t*) -> void
+// Shares the S expressions repeated in the regions nested in the spine of a region.
+void cse_regions(ir_sexpr_t* sexpr, size_t base, curly_ir_t* ir)
+{
+	switch (sexpr->tag)
+	{
+		case CURLY_IR_TAGS_INFIX:
+			cse_regions(sexpr->infix.left, base, ir);
+			if (sexpr->infix.op == IR_BINOPS_BOOLAND || sexpr->infix.op == IR_BINOPS_BOOLOR)
+				cse_region(&sexpr->infix.right, base, ir);
+			else cse_regions(sexpr->infix.right, base, ir);
+			return;
+
+		case CURLY_IR_TAGS_PREFIX:
+			cse_regions(sexpr->prefix.operand, base, ir);
+			return;
+		case CURLY_IR_TAGS_APPLY:
+			cse_regions(sexpr->apply.func, base, ir);
+			cse_regions(sexpr->apply.arg, base, ir);
+			return;
+		case CURLY_IR_TAGS_ASSIGN:
+			cse_regions(sexpr->assign.value, base, ir);
+			return;
+
+		case CURLY_IR_TAGS_LOCAL_SCOPE:
+		{
+			// The value of a local scope is after the locals it binds
+			size_t value_base = base;
+			for (size_t i = 0; i < sexpr->local_scope.assign_count; i++)
+			{
+				ir_sexpr_t* assign = sexpr->local_scope.assigns[i];
+				size_t slot = assign->tag == CURLY_IR_TAGS_ASSIGN ? assign->assign.binding.index : assign->declare.binding.index;
+				if (slot + 1 > value_base)
+					value_base = slot + 1;
+				cse_regions(assign, base, ir);
+			}
+			cse_region(&sexpr->local_scope.value, value_base, ir);
+			return;
+		}
+
+		case CURLY_IR_TAGS_FUNC:
+		{
+			ir_sexpr_func_t* func = ir->funcs[sexpr->func_id];
+			size_t body_base = func->arg_count != 0 ? func->args[func->arg_count - 1].binding.index + 1 : base;
+			cse_region(&func->body, body_base, ir);
+			return;
+		}
+
+		case CURLY_IR_TAGS_IF:
+			cse_regions(sexpr->if_expr.cond, base, ir);
+			cse_region(&sexpr->if_expr.then, base, ir);
+			cse_region(&sexpr->if_expr.elsy, base, ir);
+			return;
+
+		case CURLY_IR_TAGS_LIST:
+			for (size_t i = 0; i < sexpr->list.element_count; i++)
+			{
+				cse_regions(sexpr->list.elements[i], base, ir);
+			}
+			return;
+
+		case CURLY_IR_TAGS_SLICE:
+			cse_regions(sexpr->slice.list, base, ir);
+			cse_regions(sexpr->slice.start, base, ir);
+			cse_regions(sexpr->slice.end, base, ir);
+			return;
+
+		case CURLY_IR_TAGS_FOR:
+			cse_regions(sexpr->for_loop.iter, base, ir);
+			cse_region(&sexpr->for_loop.body, sexpr->for_loop.var_binding.index + 1, ir);
+			return;
+
+		case CURLY_IR_TAGS_RANGE:
+			cse_regions(sexpr->range.start, base, ir);
+			if (sexpr->range.end != NULL)
+				cse_regions(sexpr->range.end, base, ir);
+			return;
+
+		default:
+			return;
+	}
+}
+
+// share_common_subexpressions(curly_ir_t*, ir_scope_t*) -> void
+// Binds S expressions that are evaluated more than once whenever the expression around them is to a local in type
+// checked IR, and replaces them with the local.
+void share_common_subexpressions(curly_ir_t* ir, ir_scope_t* scope)
+{
+	for (size_t i = 0; i < ir->expr_count; i++)
+	{
+		// The values of globals are regions, and so are other top level expressions
+		ir_sexpr_t* sexpr = ir->expr[i];
+		if (sexpr->tag == CURLY_IR_TAGS_ASSIGN)
+			cse_region(&sexpr->assign.value, 0, ir);
+		else if (sexpr->tag != CURLY_IR_TAGS_DECLARE)
+			cse_region(ir->expr + i, 0, ir);
+	}
+
+	// Sharing binds locals, which moves the slots of other locals
+	resolve_symbols(ir, scope);
+}
@@ -0,0 +1,20 @@
+//
+// passes
+// common_subexpressions.h: Header file for common_subexpressions.c.
+//
+// Created by jenra.
+// Created on October 18 2026.
+//
+
+#ifndef PASSES_COMMON_SUBEXPRESSIONS_H
+#define PASSES_COMMON_SUBEXPRESSIONS_H
+
+#include "../correctness/scope.h"
+#include "../ir/generate_ir.h"
+
+// share_common_subexpressions(curly_ir_t*, ir_scope_t*) -> void
+// Binds S expressions that are evaluated more than once whenever the expression around them is to a local in type
+// checked IR, and replaces them with the local.
+void share_common_subexpressions(curly_ir_t* ir, ir_scope_t* scope);
+
+#endif /* PASSES_COMMON_SUBEXPRESSIONS_H */
@@ -0,0 +1,327 @@
+//
+// passes
+// dead_bindings.c: Removes variables that are never used from IR.
+//
+// Created by jenra.
+// Created on October 18 2026.
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include "../../../utils/list.h"
+#include "../correctness/dependencies.h"
+#include "dead_bindings.h"
+#include "resolve_symbols.h"
+
+// Evaluating an S expression has no effects, so an assignment whose variable is never read can be removed along with
+// its value (and the bodies of the functions in it, which are only built where they're used). The locals of a local
+// scope are checked from last to first so that a local only used by dead locals is dead as well, and globals are live
+// if a top level expression that isn't a definition uses them, or a live global's definition does. Generic functions
+// are never built and their uses have been renamed to their specialisations by now, so they're removed without warning.
+
+// dead_named(char*) -> bool
+// Returns whether a variable was named in the code, rather than by a pass (whose names have dots in them).
+bool dead_named(char* name)
+{
+	return strchr(name, '.') == NULL;
+}
+
+// dead_generic(ir_sexpr_t*) -> bool
+// Returns whether an assignment assigns a generic function.
+bool dead_generic(ir_sexpr_t* assign)
+{
+	ir_sexpr_t* value = assign->assign.value;
+	return value->tag == CURLY_IR_TAGS_FUNC && value->type != NULL && value->type->has_vars;
+}
+
+// dead_used(ir_sexpr_t*, size_t, curly_ir_t*) -> bool
+// Returns whether an S expression uses a local slot.
+bool dead_used(ir_sexpr_t* sexpr, size_t slot, curly_ir_t* ir)
+{
+	switch (sexpr->tag)
+	{
+		case CURLY_IR_TAGS_SYMBOL:
+			return !sexpr->binding.global && sexpr->binding.index == slot;
+		case CURLY_IR_TAGS_INFIX:
+			return dead_used(sexpr->infix.left, slot, ir) || dead_used(sexpr->infix.right, slot, ir);
+		case CURLY_IR_TAGS_PREFIX:
+			return dead_used(sexpr->prefix.operand, slot, ir);
+		case CURLY_IR_TAGS_APPLY:
+			return dead_used(sexpr->apply.func, slot, ir) || dead_used(sexpr->apply.arg, slot, ir);
+		case CURLY_IR_TAGS_ASSIGN:
+			return dead_used(sexpr->assign.value, slot, ir);
+
+		case CURLY_IR_TAGS_LOCAL_SCOPE:
+			for (size_t i = 0; i < sexpr->local_scope.assign_count; i++)
+			{
+				if (dead_used(sexpr->local_scope.assigns[i], slot, ir))
+					return true;
+			}
+			return dead_used(sexpr->local_scope.value, slot, ir);
+
+		case CURLY_IR_TAGS_FUNC:
+			return dead_used(ir->funcs[sexpr->func_id]->body, slot, ir);
+		case CURLY_IR_TAGS_IF:
+			return dead_used(sexpr->if_expr.cond, slot, ir) || dead_used(sexpr->if_expr.then, slot, ir) || dead_used(sexpr->if_expr.elsy, slot, ir);
+
+		case CURLY_IR_TAGS_LIST:
+			for (size_t i = 0; i < sexpr->list.element_count; i++)
+			{
+				if (dead_used(sexpr->list.elements[i], slot, ir))
+					return true;
+			}
+			return false;
+
+		case CURLY_IR_TAGS_SLICE:
+			return dead_used(sexpr->slice.list, slot, ir) || dead_used(sexpr->slice.start, slot, ir) || dead_used(sexpr->slice.end, slot, ir);
+		case CURLY_IR_TAGS_FOR:
+			return dead_used(sexpr->for_loop.iter, slot, ir) || dead_used(sexpr->for_loop.body, slot, ir);
+		case CURLY_IR_TAGS_RANGE:
+			return dead_used(sexpr->range.start, slot, ir) || (sexpr->range.end != NULL && dead_used(sexpr->range.end, slot, ir));
+
+		case CURLY_IR_TAGS_DUP:
+			return dead_used(sexpr->rc.value, slot, ir);
+		case CURLY_IR_TAGS_DROP:
+			if (dead_used(sexpr->rc.value, slot, ir))
+				return true;
+			for (size_t i = 0; i < sexpr->rc.drop_count; i++)
+			{
+				if (dead_used(sexpr->rc.drops[i], slot, ir))
+					return true;
+			}
+			return false;
+
+		default:
+			return false;
+	}
+}
+
+// dead_used_after(ir_sexpr_t*, size_t, bool*, curly_ir_t*) -> bool
+// Returns whether the local assigned at an index of a local scope is used before it's assigned again, ignoring the
+// assignments already found to be dead.
+bool dead_used_after(ir_sexpr_t* sexpr, size_t index, bool* dead, curly_ir_t* ir)
+{
+	size_t slot = sexpr->local_scope.assigns[index]->assign.binding.index;
+	for (size_t i = index + 1; i < sexpr->local_scope.assign_count; i++)
+	{
+		ir_sexpr_t* assign = sexpr->local_scope.assigns[i];
+		if (assign->tag == CURLY_IR_TAGS_DECLARE)
+		{
+			if (assign->declare.binding.index == slot)
+				return false;
+			continue;
+		}
+
+		// Functions are bound before their body, so a function assigned to the same local only refers to itself
+		bool rebinds = assign->assign.binding.index == slot;
+		if (rebinds && assign->assign.value->tag == CURLY_IR_TAGS_FUNC)
+			return false;
+		if (!dead[i] && dead_used(assign->assign.value, slot, ir))
+			return true;
+		if (rebinds)
+			return false;
+	}
+	return dead_used(sexpr->local_scope.value, slot, ir);
+}
+
+// dead_locals(ir_sexpr_t*, curly_ir_t*, bool) -> void
+// Removes the dead locals in an S expression, innermost first.
+void dead_locals(ir_sexpr_t* sexpr, curly_ir_t* ir, bool warn)
+{
+	switch (sexpr->tag)
+	{
+		case CURLY_IR_TAGS_INFIX:
+			dead_locals(sexpr->infix.left, ir, warn);
+			dead_locals(sexpr->infix.right, ir, warn);
+			return;
+		case CURLY_IR_TAGS_PREFIX:
+			dead_locals(sexpr->prefix.operand, ir, warn);
+			return;
+		case CURLY_IR_TAGS_APPLY:
+			dead_locals(sexpr->apply.func, ir, warn);
+			dead_locals(sexpr->apply.arg, ir, warn);
+			return;
+		case CURLY_IR_TAGS_ASSIGN:
+			dead_locals(sexpr->assign.value, ir, warn);
+			return;
+
+		case CURLY_IR_TAGS_LOCAL_SCOPE:
+		{
+			size_t count = sexpr->local_scope.assign_count;
+			ir_sexpr_t** assigns = sexpr->local_scope.assigns;
+			for (size_t i = 0; i < count; i++)
+			{
+				dead_locals(assigns[i], ir, warn);
+			}
+			dead_locals(sexpr->local_scope.value, ir, warn);
+
+			// Find the dead locals from last to first, so that locals only used by dead locals are dead too
+			bool* dead = calloc(count, sizeof(bool));
+			for (size_t i = count; i > 0; i--)
+			{
+				ir_sexpr_t* assign = assigns[i - 1];
+				if (assign->tag == CURLY_IR_TAGS_ASSIGN && !dead_generic(assign))
+					dead[i - 1] = !dead_used_after(sexpr, i - 1, dead, ir);
+			}
+
+			// Remove them in order
+			size_t kept = 0;
+			for (size_t i = 0; i < count; i++)
+			{
+				if (!dead[i])
+				{
+					assigns[kept++] = assigns[i];
+					continue;
+				}
+				if (warn && dead_named(assigns[i]->assign.name))
+					printf("Unused variable %s found at %i:%i\n", assigns[i]->assign.name, assigns[i]->lino, assigns[i]->charpos);
+				clean_ir_sexpr(assigns[i]);
+			}
+			sexpr->local_scope.assign_count = kept;
+			free(dead);
+
+			// Scopes with nothing left in them are replaced by their value
+			ir_sexpr_t* value = sexpr->local_scope.value;
+			if (kept == 0 && value->type == sexpr->type)
+			{
+				free(assigns);
+				*sexpr = *value;
+				free(value);
+			}
+			return;
+		}
+
+		case CURLY_IR_TAGS_FUNC:
+			dead_locals(ir->funcs[sexpr->func_id]->body, ir, warn);
+			return;
+		case CURLY_IR_TAGS_IF:
+			dead_locals(sexpr->if_expr.cond, ir, warn);
+			dead_locals(sexpr->if_expr.then, ir, warn);
+			dead_locals(sexpr->if_expr.elsy, ir, warn);
+			return;
+
+		case CURLY_IR_TAGS_LIST:
+			for (size_t i = 0; i < sexpr->list.element_count; i++)
+			{
+				dead_locals(sexpr->list.elements[i], ir, warn);
+			}
+			return;
+
+		case CURLY_IR_TAGS_SLICE:
+			dead_locals(sexpr->slice.list, ir, warn);
+			dead_locals(sexpr->slice.start, ir, warn);
+			dead_locals(sexpr->slice.end, ir, warn);
+			return;
+		case CURLY_IR_TAGS_FOR:
+			dead_locals(sexpr->for_loop.iter, ir, warn);
+			dead_locals(sexpr->for_loop.body, ir, warn);
+			return;
+		case CURLY_IR_TAGS_RANGE:
+			dead_locals(sexpr->range.start, ir, warn);
+			if (sexpr->range.end != NULL)
+				dead_locals(sexpr->range.end, ir, warn);
+			return;
+
+		default:
+			return;
+	}
+}
+
+// dead_defined_global(ir_sexpr_t*, size_t*) -> bool
+// Returns whether a top level expression assigns or declares a global, and sets global to its index if it does.
+bool dead_defined_global(ir_sexpr_t* sexpr, size_t* global)
+{
+	if (sexpr->tag == CURLY_IR_TAGS_ASSIGN && sexpr->assign.binding.global)
+		*global = sexpr->assign.binding.index;
+	else if (sexpr->tag == CURLY_IR_TAGS_DECLARE && sexpr->declare.binding.global)
+		*global = sexpr->declare.binding.index;
+	else return false;
+	return true;
+}
+
+// dead_globals(curly_ir_t*, ir_scope_t*, bool) -> void
+// Removes the definitions of the globals that no top level expression that isn't a definition uses, even indirectly.
+void dead_globals(curly_ir_t* ir, ir_scope_t* scope, bool warn)
+{
+	// Find the globals every top level expression uses, starting with the ones expressions that aren't definitions use
+	size_t count = ir->expr_count;
+	ir_definition_t* reads = calloc(count, sizeof(ir_definition_t));
+	size_t* stack = NULL;
+	size_t stack_size = 0;
+	size_t stack_count = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		size_t global;
+		find_dependencies(reads + i, ir->expr[i], ir->funcs);
+		for (size_t j = 0; !dead_defined_global(ir->expr[i], &global) && j < reads[i].dep_count; j++)
+		{
+			list_append_element(stack, stack_size, stack_count, size_t, reads[i].deps[j]);
+		}
+	}
+
+	// Globals used by the definitions of live globals are live
+	bool* live = calloc(scope->global_count, sizeof(bool));
+	while (stack_count != 0)
+	{
+		size_t global = stack[--stack_count];
+		if (live[global])
+			continue;
+		live[global] = true;
+		for (size_t i = 0; i < count; i++)
+		{
+			size_t defined;
+			for (size_t j = 0; dead_defined_global(ir->expr[i], &defined) && defined == global && j < reads[i].dep_count; j++)
+			{
+				list_append_element(stack, stack_size, stack_count, size_t, reads[i].deps[j]);
+			}
+		}
+	}
+
+	// Remove the definitions of dead globals, warning once for each
+	bool* warned = calloc(scope->global_count, sizeof(bool));
+	size_t kept = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		ir_sexpr_t* sexpr = ir->expr[i];
+		size_t global;
+		free(reads[i].deps);
+		if (!dead_defined_global(sexpr, &global) || live[global])
+		{
+			ir->expr[kept++] = sexpr;
+			continue;
+		}
+
+		char* name = sexpr->tag == CURLY_IR_TAGS_ASSIGN ? sexpr->assign.name : sexpr->declare.name;
+		bool generic = sexpr->tag == CURLY_IR_TAGS_ASSIGN && dead_generic(sexpr);
+		if (warn && !warned[global] && !generic && dead_named(name))
+			printf("Unused variable %s found at %i:%i\n", name, sexpr->lino, sexpr->charpos);
+		warned[global] = true;
+		clean_ir_sexpr(sexpr);
+	}
+	ir->expr_count = kept;
+
+	free(reads);
+	free(stack);
+	free(live);
+	free(warned);
+}
+
+// remove_dead_bindings(curly_ir_t*, ir_scope_t*, bool, bool) -> void
+// Removes the assignments to locals in type checked IR that are never used, and the assignments to globals that no top
+// level expression uses if globals is set (since the repl can use them later). Prints a warning for every unused
+// variable the code names if warn is set.
+void remove_dead_bindings(curly_ir_t* ir, ir_scope_t* scope, bool globals, bool warn)
+{
+	// Passes before this one can leave the slots of locals out of date
+	resolve_symbols(ir, scope);
+	if (globals)
+		dead_globals(ir, scope, warn);
+	for (size_t i = 0; i < ir->expr_count; i++)
+	{
+		dead_locals(ir->expr[i], ir, warn);
+	}
+
+	// Removing locals moves the slots of the locals after them
+	resolve_symbols(ir, scope);
+}
@@ -0,0 +1,23 @@
+//
+// passes
+// dead_bindings.h: Header file for dead_bindings.c.
+//
+// Created by jenra.
+// Created on October 18 2026.
+//
+
+#ifndef PASSES_DEAD_BINDINGS_H
+#define PASSES_DEAD_BINDINGS_H
+
+#include <stdbool.h>
+
+#include "../correctness/scope.h"
+#include "../ir/generate_ir.h"
+
+// remove_dead_bindings(curly_ir_t*, ir_scope_t*, bool, bool) -> void
+// Removes the assignments to locals in type checked IR that are never used, and the assignments to globals that no top
+// level expression uses if globals is set (since the repl can use them later). Prints a warning for every unused
+// variable the code names if warn is set.
+void remove_dead_bindings(curly_ir_t* ir, ir_scope_t* scope, bool globals, bool warn);
+
+#endif /* PASSES_DEAD_BINDINGS_H */
@@ -0,0 +1,382 @@
+//
+// passes
+// fold_constants.c: Folds operations on constants in IR.
+//
+// Created by jenra.
+// Created on October 18 2026.
+//
+
+#include <stdint.h>
+#include <string.h>
+
+#include "fold_constants.h"
+
+// Constants are folded bottom up, so an operation is folded once its operands have been. Every fold computes exactly
+// what the built code would: integer arithmetic wraps, floating point comparisons are ordered, and operations the built
+// code leaves undefined (dividing by zero, or shifting by the width of an integer or more) are left for the built code.
+// Locals bound to a constant of their own type are replaced by the constant wherever they're used.
+
+// Represents a local whose constant was replaced, so that it can be restored at the end of a scope.
+typedef struct
+{
+	size_t slot;
+	ir_sexpr_t* value;
+} fold_saved_t;
+
+// Represents the state of constant folding.
+typedef struct
+{
+	curly_ir_t* ir;
+
+	// The primitive types constants have.
+	type_t* int_type;
+	type_t* float_type;
+	type_t* bool_type;
+
+	// The constant each local slot is bound to, or NULL if it isn't bound to a constant.
+	ir_sexpr_t** locals;
+	size_t local_size;
+} fold_state_t;
+
+// fold_constant(ir_sexpr_t*) -> bool
+// Returns whether an S expression is a constant.
+bool fold_constant(ir_sexpr_t* sexpr)
+{
+	return sexpr->tag == CURLY_IR_TAGS_INT || sexpr->tag == CURLY_IR_TAGS_FLOAT || sexpr->tag == CURLY_IR_TAGS_BOOL;
+}
+
+// fold_float(ir_sexpr_t*) -> double
+// Returns the value of an integer or floating point constant as a floating point number.
+double fold_float(ir_sexpr_t* sexpr)
+{
+	return sexpr->tag == CURLY_IR_TAGS_INT ? (double) sexpr->i64 : sexpr->f64;
+}
+
+// fold_bind_local(fold_state_t*, size_t, ir_sexpr_t*) -> fold_saved_t
+// Binds a local slot to a constant (or to NULL if it isn't bound to one), returning what it was bound to before.
+fold_saved_t fold_bind_local(fold_state_t* state, size_t slot, ir_sexpr_t* value)
+{
+	if (slot >= state->local_size)
+	{
+		size_t size = state->local_size != 0 ? state->local_size : 8;
+		while (size <= slot)
+		{
+			size *= 2;
+		}
+		state->locals = realloc(state->locals, size * sizeof(ir_sexpr_t*));
+		memset(state->locals + state->local_size, 0, (size - state->local_size) * sizeof(ir_sexpr_t*));
+		state->local_size = size;
+	}
+
+	fold_saved_t saved = {slot, state->locals[slot]};
+	state->locals[slot] = value;
+	return saved;
+}
+
+// fold_replace(ir_sexpr_t*, ir_sexpr_t*) -> void
+// Replaces an S expression with one of its children. The S expression's other children must be freed already.
+void fold_replace(ir_sexpr_t* sexpr, ir_sexpr_t* child)
+{
+	*sexpr = *child;
+	free(child);
+}
+
+// fold_infix(ir_sexpr_t*, fold_state_t*) -> void
+// Folds an infix expression whose operands are constants.
+void fold_infix(ir_sexpr_t* sexpr, fold_state_t* state)
+{
+	ir_sexpr_t* left = sexpr->infix.left;
+	ir_sexpr_t* right = sexpr->infix.right;
+	bool ints = left->tag == CURLY_IR_TAGS_INT && right->tag == CURLY_IR_TAGS_INT;
+	bool numbers = left->tag != CURLY_IR_TAGS_BOOL && right->tag != CURLY_IR_TAGS_BOOL;
+	bool bools = left->tag == CURLY_IR_TAGS_BOOL && right->tag == CURLY_IR_TAGS_BOOL;
+	uint64_t l = left->i64;
+	uint64_t r = right->i64;
+	double lf = fold_float(left);
+	double rf = fold_float(right);
+
+	// Integer operations
+	ir_types_t tag;
+	if (sexpr->type == state->int_type && ints)
+	{
+		int64_t value;
+		switch (sexpr->infix.op)
+		{
+			case IR_BINOPS_MUL: value = l * r; break;
+			case IR_BINOPS_ADD: value = l + r; break;
+			case IR_BINOPS_SUB: value = l - r; break;
+			case IR_BINOPS_BITAND: value = l & r; break;
+			case IR_BINOPS_BITOR: value = l | r; break;
+			case IR_BINOPS_BITXOR: value = l ^ r; break;
+			case IR_BINOPS_DIV:
+			case IR_BINOPS_MOD:
+				if (right->i64 == 0 || (left->i64 == INT64_MIN && right->i64 == -1))
+					return;
+				value = sexpr->infix.op == IR_BINOPS_DIV ? left->i64 / right->i64 : left->i64 % right->i64;
+				break;
+			case IR_BINOPS_BSL:
+			case IR_BINOPS_BSR:
+				if (r >= 64)
+					return;
+				value = sexpr->infix.op == IR_BINOPS_BSL ? l << r : l >> r;
+				break;
+			default:
+				return;
+		}
+		tag = CURLY_IR_TAGS_INT;
+		sexpr->i64 = value;
+	}
+
+	// Floating point operations
+	else if (sexpr->type == state->float_type && numbers)
+	{
+		double value;
+		switch (sexpr->infix.op)
+		{
+			case IR_BINOPS_MUL: value = lf * rf; break;
+			case IR_BINOPS_DIV: value = lf / rf; break;
+			case IR_BINOPS_ADD: value = lf + rf; break;
+			case IR_BINOPS_SUB: value = lf - rf; break;
+			default:
+				return;
+		}
+		tag = CURLY_IR_TAGS_FLOAT;
+		sexpr->f64 = value;
+	}
+
+	// Comparisons and boolean operations
+	else if (sexpr->type == state->bool_type && (numbers || bools))
+	{
+		bool value;
+		switch (sexpr->infix.op)
+		{
+			case IR_BINOPS_CMPLT: value = ints ? (int64_t) l < (int64_t) r : lf < rf; break;
+			case IR_BINOPS_CMPLTE: value = ints ? (int64_t) l <= (int64_t) r : lf <= rf; break;
+			case IR_BINOPS_CMPGT: value = ints ? (int64_t) l > (int64_t) r : lf > rf; break;
+			case IR_BINOPS_CMPGTE: value = ints ? (int64_t) l >= (int64_t) r : lf >= rf; break;
+			case IR_BINOPS_CMPEQ: value = ints ? l == r : lf == rf; break;
+			case IR_BINOPS_CMPNEQ: value = ints ? l != r : lf < rf || lf > rf; break;
+			case IR_BINOPS_BOOLAND: value = left->i1 && right->i1; break;
+			case IR_BINOPS_BOOLOR: value = left->i1 || right->i1; break;
+			case IR_BINOPS_BOOLXOR: value = left->i1 != right->i1; break;
+			default:
+				return;
+		}
+
+		// Comparisons of booleans aren't built as integer comparisons, so they're left as they are
+		if (bools != (sexpr->infix.op >= IR_BINOPS_BOOLAND))
+			return;
+		tag = CURLY_IR_TAGS_BOOL;
+		sexpr->i1 = value;
+	} else return;
+
+	clean_ir_sexpr(left);
+	clean_ir_sexpr(right);
+	sexpr->tag = tag;
+}
+
+// fold_sexpr(ir_sexpr_t*, fold_state_t*) -> void
+// Folds the constants in an S expression.
+void fold_sexpr(ir_sexpr_t* sexpr, fold_state_t* state)
+{
+	switch (sexpr->tag)
+	{
+		case CURLY_IR_TAGS_SYMBOL:
+		{
+			// Locals bound to constants are replaced by the constant
+			ir_sexpr_t* value = !sexpr->binding.global && sexpr->binding.index < state->local_size ? state->locals[sexpr->binding.index] : NULL;
+			if (value == NULL || value->type != sexpr->type)
+				return;
+			free(sexpr->symbol);
+			sexpr->tag = value->tag;
+			if (value->tag == CURLY_IR_TAGS_INT)
+				sexpr->i64 = value->i64;
+			else if (value->tag == CURLY_IR_TAGS_FLOAT)
+				sexpr->f64 = value->f64;
+			else sexpr->i1 = value->i1;
+			return;
+		}
+
+		case CURLY_IR_TAGS_INFIX:
+		{
+			fold_sexpr(sexpr->infix.left, state);
+
+			// Boolean operators with a constant left operand either short circuit or are their right operand
+			ir_sexpr_t* left = sexpr->infix.left;
+			if ((sexpr->infix.op == IR_BINOPS_BOOLAND || sexpr->infix.op == IR_BINOPS_BOOLOR) && left->tag == CURLY_IR_TAGS_BOOL)
+			{
+				if (left->i1 == (sexpr->infix.op == IR_BINOPS_BOOLOR))
+				{
+					clean_ir_sexpr(sexpr->infix.right);
+					fold_replace(sexpr, left);
+					return;
+				}
+
+				fold_sexpr(sexpr->infix.right, state);
+				if (sexpr->infix.right->type == sexpr->type)
+				{
+					clean_ir_sexpr(left);
+					fold_replace(sexpr, sexpr->infix.right);
+				}
+				return;
+			}
+
+			fold_sexpr(sexpr->infix.right, state);
+			if (fold_constant(sexpr->infix.left) && fold_constant(sexpr->infix.right))
+				fold_infix(sexpr, state);
+			return;
+		}
+
+		case CURLY_IR_TAGS_PREFIX:
+		{
+			fold_sexpr(sexpr->prefix.operand, state);
+			ir_sexpr_t* operand = sexpr->prefix.operand;
+			if (sexpr->prefix.op != IR_BINOPS_NEG || operand->type != sexpr->type)
+				return;
+			else if (operand->tag == CURLY_IR_TAGS_INT)
+				operand->i64 = -(uint64_t) operand->i64;
+			else if (operand->tag == CURLY_IR_TAGS_FLOAT)
+				operand->f64 = -operand->f64;
+			else return;
+			fold_replace(sexpr, operand);
+			return;
+		}
+
+		case CURLY_IR_TAGS_APPLY:
+			fold_sexpr(sexpr->apply.func, state);
+			fold_sexpr(sexpr->apply.arg, state);
+			return;
+
+		case CURLY_IR_TAGS_ASSIGN:
+			fold_sexpr(sexpr->assign.value, state);
+			return;
+
+		case CURLY_IR_TAGS_LOCAL_SCOPE:
+		{
+			// Bind the locals assigned constants of their own type
+			size_t count = sexpr->local_scope.assign_count;
+			fold_saved_t* saved = calloc(count, sizeof(fold_saved_t));
+			for (size_t i = 0; i < count; i++)
+			{
+				ir_sexpr_t* assign = sexpr->local_scope.assigns[i];
+				if (assign->tag == CURLY_IR_TAGS_DECLARE)
+				{
+					saved[i] = fold_bind_local(state, assign->declare.binding.index, NULL);
+					continue;
+				}
+
+				// Functions refer to themselves, so they're bound before their body is folded
+				bool func = assign->assign.value->tag == CURLY_IR_TAGS_FUNC;
+				if (func)
+					saved[i] = fold_bind_local(state, assign->assign.binding.index, NULL);
+				fold_sexpr(assign, state);
+				if (!func)
+				{
+					ir_sexpr_t* value = assign->assign.value;
+					saved[i] = fold_bind_local(state, assign->assign.binding.index, fold_constant(value) && value->type == assign->type ? value : NULL);
+				}
+			}
+
+			// Fold the value and restore the locals in reverse, since a local can be assigned more than once
+			fold_sexpr(sexpr->local_scope.value, state);
+			for (size_t i = count; i > 0; i--)
+			{
+				state->locals[saved[i - 1].slot] = saved[i - 1].value;
+			}
+			free(saved);
+			return;
+		}
+
+		case CURLY_IR_TAGS_FUNC:
+		{
+			// Arguments aren't constants
+			ir_sexpr_func_t* func = state->ir->funcs[sexpr->func_id];
+			fold_saved_t* saved = calloc(func->arg_count, sizeof(fold_saved_t));
+			for (size_t i = 0; i < func->arg_count; i++)
+			{
+				saved[i] = fold_bind_local(state, func->args[i].binding.index, NULL);
+			}
+			fold_sexpr(func->body, state);
+			for (size_t i = func->arg_count; i > 0; i--)
+			{
+				state->locals[saved[i - 1].slot] = saved[i - 1].value;
+			}
+			free(saved);
+			return;
+		}
+
+		case CURLY_IR_TAGS_IF:
+		{
+			// Only the branch taken is kept if the condition is constant
+			fold_sexpr(sexpr->if_expr.cond, state);
+			ir_sexpr_t* cond = sexpr->if_expr.cond;
+			if (cond->tag == CURLY_IR_TAGS_BOOL)
+			{
+				ir_sexpr_t* taken = cond->i1 ? sexpr->if_expr.then : sexpr->if_expr.elsy;
+				ir_sexpr_t* dead = cond->i1 ? sexpr->if_expr.elsy : sexpr->if_expr.then;
+				if (taken->type == sexpr->type)
+				{
+					fold_sexpr(taken, state);
+					clean_ir_sexpr(cond);
+					clean_ir_sexpr(dead);
+					fold_replace(sexpr, taken);
+					return;
+				}
+			}
+
+			fold_sexpr(sexpr->if_expr.then, state);
+			fold_sexpr(sexpr->if_expr.elsy, state);
+			return;
+		}
+
+		case CURLY_IR_TAGS_LIST:
+			for (size_t i = 0; i < sexpr->list.element_count; i++)
+			{
+				fold_sexpr(sexpr->list.elements[i], state);
+			}
+			return;
+
+		case CURLY_IR_TAGS_SLICE:
+			fold_sexpr(sexpr->slice.list, state);
+			fold_sexpr(sexpr->slice.start, state);
+			fold_sexpr(sexpr->slice.end, state);
+			return;
+
+		case CURLY_IR_TAGS_FOR:
+		{
+			// The loop variable isn't a constant
+			fold_sexpr(sexpr->for_loop.iter, state);
+			fold_saved_t saved = fold_bind_local(state, sexpr->for_loop.var_binding.index, NULL);
+			fold_sexpr(sexpr->for_loop.body, state);
+			state->locals[saved.slot] = saved.value;
+			return;
+		}
+
+		case CURLY_IR_TAGS_RANGE:
+			fold_sexpr(sexpr->range.start, state);
+			if (sexpr->range.end != NULL)
+				fold_sexpr(sexpr->range.end, state);
+			return;
+
+		case CURLY_IR_TAGS_DUP:
+		case CURLY_IR_TAGS_DROP:
+			fold_sexpr(sexpr->rc.value, state);
+			return;
+
+		default:
+			return;
+	}
+}
+
+// fold_constants(curly_ir_t*, ir_scope_t*) -> void
+// Replaces operations on constants in type checked IR with their results, replaces uses of locals bound to constants
+// with the constants, and replaces if expressions with constant conditions with the branch they take.
+void fold_constants(curly_ir_t* ir, ir_scope_t* scope)
+{
+	fold_state_t state = {ir, scope_lookup_type(scope, "Int"), scope_lookup_type(scope, "Float"), scope_lookup_type(scope, "Bool"), NULL, 0};
+	for (size_t i = 0; i < ir->expr_count; i++)
+	{
+		fold_sexpr(ir->expr[i], &state);
+	}
+	free(state.locals);
+}
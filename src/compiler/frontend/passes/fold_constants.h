@@ -0,0 +1,20 @@
+//
+// passes
+// fold_constants.h: Header file for fold_constants.c.
+//
+// Created by jenra.
+// Created on October 18 2026.
+//
+
+#ifndef PASSES_FOLD_CONSTANTS_H
+#define PASSES_FOLD_CONSTANTS_H
+
+#include "../correctness/scope.h"
+#include "../ir/generate_ir.h"
+
+// fold_constants(curly_ir_t*, ir_scope_t*) -> void
+// Replaces operations on constants in type checked IR with their results, replaces uses of locals bound to constants
+// with the constants, and replaces if expressions with constant conditions with the branch they take.
+void fold_constants(curly_ir_t* ir, ir_scope_t* scope);
+
+#endif /* PASSES_FOLD_CONSTANTS_H */
@@ -0,0 +1,814 @@
+//
+// passes
+// inline.c: Inlines small functions and locals used once in IR.
+//
+// Created by jenra.
+// Created on October 18 2026.
+//
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../../../utils/list.h"
+#include "inline.h"
+#include "resolve_symbols.h"
+
+// A saturated call of a function bound to a known name is replaced with a copy of the function's body, with the
+// arguments bound to fresh locals around it. Only bodies without functions or loops that refer to nothing but their own
+// arguments, their own locals, and globals are copied, so the copy means the same thing wherever it's put, as long as
+// none of the globals it refers to are shadowed at the call. Bodies are inlined if they're small, and bodies of calls
+// with constant arguments can be larger since they're likely to be folded. Afterwards, locals that are used once are
+// replaced with their value, as long as the use isn't repeated (in a function or a loop body) and nothing the value
+// refers to is bound again between the local and its use. This also substitutes the arguments of inlined calls.
+
+// Represents a local whose function was replaced, so that it can be restored at the end of a scope.
+typedef struct
+{
+	size_t slot;
+	ir_sexpr_t* value;
+} inline_saved_t;
+
+// Represents the state of inlining calls.
+typedef struct
+{
+	curly_ir_t* ir;
+	bool report;
+
+	// The function each global is bound to if it's assigned exactly once, or NULL.
+	ir_sexpr_t** globals;
+	size_t global_count;
+
+	// The function each local slot is bound to, or NULL if it isn't bound to one.
+	ir_sexpr_t** locals;
+	size_t local_size;
+
+	// The names of the locals in scope.
+	char** names;
+	size_t name_size;
+	size_t name_count;
+
+	// Whether calls were inlined into the body of each function, and the innermost function being inlined into (or
+	// SIZE_MAX at the top level).
+	bool* changed;
+	size_t func;
+} inline_state_t;
+
+// Represents what was found when looking for the uses of a local.
+typedef struct
+{
+	size_t slot;
+
+	// The names the value of the local refers to.
+	char** names;
+	size_t name_size;
+	size_t name_count;
+
+	// The last use found, the number of uses, and whether a use is repeated or a name the value refers to is bound.
+	ir_sexpr_t* use;
+	size_t use_count;
+	bool blocked;
+} inline_uses_t;
+
+// The number of locals bound by inlining.
+size_t inline_count = 0;
+
+// inline_bind_local(inline_state_t*, size_t, ir_sexpr_t*) -> inline_saved_t
+// Binds a local slot to a function (or to NULL if it isn't bound to one), returning what it was bound to before.
+inline_saved_t inline_bind_local(inline_state_t* state, size_t slot, ir_sexpr_t* value)
+{
+	if (slot >= state->local_size)
+	{
+		size_t size = state->local_size != 0 ? state->local_size : 8;
+		while (size <= slot)
+		{
+			size *= 2;
+		}
+		state->locals = realloc(state->locals, size * sizeof(ir_sexpr_t*));
+		memset(state->locals + state->local_size, 0, (size - state->local_size) * sizeof(ir_sexpr_t*));
+		state->local_size = size;
+	}
+
+	inline_saved_t saved = {slot, state->locals[slot]};
+	state->locals[slot] = value;
+	return saved;
+}
+
+// inline_measure(ir_sexpr_t*, size_t, size_t, size_t*) -> bool
+// Adds the number of S expressions in the body of a function to size. Returns false if the body can't be copied, which
+// is when it has functions or loops, or refers to locals bound before the first argument slot or to the global self.
+bool inline_measure(ir_sexpr_t* sexpr, size_t base, size_t self, size_t* size)
+{
+	(*size)++;
+	switch (sexpr->tag)
+	{
+		case CURLY_IR_TAGS_INT:
+		case CURLY_IR_TAGS_FLOAT:
+		case CURLY_IR_TAGS_BOOL:
+		case CURLY_IR_TAGS_DECLARE:
+			return true;
+		case CURLY_IR_TAGS_SYMBOL:
+			return sexpr->binding.global ? sexpr->binding.index != self : sexpr->binding.index >= base;
+		case CURLY_IR_TAGS_INFIX:
+			return inline_measure(sexpr->infix.left, base, self, size) && inline_measure(sexpr->infix.right, base, self, size);
+		case CURLY_IR_TAGS_PREFIX:
+			return inline_measure(sexpr->prefix.operand, base, self, size);
+		case CURLY_IR_TAGS_APPLY:
+			return inline_measure(sexpr->apply.func, base, self, size) && inline_measure(sexpr->apply.arg, base, self, size);
+		case CURLY_IR_TAGS_ASSIGN:
+			return sexpr->assign.value->tag != CURLY_IR_TAGS_FUNC && inline_measure(sexpr->assign.value, base, self, size);
+
+		case CURLY_IR_TAGS_LOCAL_SCOPE:
+			for (size_t i = 0; i < sexpr->local_scope.assign_count; i++)
+			{
+				if (!inline_measure(sexpr->local_scope.assigns[i], base, self, size))
+					return false;
+			}
+			return inline_measure(sexpr->local_scope.value, base, self, size);
+
+		case CURLY_IR_TAGS_IF:
+			return inline_measure(sexpr->if_expr.cond, base, self, size) && inline_measure(sexpr->if_expr.then, base, self, size)
+				&& inline_measure(sexpr->if_expr.elsy, base, self, size);
+
+		case CURLY_IR_TAGS_LIST:
+			for (size_t i = 0; i < sexpr->list.element_count; i++)
+			{
+				if (!inline_measure(sexpr->list.elements[i], base, self, size))
+					return false;
+			}
+			return true;
+
+		case CURLY_IR_TAGS_SLICE:
+			return inline_measure(sexpr->slice.list, base, self, size) && inline_measure(sexpr->slice.start, base, self, size)
+				&& inline_measure(sexpr->slice.end, base, self, size);
+		case CURLY_IR_TAGS_RANGE:
+			return inline_measure(sexpr->range.start, base, self, size) && (sexpr->range.end == NULL || inline_measure(sexpr->range.end, base, self, size));
+
+		default:
+			return false;
+	}
+}
+
+// inline_collect_names(ir_sexpr_t*, curly_ir_t*, bool, char***, size_t*, size_t*) -> void
+// Collects the names an S expression refers to, or only the names of globals if globals is set.
+void inline_collect_names(ir_sexpr_t* sexpr, curly_ir_t* ir, bool globals, char*** names, size_t* name_size, size_t* name_count)
+{
+	switch (sexpr->tag)
+	{
+		case CURLY_IR_TAGS_SYMBOL:
+			if (!globals || sexpr->binding.global)
+				list_append_element(*names, *name_size, *name_count, char*, sexpr->symbol);
+			return;
+		case CURLY_IR_TAGS_INFIX:
+			inline_collect_names(sexpr->infix.left, ir, globals, names, name_size, name_count);
+			inline_collect_names(sexpr->infix.right, ir, globals, names, name_size, name_count);
+			return;
+		case CURLY_IR_TAGS_PREFIX:
+			inline_collect_names(sexpr->prefix.operand, ir, globals, names, name_size, name_count);
+			return;
+		case CURLY_IR_TAGS_APPLY:
+			inline_collect_names(sexpr->apply.func, ir, globals, names, name_size, name_count);
+			inline_collect_names(sexpr->apply.arg, ir, globals, names, name_size, name_count);
+			return;
+		case CURLY_IR_TAGS_ASSIGN:
+			inline_collect_names(sexpr->assign.value, ir, globals, names, name_size, name_count);
+			return;
+
+		case CURLY_IR_TAGS_LOCAL_SCOPE:
+			for (size_t i = 0; i < sexpr->local_scope.assign_count; i++)
+			{
+				inline_collect_names(sexpr->local_scope.assigns[i], ir, globals, names, name_size, name_count);
+			}
+			inline_collect_names(sexpr->local_scope.value, ir, globals, names, name_size, name_count);
+			return;
+
+		case CURLY_IR_TAGS_FUNC:
+			inline_collect_names(ir->funcs[sexpr->func_id]->body, ir, globals, names, name_size, name_count);
+			return;
+		case CURLY_IR_TAGS_IF:
+			inline_collect_names(sexpr->if_expr.cond, ir, globals, names, name_size, name_count);
+			inline_collect_names(sexpr->if_expr.then, ir, globals, names, name_size, name_count);
+			inline_collect_names(sexpr->if_expr.elsy, ir, globals, names, name_size, name_count);
+			return;
+
+		case CURLY_IR_TAGS_LIST:
+			for (size_t i = 0; i < sexpr->list.element_count; i++)
+			{
+				inline_collect_names(sexpr->list.elements[i], ir, globals, names, name_size, name_count);
+			}
+			return;
+
+		case CURLY_IR_TAGS_SLICE:
+			inline_collect_names(sexpr->slice.list, ir, globals, names, name_size, name_count);
+			inline_collect_names(sexpr->slice.start, ir, globals, names, name_size, name_count);
+			inline_collect_names(sexpr->slice.end, ir, globals, names, name_size, name_count);
+			return;
+		case CURLY_IR_TAGS_FOR:
+			inline_collect_names(sexpr->for_loop.iter, ir, globals, names, name_size, name_count);
+			inline_collect_names(sexpr->for_loop.body, ir, globals, names, name_size, name_count);
+			return;
+		case CURLY_IR_TAGS_RANGE:
+			inline_collect_names(sexpr->range.start, ir, globals, names, name_size, name_count);
+			if (sexpr->range.end != NULL)
+				inline_collect_names(sexpr->range.end, ir, globals, names, name_size, name_count);
+			return;
+
+		default:
+			return;
+	}
+}
+
+// inline_has_name(char**, size_t, char*) -> bool
+// Returns whether a list of names has a name.
+bool inline_has_name(char** names, size_t name_count, char* name)
+{
+	for (size_t i = 0; i < name_count; i++)
+	{
+		if (!strcmp(names[i], name))
+			return true;
+	}
+	return false;
+}
+
+
+// inline_clone(ir_sexpr_t*, size_t, ir_sexpr_t**, size_t) -> ir_sexpr_t*
+// Copies the body of a function that can be copied, renaming its arguments to the locals they're assigned to. The
+// arguments are in the slots from base, and the locals of the body are in the slots after them.
+ir_sexpr_t* inline_clone(ir_sexpr_t* sexpr, size_t base, ir_sexpr_t** assigns, size_t arg_count)
+{
+	ir_sexpr_t* clone = malloc(sizeof(ir_sexpr_t));
+	*clone = *sexpr;
+	switch (sexpr->tag)
+	{
+		case CURLY_IR_TAGS_SYMBOL:
+			if (!sexpr->binding.global && sexpr->binding.index - base < arg_count)
+				clone->symbol = strdup(assigns[sexpr->binding.index - base]->assign.name);
+			else clone->symbol = strdup(sexpr->symbol);
+			break;
+		case CURLY_IR_TAGS_INFIX:
+			clone->infix.left = inline_clone(sexpr->infix.left, base, assigns, arg_count);
+			clone->infix.right = inline_clone(sexpr->infix.right, base, assigns, arg_count);
+			break;
+		case CURLY_IR_TAGS_PREFIX:
+			clone->prefix.operand = inline_clone(sexpr->prefix.operand, base, assigns, arg_count);
+			break;
+		case CURLY_IR_TAGS_APPLY:
+			clone->apply.func = inline_clone(sexpr->apply.func, base, assigns, arg_count);
+			clone->apply.arg = inline_clone(sexpr->apply.arg, base, assigns, arg_count);
+			break;
+		case CURLY_IR_TAGS_ASSIGN:
+			clone->assign.name = strdup(sexpr->assign.name);
+			clone->assign.value = inline_clone(sexpr->assign.value, base, assigns, arg_count);
+			break;
+		case CURLY_IR_TAGS_DECLARE:
+			clone->declare.name = strdup(sexpr->declare.name);
+			break;
+
+		case CURLY_IR_TAGS_LOCAL_SCOPE:
+			clone->local_scope.assigns = calloc(sexpr->local_scope.assign_count, sizeof(ir_sexpr_t*));
+			for (size_t i = 0; i < sexpr->local_scope.assign_count; i++)
+			{
+				clone->local_scope.assigns[i] = inline_clone(sexpr->local_scope.assigns[i], base, assigns, arg_count);
+			}
+			clone->local_scope.value = inline_clone(sexpr->local_scope.value, base, assigns, arg_count);
+			break;
+
+		case CURLY_IR_TAGS_IF:
+			clone->if_expr.cond = inline_clone(sexpr->if_expr.cond, base, assigns, arg_count);
+			clone->if_expr.then = inline_clone(sexpr->if_expr.then, base, assigns, arg_count);
+			clone->if_expr.elsy = inline_clone(sexpr->if_expr.elsy, base, assigns, arg_count);
+			break;
+
+		case CURLY_IR_TAGS_LIST:
+			clone->list.elements = calloc(sexpr->list.element_count, sizeof(ir_sexpr_t*));
+			for (size_t i = 0; i < sexpr->list.element_count; i++)
+			{
+				clone->list.elements[i] = inline_clone(sexpr->list.elements[i], base, assigns, arg_count);
+			}
+			break;
+
+		case CURLY_IR_TAGS_SLICE:
+			clone->slice.list = inline_clone(sexpr->slice.list, base, assigns, arg_count);
+			clone->slice.start = inline_clone(sexpr->slice.start, base, assigns, arg_count);
+			clone->slice.end = inline_clone(sexpr->slice.end, base, assigns, arg_count);
+			break;
+		case CURLY_IR_TAGS_RANGE:
+			clone->range.start = inline_clone(sexpr->range.start, base, assigns, arg_count);
+			if (sexpr->range.end != NULL)
+				clone->range.end = inline_clone(sexpr->range.end, base, assigns, arg_count);
+			break;
+
+		default:
+			break;
+	}
+	return clone;
+}
+
+// inline_call(ir_sexpr_t*, inline_state_t*) -> void
+// Replaces a saturated call of a function bound to a known name with the function's body if the body is small enough.
+void inline_call(ir_sexpr_t* sexpr, inline_state_t* state)
+{
+	// Find the function called
+	size_t arg_count = 0;
+	ir_sexpr_t* head = sexpr;
+	while (head->tag == CURLY_IR_TAGS_APPLY)
+	{
+		head = head->apply.func;
+		arg_count++;
+	}
+	if (head->tag != CURLY_IR_TAGS_SYMBOL)
+		return;
+	size_t index = head->binding.index;
+	ir_sexpr_t* value = NULL;
+	if (head->binding.global && index < state->global_count)
+		value = state->globals[index];
+	else if (!head->binding.global && index < state->local_size)
+		value = state->locals[index];
+	if (value == NULL || value->type->has_vars || value->type != head->type)
+		return;
+	ir_sexpr_func_t* func = state->ir->funcs[value->func_id];
+	if (func->arg_count != arg_count)
+		return;
+
+	// Collect the arguments, allowing larger bodies for every constant argument
+	ir_sexpr_t** args = calloc(arg_count, sizeof(ir_sexpr_t*));
+	ir_sexpr_t* apply = sexpr;
+	bool types_match = func->body->type == sexpr->type;
+	size_t limit = CURLY_INLINE_SIZE_LIMIT;
+	for (size_t i = arg_count; i > 0; i--)
+	{
+		ir_sexpr_t* arg = args[i - 1] = apply->apply.arg;
+		types_match = types_match && arg->type == func->args[i - 1].type;
+		if (arg->tag == CURLY_IR_TAGS_INT || arg->tag == CURLY_IR_TAGS_FLOAT || arg->tag == CURLY_IR_TAGS_BOOL)
+			limit += CURLY_INLINE_CONSTANT_BONUS;
+		apply = apply->apply.func;
+	}
+
+	// Bodies are only copied if they're small and would mean the same thing here
+	size_t base = func->args[0].binding.index;
+	size_t size = 0;
+	bool copyable = !state->changed[value->func_id] && inline_measure(func->body, base, head->binding.global ? index : SIZE_MAX, &size);
+	bool shadowed = false;
+	if (copyable && types_match && size <= limit)
+	{
+		char** globals = NULL;
+		size_t global_size = 0;
+		size_t global_count = 0;
+		inline_collect_names(func->body, state->ir, true, &globals, &global_size, &global_count);
+		for (size_t i = 0; !shadowed && i < global_count; i++)
+		{
+			shadowed = inline_has_name(state->names, state->name_count, globals[i]);
+		}
+		free(globals);
+	}
+
+	// Report the decision
+	if (state->report)
+	{
+		if (!copyable)
+			printf("Not inlining %s at %i:%i: its body is recursive or can't be copied\n", head->symbol, head->lino, head->charpos);
+		else if (!types_match)
+			printf("Not inlining %s at %i:%i: its types differ from the call\n", head->symbol, head->lino, head->charpos);
+		else if (size > limit)
+			printf("Not inlining %s at %i:%i: its body has %zu S expressions (the limit is %zu)\n", head->symbol, head->lino, head->charpos, size, limit);
+		else if (shadowed)
+			printf("Not inlining %s at %i:%i: a global its body refers to is shadowed\n", head->symbol, head->lino, head->charpos);
+		else printf("Inlining %s at %i:%i\n", head->symbol, head->lino, head->charpos);
+	}
+	if (!copyable || !types_match || size > limit || shadowed)
+	{
+		free(args);
+		return;
+	}
+
+	// Bind the arguments to fresh locals
+	ir_sexpr_t** assigns = calloc(arg_count, sizeof(ir_sexpr_t*));
+	for (size_t i = 0; i < arg_count; i++)
+	{
+		ir_sexpr_t* assign = malloc(sizeof(ir_sexpr_t));
+		assign->tag = CURLY_IR_TAGS_ASSIGN;
+		assign->type = func->args[i].type;
+		assign->pos = args[i]->pos;
+		assign->lino = args[i]->lino;
+		assign->charpos = args[i]->charpos;
+		assign->assign.name = malloc(strlen(func->args[i].name) + 32);
+		sprintf(assign->assign.name, "%s.inline%zu", func->args[i].name, inline_count++);
+		assign->assign.binding = (ir_binding_id_t) {false, 0};
+		assign->assign.value = args[i];
+		assigns[i] = assign;
+	}
+	free(args);
+
+	// Replace the call with a copy of the body in the scope of the arguments
+	ir_sexpr_t* body = inline_clone(func->body, base, assigns, arg_count);
+	apply = sexpr->apply.func;
+	while (apply->tag == CURLY_IR_TAGS_APPLY)
+	{
+		ir_sexpr_t* next = apply->apply.func;
+		free(apply);
+		apply = next;
+	}
+	clean_ir_sexpr(apply);
+	sexpr->tag = CURLY_IR_TAGS_LOCAL_SCOPE;
+	sexpr->local_scope.assigns = assigns;
+	sexpr->local_scope.assign_count = arg_count;
+	sexpr->local_scope.value = body;
+	if (state->func != SIZE_MAX)
+		state->changed[state->func] = true;
+}
+
+// inline_calls(ir_sexpr_t*, inline_state_t*) -> void
+// Inlines the calls in an S expression, innermost first.
+void inline_calls(ir_sexpr_t* sexpr, inline_state_t* state)
+{
+	switch (sexpr->tag)
+	{
+		case CURLY_IR_TAGS_INFIX:
+			inline_calls(sexpr->infix.left, state);
+			inline_calls(sexpr->infix.right, state);
+			return;
+		case CURLY_IR_TAGS_PREFIX:
+			inline_calls(sexpr->prefix.operand, state);
+			return;
+
+		case CURLY_IR_TAGS_APPLY:
+			inline_calls(sexpr->apply.func, state);
+			inline_calls(sexpr->apply.arg, state);
+			inline_call(sexpr, state);
+			return;
+
+		case CURLY_IR_TAGS_ASSIGN:
+			inline_calls(sexpr->assign.value, state);
+			return;
+
+		case CURLY_IR_TAGS_LOCAL_SCOPE:
+		{
+			// Bind the locals assigned functions, which are bound before their body since they can refer to themselves
+			size_t name_count = state->name_count;
+			size_t count = sexpr->local_scope.assign_count;
+			inline_saved_t* saved = calloc(count, sizeof(inline_saved_t));
+			for (size_t i = 0; i < count; i++)
+			{
+				ir_sexpr_t* assign = sexpr->local_scope.assigns[i];
+				if (assign->tag == CURLY_IR_TAGS_DECLARE)
+				{
+					saved[i] = inline_bind_local(state, assign->declare.binding.index, NULL);
+					list_append_element(state->names, state->name_size, state->name_count, char*, assign->declare.name);
+					continue;
+				}
+
+				bool func = assign->assign.value->tag == CURLY_IR_TAGS_FUNC;
+				if (func)
+					saved[i] = inline_bind_local(state, assign->assign.binding.index, assign->assign.value);
+				inline_calls(assign, state);
+				if (!func)
+					saved[i] = inline_bind_local(state, assign->assign.binding.index, NULL);
+				list_append_element(state->names, state->name_size, state->name_count, char*, assign->assign.name);
+			}
+
+			// Inline the value and restore the locals in reverse, since a local can be assigned more than once
+			inline_calls(sexpr->local_scope.value, state);
+			for (size_t i = count; i > 0; i--)
+			{
+				state->locals[saved[i - 1].slot] = saved[i - 1].value;
+			}
+			free(saved);
+			state->name_count = name_count;
+			return;
+		}
+
+		case CURLY_IR_TAGS_FUNC:
+		{
+			// Arguments aren't known functions
+			ir_sexpr_func_t* func = state->ir->funcs[sexpr->func_id];
+			size_t name_count = state->name_count;
+			size_t outer = state->func;
+			inline_saved_t* saved = calloc(func->arg_count, sizeof(inline_saved_t));
+			for (size_t i = 0; i < func->arg_count; i++)
+			{
+				saved[i] = inline_bind_local(state, func->args[i].binding.index, NULL);
+				list_append_element(state->names, state->name_size, state->name_count, char*, func->args[i].name);
+			}
+			state->func = sexpr->func_id;
+			inline_calls(func->body, state);
+			state->func = outer;
+			for (size_t i = func->arg_count; i > 0; i--)
+			{
+				state->locals[saved[i - 1].slot] = saved[i - 1].value;
+			}
+			free(saved);
+			state->name_count = name_count;
+			return;
+		}
+
+		case CURLY_IR_TAGS_IF:
+			inline_calls(sexpr->if_expr.cond, state);
+			inline_calls(sexpr->if_expr.then, state);
+			inline_calls(sexpr->if_expr.elsy, state);
+			return;
+
+		case CURLY_IR_TAGS_LIST:
+			for (size_t i = 0; i < sexpr->list.element_count; i++)
+			{
+				inline_calls(sexpr->list.elements[i], state);
+			}
+			return;
+
+		case CURLY_IR_TAGS_SLICE:
+			inline_calls(sexpr->slice.list, state);
+			inline_calls(sexpr->slice.start, state);
+			inline_calls(sexpr->slice.end, state);
+			return;
+
+		case CURLY_IR_TAGS_FOR:
+		{
+			// The loop variable isn't a known function
+			size_t name_count = state->name_count;
+			inline_calls(sexpr->for_loop.iter, state);
+			inline_saved_t saved = inline_bind_local(state, sexpr->for_loop.var_binding.index, NULL);
+			list_append_element(state->names, state->name_size, state->name_count, char*, sexpr->for_loop.var);
+			inline_calls(sexpr->for_loop.body, state);
+			state->locals[saved.slot] = saved.value;
+			state->name_count = name_count;
+			return;
+		}
+
+		case CURLY_IR_TAGS_RANGE:
+			inline_calls(sexpr->range.start, state);
+			if (sexpr->range.end != NULL)
+				inline_calls(sexpr->range.end, state);
+			return;
+
+		default:
+			return;
+	}
+}
+
+// inline_find_uses(ir_sexpr_t*, curly_ir_t*, bool, inline_uses_t*) -> void
+// Finds the uses of a local in an S expression, blocking the local from being substituted if a use is repeated or a
+// name its value refers to is bound.
+void inline_find_uses(ir_sexpr_t* sexpr, curly_ir_t* ir, bool repeated, inline_uses_t* uses)
+{
+	switch (sexpr->tag)
+	{
+		case CURLY_IR_TAGS_SYMBOL:
+			if (!sexpr->binding.global && sexpr->binding.index == uses->slot)
+			{
+				uses->use = sexpr;
+				uses->use_count++;
+				uses->blocked = uses->blocked || repeated;
+			}
+			return;
+
+		case CURLY_IR_TAGS_INFIX:
+			inline_find_uses(sexpr->infix.left, ir, repeated, uses);
+			inline_find_uses(sexpr->infix.right, ir, repeated, uses);
+			return;
+		case CURLY_IR_TAGS_PREFIX:
+			inline_find_uses(sexpr->prefix.operand, ir, repeated, uses);
+			return;
+		case CURLY_IR_TAGS_APPLY:
+			inline_find_uses(sexpr->apply.func, ir, repeated, uses);
+			inline_find_uses(sexpr->apply.arg, ir, repeated, uses);
+			return;
+
+		case CURLY_IR_TAGS_ASSIGN:
+			uses->blocked = uses->blocked || inline_has_name(uses->names, uses->name_count, sexpr->assign.name);
+			inline_find_uses(sexpr->assign.value, ir, repeated, uses);
+			return;
+		case CURLY_IR_TAGS_DECLARE:
+			uses->blocked = uses->blocked || inline_has_name(uses->names, uses->name_count, sexpr->declare.name);
+			return;
+
+		case CURLY_IR_TAGS_LOCAL_SCOPE:
+			for (size_t i = 0; i < sexpr->local_scope.assign_count; i++)
+			{
+				inline_find_uses(sexpr->local_scope.assigns[i], ir, repeated, uses);
+			}
+			inline_find_uses(sexpr->local_scope.value, ir, repeated, uses);
+			return;
+
+		case CURLY_IR_TAGS_FUNC:
+		{
+			// Function bodies are run any number of times
+			ir_sexpr_func_t* func = ir->funcs[sexpr->func_id];
+			for (size_t i = 0; i < func->arg_count; i++)
+			{
+				uses->blocked = uses->blocked || inline_has_name(uses->names, uses->name_count, func->args[i].name);
+			}
+			inline_find_uses(func->body, ir, true, uses);
+			return;
+		}
+
+		case CURLY_IR_TAGS_IF:
+			inline_find_uses(sexpr->if_expr.cond, ir, repeated, uses);
+			inline_find_uses(sexpr->if_expr.then, ir, repeated, uses);
+			inline_find_uses(sexpr->if_expr.elsy, ir, repeated, uses);
+			return;
+
+		case CURLY_IR_TAGS_LIST:
+			for (size_t i = 0; i < sexpr->list.element_count; i++)
+			{
+				inline_find_uses(sexpr->list.elements[i], ir, repeated, uses);
+			}
+			return;
+
+		case CURLY_IR_TAGS_SLICE:
+			inline_find_uses(sexpr->slice.list, ir, repeated, uses);
+			inline_find_uses(sexpr->slice.start, ir, repeated, uses);
+			inline_find_uses(sexpr->slice.end, ir, repeated, uses);
+			return;
+
+		case CURLY_IR_TAGS_FOR:
+			// Loop bodies are run once for every item
+			inline_find_uses(sexpr->for_loop.iter, ir, repeated, uses);
+			uses->blocked = uses->blocked || inline_has_name(uses->names, uses->name_count, sexpr->for_loop.var);
+			inline_find_uses(sexpr->for_loop.body, ir, true, uses);
+			return;
+
+		case CURLY_IR_TAGS_RANGE:
+			inline_find_uses(sexpr->range.start, ir, repeated, uses);
+			if (sexpr->range.end != NULL)
+				inline_find_uses(sexpr->range.end, ir, repeated, uses);
+			return;
+
+		default:
+			return;
+	}
+}
+
+// inline_local(ir_sexpr_t*, size_t, curly_ir_t*, bool) -> bool
+// Replaces the only use of a local assigned in a local scope with its value and removes the assignment. Returns false
+// if the local can't be substituted.
+bool inline_local(ir_sexpr_t* sexpr, size_t index, curly_ir_t* ir, bool report)
+{
+	// Functions are inlined instead, and locals assigned more than once aren't substituted
+	ir_sexpr_t** assigns = sexpr->local_scope.assigns;
+	size_t count = sexpr->local_scope.assign_count;
+	ir_sexpr_t* assign = assigns[index];
+	if (assign->tag != CURLY_IR_TAGS_ASSIGN || assign->assign.value->tag == CURLY_IR_TAGS_FUNC)
+		return false;
+	size_t slot = assign->assign.binding.index;
+	for (size_t i = 0; i < count; i++)
+	{
+		ir_sexpr_t* other = assigns[i];
+		size_t other_slot = other->tag == CURLY_IR_TAGS_ASSIGN ? other->assign.binding.index : other->declare.binding.index;
+		if (i != index && other_slot == slot)
+			return false;
+	}
+
+	// Find the uses after the assignment
+	ir_sexpr_t* value = assign->assign.value;
+	inline_uses_t uses = {slot, NULL, 0, 0, NULL, 0, false};
+	inline_collect_names(value, ir, false, &uses.names, &uses.name_size, &uses.name_count);
+	for (size_t i = index + 1; i < count; i++)
+	{
+		inline_find_uses(assigns[i], ir, false, &uses);
+	}
+	inline_find_uses(sexpr->local_scope.value, ir, false, &uses);
+	free(uses.names);
+	if (uses.use_count != 1 || uses.blocked || uses.use->type != value->type)
+		return false;
+
+	// Move the value to the use and remove the assignment
+	if (report)
+		printf("Substituting %s at %i:%i\n", assign->assign.name, uses.use->lino, uses.use->charpos);
+	free(uses.use->symbol);
+	*uses.use = *value;
+	free(value);
+	free(assign->assign.name);
+	free(assign);
+	memmove(assigns + index, assigns + index + 1, (count - index - 1) * sizeof(ir_sexpr_t*));
+	sexpr->local_scope.assign_count--;
+	return true;
+}
+
+// inline_locals(ir_sexpr_t*, curly_ir_t*, bool) -> void
+// Substitutes the locals used once in an S expression, innermost first.
+void inline_locals(ir_sexpr_t* sexpr, curly_ir_t* ir, bool report)
+{
+	switch (sexpr->tag)
+	{
+		case CURLY_IR_TAGS_INFIX:
+			inline_locals(sexpr->infix.left, ir, report);
+			inline_locals(sexpr->infix.right, ir, report);
+			return;
+		case CURLY_IR_TAGS_PREFIX:
+			inline_locals(sexpr->prefix.operand, ir, report);
+			return;
+		case CURLY_IR_TAGS_APPLY:
+			inline_locals(sexpr->apply.func, ir, report);
+			inline_locals(sexpr->apply.arg, ir, report);
+			return;
+		case CURLY_IR_TAGS_ASSIGN:
+			inline_locals(sexpr->assign.value, ir, report);
+			return;
+
+		case CURLY_IR_TAGS_LOCAL_SCOPE:
+		{
+			for (size_t i = 0; i < sexpr->local_scope.assign_count; i++)
+			{
+				inline_locals(sexpr->local_scope.assigns[i], ir, report);
+			}
+			inline_locals(sexpr->local_scope.value, ir, report);
+
+			// Substitute the locals in order, and replace the scope with its value if none are left
+			for (size_t i = 0; i < sexpr->local_scope.assign_count;)
+			{
+				if (!inline_local(sexpr, i, ir, report))
+					i++;
+			}
+			ir_sexpr_t* value = sexpr->local_scope.value;
+			if (sexpr->local_scope.assign_count == 0 && value->type == sexpr->type)
+			{
+				free(sexpr->local_scope.assigns);
+				*sexpr = *value;
+				free(value);
+			}
+			return;
+		}
+
+		case CURLY_IR_TAGS_FUNC:
+			inline_locals(ir->funcs[sexpr->func_id]->body, ir, report);
+			return;
+		case CURLY_IR_TAGS_IF:
+			inline_locals(sexpr->if_expr.cond, ir, report);
+			inline_locals(sexpr->if_expr.then, ir, report);
+			inline_locals(sexpr->if_expr.elsy, ir, report);
+			return;
+
+		case CURLY_IR_TAGS_LIST:
+			for (size_t i = 0; i < sexpr->list.element_count; i++)
+			{
+				inline_locals(sexpr->list.elements[i], ir, report);
+			}
+			return;
+
+		case CURLY_IR_TAGS_SLICE:
+			inline_locals(sexpr->slice.list, ir, report);
+			inline_locals(sexpr->slice.start, ir, report);
+			inline_locals(sexpr->slice.end, ir, report);
+			return;
+		case CURLY_IR_TAGS_FOR:
+			inline_locals(sexpr->for_loop.iter, ir, report);
+			inline_locals(sexpr->for_loop.body, ir, report);
+			return;
+		case CURLY_IR_TAGS_RANGE:
+			inline_locals(sexpr->range.start, ir, report);
+			if (sexpr->range.end != NULL)
+				inline_locals(sexpr->range.end, ir, report);
+			return;
+
+		default:
+			return;
+	}
+}
+
+// inline_functions(curly_ir_t*, ir_scope_t*, bool, bool) -> void
+// Replaces saturated calls of small functions in type checked IR with their bodies, and replaces locals that are used
+// once with their values. Globals are only inlined if inline_globals is set, since the repl can reassign them. Prints
+// every decision if report is set.
+void inline_functions(curly_ir_t* ir, ir_scope_t* scope, bool inline_globals, bool report)
+{
+	// Monomorphisation binds specialisations, which moves the slots of locals
+	resolve_symbols(ir, scope);
+
+	// Find the globals assigned a function exactly once
+	size_t global_count = inline_globals ? scope->global_count : 0;
+	ir_sexpr_t** globals = calloc(global_count, sizeof(ir_sexpr_t*));
+	size_t* assigned = calloc(global_count, sizeof(size_t));
+	for (size_t i = 0; i < ir->expr_count; i++)
+	{
+		ir_sexpr_t* sexpr = ir->expr[i];
+		if (sexpr->tag != CURLY_IR_TAGS_ASSIGN || !sexpr->assign.binding.global || sexpr->assign.binding.index >= global_count)
+			continue;
+		size_t global = sexpr->assign.binding.index;
+		assigned[global]++;
+		globals[global] = sexpr->assign.value->tag == CURLY_IR_TAGS_FUNC ? sexpr->assign.value : NULL;
+	}
+	for (size_t i = 0; i < global_count; i++)
+	{
+		if (assigned[i] != 1)
+			globals[i] = NULL;
+	}
+	free(assigned);
+
+	// Inline calls
+	inline_state_t state = {ir, report, globals, global_count, NULL, 0, NULL, 0, 0, calloc(ir->func_count, sizeof(bool)), SIZE_MAX};
+	for (size_t i = 0; i < ir->expr_count; i++)
+	{
+		inline_calls(ir->expr[i], &state);
+	}
+	free(globals);
+	free(state.locals);
+	free(state.names);
+	free(state.changed);
+
+	// Inlining binds arguments, so the locals are resolved again before they're substituted
+	resolve_symbols(ir, scope);
+	for (size_t i = 0; i < ir->expr_count; i++)
+	{
+		inline_locals(ir->expr[i], ir, report);
+	}
+	resolve_symbols(ir, scope);
+}
@@ -0,0 +1,28 @@
+//
+// passes
+// inline.h: Header file for inline.c.
+//
+// Created by jenra.
+// Created on October 18 2026.
+//
+
+#ifndef PASSES_INLINE_H
+#define PASSES_INLINE_H
+
+#include <stdbool.h>
+
+#include "../correctness/scope.h"
+#include "../ir/generate_ir.h"
+
+// The most S expressions the body of a function can have to be inlined, and how many more it can have for every
+// constant argument at a call site (since the body can then be folded).
+#define CURLY_INLINE_SIZE_LIMIT 16
+#define CURLY_INLINE_CONSTANT_BONUS 8
+
+// inline_functions(curly_ir_t*, ir_scope_t*, bool, bool) -> void
+// Replaces saturated calls of small functions in type checked IR with their bodies, and replaces locals that are used
+// once with their values. Globals are only inlined if inline_globals is set, since the repl can reassign them. Prints
+// every decision if report is set.
+void inline_functions(curly_ir_t* ir, ir_scope_t* scope, bool inline_globals, bool report);
+
+#endif /* PASSES_INLINE_H */
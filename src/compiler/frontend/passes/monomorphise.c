@@ -0,0 +1,532 @@
+//
+// passes
+// monomorphise.c: Specialises generic functions for the types they're used at.
+//
+// Created by jenra.
+// Created on October 18 2026.
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include "../../../utils/list.h"
+#include "../correctness/infer.h"
+#include "monomorphise.h"
+
+// Generic functions are never built. Every use of one is renamed to a specialisation of the function for the concrete
+// type it's used at, which is a clone of the function with its generic type variables replaced. Specialisations of
+// globals are bound at the top level before the expression that first uses them, and specialisations of locals are
+// bound right after the generic function. The specialisations are cached by function and type in the IR so that each
+// one is only built once (across inputs in the repl), and they're cached before their body is specialised so that
+// recursive functions refer to themselves. Type variables that nothing constrains are defaulted to Int.
+
+// Represents a local variable bound to a generic function.
+typedef struct
+{
+	// The slot of the local and the generic function.
+	size_t slot;
+	size_t func_id;
+
+	// The assignment binding the function (or NULL once it's reassigned to a value that isn't generic) and the local
+	// scope it's in, which the specialisations are added to.
+	ir_sexpr_t* assign;
+	ir_sexpr_t* scope;
+} mono_local_t;
+
+// Represents the state of monomorphisation.
+typedef struct
+{
+	curly_ir_t* ir;
+
+	// The type unconstrained type variables are defaulted to.
+	type_t* fallback;
+
+	// The new list of top level expressions, including the specialisations of globals.
+	ir_sexpr_t** exprs;
+	size_t expr_size;
+	size_t expr_count;
+
+	// The locals bound to generic functions that are in scope, innermost last.
+	mono_local_t* locals;
+	size_t local_size;
+	size_t local_count;
+} mono_state_t;
+
+// mono_default_type(type_t*, type_t*) -> void
+// Binds the type variables in a type that aren't generic to the fallback type.
+void mono_default_type(type_t* type, type_t* fallback)
+{
+	type = find_type(type);
+	if (type == NULL)
+		return;
+	else if (type->type_type == IR_TYPES_VAR)
+	{
+		if (type->level != IR_TYPE_GENERIC_LEVEL)
+			unify_types(type, fallback);
+		return;
+	} else if (!type->has_vars)
+		return;
+
+	for (size_t i = 0; i < type->field_count; i++)
+	{
+		mono_default_type(type->field_types[i], fallback);
+	}
+}
+
+// mono_resolve_type(type_t*, mono_state_t*) -> type_t*
+// Defaults the unconstrained type variables in a type and resolves it.
+type_t* mono_resolve_type(type_t* type, mono_state_t* state)
+{
+	mono_default_type(type, state->fallback);
+	return resolve_type(type);
+}
+
+// mono_generic_type(type_t*) -> bool
+// Returns whether a type has generic type variables.
+bool mono_generic_type(type_t* type)
+{
+	type_t** vars = NULL;
+	size_t vars_size = 0;
+	size_t var_count = 0;
+	find_generic_vars(type, &vars, &vars_size, &var_count);
+	free(vars);
+	return var_count != 0;
+}
+
+// mono_match_type(type_t*, type_t*, type_t**, type_t**, size_t) -> void
+// Finds the types the type variables of a generic type stand for in a concrete type with the same structure.
+void mono_match_type(type_t* generic, type_t* concrete, type_t** vars, type_t** types, size_t count)
+{
+	generic = find_type(generic);
+	concrete = find_type(concrete);
+	if (generic == NULL || concrete == NULL)
+		return;
+	else if (generic->type_type == IR_TYPES_VAR)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			if (vars[i] == generic && types[i] == NULL)
+				types[i] = concrete;
+		}
+		return;
+	} else if (!generic->has_vars || generic->field_count != concrete->field_count)
+		return;
+
+	for (size_t i = 0; i < generic->field_count; i++)
+	{
+		mono_match_type(generic->field_types[i], concrete->field_types[i], vars, types, count);
+	}
+}
+
+size_t mono_clone_func(mono_state_t* state, size_t func_id, type_t** vars, type_t** types, size_t count);
+
+// mono_clone_sexpr(mono_state_t*, ir_sexpr_t*, type_t**, type_t**, size_t) -> ir_sexpr_t*
+// Clones an S expression, replacing the type variables in one array with the types at the same index in another array.
+ir_sexpr_t* mono_clone_sexpr(mono_state_t* state, ir_sexpr_t* sexpr, type_t** vars, type_t** types, size_t count)
+{
+	ir_sexpr_t* clone = malloc(sizeof(ir_sexpr_t));
+	*clone = *sexpr;
+	clone->type = resolve_type(substitute_type(sexpr->type, vars, types, count));
+	switch (sexpr->tag)
+	{
+		case CURLY_IR_TAGS_SYMBOL:
+			clone->symbol = strdup(sexpr->symbol);
+			break;
+		case CURLY_IR_TAGS_INFIX:
+			// Operators are resolved again for the new operand types
+			clone->infix.left = mono_clone_sexpr(state, sexpr->infix.left, vars, types, count);
+			clone->infix.right = mono_clone_sexpr(state, sexpr->infix.right, vars, types, count);
+			clone->infix.resolved_left = NULL;
+			clone->infix.resolved_right = NULL;
+			break;
+		case CURLY_IR_TAGS_PREFIX:
+			clone->prefix.operand = mono_clone_sexpr(state, sexpr->prefix.operand, vars, types, count);
+			clone->prefix.resolved_operand = NULL;
+			break;
+		case CURLY_IR_TAGS_APPLY:
+			clone->apply.func = mono_clone_sexpr(state, sexpr->apply.func, vars, types, count);
+			clone->apply.arg = mono_clone_sexpr(state, sexpr->apply.arg, vars, types, count);
+			break;
+		case CURLY_IR_TAGS_FUNC:
+			clone->func_id = mono_clone_func(state, sexpr->func_id, vars, types, count);
+			break;
+		case CURLY_IR_TAGS_ASSIGN:
+			clone->assign.name = strdup(sexpr->assign.name);
+			clone->assign.value = mono_clone_sexpr(state, sexpr->assign.value, vars, types, count);
+			break;
+		case CURLY_IR_TAGS_DECLARE:
+			clone->declare.name = strdup(sexpr->declare.name);
+			break;
+		case CURLY_IR_TAGS_LOCAL_SCOPE:
+			clone->local_scope.assigns = calloc(sexpr->local_scope.assign_count, sizeof(ir_sexpr_t*));
+			for (size_t i = 0; i < sexpr->local_scope.assign_count; i++)
+			{
+				clone->local_scope.assigns[i] = mono_clone_sexpr(state, sexpr->local_scope.assigns[i], vars, types, count);
+			}
+			clone->local_scope.value = mono_clone_sexpr(state, sexpr->local_scope.value, vars, types, count);
+			break;
+		case CURLY_IR_TAGS_IF:
+			clone->if_expr.cond = mono_clone_sexpr(state, sexpr->if_expr.cond, vars, types, count);
+			clone->if_expr.then = mono_clone_sexpr(state, sexpr->if_expr.then, vars, types, count);
+			clone->if_expr.elsy = mono_clone_sexpr(state, sexpr->if_expr.elsy, vars, types, count);
+			break;
+		case CURLY_IR_TAGS_LIST:
+			clone->list.elements = calloc(sexpr->list.element_count, sizeof(ir_sexpr_t*));
+			for (size_t i = 0; i < sexpr->list.element_count; i++)
+			{
+				clone->list.elements[i] = mono_clone_sexpr(state, sexpr->list.elements[i], vars, types, count);
+			}
+			break;
+		case CURLY_IR_TAGS_SLICE:
+			clone->slice.list = mono_clone_sexpr(state, sexpr->slice.list, vars, types, count);
+			clone->slice.start = mono_clone_sexpr(state, sexpr->slice.start, vars, types, count);
+			clone->slice.end = mono_clone_sexpr(state, sexpr->slice.end, vars, types, count);
+			break;
+		case CURLY_IR_TAGS_FOR:
+			clone->for_loop.var = strdup(sexpr->for_loop.var);
+			clone->for_loop.iter = mono_clone_sexpr(state, sexpr->for_loop.iter, vars, types, count);
+			clone->for_loop.body = mono_clone_sexpr(state, sexpr->for_loop.body, vars, types, count);
+			break;
+		case CURLY_IR_TAGS_RANGE:
+			clone->range.start = mono_clone_sexpr(state, sexpr->range.start, vars, types, count);
+			if (sexpr->range.end != NULL)
+				clone->range.end = mono_clone_sexpr(state, sexpr->range.end, vars, types, count);
+			break;
+		default:
+			break;
+	}
+	return clone;
+}
+
+// mono_clone_func(mono_state_t*, size_t, type_t**, type_t**, size_t) -> size_t
+// Clones a function, replacing the type variables in one array with the types at the same index in another array, and returns the id of the clone.
+size_t mono_clone_func(mono_state_t* state, size_t func_id, type_t** vars, type_t** types, size_t count)
+{
+	ir_sexpr_func_t* func = state->ir->funcs[func_id];
+	ir_sexpr_func_t* clone = malloc(sizeof(ir_sexpr_func_t));
+	clone->arg_count = func->arg_count;
+	clone->args = calloc(func->arg_count, sizeof(ir_sexpr_func_arg_t));
+	for (size_t i = 0; i < func->arg_count; i++)
+	{
+		type_t* type = resolve_type(substitute_type(func->args[i].type, vars, types, count));
+		clone->args[i] = (ir_sexpr_func_arg_t) {type, strdup(func->args[i].name), func->args[i].binding};
+	}
+	clone->body = mono_clone_sexpr(state, func->body, vars, types, count);
+	list_append_element(state->ir->funcs, state->ir->func_size, state->ir->func_count, ir_sexpr_func_t*, clone);
+	return state->ir->func_count - 1;
+}
+
+// mono_insert_assign(ir_sexpr_t*, ir_sexpr_t*, ir_sexpr_t*) -> void
+// Inserts an assignment into a local scope after another assignment.
+void mono_insert_assign(ir_sexpr_t* scope_sexpr, ir_sexpr_t* after, ir_sexpr_t* assign)
+{
+	size_t index = 0;
+	while (scope_sexpr->local_scope.assigns[index] != after)
+	{
+		index++;
+	}
+
+	size_t count = scope_sexpr->local_scope.assign_count++;
+	scope_sexpr->local_scope.assigns = realloc(scope_sexpr->local_scope.assigns, (count + 1) * sizeof(ir_sexpr_t*));
+	memmove(scope_sexpr->local_scope.assigns + index + 2, scope_sexpr->local_scope.assigns + index + 1, (count - index - 1) * sizeof(ir_sexpr_t*));
+	scope_sexpr->local_scope.assigns[index + 1] = assign;
+}
+
+bool mono_sexpr(ir_sexpr_t* sexpr, mono_state_t* state);
+
+// mono_specialise(mono_state_t*, ir_sexpr_t*, size_t, type_t*, char*, size_t) -> char*
+// Returns the name of the specialisation of a generic function for the type of a use of it, creating the specialisation
+// if it doesn't exist. local is one plus the index of the generic local the function is bound to, or 0 for globals.
+// Returns NULL if the function has too many specialisations.
+char* mono_specialise(mono_state_t* state, ir_sexpr_t* use, size_t func_id, type_t* generic, char* name, size_t local)
+{
+	// Look up the specialisation
+	curly_ir_t* ir = state->ir;
+	char key[48];
+	snprintf(key, sizeof(key), "%zu:%zu", func_id, use->type->id);
+	size_t index = (size_t) map_get(ir->spec_indices, key);
+	if (index != 0)
+		return ir->specs[index - 1].name;
+
+	// Functions can only be specialised so many times
+	size_t spec_count = 0;
+	for (size_t i = 0; i < ir->spec_count; i++)
+	{
+		spec_count += ir->specs[i].func_id == func_id;
+	}
+	if (spec_count >= ir->spec_limit)
+	{
+		printf("Too many specialisations of %s found at %i:%i\n", name, use->lino, use->charpos);
+		return NULL;
+	}
+
+	// Find the types the generic type variables stand for
+	type_t** vars = NULL;
+	size_t vars_size = 0;
+	size_t var_count = 0;
+	find_generic_vars(generic, &vars, &vars_size, &var_count);
+	type_t** types = calloc(var_count, sizeof(type_t*));
+	mono_match_type(generic, use->type, vars, types, var_count);
+	for (size_t i = 0; i < var_count; i++)
+	{
+		if (types[i] == NULL)
+			types[i] = state->fallback;
+	}
+
+	// Cache the specialisation before its body is specialised so that recursive uses refer to it
+	char* spec_name = malloc(strlen(name) + 24);
+	sprintf(spec_name, "%s.%zu", name, ir->spec_count);
+	list_append_element(ir->specs, ir->spec_size, ir->spec_count, ir_specialisation_t, ((ir_specialisation_t) {func_id, use->type, spec_name}));
+	map_add(ir->spec_indices, key, (void*) ir->spec_count);
+
+	// Clone the function
+	ir_sexpr_t* value = malloc(sizeof(ir_sexpr_t));
+	value->tag = CURLY_IR_TAGS_FUNC;
+	value->type = use->type;
+	value->pos = use->pos;
+	value->lino = use->lino;
+	value->charpos = use->charpos;
+	value->func_id = mono_clone_func(state, func_id, vars, types, var_count);
+	free(vars);
+	free(types);
+
+	// Specialise the clone with only the generic locals the function can see
+	size_t hidden_count = state->local_count - local;
+	mono_local_t* hidden = calloc(hidden_count, sizeof(mono_local_t));
+	if (hidden_count != 0)
+		memcpy(hidden, state->locals + local, hidden_count * sizeof(mono_local_t));
+	state->local_count = local;
+	bool valid = mono_sexpr(value, state);
+	state->local_count = local;
+	for (size_t i = 0; i < hidden_count; i++)
+	{
+		list_append_element(state->locals, state->local_size, state->local_count, mono_local_t, hidden[i]);
+	}
+	free(hidden);
+
+	// Bind the specialisation after everything it uses
+	ir_sexpr_t* assign = malloc(sizeof(ir_sexpr_t));
+	*assign = *value;
+	assign->tag = CURLY_IR_TAGS_ASSIGN;
+	assign->assign.name = strdup(spec_name);
+	assign->assign.value = value;
+	if (local == 0)
+		list_append_element(state->exprs, state->expr_size, state->expr_count, ir_sexpr_t*, assign);
+	else mono_insert_assign(state->locals[local - 1].scope, state->locals[local - 1].assign, assign);
+	return valid ? spec_name : NULL;
+}
+
+// mono_find_local(mono_state_t*, size_t) -> size_t
+// Returns one plus the index of the innermost generic local in a slot, or 0 if there is none.
+size_t mono_find_local(mono_state_t* state, size_t slot)
+{
+	for (size_t i = state->local_count; i > 0; i--)
+	{
+		if (state->locals[i - 1].slot == slot)
+			return state->locals[i - 1].assign != NULL ? i : 0;
+	}
+	return 0;
+}
+
+// mono_find_global(curly_ir_t*, size_t) -> ir_generic_t*
+// Returns the generic function a global is bound to, or NULL if it isn't bound to one.
+ir_generic_t* mono_find_global(curly_ir_t* ir, size_t index)
+{
+	for (size_t i = ir->generic_count; i > 0; i--)
+	{
+		if (ir->generics[i - 1].binding.index == index)
+			return ir->generics[i - 1].type != NULL ? ir->generics + i - 1 : NULL;
+	}
+	return NULL;
+}
+
+// mono_symbol(ir_sexpr_t*, mono_state_t*) -> bool
+// Renames a use of a generic function to the specialisation of the function for its type.
+bool mono_symbol(ir_sexpr_t* sexpr, mono_state_t* state)
+{
+	// Uses in generic code are specialised along with the code
+	if (sexpr->type->has_vars)
+		return true;
+
+	// Find the generic function the symbol refers to
+	char* name;
+	if (sexpr->binding.global)
+	{
+		ir_generic_t* generic = mono_find_global(state->ir, sexpr->binding.index);
+		if (generic == NULL)
+			return true;
+		name = mono_specialise(state, sexpr, generic->func_id, generic->type, generic->name, 0);
+	} else
+	{
+		size_t local = mono_find_local(state, sexpr->binding.index);
+		if (local == 0)
+			return true;
+		ir_sexpr_t* assign = state->locals[local - 1].assign;
+		name = mono_specialise(state, sexpr, assign->assign.value->func_id, assign->assign.value->type, assign->assign.name, local);
+	}
+
+	// Rename the symbol
+	if (name == NULL)
+		return false;
+	free(sexpr->symbol);
+	sexpr->symbol = strdup(name);
+	return true;
+}
+
+// mono_sexpr(ir_sexpr_t*, mono_state_t*) -> bool
+// Specialises the uses of generic functions in an S expression.
+bool mono_sexpr(ir_sexpr_t* sexpr, mono_state_t* state)
+{
+	sexpr->type = mono_resolve_type(sexpr->type, state);
+	switch (sexpr->tag)
+	{
+		case CURLY_IR_TAGS_SYMBOL:
+			return mono_symbol(sexpr, state);
+
+		case CURLY_IR_TAGS_INFIX:
+			return mono_sexpr(sexpr->infix.left, state) && mono_sexpr(sexpr->infix.right, state);
+		case CURLY_IR_TAGS_PREFIX:
+			return mono_sexpr(sexpr->prefix.operand, state);
+		case CURLY_IR_TAGS_APPLY:
+			return mono_sexpr(sexpr->apply.func, state) && mono_sexpr(sexpr->apply.arg, state);
+		case CURLY_IR_TAGS_ASSIGN:
+			return mono_sexpr(sexpr->assign.value, state);
+
+		case CURLY_IR_TAGS_FUNC:
+		{
+			// Generic functions are only built through their specialisations
+			if (mono_generic_type(sexpr->type))
+				return true;
+			ir_sexpr_func_t* func = state->ir->funcs[sexpr->func_id];
+			for (size_t i = 0; i < func->arg_count; i++)
+			{
+				func->args[i].type = mono_resolve_type(func->args[i].type, state);
+			}
+			return mono_sexpr(func->body, state);
+		}
+
+		case CURLY_IR_TAGS_LOCAL_SCOPE:
+		{
+			size_t local_count = state->local_count;
+			for (size_t i = 0; i < sexpr->local_scope.assign_count; i++)
+			{
+				ir_sexpr_t* assign = sexpr->local_scope.assigns[i];
+				if (assign->tag == CURLY_IR_TAGS_ASSIGN)
+				{
+					// Generic functions are specialised where they're used
+					ir_sexpr_t* value = assign->assign.value;
+					value->type = mono_resolve_type(value->type, state);
+					if (value->tag == CURLY_IR_TAGS_FUNC && mono_generic_type(value->type))
+					{
+						assign->type = mono_resolve_type(assign->type, state);
+						mono_local_t local = {assign->assign.binding.index, value->func_id, assign, sexpr};
+						list_append_element(state->locals, state->local_size, state->local_count, mono_local_t, local);
+						continue;
+					}
+
+					// Generic locals reassigned to other values aren't generic anymore
+					if (mono_find_local(state, assign->assign.binding.index) != 0)
+					{
+						mono_local_t local = {assign->assign.binding.index, 0, NULL, sexpr};
+						list_append_element(state->locals, state->local_size, state->local_count, mono_local_t, local);
+					}
+				}
+				if (!mono_sexpr(assign, state))
+					return false;
+
+				// Specialisations may have been added before the assignment
+				while (sexpr->local_scope.assigns[i] != assign)
+				{
+					i++;
+				}
+			}
+
+			bool valid = mono_sexpr(sexpr->local_scope.value, state);
+			state->local_count = local_count;
+			return valid;
+		}
+
+		case CURLY_IR_TAGS_IF:
+			return mono_sexpr(sexpr->if_expr.cond, state) && mono_sexpr(sexpr->if_expr.then, state)
+				&& mono_sexpr(sexpr->if_expr.elsy, state);
+
+		case CURLY_IR_TAGS_LIST:
+			for (size_t i = 0; i < sexpr->list.element_count; i++)
+			{
+				if (!mono_sexpr(sexpr->list.elements[i], state))
+					return false;
+			}
+			return true;
+
+		case CURLY_IR_TAGS_SLICE:
+			return mono_sexpr(sexpr->slice.list, state) && mono_sexpr(sexpr->slice.start, state)
+				&& mono_sexpr(sexpr->slice.end, state);
+		case CURLY_IR_TAGS_FOR:
+			return mono_sexpr(sexpr->for_loop.iter, state) && mono_sexpr(sexpr->for_loop.body, state);
+		case CURLY_IR_TAGS_RANGE:
+			return mono_sexpr(sexpr->range.start, state) && (sexpr->range.end == NULL || mono_sexpr(sexpr->range.end, state));
+
+		default:
+			return true;
+	}
+}
+
+// monomorphise(curly_ir_t*, ir_scope_t*) -> bool
+// Replaces every use of a generic function in type checked IR with a specialisation of the function for the type it's
+// used at, so that every value built has a concrete type. Returns false if a function has too many specialisations.
+bool monomorphise(curly_ir_t* ir, ir_scope_t* scope)
+{
+	mono_state_t state = {ir, scope_lookup_type(scope, "Int"), NULL, 0, 0, NULL, 0, 0};
+	size_t spec_count = ir->spec_count;
+	size_t generic_count = ir->generic_count;
+	bool valid = true;
+	for (size_t i = 0; i < ir->expr_count; i++)
+	{
+		ir_sexpr_t* sexpr = ir->expr[i];
+		if (valid && sexpr->tag == CURLY_IR_TAGS_ASSIGN)
+		{
+			// Generic global functions are specialised where they're used
+			ir_sexpr_t* value = sexpr->assign.value;
+			value->type = mono_resolve_type(value->type, &state);
+			if (value->tag == CURLY_IR_TAGS_FUNC && mono_generic_type(value->type))
+			{
+				ir_generic_t generic = {sexpr->assign.binding, value->func_id, value->type, strdup(sexpr->assign.name)};
+				list_append_element(ir->generics, ir->generic_size, ir->generic_count, ir_generic_t, generic);
+
+			// Generic globals reassigned to other values aren't generic anymore
+			} else if (mono_find_global(ir, sexpr->assign.binding.index) != NULL)
+			{
+				ir_generic_t generic = {sexpr->assign.binding, 0, NULL, strdup(sexpr->assign.name)};
+				list_append_element(ir->generics, ir->generic_size, ir->generic_count, ir_generic_t, generic);
+			}
+		}
+
+		// Specialisations are added before the expression that uses them
+		valid = valid && mono_sexpr(sexpr, &state);
+		list_append_element(state.exprs, state.expr_size, state.expr_count, ir_sexpr_t*, sexpr);
+	}
+
+	// The new list has every expression, so that they're cleaned up either way
+	free(ir->expr);
+	ir->expr = state.exprs;
+	ir->expr_count = state.expr_count;
+	free(state.locals);
+	if (valid)
+		return true;
+
+	// Forget the specialisations and generics of IR that failed
+	for (size_t i = spec_count; i < ir->spec_count; i++)
+	{
+		char key[48];
+		snprintf(key, sizeof(key), "%zu:%zu", ir->specs[i].func_id, ir->specs[i].type->id);
+		map_remove(ir->spec_indices, key);
+		free(ir->specs[i].name);
+	}
+	ir->spec_count = spec_count;
+	for (size_t i = generic_count; i < ir->generic_count; i++)
+	{
+		free(ir->generics[i].name);
+	}
+	ir->generic_count = generic_count;
+	return false;
+}
@@ -0,0 +1,20 @@
+//
+// passes
+// monomorphise.h: Header file for monomorphise.c.
+//
+// Created by jenra.
+// Created on October 18 2026.
+//
+
+#ifndef PASSES_MONOMORPHISE_H
+#define PASSES_MONOMORPHISE_H
+
+#include "../correctness/scope.h"
+#include "../ir/generate_ir.h"
+
+// monomorphise(curly_ir_t*, ir_scope_t*) -> bool
+// Replaces every use of a generic function in type checked IR with a specialisation of the function for the type it's
+// used at, so that every value built has a concrete type. Returns false if a function has too many specialisations.
+bool monomorphise(curly_ir_t* ir, ir_scope_t* scope);
+
+#endif /* PASSES_MONOMORPHISE_H */
@@ -0,0 +1,457 @@
+//
+// passes
+// rc_insertion.c: Inserts reference counting operations into IR.
+//
+// Created by jenra.
+// Created on October 18 2026.
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include "../../../utils/list.h"
+#include "rc_insertion.h"
+
+// Every local owns a reference to its value, and every expression in an owned position produces a new reference.
+// Uses of a local in an owned position are dups, and owned locals are dropped at the end of their scope. A dup that
+// is the last use of a local cancels out with its drop, leaving a move. Temporaries in borrowed positions are bound
+// to hidden locals that are dropped at the end of the full expression.
+
+// Represents a list of temporaries bound during a full expression.
+typedef struct
+{
+	ir_sexpr_t** assigns;
+	size_t assigns_size;
+	size_t assign_count;
+} rc_temps_t;
+
+// Represents a use of a local found when looking for last uses.
+typedef struct
+{
+	// The use (a symbol or a dup of a symbol).
+	ir_sexpr_t* sexpr;
+
+	// Whether the use is evaluated exactly once whenever its scope is.
+	bool unconditional;
+} rc_use_t;
+
+// The number of temporaries created.
+size_t rc_temp_count = 0;
+
+// The IR being transformed, which holds the bodies of functions.
+curly_ir_t* rc_ir = NULL;
+
+// rc_type(type_t*) -> bool
+// Returns whether values of a type are reference counted.
+bool rc_type(type_t* type)
+{
+	return type != NULL && (type->type_type == IR_TYPES_LIST || type->type_type == IR_TYPES_GENERATOR || type->type_type == IR_TYPES_FUNC);
+}
+
+// rc_new_sexpr(ir_types_t, ir_sexpr_t*) -> ir_sexpr_t*
+// Creates a new S expression with the type and position of another S expression.
+ir_sexpr_t* rc_new_sexpr(ir_types_t tag, ir_sexpr_t* like)
+{
+	ir_sexpr_t* sexpr = malloc(sizeof(ir_sexpr_t));
+	sexpr->tag = tag;
+	sexpr->type = like->type;
+	sexpr->pos = like->pos;
+	sexpr->lino = like->lino;
+	sexpr->charpos = like->charpos;
+	return sexpr;
+}
+
+// rc_new_symbol(char*, ir_sexpr_t*) -> ir_sexpr_t*
+// Creates a new symbol with the type and position of another S expression.
+ir_sexpr_t* rc_new_symbol(char* name, ir_sexpr_t* like)
+{
+	ir_sexpr_t* sexpr = rc_new_sexpr(CURLY_IR_TAGS_SYMBOL, like);
+	sexpr->symbol = strdup(name);
+	return sexpr;
+}
+
+// rc_new_dup(ir_sexpr_t*) -> ir_sexpr_t*
+// Wraps an S expression in a dup.
+ir_sexpr_t* rc_new_dup(ir_sexpr_t* value)
+{
+	ir_sexpr_t* sexpr = rc_new_sexpr(CURLY_IR_TAGS_DUP, value);
+	sexpr->rc.value = value;
+	sexpr->rc.drops = NULL;
+	sexpr->rc.drop_count = 0;
+	return sexpr;
+}
+
+// rc_new_drop(ir_sexpr_t*, ir_sexpr_t**, size_t) -> ir_sexpr_t*
+// Wraps an S expression in a drop of the given locals.
+ir_sexpr_t* rc_new_drop(ir_sexpr_t* value, ir_sexpr_t** drops, size_t drop_count)
+{
+	ir_sexpr_t* sexpr = rc_new_sexpr(CURLY_IR_TAGS_DROP, value);
+	sexpr->rc.value = value;
+	sexpr->rc.drops = drops;
+	sexpr->rc.drop_count = drop_count;
+	return sexpr;
+}
+
+// rc_generator_constructor(ir_sexpr_t*) -> bool
+// Returns whether an S expression creates a new generator.
+bool rc_generator_constructor(ir_sexpr_t* sexpr)
+{
+	return sexpr->tag == CURLY_IR_TAGS_RANGE || (sexpr->tag == CURLY_IR_TAGS_FOR
+		&& (sexpr->for_loop.loop_type == IR_LOOP_GENERATOR || sexpr->for_loop.loop_type == IR_LOOP_WHERE));
+}
+
+ir_sexpr_t* rc_transform(ir_sexpr_t* sexpr, bool owned, rc_temps_t* temps);
+
+// rc_bind_temps(ir_sexpr_t*, rc_temps_t) -> ir_sexpr_t*
+// Binds temporaries before an S expression and drops them after it.
+ir_sexpr_t* rc_bind_temps(ir_sexpr_t* sexpr, rc_temps_t temps)
+{
+	if (temps.assign_count == 0)
+		return sexpr;
+
+	// Drop the temporaries after the expression
+	ir_sexpr_t** drops = calloc(temps.assign_count, sizeof(ir_sexpr_t*));
+	for (size_t i = 0; i < temps.assign_count; i++)
+	{
+		drops[i] = rc_new_symbol(temps.assigns[i]->assign.name, temps.assigns[i]);
+	}
+
+	// Bind the temporaries before the expression
+	ir_sexpr_t* wrapper = rc_new_sexpr(CURLY_IR_TAGS_LOCAL_SCOPE, sexpr);
+	wrapper->local_scope.assigns = temps.assigns;
+	wrapper->local_scope.assign_count = temps.assign_count;
+	wrapper->local_scope.value = rc_new_drop(sexpr, drops, temps.assign_count);
+	return wrapper;
+}
+
+// rc_full_expression(ir_sexpr_t*, bool) -> ir_sexpr_t*
+// Transforms a full expression, dropping the temporaries it creates at the end.
+ir_sexpr_t* rc_full_expression(ir_sexpr_t* sexpr, bool owned)
+{
+	rc_temps_t temps = {NULL, 0, 0};
+	sexpr = rc_transform(sexpr, owned, &temps);
+	return rc_bind_temps(sexpr, temps);
+}
+
+// rc_borrow(ir_sexpr_t*, rc_temps_t*) -> ir_sexpr_t*
+// Transforms an S expression in a borrowed position, binding new references to temporaries.
+ir_sexpr_t* rc_borrow(ir_sexpr_t* sexpr, rc_temps_t* temps)
+{
+	if (!rc_type(sexpr->type) || sexpr->tag == CURLY_IR_TAGS_SYMBOL)
+		return rc_transform(sexpr, false, temps);
+
+	// Bind the new reference to a temporary
+	char name[32];
+	snprintf(name, sizeof(name), ".rc.tmp%zu", rc_temp_count++);
+	ir_sexpr_t* value = rc_transform(sexpr, true, temps);
+	ir_sexpr_t* assign = rc_new_sexpr(CURLY_IR_TAGS_ASSIGN, value);
+	assign->assign.name = strdup(name);
+	assign->assign.value = value;
+	list_append_element(temps->assigns, temps->assigns_size, temps->assign_count, ir_sexpr_t*, assign);
+	return rc_new_symbol(name, value);
+}
+
+// rc_iterate(ir_sexpr_t*, rc_temps_t*) -> ir_sexpr_t*
+// Transforms an S expression being iterated over. Generators created in place are consumed directly.
+ir_sexpr_t* rc_iterate(ir_sexpr_t* sexpr, rc_temps_t* temps)
+{
+	if (rc_generator_constructor(sexpr))
+		return rc_transform(sexpr, false, temps);
+	return rc_borrow(sexpr, temps);
+}
+
+// rc_find_uses(ir_sexpr_t*, char*, bool, rc_use_t**, size_t*, size_t*) -> void
+// Finds every use of a local in evaluation order.
+void rc_find_uses(ir_sexpr_t* sexpr, char* name, bool unconditional, rc_use_t** uses, size_t* uses_size, size_t* use_count)
+{
+	switch (sexpr->tag)
+	{
+		case CURLY_IR_TAGS_SYMBOL:
+			if (!strcmp(sexpr->symbol, name))
+				list_append_element(*uses, *uses_size, *use_count, rc_use_t, ((rc_use_t) {sexpr, unconditional}));
+			break;
+		case CURLY_IR_TAGS_DUP:
+			if (sexpr->rc.value->tag == CURLY_IR_TAGS_SYMBOL && !strcmp(sexpr->rc.value->symbol, name))
+				list_append_element(*uses, *uses_size, *use_count, rc_use_t, ((rc_use_t) {sexpr, unconditional}));
+			else rc_find_uses(sexpr->rc.value, name, unconditional, uses, uses_size, use_count);
+			break;
+		case CURLY_IR_TAGS_DROP:
+			rc_find_uses(sexpr->rc.value, name, unconditional, uses, uses_size, use_count);
+			break;
+		case CURLY_IR_TAGS_INFIX:
+		{
+			// The right side of short circuiting operators is conditional
+			bool conditional = sexpr->infix.op == IR_BINOPS_BOOLAND || sexpr->infix.op == IR_BINOPS_BOOLOR;
+			rc_find_uses(sexpr->infix.left, name, unconditional, uses, uses_size, use_count);
+			rc_find_uses(sexpr->infix.right, name, unconditional && !conditional, uses, uses_size, use_count);
+			break;
+		}
+		case CURLY_IR_TAGS_PREFIX:
+			rc_find_uses(sexpr->prefix.operand, name, unconditional, uses, uses_size, use_count);
+			break;
+		case CURLY_IR_TAGS_APPLY:
+			rc_find_uses(sexpr->apply.func, name, unconditional, uses, uses_size, use_count);
+			rc_find_uses(sexpr->apply.arg, name, unconditional, uses, uses_size, use_count);
+			break;
+		case CURLY_IR_TAGS_FUNC:
+		{
+			// Function bodies run later, any number of times, unless an argument shadows the local
+			ir_sexpr_func_t* func = rc_ir->funcs[sexpr->func_id];
+			for (size_t i = 0; i < func->arg_count; i++)
+			{
+				if (!strcmp(func->args[i].name, name))
+					return;
+			}
+			rc_find_uses(func->body, name, false, uses, uses_size, use_count);
+			break;
+		}
+		case CURLY_IR_TAGS_ASSIGN:
+			rc_find_uses(sexpr->assign.value, name, unconditional, uses, uses_size, use_count);
+			break;
+		case CURLY_IR_TAGS_LOCAL_SCOPE:
+			// Stop looking once the local is shadowed
+			for (size_t i = 0; i < sexpr->local_scope.assign_count; i++)
+			{
+				ir_sexpr_t* assign = sexpr->local_scope.assigns[i];
+				rc_find_uses(assign, name, unconditional, uses, uses_size, use_count);
+				if ((assign->tag == CURLY_IR_TAGS_ASSIGN && !strcmp(assign->assign.name, name))
+				 || (assign->tag == CURLY_IR_TAGS_DECLARE && !strcmp(assign->declare.name, name)))
+					return;
+			}
+			rc_find_uses(sexpr->local_scope.value, name, unconditional, uses, uses_size, use_count);
+			break;
+		case CURLY_IR_TAGS_IF:
+			rc_find_uses(sexpr->if_expr.cond, name, unconditional, uses, uses_size, use_count);
+			rc_find_uses(sexpr->if_expr.then, name, false, uses, uses_size, use_count);
+			rc_find_uses(sexpr->if_expr.elsy, name, false, uses, uses_size, use_count);
+			break;
+		case CURLY_IR_TAGS_LIST:
+			for (size_t i = 0; i < sexpr->list.element_count; i++)
+			{
+				rc_find_uses(sexpr->list.elements[i], name, unconditional, uses, uses_size, use_count);
+			}
+			break;
+		case CURLY_IR_TAGS_SLICE:
+			rc_find_uses(sexpr->slice.list, name, unconditional, uses, uses_size, use_count);
+			rc_find_uses(sexpr->slice.start, name, unconditional, uses, uses_size, use_count);
+			rc_find_uses(sexpr->slice.end, name, unconditional, uses, uses_size, use_count);
+			break;
+		case CURLY_IR_TAGS_FOR:
+		{
+			// Generators run later, and loop bodies run any number of times
+			bool generator = rc_generator_constructor(sexpr);
+			rc_find_uses(sexpr->for_loop.iter, name, unconditional && !generator, uses, uses_size, use_count);
+			if (strcmp(sexpr->for_loop.var, name))
+				rc_find_uses(sexpr->for_loop.body, name, false, uses, uses_size, use_count);
+			break;
+		}
+		case CURLY_IR_TAGS_RANGE:
+			rc_find_uses(sexpr->range.start, name, false, uses, uses_size, use_count);
+			if (sexpr->range.end != NULL)
+				rc_find_uses(sexpr->range.end, name, false, uses, uses_size, use_count);
+			break;
+		default:
+			break;
+	}
+}
+
+// rc_fuse(ir_sexpr_t*) -> void
+// Cancels out the dups and drops of the owned locals of a scope where the last use of a local is a dup.
+void rc_fuse(ir_sexpr_t* scope_sexpr)
+{
+	ir_sexpr_t* drop = scope_sexpr->local_scope.value;
+	for (size_t i = 0; i < drop->rc.drop_count; i++)
+	{
+		// Find every use after the local is bound
+		char* name = drop->rc.drops[i]->symbol;
+		rc_use_t* uses = NULL;
+		size_t uses_size = 0;
+		size_t use_count = 0;
+		bool bound = false;
+		for (size_t j = 0; j < scope_sexpr->local_scope.assign_count; j++)
+		{
+			ir_sexpr_t* assign = scope_sexpr->local_scope.assigns[j];
+			if (bound)
+				rc_find_uses(assign, name, true, &uses, &uses_size, &use_count);
+			else bound = assign->tag == CURLY_IR_TAGS_ASSIGN && !strcmp(assign->assign.name, name);
+		}
+		rc_find_uses(drop->rc.value, name, true, &uses, &uses_size, &use_count);
+
+		// Turn the last dup into a move
+		if (use_count != 0 && uses[use_count - 1].unconditional && uses[use_count - 1].sexpr->tag == CURLY_IR_TAGS_DUP)
+		{
+			ir_sexpr_t* dup = uses[use_count - 1].sexpr;
+			ir_sexpr_t* symbol = dup->rc.value;
+			*dup = *symbol;
+			free(symbol);
+
+			// Remove the drop
+			clean_ir_sexpr(drop->rc.drops[i]);
+			memmove(drop->rc.drops + i, drop->rc.drops + i + 1, (drop->rc.drop_count - i - 1) * sizeof(ir_sexpr_t*));
+			drop->rc.drop_count--;
+			i--;
+		}
+		free(uses);
+	}
+}
+
+// rc_transform(ir_sexpr_t*, bool, rc_temps_t*) -> ir_sexpr_t*
+// Inserts reference counting operations into an S expression. If owned is true, the S expression must produce a new reference.
+ir_sexpr_t* rc_transform(ir_sexpr_t* sexpr, bool owned, rc_temps_t* temps)
+{
+	switch (sexpr->tag)
+	{
+		case CURLY_IR_TAGS_SYMBOL:
+			// Uses of locals in owned positions are new references
+			if (owned && rc_type(sexpr->type))
+				return rc_new_dup(sexpr);
+			return sexpr;
+
+		case CURLY_IR_TAGS_INFIX:
+			switch (sexpr->infix.op)
+			{
+				case IR_BINOPS_INDEX:
+					// Elements are borrowed from their list
+					sexpr->infix.left = rc_borrow(sexpr->infix.left, temps);
+					sexpr->infix.right = rc_transform(sexpr->infix.right, false, temps);
+					if (owned && rc_type(sexpr->type))
+						return rc_new_dup(sexpr);
+					return sexpr;
+				case IR_BINOPS_CMPIN:
+					sexpr->infix.left = rc_transform(sexpr->infix.left, false, temps);
+					sexpr->infix.right = rc_iterate(sexpr->infix.right, temps);
+					return sexpr;
+				case IR_BINOPS_BOOLAND:
+				case IR_BINOPS_BOOLOR:
+					sexpr->infix.left = rc_transform(sexpr->infix.left, false, temps);
+					sexpr->infix.right = rc_full_expression(sexpr->infix.right, false);
+					return sexpr;
+				default:
+					sexpr->infix.left = rc_transform(sexpr->infix.left, false, temps);
+					sexpr->infix.right = rc_transform(sexpr->infix.right, false, temps);
+					return sexpr;
+			}
+
+		case CURLY_IR_TAGS_PREFIX:
+			sexpr->prefix.operand = rc_transform(sexpr->prefix.operand, false, temps);
+			return sexpr;
+
+		case CURLY_IR_TAGS_APPLY:
+			// Functions and arguments are borrowed by the call, which returns a new reference
+			if (sexpr->apply.func->tag == CURLY_IR_TAGS_APPLY)
+				sexpr->apply.func = rc_transform(sexpr->apply.func, true, temps);
+			else sexpr->apply.func = rc_borrow(sexpr->apply.func, temps);
+			sexpr->apply.arg = rc_borrow(sexpr->apply.arg, temps);
+			return sexpr;
+
+		case CURLY_IR_TAGS_FUNC:
+		{
+			// Functions own the values they close over and borrow their arguments, and generic functions are only
+			// transformed through their specialisations
+			if (sexpr->type->has_vars)
+				return sexpr;
+			ir_sexpr_func_t* func = rc_ir->funcs[sexpr->func_id];
+			func->body = rc_full_expression(func->body, true);
+			return sexpr;
+		}
+
+		case CURLY_IR_TAGS_ASSIGN:
+			sexpr->assign.value = rc_full_expression(sexpr->assign.value, true);
+			return sexpr;
+
+		case CURLY_IR_TAGS_LOCAL_SCOPE:
+		{
+			// Transform the assignments, taking ownership of reference counted values
+			ir_sexpr_t** drops = NULL;
+			size_t drops_size = 0;
+			size_t drop_count = 0;
+			for (size_t i = 0; i < sexpr->local_scope.assign_count; i++)
+			{
+				ir_sexpr_t* assign = sexpr->local_scope.assigns[i];
+				if (assign->tag != CURLY_IR_TAGS_ASSIGN)
+					continue;
+				rc_transform(assign, true, temps);
+				if (rc_type(assign->assign.value->type))
+					list_append_element(drops, drops_size, drop_count, ir_sexpr_t*, rc_new_symbol(assign->assign.name, assign->assign.value));
+			}
+
+			// Drop the owned locals after the value, unless they were moved
+			sexpr->local_scope.value = rc_full_expression(sexpr->local_scope.value, owned);
+			if (drop_count != 0)
+			{
+				sexpr->local_scope.value = rc_new_drop(sexpr->local_scope.value, drops, drop_count);
+				rc_fuse(sexpr);
+			}
+			return sexpr;
+		}
+
+		case CURLY_IR_TAGS_IF:
+			sexpr->if_expr.cond = rc_transform(sexpr->if_expr.cond, false, temps);
+			sexpr->if_expr.then = rc_full_expression(sexpr->if_expr.then, owned);
+			sexpr->if_expr.elsy = rc_full_expression(sexpr->if_expr.elsy, owned);
+			return sexpr;
+
+		case CURLY_IR_TAGS_LIST:
+			// Lists own their elements
+			for (size_t i = 0; i < sexpr->list.element_count; i++)
+			{
+				sexpr->list.elements[i] = rc_transform(sexpr->list.elements[i], true, temps);
+			}
+			return sexpr;
+
+		case CURLY_IR_TAGS_SLICE:
+			sexpr->slice.list = rc_borrow(sexpr->slice.list, temps);
+			sexpr->slice.start = rc_transform(sexpr->slice.start, false, temps);
+			sexpr->slice.end = rc_transform(sexpr->slice.end, false, temps);
+			return sexpr;
+
+		case CURLY_IR_TAGS_FOR:
+		{
+			// Maps over lists take ownership of the list so its memory can be reused
+			if (sexpr->for_loop.loop_type == IR_LOOP_LIST && sexpr->for_loop.iter->type->type_type == IR_TYPES_LIST)
+			{
+				sexpr->for_loop.consume = true;
+				sexpr->for_loop.iter = rc_transform(sexpr->for_loop.iter, true, temps);
+			} else sexpr->for_loop.iter = rc_iterate(sexpr->for_loop.iter, temps);
+
+			// Loop variables are borrowed from the iterator
+			bool body_owned = sexpr->for_loop.loop_type == IR_LOOP_LIST || sexpr->for_loop.loop_type == IR_LOOP_GENERATOR;
+			sexpr->for_loop.body = rc_full_expression(sexpr->for_loop.body, body_owned);
+			return sexpr;
+		}
+
+		case CURLY_IR_TAGS_RANGE:
+			sexpr->range.start = rc_transform(sexpr->range.start, false, temps);
+			if (sexpr->range.end != NULL)
+				sexpr->range.end = rc_transform(sexpr->range.end, false, temps);
+			return sexpr;
+
+		default:
+			return sexpr;
+	}
+}
+
+// insert_rc_ops(curly_ir_t*, bool) -> void
+// Inserts reference counting operations into type checked IR. If keep_last is true, the value of the last expression is not dropped.
+void insert_rc_ops(curly_ir_t* ir, bool keep_last)
+{
+	rc_ir = ir;
+	for (size_t i = 0; i < ir->expr_count; i++)
+	{
+		ir_sexpr_t* sexpr = ir->expr[i];
+		if (sexpr->tag == CURLY_IR_TAGS_ASSIGN)
+			rc_transform(sexpr, true, NULL);
+		else if (sexpr->tag == CURLY_IR_TAGS_DECLARE)
+			continue;
+
+		// Values of expressions are dropped once they are evaluated
+		else if (keep_last && i == ir->expr_count - 1)
+			ir->expr[i] = rc_full_expression(sexpr, true);
+		else
+		{
+			rc_temps_t temps = {NULL, 0, 0};
+			sexpr = rc_borrow(sexpr, &temps);
+			ir->expr[i] = rc_bind_temps(sexpr, temps);
+		}
+	}
+}
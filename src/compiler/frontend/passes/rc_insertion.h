@@ -0,0 +1,22 @@
+//
+// passes
+// rc_insertion.h: Header file for rc_insertion.c.
+//
+// Created by jenra.
+// Created on October 18 2026.
+//
+
+#ifndef PASSES_RC_INSERTION_H
+#define PASSES_RC_INSERTION_H
+
+#include "../ir/generate_ir.h"
+
+// rc_type(type_t*) -> bool
+// Returns whether values of a type are reference counted.
+bool rc_type(type_t* type);
+
+// insert_rc_ops(curly_ir_t*, bool) -> void
+// Inserts reference counting operations into type checked IR. If keep_last is true, the value of the last expression is not dropped.
+void insert_rc_ops(curly_ir_t* ir, bool keep_last);
+
+#endif /* PASSES_RC_INSERTION_H */
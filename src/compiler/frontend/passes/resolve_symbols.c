@@ -0,0 +1,149 @@
+//
+// passes
+// resolve_symbols.c: Resolves variable names in IR to binding ids.
+//
+// Created by jenra.
+// Created on October 18 2026.
+//
+
+#include <stdio.h>
+
+#include "resolve_symbols.h"
+
+// resolve_sexpr(ir_sexpr_t*, ir_scope_t*, curly_ir_t*) -> bool
+// Resolves the names in an S expression.
+bool resolve_sexpr(ir_sexpr_t* sexpr, ir_scope_t* scope, curly_ir_t* ir)
+{
+	switch (sexpr->tag)
+	{
+		case CURLY_IR_TAGS_SYMBOL:
+			if (!scope_lookup_binding(scope, sexpr->symbol, &sexpr->binding))
+			{
+				printf("Undeclared variable %s found at %i:%i\n", sexpr->symbol, sexpr->lino, sexpr->charpos);
+				return false;
+			}
+			return true;
+
+		case CURLY_IR_TAGS_INFIX:
+			return resolve_sexpr(sexpr->infix.left, scope, ir) && resolve_sexpr(sexpr->infix.right, scope, ir);
+		case CURLY_IR_TAGS_PREFIX:
+			return resolve_sexpr(sexpr->prefix.operand, scope, ir);
+
+		case CURLY_IR_TAGS_APPLY:
+			return resolve_sexpr(sexpr->apply.func, scope, ir) && resolve_sexpr(sexpr->apply.arg, scope, ir);
+
+		case CURLY_IR_TAGS_ASSIGN:
+			// Functions can refer to themselves, so their names are bound first
+			if (sexpr->assign.value->tag == CURLY_IR_TAGS_FUNC)
+			{
+				sexpr->assign.binding = bind_var(scope, sexpr->assign.name);
+				return resolve_sexpr(sexpr->assign.value, scope, ir);
+			}
+
+			// Other values are resolved before the name is bound
+			if (!resolve_sexpr(sexpr->assign.value, scope, ir))
+				return false;
+			sexpr->assign.binding = bind_var(scope, sexpr->assign.name);
+			return true;
+		case CURLY_IR_TAGS_DECLARE:
+			sexpr->declare.binding = bind_var(scope, sexpr->declare.name);
+			return true;
+
+		case CURLY_IR_TAGS_LOCAL_SCOPE:
+		{
+			// Bind the assignments in a new scope
+			size_t base = push_scope(scope);
+			for (size_t i = 0; i < sexpr->local_scope.assign_count; i++)
+			{
+				if (!resolve_sexpr(sexpr->local_scope.assigns[i], scope, ir))
+					return false;
+			}
+
+			// Resolve the value and pop the scope
+			if (!resolve_sexpr(sexpr->local_scope.value, scope, ir))
+				return false;
+			pop_scope(scope, base);
+			return true;
+		}
+
+		case CURLY_IR_TAGS_FUNC:
+		{
+			// The arguments are bound in a new scope around the body
+			ir_sexpr_func_t* func = ir->funcs[sexpr->func_id];
+			size_t base = push_scope(scope);
+			for (size_t i = 0; i < func->arg_count; i++)
+			{
+				func->args[i].binding = bind_var(scope, func->args[i].name);
+			}
+			if (!resolve_sexpr(func->body, scope, ir))
+				return false;
+			pop_scope(scope, base);
+			return true;
+		}
+
+		case CURLY_IR_TAGS_IF:
+			return resolve_sexpr(sexpr->if_expr.cond, scope, ir) && resolve_sexpr(sexpr->if_expr.then, scope, ir)
+				&& resolve_sexpr(sexpr->if_expr.elsy, scope, ir);
+
+		case CURLY_IR_TAGS_LIST:
+			for (size_t i = 0; i < sexpr->list.element_count; i++)
+			{
+				if (!resolve_sexpr(sexpr->list.elements[i], scope, ir))
+					return false;
+			}
+			return true;
+
+		case CURLY_IR_TAGS_SLICE:
+			return resolve_sexpr(sexpr->slice.list, scope, ir) && resolve_sexpr(sexpr->slice.start, scope, ir)
+				&& resolve_sexpr(sexpr->slice.end, scope, ir);
+
+		case CURLY_IR_TAGS_FOR:
+		{
+			// The loop variable is bound in a new scope around the body
+			if (!resolve_sexpr(sexpr->for_loop.iter, scope, ir))
+				return false;
+			size_t base = push_scope(scope);
+			sexpr->for_loop.var_binding = bind_var(scope, sexpr->for_loop.var);
+			if (!resolve_sexpr(sexpr->for_loop.body, scope, ir))
+				return false;
+			pop_scope(scope, base);
+			return true;
+		}
+
+		case CURLY_IR_TAGS_RANGE:
+			return resolve_sexpr(sexpr->range.start, scope, ir) && (sexpr->range.end == NULL || resolve_sexpr(sexpr->range.end, scope, ir));
+
+		case CURLY_IR_TAGS_DUP:
+			return resolve_sexpr(sexpr->rc.value, scope, ir);
+		case CURLY_IR_TAGS_DROP:
+			if (!resolve_sexpr(sexpr->rc.value, scope, ir))
+				return false;
+			for (size_t i = 0; i < sexpr->rc.drop_count; i++)
+			{
+				if (!resolve_sexpr(sexpr->rc.drops[i], scope, ir))
+					return false;
+			}
+			return true;
+
+		default:
+			return true;
+	}
+}
+
+// resolve_symbols(curly_ir_t*, ir_scope_t*) -> bool
+// Resolves every variable name in the IR to a binding id, binding new globals in the scope. Returns false if a name is unbound.
+// Resolving the same IR again gives the same ids, so passes that add locals can resolve it again.
+bool resolve_symbols(curly_ir_t* ir, ir_scope_t* scope)
+{
+	size_t binding_count = scope->binding_count;
+	for (size_t i = 0; i < ir->expr_count; i++)
+	{
+		// Unbind everything bound by the IR if it fails
+		if (!resolve_sexpr(ir->expr[i], scope, ir))
+		{
+			restore_scope(scope, binding_count);
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,20 @@
+//
+// passes
+// resolve_symbols.h: Header file for resolve_symbols.c.
+//
+// Created by jenra.
+// Created on October 18 2026.
+//
+
+#ifndef PASSES_RESOLVE_SYMBOLS_H
+#define PASSES_RESOLVE_SYMBOLS_H
+
+#include "../correctness/scope.h"
+#include "../ir/generate_ir.h"
+
+// resolve_symbols(curly_ir_t*, ir_scope_t*) -> bool
+// Resolves every variable name in the IR to a binding id, binding new globals in the scope. Returns false if a name is unbound.
+// Resolving the same IR again gives the same ids, so passes that add locals can resolve it again.
+bool resolve_symbols(curly_ir_t* ir, ir_scope_t* scope);
+
+#endif /* PASSES_RESOLVE_SYMBOLS_H */
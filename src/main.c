@@ -14,11 +14,25 @@
 #include <string.h>
 
 #include "compiler/backends/llvm/codegen.h"
+#include "compiler/backends/llvm/layouts.h"
+#include "compiler/backends/llvm/runtime.h"
 #include "compiler/frontend/correctness/check.h"
 #include "compiler/frontend/ir/generate_ir.h"
+#include "compiler/frontend/ir/serialise.h"
 #include "compiler/frontend/parse/lexer.h"
 #include "compiler/frontend/parse/parser.h"
+#include "compiler/frontend/passes/common_subexpressions.h"
+#include "compiler/frontend/passes/dead_bindings.h"
+#include "compiler/frontend/passes/fold_constants.h"
+#include "compiler/frontend/passes/inline.h"
+#include "compiler/frontend/passes/monomorphise.h"
+#include "compiler/frontend/passes/rc_insertion.h"
+#include "compiler/frontend/passes/resolve_symbols.h"
+#include "runtime/alloc.h"
+#include "runtime/errors.h"
+#include "runtime/rc.h"
 #include "utils/list.h"
+#include "utils/phases.h"
 
 // count_groupings(char*, int) -> int
 // Counts the number of unmatched grouping symbols and returns the result.
@@ -53,40 +67,188 @@ typedef union
 	bool i1;
 	struct
 	{
-		int32_t reference_count;
-		void* func;
-		int8_t count;
-		int8_t arity;
-		int64_t thunk_bitmap;
-		int64_t* args;
-	} func_app;
+		int64_t length;
+		int64_t capacity;
+		void* data;
+	} list;
 } repl_value_t;
 
+// print_repl_list(repl_value_t, type_t*) -> void
+// Prints out a list of primitives returned by the repl.
+void print_repl_list(repl_value_t value, type_t* type)
+{
+	type_t* elem_type = type->field_count != 0 ? type->field_types[0] : NULL;
+	char* name = elem_type != NULL && elem_type->type_type == IR_TYPES_PRIMITIVE ? elem_type->type_name : "";
+
+	printf("[");
+	for (int64_t i = 0; i < value.list.length; i++)
+	{
+		if (i > 0) printf(", ");
+		if (!strcmp(name, "Int"))
+			printf("%li", ((int64_t*) value.list.data)[i]);
+		else if (!strcmp(name, "Float"))
+			printf("%.5f", ((double*) value.list.data)[i]);
+		else if (!strcmp(name, "Bool"))
+			printf("%s", ((bool*) value.list.data)[i] ? "true" : "false");
+		else printf("...");
+	}
+	printf("]");
+}
+
+// lex_all(lexer_t*) -> void
+// Lexes every token up front so that lexing is timed apart from parsing. The parser reuses the memoised tokens.
+void lex_all(lexer_t* lex)
+{
+	begin_phase(CURLY_PHASE_LEX);
+	while (lex_next(lex)->type != LEX_TYPE_EOF);
+	lex->token_pos = 0;
+	end_phase();
+}
+
+// run_file_code(curly_ir_t, ir_scope_t*, bool, bool, bool) -> int
+// Builds checked IR with its reference counting operations inserted and runs it, returning the exit code. The final IR
+// and LLVM IR are printed if dump_ir and dump_llvm are set.
+int run_file_code(curly_ir_t ir, ir_scope_t* scope, bool print_layouts, bool dump_ir, bool dump_llvm)
+{
+	// Build the LLVM IR
+	if (dump_ir)
+		print_ir(ir);
+	if (print_layouts)
+		print_type_layouts(scope->types, ir);
+	begin_phase(CURLY_PHASE_CODEGEN);
+	llvm_codegen_env_t* env = generate_code(ir, scope, NULL);
+	begin_phase(CURLY_PHASE_OPT);
+	optimize_code(env);
+	end_phase();
+	if (dump_llvm)
+	{
+		char* string = LLVMPrintModuleToString(env->body_mod);
+		printf("%s", string);
+		free(string);
+	}
+
+	// Init JIT
+	begin_phase(CURLY_PHASE_JIT);
+	LLVMInitializeNativeTarget();
+	LLVMInitializeNativeAsmPrinter();
+	LLVMLinkInMCJIT();
+	register_llvm_runtime();
+
+	// Create the execution engine
+	char* error = NULL;
+	LLVMExecutionEngineRef engine = NULL;
+	if (LLVMCreateJITCompilerForModule(&engine, env->body_mod, 0, &error) || error != NULL)
+	{
+		fprintf(stderr, "engine error: %s\n", error);
+		free(error);
+		LLVMDisposeExecutionEngine(engine);
+		end_phase();
+		return -1;
+	}
+
+	// Run the code (getting the main function compiles the module)
+	LLVMGetPointerToGlobal(engine, env->main_func);
+	begin_phase(CURLY_PHASE_RUN);
+	LLVMDisposeGenericValue(LLVMRunFunction(engine, env->main_func, 0, (LLVMGenericValueRef[]) {}));
+	end_phase();
+	if (getenv(CURLY_RC_STATS_ENV) != NULL)
+		curly_rc_print_stats(stderr);
+	if (getenv(CURLY_ALLOC_STATS_ENV) != NULL)
+		curly_alloc_print_stats(stderr);
+
+	// Clean up
+	LLVMDisposeExecutionEngine(engine);
+	clean_llvm_codegen_environment(env);
+	return 0;
+}
+
 int main(int argc, char** argv)
 {
-	switch (argc)
+	// Options come before the file name
+	bool print_layouts = false;
+	bool print_inlining = false;
+	bool warn_unused = false;
+	bool dump_ast = false;
+	bool dump_ir = false;
+	bool dump_llvm = false;
+	bool time_phases = false;
+	char* save_path = NULL;
+	int arg = 1;
+	for (; arg < argc && !strncmp(argv[arg], "--", 2); arg++)
+	{
+		if (!strcmp(argv[arg], "--print-layouts"))
+			print_layouts = true;
+		else if (!strcmp(argv[arg], "--print-inlining"))
+			print_inlining = true;
+		else if (!strcmp(argv[arg], "--warn-unused"))
+			warn_unused = true;
+		else if (!strcmp(argv[arg], "--dump-ast"))
+			dump_ast = true;
+		else if (!strcmp(argv[arg], "--dump-ir"))
+			dump_ir = true;
+		else if (!strcmp(argv[arg], "--dump-llvm"))
+			dump_llvm = true;
+		else if (!strcmp(argv[arg], "--time-phases"))
+			time_phases = true;
+		else if (!strcmp(argv[arg], "--save-ir") && arg + 1 < argc)
+			save_path = argv[++arg];
+		else
+		{
+			printf("Unknown option %s\n", argv[arg]);
+			puts("usage: curly [--print-layouts] [--print-inlining] [--warn-unused] [--dump-ast] [--dump-ir] [--dump-llvm] "
+				"[--time-phases] [--save-ir path] [filename]");
+			return -1;
+		}
+	}
+
+	if (time_phases)
+		enable_phase_timing();
+
+	switch (argc - arg + 1)
 	{
 		case 1:
 		{
 			// Set up
 			puts("Curly REPL");
-			ir_scope_t* scope = push_scope(NULL);
+			ir_scope_t* scope = init_scope();
 			create_primatives(scope);
 			lexer_t lex;
 			parse_result_t res;
 			curly_ir_t ir;
 			init_ir(&ir);
-			LLVMContextRef context = LLVMContextCreate();
-			llvm_codegen_env_t* env = create_llvm_codegen_environment(LLVMModuleCreateWithNameInContext("repl-header", context));
+			char* spec_limit = getenv(CURLY_SPECIALISATION_LIMIT_ENV);
+			if (spec_limit != NULL)
+				ir.spec_limit = strtoul(spec_limit, NULL, 10);
+			char* check_threads = getenv(CURLY_CHECK_THREADS_ENV);
+			if (check_threads != NULL && strtoul(check_threads, NULL, 10) != 0)
+				ir.check_threads = strtoul(check_threads, NULL, 10);
+			llvm_codegen_env_t* env = create_llvm_codegen_environment(LLVMModuleCreateWithName("repl-header"));
+
+			// Every global has its own value, which doesn't move when more globals are added
 			size_t globals_size = 0;
 			size_t globals_count = 0;
-			repl_value_t* global_vals = calloc(globals_size, sizeof(repl_value_t));
+			repl_value_t** global_vals = NULL;
 			repl_value_t last_repl_val = {0};
+			bool repl_last_mapped = false;
+			size_t input_count = 0;
 
 			// Init JIT
 			LLVMInitializeNativeTarget();
 			LLVMInitializeNativeAsmPrinter();
 			LLVMLinkInMCJIT();
+			register_llvm_runtime();
+
+			// Create the execution engine
+			// The code of every input is added to the one engine, since generators saved to globals use code from previous inputs
+			char* error = NULL;
+			LLVMExecutionEngineRef engine = NULL;
+			if (LLVMCreateExecutionEngineForModule(&engine, LLVMModuleCreateWithName("repl"), &error) || error != NULL)
+			{
+				fprintf(stderr, "engine error: %s\n", error);
+				free(error);
+				LLVMDisposeExecutionEngine(engine);
+				return -1;
+			}
 
 			while (true)
 			{
@@ -129,17 +291,13 @@ int main(int argc, char** argv)
 				// Init lexer
 				init_lexer(&lex, input);
 				free(input);
-
-				// Print out tokens
-				// token_t* token;
-				// while ((token = lex_next(&lex))->type != LEX_TYPE_EOF)
-				// {
-				// 	printf("%s (%i:%i/%i)\n", token->value, token->lino, token->charpos, token->type);
-				// }
-				// lex.token_pos = 0;
+				if (time_phases)
+					lex_all(&lex);
 
 				// Parse
+				begin_phase(CURLY_PHASE_PARSE);
 				res = lang_parser(&lex);
+				end_phase();
 
 				if (res.succ)
 				{
@@ -148,79 +306,137 @@ int main(int argc, char** argv)
 						continue;
 
 					// Print
-					print_ast(res.ast);
+					if (dump_ast)
+						print_ast(res.ast);
 
 					// Generate IR code
-					convert_ast_to_ir(res.ast, scope, &ir);
-					print_ir(ir);
-
-					// Type check
-					// Build the LLVM IR if it's correct code
-					if (check_correctness(ir, scope))
-					{
+					size_t binding_count = scope->binding_count;
+					begin_phase(CURLY_PHASE_IR);
+					bool converted = convert_ast_to_ir(res.ast, scope, &ir);
+					end_phase();
+					if (dump_ir)
 						print_ir(ir);
 
-						generate_code(ir, env);
-						char* modstr = LLVMPrintModuleToString(env->header_mod);
-						printf("%s\n", modstr);
-						free(modstr);
-						modstr = LLVMPrintModuleToString(env->body_mod);
-						printf("%s\n", modstr);
-						free(modstr);
-
-						// Create the execution engine
-						char* error = NULL;
-						LLVMExecutionEngineRef engine = NULL;
-						if (LLVMCreateExecutionEngineForModule(&engine, env->body_mod, &error) || error != NULL)
+					// Resolve names, type check, and specialise generic functions
+					// Build the LLVM IR if it's correct code (inputs that only declare types have nothing to build)
+					begin_phase(CURLY_PHASE_CHECK);
+					if (converted && ir.expr_count != 0 && resolve_symbols(&ir, scope) && check_correctness(&ir, scope) && monomorphise(&ir, scope))
+					{
+						// The last value is kept alive for printing
+						// Globals aren't inlined or removed since later inputs can use them
+						// Reference counting binds temporaries, which moves the slots of locals
+						begin_phase(CURLY_PHASE_PASSES);
+						remove_dead_bindings(&ir, scope, false, warn_unused);
+						inline_functions(&ir, scope, false, print_inlining);
+						fold_constants(&ir, scope);
+						share_common_subexpressions(&ir, scope);
+						remove_dead_bindings(&ir, scope, false, false);
+						insert_rc_ops(&ir, true);
+						resolve_symbols(&ir, scope);
+						end_phase();
+						if (dump_ir)
+							print_ir(ir);
+						if (print_layouts)
+							print_type_layouts(scope->types, ir);
+
+						begin_phase(CURLY_PHASE_CODEGEN);
+						generate_code(ir, scope, env);
+
+						// The main function of every input is in the same engine, so each one has its own name
+						char main_name[32];
+						snprintf(main_name, sizeof(main_name), "repl.main.%zu", input_count++);
+						LLVMSetValueName2(env->main_func, main_name, strlen(main_name));
+						begin_phase(CURLY_PHASE_OPT);
+						optimize_code(env);
+						end_phase();
+						if (dump_llvm)
 						{
-							fprintf(stderr, "engine error: %s\n", error);
-							free(error);
-							LLVMDisposeExecutionEngine(engine);
-							return -1;
+							char* modstr = LLVMPrintModuleToString(env->header_mod);
+							printf("%s\n", modstr);
+							free(modstr);
+							modstr = LLVMPrintModuleToString(env->body_mod);
+							printf("%s\n", modstr);
+							free(modstr);
 						}
 
-						// Set global mappings
+						// Map the globals the input added (the engine keeps the mappings of previous inputs)
+						begin_phase(CURLY_PHASE_JIT);
 						LLVMValueRef global = LLVMGetFirstGlobal(env->header_mod);
 						size_t i = 0;
 						while (global != NULL)
 						{
 							size_t length = 0;
-							if (strcmp(LLVMGetValueName2(global, &length), "repl.last"))
+							const char* name = LLVMGetValueName2(global, &length);
+							if (strncmp(name, "repl.last", strlen("repl.last")))
 							{
-								if (i < globals_count)
-									list_append_element(global_vals, globals_size, globals_count, repl_value_t, (repl_value_t) {0});
-								LLVMAddGlobalMapping(engine, global, global_vals + i++);
-
-							// The repl value global has its own special global value
-							} else LLVMAddGlobalMapping(engine, global, &last_repl_val);
+								if (i >= globals_count)
+								{
+									list_append_element(global_vals, globals_size, globals_count, repl_value_t*, calloc(1, sizeof(repl_value_t)));
+									LLVMAddGlobalMapping(engine, global, global_vals[i]);
+								}
+								i++;
+
+							// The repl value global has its own special global value (and the renamed ones are unused)
+							} else if (!strcmp(name, "repl.last") && !repl_last_mapped)
+							{
+								LLVMAddGlobalMapping(engine, global, &last_repl_val);
+								repl_last_mapped = true;
+							}
 
 							global = LLVMGetNextGlobal(global);
 						}
 
-						// Run the code
-						LLVMAddModule(engine, env->header_mod);
-						LLVMDisposeGenericValue(LLVMRunFunction(engine, env->main_func, 0, (LLVMGenericValueRef[]) {}));
-
-						// Print the result
-						type_t* ret_type = ir.expr[ir.expr_count - 1]->type;
-						printf("  = ");
-						if (ret_type->type_type == IR_TYPES_PRIMITIVE && !strcmp(ret_type->type_name, "Int"))
-							printf("%li", last_repl_val.i64);
-						else if (ret_type->type_type == IR_TYPES_PRIMITIVE && !strcmp(ret_type->type_name, "Float"))
-							printf("%.5f", last_repl_val.f64);
-						else if (ret_type->type_type == IR_TYPES_PRIMITIVE && !strcmp(ret_type->type_name, "Bool"))
-							printf("%s", last_repl_val.i1 ? "true" : "false");
-						else if (ret_type->type_type == IR_TYPES_FUNC)
-							printf("(%i) %p: %i/%i args, bitmap = %li, args => %p", last_repl_val.func_app.reference_count, last_repl_val.func_app.func, last_repl_val.func_app.count, last_repl_val.func_app.arity, last_repl_val.func_app.thunk_bitmap, last_repl_val.func_app.args);
-						else printf("unknown value");
-						puts("");
-
-						// Clean up
-						LLVMRemoveModule(engine, env->header_mod, &env->header_mod, &error);
+						// Run the code (getting the main function compiles the module)
+						LLVMAddModule(engine, env->body_mod);
+						LLVMGetPointerToGlobal(engine, env->main_func);
+
+						// Errors while running return to the prompt, forgetting the globals bound by the input like a failed check
+						begin_phase(CURLY_PHASE_RUN);
+						bool run_failed = false;
+						jmp_buf recovery;
+						curly_error_recovery = &recovery;
+						if (!setjmp(recovery))
+							LLVMDisposeGenericValue(LLVMRunFunction(engine, env->main_func, 0, (LLVMGenericValueRef[]) {}));
+						else run_failed = true;
+						curly_error_recovery = NULL;
+						end_phase();
+
+						if (run_failed)
+						{
+							restore_scope(scope, binding_count);
+							forget_llvm_globals(env, binding_count);
+						} else
+						{
+							// Print the result
+							type_t* ret_type = ir.expr[ir.expr_count - 1]->type;
+							printf("  = ");
+							if (ret_type->type_type == IR_TYPES_PRIMITIVE && !strcmp(ret_type->type_name, "Int"))
+								printf("%li", last_repl_val.i64);
+							else if (ret_type->type_type == IR_TYPES_PRIMITIVE && !strcmp(ret_type->type_name, "Float"))
+								printf("%.5f", last_repl_val.f64);
+							else if (ret_type->type_type == IR_TYPES_PRIMITIVE && !strcmp(ret_type->type_name, "Bool"))
+								printf("%s", last_repl_val.i1 ? "true" : "false");
+							else if (ret_type->type_type == IR_TYPES_FUNC)
+								printf("<function>");
+							else if (ret_type->type_type == IR_TYPES_LIST)
+								print_repl_list(last_repl_val, ret_type);
+							else if (ret_type->type_type == IR_TYPES_GENERATOR)
+								printf("<generator>");
+							else printf("unknown value");
+							puts("");
+						}
+
+						// Clean up (the engine owns the module now)
 						empty_llvm_codegen_environment(env);
-						LLVMDisposeExecutionEngine(engine);
-					} else printf("Check failed\n");
+					} else if (!converted || ir.expr_count != 0)
+					{
+						// Forget the globals bound by the input
+						restore_scope(scope, binding_count);
+						printf("Check failed\n");
+					}
 
+					// Inputs that only declare types end the check phase here
+					end_phase();
 					clean_ir(&ir);
 				} else
 				{
@@ -238,17 +454,46 @@ int main(int argc, char** argv)
 			// Final clean up
 			clean_functions(&ir);
 			clean_types();
-			pop_scope(scope);
+			del_scope(scope);
+			for (size_t i = 0; i < globals_count; i++)
+			{
+				free(global_vals[i]);
+			}
 			free(global_vals);
+			// The engine's modules use the globals of the header, so the engine is disposed of first
+			LLVMDisposeExecutionEngine(engine);
 			clean_llvm_codegen_environment(env);
-			LLVMContextDispose(context);
+			if (getenv(CURLY_RC_STATS_ENV) != NULL)
+				curly_rc_print_stats(stderr);
+			if (getenv(CURLY_ALLOC_STATS_ENV) != NULL)
+				curly_alloc_print_stats(stderr);
+			print_phase_stats(stderr);
 			puts("Leaving Curly REPL");
 			return 0;
 		}
 		case 2:
 		{
+			// Images of checked IR are built without being parsed or checked again
+			if (is_ir_image_path(argv[arg]))
+			{
+				ir_scope_t* scope = init_scope();
+				curly_ir_t ir;
+				curly_ir_image_t image;
+				int code = -1;
+				begin_phase(CURLY_PHASE_LOAD);
+				bool loaded = load_ir(argv[arg], &ir, scope, &image);
+				end_phase();
+				if (loaded)
+					code = run_file_code(ir, scope, print_layouts, dump_ir, dump_llvm);
+				print_phase_stats(stderr);
+				del_scope(scope);
+				clean_types();
+				unload_ir(&image);
+				return code;
+			}
+
 			// Set up
-			FILE* file = fopen(argv[1], "r");
+			FILE* file = fopen(argv[arg], "r");
 			size_t size = 128;
 			char* string = malloc(size + 1);
 			string[0] = '\0';
@@ -266,85 +511,98 @@ int main(int argc, char** argv)
 			fclose(file);
 
 			// Init lexer
+			// Timing phases lexes the whole file up front, which keeps every token until the end
 			lexer_t lex;
 			init_lexer(&lex, string);
 			free(string);
+			if (time_phases)
+				lex_all(&lex);
 
-			// Print out tokens
-			// token_t* token;
-			// while ((token = lex_next(&lex))->type != LEX_TYPE_EOF)
-			// {
-			// 	printf("%s (%i:%i/%i)\n", token->value, token->lino, token->charpos, token->type);
-			// }
-			// lex.token_pos = 0;
+			// Set up the IR
+			ir_scope_t* scope = init_scope();
+			create_primatives(scope);
+			curly_ir_t ir;
+			init_ir(&ir);
+			char* spec_limit = getenv(CURLY_SPECIALISATION_LIMIT_ENV);
+			if (spec_limit != NULL)
+				ir.spec_limit = strtoul(spec_limit, NULL, 10);
+			char* check_threads = getenv(CURLY_CHECK_THREADS_ENV);
+			if (check_threads != NULL && strtoul(check_threads, NULL, 10) != 0)
+				ir.check_threads = strtoul(check_threads, NULL, 10);
+
+			// Parse and generate IR code one statement at a time
+			// The tokens and AST of a statement are freed once it's converted, so they don't grow with the file
+			parse_result_t res;
+			bool done = false;
+			bool converted = true;
+			while (!done)
+			{
+				begin_phase(CURLY_PHASE_PARSE);
+				res = lang_parser_next(&lex, &done);
+				end_phase();
+				if (!res.succ)
+					break;
+				if (dump_ast)
+					print_ast(res.ast);
 
-			// Parse
-			parse_result_t res = lang_parser(&lex);
+				begin_phase(CURLY_PHASE_IR);
+				converted = convert_ast_to_ir(res.ast, scope, &ir) && converted;
+				end_phase();
+				clean_parse_result(res);
+				discard_tokens(&lex);
+			}
 
 			if (res.succ)
 			{
-				print_ast(res.ast);
-
-				// Generate IR code
-				ir_scope_t* scope = push_scope(NULL);
-				curly_ir_t ir;
-				init_ir(&ir);
-				convert_ast_to_ir(res.ast, scope, &ir);
-				print_ir(ir);
+				if (dump_ir)
+					print_ir(ir);
 
-				// Type check
-				if (check_correctness(ir, NULL))
+				// Resolve names, type check, and specialise generic functions
+				begin_phase(CURLY_PHASE_CHECK);
+				if (converted && resolve_symbols(&ir, scope) && check_correctness(&ir, scope) && monomorphise(&ir, scope))
 				{
 					// Build the LLVM IR
-					llvm_codegen_env_t* env = generate_code(ir, NULL);
-					char* string = LLVMPrintModuleToString(env->body_mod);
-					printf("%s", string);
-					free(string);
-
-					// Init JIT
-					LLVMInitializeNativeTarget();
-					LLVMInitializeNativeAsmPrinter();
-					LLVMLinkInMCJIT();
-
-					// Create the execution engine
-					char* error = NULL;
-					LLVMExecutionEngineRef engine = NULL;
-					if (LLVMCreateJITCompilerForModule(&engine, env->body_mod, 0, &error) || error != NULL)
-					{
-						fprintf(stderr, "engine error: %s\n", error);
-						free(error);
-						LLVMDisposeExecutionEngine(engine);
+					// Reference counting binds temporaries, which moves the slots of locals
+					begin_phase(CURLY_PHASE_PASSES);
+					remove_dead_bindings(&ir, scope, true, warn_unused);
+					inline_functions(&ir, scope, true, print_inlining);
+					fold_constants(&ir, scope);
+					share_common_subexpressions(&ir, scope);
+					remove_dead_bindings(&ir, scope, true, false);
+					insert_rc_ops(&ir, false);
+					resolve_symbols(&ir, scope);
+					end_phase();
+					if (save_path != NULL && !save_ir(&ir, scope, save_path))
+						printf("Could not save IR to %s\n", save_path);
+					if (run_file_code(ir, scope, print_layouts, dump_ir, dump_llvm) != 0)
 						return -1;
-					}
-
-					// Run the code
-					LLVMDisposeGenericValue(LLVMRunFunction(engine, env->main_func, 0, (LLVMGenericValueRef[]) {}));
-
-					// Clean up
-					LLVMDisposeExecutionEngine(engine);
-					clean_llvm_codegen_environment(env);
-				} else printf("Check failed\n");
-
-				clean_functions(&ir);
-				clean_ir(&ir);
-				pop_scope(scope);
+				} else
+				{
+					end_phase();
+					printf("Check failed\n");
+				}
+				print_phase_stats(stderr);
 			} else
 			{
 				// Print out parsing error
 				puts("an error occured");
 				printf("Expected %s, got '%s'\n", res.error->expected, res.error->value.value);
 				printf(" (%i:%i)\n", res.error->value.lino, res.error->value.charpos);
+				clean_parse_result(res);
 			}
 
 			// Clean up
+			clean_functions(&ir);
+			clean_ir(&ir);
+			del_scope(scope);
 			cleanup_lexer(&lex);
-			clean_parse_result(res);
 			clean_types();
 			return 0;
 		}
 		default:
 			// Display usage message
-			puts("usage: curly [filename]");
+			puts("usage: curly [--print-layouts] [--print-inlining] [--warn-unused] [--dump-ast] [--dump-ir] [--dump-llvm] "
+				"[--time-phases] [--save-ir path] [filename]");
 			return -1;
 	}
 }
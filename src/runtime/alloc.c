@@ -0,0 +1,270 @@
+//
+// runtime
+// alloc.c: Implements a size class allocator with slab pages and thread local caches.
+//
+// Created by jenra.
+// Created on October 18 2026.
+//
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+
+// Every block starts with a header holding its size class, so that freeing doesn't need the size. Large blocks are
+// allocated with malloc. Free blocks are linked through their headers.
+
+// The header before every block.
+typedef struct
+{
+	// The size class of the block, or CURLY_ALLOC_CLASS_COUNT for large blocks.
+	size_t size_class;
+} curly_alloc_header_t;
+
+// Represents a free block.
+typedef struct curly_alloc_free_s
+{
+	struct curly_alloc_free_s* next;
+} curly_alloc_free_t;
+
+// Represents the blocks shared between threads for a size class.
+typedef struct
+{
+	// The free blocks returned by thread caches.
+	curly_alloc_free_t* free;
+
+	// The unused part of the current slab page.
+	char* slab;
+	char* slab_end;
+} curly_alloc_pool_t;
+
+// Represents the free blocks cached by a thread for a size class.
+typedef struct
+{
+	curly_alloc_free_t* free;
+	size_t count;
+} curly_alloc_cache_t;
+
+// The size of a block in each size class, including its header.
+const size_t curly_alloc_class_sizes[CURLY_ALLOC_CLASS_COUNT] = {
+	16, 32, 48, 64, 80, 96, 112, 128,
+	160, 192, 224, 256,
+	320, 384, 448, 512,
+	640, 768, 896, 1024
+};
+
+// Maps a block size rounded up to 16 bytes (divided by 16) to its size class.
+uint8_t curly_alloc_class_lookup[CURLY_ALLOC_MAX_SMALL / 16 + 1];
+pthread_once_t curly_alloc_lookup_once = PTHREAD_ONCE_INIT;
+
+// The shared pools, the lock guarding them and the statistics. Statistics are not synchronised since programs are single threaded.
+curly_alloc_pool_t curly_alloc_pools[CURLY_ALLOC_CLASS_COUNT];
+pthread_mutex_t curly_alloc_lock = PTHREAD_MUTEX_INITIALIZER;
+curly_alloc_stats_t curly_alloc_stats[CURLY_ALLOC_CLASS_COUNT + 1];
+
+// The free blocks cached by the current thread.
+_Thread_local curly_alloc_cache_t curly_alloc_caches[CURLY_ALLOC_CLASS_COUNT];
+
+// curly_alloc_init_lookup(void) -> void
+// Initialises the table mapping sizes to size classes.
+void curly_alloc_init_lookup()
+{
+	size_t size_class = 0;
+	for (size_t i = 0; i <= CURLY_ALLOC_MAX_SMALL / 16; i++)
+	{
+		while (curly_alloc_class_sizes[size_class] < i * 16)
+			size_class++;
+		curly_alloc_class_lookup[i] = size_class;
+	}
+}
+
+// curly_alloc_refill(size_t) -> void
+// Moves a batch of blocks from the shared pool of a size class into the current thread's cache.
+void curly_alloc_refill(size_t size_class)
+{
+	curly_alloc_cache_t* cache = curly_alloc_caches + size_class;
+	curly_alloc_pool_t* pool = curly_alloc_pools + size_class;
+	size_t block_size = curly_alloc_class_sizes[size_class];
+	pthread_mutex_lock(&curly_alloc_lock);
+
+	for (size_t i = 0; i < CURLY_ALLOC_BATCH; i++)
+	{
+		// Reuse a free block if there is one
+		curly_alloc_free_t* block = pool->free;
+		if (block != NULL)
+			pool->free = block->next;
+
+		// Otherwise carve one out of the slab, starting a new slab if it's full
+		else
+		{
+			if (pool->slab == NULL || pool->slab + block_size > pool->slab_end)
+			{
+				pool->slab = malloc(CURLY_ALLOC_SLAB_SIZE);
+				pool->slab_end = pool->slab + CURLY_ALLOC_SLAB_SIZE;
+				curly_alloc_stats[size_class].slabs++;
+			}
+			block = (curly_alloc_free_t*) pool->slab;
+			pool->slab += block_size;
+		}
+
+		block->next = cache->free;
+		cache->free = block;
+		cache->count++;
+	}
+
+	pthread_mutex_unlock(&curly_alloc_lock);
+}
+
+// curly_alloc_flush(size_t) -> void
+// Returns a batch of blocks from the current thread's cache to the shared pool of a size class.
+void curly_alloc_flush(size_t size_class)
+{
+	curly_alloc_cache_t* cache = curly_alloc_caches + size_class;
+	curly_alloc_pool_t* pool = curly_alloc_pools + size_class;
+	pthread_mutex_lock(&curly_alloc_lock);
+
+	for (size_t i = 0; i < CURLY_ALLOC_BATCH && cache->free != NULL; i++)
+	{
+		curly_alloc_free_t* block = cache->free;
+		cache->free = block->next;
+		cache->count--;
+		block->next = pool->free;
+		pool->free = block;
+	}
+
+	pthread_mutex_unlock(&curly_alloc_lock);
+}
+
+// curly_alloc_update_stats(size_t, bool) -> void
+// Counts an allocation or free in the statistics of a size class.
+void curly_alloc_update_stats(size_t size_class, bool alloc)
+{
+	curly_alloc_stats_t* stats = curly_alloc_stats + size_class;
+	if (alloc)
+	{
+		stats->allocations++;
+		if (++stats->live > stats->peak_live)
+			stats->peak_live = stats->live;
+	} else
+	{
+		stats->frees++;
+		stats->live--;
+	}
+}
+
+// curly_alloc(size_t) -> void*
+// Allocates a block of at least the given size in bytes.
+void* curly_alloc(size_t size)
+{
+	pthread_once(&curly_alloc_lookup_once, curly_alloc_init_lookup);
+	size_t block_size = size + sizeof(curly_alloc_header_t);
+	curly_alloc_header_t* header;
+
+	// Large blocks are allocated directly
+	if (block_size > CURLY_ALLOC_MAX_SMALL)
+	{
+		header = malloc(block_size);
+		header->size_class = CURLY_ALLOC_CLASS_COUNT;
+		curly_alloc_update_stats(CURLY_ALLOC_CLASS_COUNT, true);
+		return header + 1;
+	}
+
+	// Small blocks come from the thread's cache
+	size_t size_class = curly_alloc_class_lookup[(block_size + 15) / 16];
+	curly_alloc_cache_t* cache = curly_alloc_caches + size_class;
+	if (cache->free == NULL)
+		curly_alloc_refill(size_class);
+	header = (curly_alloc_header_t*) cache->free;
+	cache->free = cache->free->next;
+	cache->count--;
+	header->size_class = size_class;
+	curly_alloc_update_stats(size_class, true);
+	return header + 1;
+}
+
+// curly_alloc_realloc(void*, size_t) -> void*
+// Resizes a block, moving it if it no longer fits in its size class. A NULL pointer allocates a new block.
+void* curly_alloc_realloc(void* ptr, size_t size)
+{
+	if (ptr == NULL)
+		return curly_alloc(size);
+
+	// Large blocks that stay large are resized by malloc
+	curly_alloc_header_t* header = (curly_alloc_header_t*) ptr - 1;
+	size_t copy_size = size;
+	if (header->size_class == CURLY_ALLOC_CLASS_COUNT)
+	{
+		if (size + sizeof(curly_alloc_header_t) > CURLY_ALLOC_MAX_SMALL)
+		{
+			header = realloc(header, size + sizeof(curly_alloc_header_t));
+			return header + 1;
+		}
+
+	// Small blocks that still fit don't move
+	} else
+	{
+		size_t old_size = curly_alloc_class_sizes[header->size_class] - sizeof(curly_alloc_header_t);
+		if (size <= old_size)
+			return ptr;
+		copy_size = old_size;
+	}
+
+	// Move the block
+	void* moved = curly_alloc(size);
+	memcpy(moved, ptr, copy_size);
+	curly_alloc_free(ptr);
+	return moved;
+}
+
+// curly_alloc_free(void*) -> void
+// Frees a block, returning it to the current thread's cache.
+void curly_alloc_free(void* ptr)
+{
+	if (ptr == NULL)
+		return;
+	curly_alloc_header_t* header = (curly_alloc_header_t*) ptr - 1;
+	size_t size_class = header->size_class;
+	curly_alloc_update_stats(size_class, false);
+
+	// Large blocks are freed directly
+	if (size_class == CURLY_ALLOC_CLASS_COUNT)
+	{
+		free(header);
+		return;
+	}
+
+	// Small blocks go back to the thread's cache, which returns a batch once it holds too many
+	curly_alloc_cache_t* cache = curly_alloc_caches + size_class;
+	curly_alloc_free_t* block = (curly_alloc_free_t*) header;
+	block->next = cache->free;
+	cache->free = block;
+	if (++cache->count > CURLY_ALLOC_CACHE_MAX)
+		curly_alloc_flush(size_class);
+}
+
+// curly_alloc_get_stats(size_t) -> curly_alloc_stats_t
+// Returns the statistics on a size class, or on large allocations if the index is CURLY_ALLOC_CLASS_COUNT.
+curly_alloc_stats_t curly_alloc_get_stats(size_t size_class)
+{
+	return curly_alloc_stats[size_class];
+}
+
+// curly_alloc_print_stats(FILE*) -> void
+// Prints the statistics on every size class that has been used.
+void curly_alloc_print_stats(FILE* file)
+{
+	for (size_t i = 0; i <= CURLY_ALLOC_CLASS_COUNT; i++)
+	{
+		curly_alloc_stats_t stats = curly_alloc_stats[i];
+		if (stats.allocations == 0)
+			continue;
+		if (i < CURLY_ALLOC_CLASS_COUNT)
+			fprintf(file, "alloc: %4zu bytes: ", curly_alloc_class_sizes[i]);
+		else fprintf(file, "alloc:      large: ");
+		fprintf(file, "%zu allocations, %zu frees, %zu live, %zu peak live, %zu slabs\n",
+			stats.allocations, stats.frees, stats.live, stats.peak_live, stats.slabs);
+	}
+}
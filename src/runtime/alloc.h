@@ -0,0 +1,61 @@
+//
+// runtime
+// alloc.h: Header file for alloc.c.
+//
+// Created by jenra.
+// Created on October 18 2026.
+//
+
+#ifndef RUNTIME_ALLOC_H
+#define RUNTIME_ALLOC_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+// The environment variable used to print allocator statistics on exit.
+#define CURLY_ALLOC_STATS_ENV "CURLY_ALLOC_STATS"
+
+// The number of size classes, the largest of which is CURLY_ALLOC_MAX_SMALL bytes including the block header.
+#define CURLY_ALLOC_CLASS_COUNT 20
+#define CURLY_ALLOC_MAX_SMALL 1024
+
+// The size of a slab page that blocks of a size class are carved out of.
+#define CURLY_ALLOC_SLAB_SIZE (64 * 1024)
+
+// The number of blocks moved between a thread's cache and the shared free lists at once.
+#define CURLY_ALLOC_BATCH 32
+
+// The number of free blocks a thread's cache keeps per size class before returning a batch.
+#define CURLY_ALLOC_CACHE_MAX 256
+
+// Represents statistics on a size class (or on large allocations).
+typedef struct
+{
+	size_t allocations;
+	size_t frees;
+	size_t live;
+	size_t peak_live;
+	size_t slabs;
+} curly_alloc_stats_t;
+
+// curly_alloc(size_t) -> void*
+// Allocates a block of at least the given size in bytes.
+void* curly_alloc(size_t size);
+
+// curly_alloc_realloc(void*, size_t) -> void*
+// Resizes a block, moving it if it no longer fits in its size class. A NULL pointer allocates a new block.
+void* curly_alloc_realloc(void* ptr, size_t size);
+
+// curly_alloc_free(void*) -> void
+// Frees a block, returning it to the current thread's cache.
+void curly_alloc_free(void* ptr);
+
+// curly_alloc_get_stats(size_t) -> curly_alloc_stats_t
+// Returns the statistics on a size class, or on large allocations if the index is CURLY_ALLOC_CLASS_COUNT.
+curly_alloc_stats_t curly_alloc_get_stats(size_t size_class);
+
+// curly_alloc_print_stats(FILE*) -> void
+// Prints the statistics on every size class that has been used.
+void curly_alloc_print_stats(FILE* file);
+
+#endif /* RUNTIME_ALLOC_H */
@@ -0,0 +1,42 @@
+//
+// runtime
+// errors.c: Implements the errors compiled code can raise while running.
+//
+// Created by jenra.
+// Created on October 18 2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "errors.h"
+
+// The recovery point errors jump to.
+jmp_buf* curly_error_recovery = NULL;
+
+// curly_error_recover(void) -> void
+// Jumps to the error recovery point if there is one, and exits otherwise.
+void curly_error_recover()
+{
+	if (curly_error_recovery != NULL)
+		longjmp(*curly_error_recovery, 1);
+	exit(1);
+}
+
+// curly_error_index(int64_t, int64_t) -> void
+// Reports an index outside of a list and recovers from the error.
+void curly_error_index(int64_t index, int64_t length)
+{
+	fflush(stdout);
+	fprintf(stderr, "Index out of bounds: index %li into a list of length %li\n", (long) index, (long) length);
+	curly_error_recover();
+}
+
+// curly_error_slice(int64_t, int64_t, int64_t) -> void
+// Reports a slice outside of a list (or with its start after its end) and recovers from the error.
+void curly_error_slice(int64_t start, int64_t end, int64_t length)
+{
+	fflush(stdout);
+	fprintf(stderr, "Slice out of bounds: range %li to %li of a list of length %li\n", (long) start, (long) end, (long) length);
+	curly_error_recover();
+}
@@ -0,0 +1,30 @@
+//
+// runtime
+// errors.h: Header file for errors.c.
+//
+// Created by jenra.
+// Created on October 18 2026.
+//
+
+#ifndef RUNTIME_ERRORS_H
+#define RUNTIME_ERRORS_H
+
+#include <setjmp.h>
+#include <stdint.h>
+
+// Where errors jump to instead of exiting (such as the repl's prompt), or NULL to exit.
+extern jmp_buf* curly_error_recovery;
+
+// curly_error_index(int64_t, int64_t) -> void
+// Reports an index outside of a list and recovers from the error.
+void curly_error_index(int64_t index, int64_t length);
+
+// curly_error_slice(int64_t, int64_t, int64_t) -> void
+// Reports a slice outside of a list (or with its start after its end) and recovers from the error.
+void curly_error_slice(int64_t start, int64_t end, int64_t length);
+
+// curly_error_recover(void) -> void
+// Jumps to the error recovery point if there is one, and exits otherwise.
+void curly_error_recover();
+
+#endif /* RUNTIME_ERRORS_H */
@@ -0,0 +1,133 @@
+//
+// runtime
+// memo.c: Implements chunked buffers for memoising generators.
+//
+// Created by jenra.
+// Created on October 18 2026.
+//
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../utils/list.h"
+#include "memo.h"
+
+// curly_memo_drop_chunk(curly_memo_t*, size_t) -> void
+// Drops every element in a chunk of a memo buffer and frees it.
+void curly_memo_drop_chunk(curly_memo_t* memo, size_t chunk)
+{
+	if (memo->drop != NULL)
+	{
+		size_t count = memo->length - chunk * CURLY_MEMO_CHUNK_SIZE;
+		if (count > CURLY_MEMO_CHUNK_SIZE)
+			count = CURLY_MEMO_CHUNK_SIZE;
+		for (size_t i = 0; i < count; i++)
+		{
+			memo->drop(memo->chunks[chunk] + i * memo->elem_size);
+		}
+	}
+	free(memo->chunks[chunk]);
+	memo->chunks[chunk] = NULL;
+}
+
+// curly_memo_new(size_t, void (*)(void*)) -> curly_memo_t*
+// Creates a new memo buffer for elements of the given size.
+curly_memo_t* curly_memo_new(size_t elem_size, void (*drop)(void*))
+{
+	curly_memo_t* memo = malloc(sizeof(curly_memo_t));
+	memo->source = NULL;
+	memo->done = false;
+	memo->elem_size = elem_size;
+	memo->drop = drop;
+	memo->chunks = NULL;
+	memo->chunks_size = 0;
+	memo->chunk_count = 0;
+	memo->length = 0;
+	memo->first_chunk = 0;
+	memo->max_chunks = 0;
+
+	// Get the cap, rounded up to a whole number of chunks
+	char* cap = getenv(CURLY_MEMO_CAP_ENV);
+	if (cap != NULL)
+	{
+		size_t elems = strtoull(cap, NULL, 10);
+		if (elems != 0)
+			memo->max_chunks = (elems + CURLY_MEMO_CHUNK_SIZE - 1) / CURLY_MEMO_CHUNK_SIZE;
+	}
+	return memo;
+}
+
+// curly_memo_get(curly_memo_t*, size_t, void*) -> curly_memo_result_t
+// Copies the element at the given index into out if it is buffered.
+curly_memo_result_t curly_memo_get(curly_memo_t* memo, size_t index, void* out)
+{
+	// Element has not been produced yet
+	if (index >= memo->length)
+		return memo->done ? CURLY_MEMO_DONE : CURLY_MEMO_MISS;
+
+	// Element was produced but evicted
+	size_t chunk = index / CURLY_MEMO_CHUNK_SIZE;
+	if (chunk < memo->first_chunk)
+		return CURLY_MEMO_EVICTED;
+
+	// Copy the element
+	memcpy(out, memo->chunks[chunk] + (index % CURLY_MEMO_CHUNK_SIZE) * memo->elem_size, memo->elem_size);
+	return CURLY_MEMO_HIT;
+}
+
+// curly_memo_push(curly_memo_t*, void*) -> void
+// Appends an element to a memo buffer, evicting the oldest chunk if the buffer is full. The buffer owns the element.
+void curly_memo_push(curly_memo_t* memo, void* value)
+{
+	// Add a new chunk if the last one is full
+	size_t offset = memo->length % CURLY_MEMO_CHUNK_SIZE;
+	if (offset == 0)
+	{
+		// Evict the oldest chunk
+		if (memo->max_chunks != 0 && memo->chunk_count - memo->first_chunk >= memo->max_chunks)
+		{
+			curly_memo_drop_chunk(memo, memo->first_chunk++);
+		}
+
+		char* chunk = malloc(CURLY_MEMO_CHUNK_SIZE * memo->elem_size);
+		list_append_element(memo->chunks, memo->chunks_size, memo->chunk_count, char*, chunk);
+	}
+
+	// Copy the element
+	memcpy(memo->chunks[memo->chunk_count - 1] + offset * memo->elem_size, value, memo->elem_size);
+	memo->length++;
+}
+
+// curly_memo_source(curly_memo_t*) -> void*
+// Returns the coroutine handle producing new elements for a memo buffer.
+void* curly_memo_source(curly_memo_t* memo)
+{
+	return memo->source;
+}
+
+// curly_memo_set_source(curly_memo_t*, void*) -> void
+// Sets the coroutine handle producing new elements for a memo buffer.
+void curly_memo_set_source(curly_memo_t* memo, void* source)
+{
+	memo->source = source;
+}
+
+// curly_memo_finish(curly_memo_t*) -> void
+// Marks a memo buffer as having every element of its generator.
+void curly_memo_finish(curly_memo_t* memo)
+{
+	memo->source = NULL;
+	memo->done = true;
+}
+
+// curly_memo_del(curly_memo_t*) -> void
+// Deletes a memo buffer. The source is not destroyed.
+void curly_memo_del(curly_memo_t* memo)
+{
+	for (size_t i = memo->first_chunk; i < memo->chunk_count; i++)
+	{
+		curly_memo_drop_chunk(memo, i);
+	}
+	free(memo->chunks);
+	free(memo);
+}
@@ -0,0 +1,88 @@
+//
+// runtime
+// memo.h: Header file for memo.c.
+//
+// Created by jenra.
+// Created on October 18 2026.
+//
+
+#ifndef RUNTIME_MEMO_H
+#define RUNTIME_MEMO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// The number of elements in a chunk of a memo buffer.
+#define CURLY_MEMO_CHUNK_SIZE 64
+
+// The environment variable used to cap the number of elements a memo buffer retains.
+#define CURLY_MEMO_CAP_ENV "CURLY_MEMO_CAP"
+
+// Represents the result of looking up an element in a memo buffer.
+typedef enum
+{
+	CURLY_MEMO_HIT,
+	CURLY_MEMO_MISS,
+	CURLY_MEMO_DONE,
+	CURLY_MEMO_EVICTED
+} curly_memo_result_t;
+
+// Represents a buffer of elements already produced by a generator, shared between everything consuming the generator.
+typedef struct
+{
+	// The coroutine handle producing new elements (NULL if not started).
+	void* source;
+
+	// Whether the source has produced all of its elements.
+	bool done;
+
+	// The size of an element in bytes.
+	size_t elem_size;
+
+	// Drops the references an element holds (NULL if there are none).
+	void (*drop)(void*);
+
+	// The chunks of elements. Evicted chunks are NULL.
+	char** chunks;
+	size_t chunks_size;
+	size_t chunk_count;
+
+	// The number of elements produced so far.
+	size_t length;
+
+	// The index of the first chunk that has not been evicted.
+	size_t first_chunk;
+
+	// The maximum number of chunks retained (0 if unbounded).
+	size_t max_chunks;
+} curly_memo_t;
+
+// curly_memo_new(size_t, void (*)(void*)) -> curly_memo_t*
+// Creates a new memo buffer for elements of the given size.
+curly_memo_t* curly_memo_new(size_t elem_size, void (*drop)(void*));
+
+// curly_memo_get(curly_memo_t*, size_t, void*) -> curly_memo_result_t
+// Copies the element at the given index into out if it is buffered.
+curly_memo_result_t curly_memo_get(curly_memo_t* memo, size_t index, void* out);
+
+// curly_memo_push(curly_memo_t*, void*) -> void
+// Appends an element to a memo buffer, evicting the oldest chunk if the buffer is full. The buffer owns the element.
+void curly_memo_push(curly_memo_t* memo, void* value);
+
+// curly_memo_source(curly_memo_t*) -> void*
+// Returns the coroutine handle producing new elements for a memo buffer.
+void* curly_memo_source(curly_memo_t* memo);
+
+// curly_memo_set_source(curly_memo_t*, void*) -> void
+// Sets the coroutine handle producing new elements for a memo buffer.
+void curly_memo_set_source(curly_memo_t* memo, void* source);
+
+// curly_memo_finish(curly_memo_t*) -> void
+// Marks a memo buffer as having every element of its generator.
+void curly_memo_finish(curly_memo_t* memo);
+
+// curly_memo_del(curly_memo_t*) -> void
+// Deletes a memo buffer. The source is not destroyed.
+void curly_memo_del(curly_memo_t* memo);
+
+#endif /* RUNTIME_MEMO_H */
@@ -0,0 +1,73 @@
+//
+// runtime
+// rc.c: Implements allocation for reference counted objects.
+//
+// Created by jenra.
+// Created on October 18 2026.
+//
+
+#include <stdlib.h>
+#include <sys/resource.h>
+
+#include "alloc.h"
+#include "rc.h"
+
+// The statistics on reference counted allocations.
+curly_rc_stats_t curly_rc_stats = {0};
+
+// curly_rc_alloc(size_t, void (*)(void*)) -> void*
+// Allocates a reference counted object with a count of 1.
+void* curly_rc_alloc(size_t size, void (*drop)(void*))
+{
+	curly_rc_header_t* header = curly_alloc(sizeof(curly_rc_header_t) + size);
+	header->count = 1;
+	header->drop = drop;
+
+	// Update statistics
+	curly_rc_stats.allocations++;
+	curly_rc_stats.bytes += size;
+	if (++curly_rc_stats.live > curly_rc_stats.peak_live)
+		curly_rc_stats.peak_live = curly_rc_stats.live;
+	return header + 1;
+}
+
+// curly_rc_realloc(void*, size_t) -> void*
+// Resizes a uniquely referenced object, allocating a new one if the pointer is NULL.
+void* curly_rc_realloc(void* ptr, size_t size)
+{
+	if (ptr == NULL)
+		return curly_rc_alloc(size, NULL);
+	curly_rc_header_t* header = curly_alloc_realloc((curly_rc_header_t*) ptr - 1, sizeof(curly_rc_header_t) + size);
+	curly_rc_stats.bytes += size;
+	return header + 1;
+}
+
+// curly_rc_free(void*) -> void
+// Drops the references an object holds and frees it, once its count has reached zero.
+void curly_rc_free(void* ptr)
+{
+	curly_rc_header_t* header = (curly_rc_header_t*) ptr - 1;
+	if (header->drop != NULL)
+		header->drop(ptr);
+	curly_alloc_free(header);
+	curly_rc_stats.frees++;
+	curly_rc_stats.live--;
+}
+
+// curly_rc_get_stats(void) -> curly_rc_stats_t
+// Returns the statistics on reference counted allocations so far.
+curly_rc_stats_t curly_rc_get_stats()
+{
+	return curly_rc_stats;
+}
+
+// curly_rc_print_stats(FILE*) -> void
+// Prints the statistics on reference counted allocations and the peak resident set size.
+void curly_rc_print_stats(FILE* file)
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	fprintf(file, "rc: %zu allocations, %zu frees, %zu bytes, %zu live, %zu peak live, %li KiB peak rss\n",
+		curly_rc_stats.allocations, curly_rc_stats.frees, curly_rc_stats.bytes,
+		curly_rc_stats.live, curly_rc_stats.peak_live, usage.ru_maxrss);
+}
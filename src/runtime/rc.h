@@ -0,0 +1,59 @@
+//
+// runtime
+// rc.h: Header file for rc.c.
+//
+// Created by jenra.
+// Created on October 18 2026.
+//
+
+#ifndef RUNTIME_RC_H
+#define RUNTIME_RC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// The environment variable used to print allocation statistics on exit.
+#define CURLY_RC_STATS_ENV "CURLY_RC_STATS"
+
+// The header before every reference counted object. Counts are not atomic since programs are single threaded.
+typedef struct
+{
+	// The number of references to the object.
+	int64_t count;
+
+	// Drops the references the object holds (NULL if there are none).
+	void (*drop)(void*);
+} curly_rc_header_t;
+
+// Represents statistics on reference counted allocations.
+typedef struct
+{
+	size_t allocations;
+	size_t frees;
+	size_t bytes;
+	size_t live;
+	size_t peak_live;
+} curly_rc_stats_t;
+
+// curly_rc_alloc(size_t, void (*)(void*)) -> void*
+// Allocates a reference counted object with a count of 1.
+void* curly_rc_alloc(size_t size, void (*drop)(void*));
+
+// curly_rc_realloc(void*, size_t) -> void*
+// Resizes a uniquely referenced object, allocating a new one if the pointer is NULL.
+void* curly_rc_realloc(void* ptr, size_t size);
+
+// curly_rc_free(void*) -> void
+// Drops the references an object holds and frees it, once its count has reached zero.
+void curly_rc_free(void* ptr);
+
+// curly_rc_get_stats(void) -> curly_rc_stats_t
+// Returns the statistics on reference counted allocations so far.
+curly_rc_stats_t curly_rc_get_stats();
+
+// curly_rc_print_stats(FILE*) -> void
+// Prints the statistics on reference counted allocations and the peak resident set size.
+void curly_rc_print_stats(FILE* file);
+
+#endif /* RUNTIME_RC_H */
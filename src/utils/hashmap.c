@@ -60,7 +60,9 @@ void map_resize(hashmap_t* map, bool grow)
 	for (size_t i = 0; i < map->buckets_size; i++)
 	{
 		hash_bucket* current = map->buckets[i];
-		if (all_buckets == NULL)
+		if (current == NULL)
+			continue;
+		else if (all_buckets == NULL)
 			all_buckets = current;
 		else
 		{
@@ -73,6 +75,10 @@ void map_resize(hashmap_t* map, bool grow)
 	else
 		map->buckets_size = map->buckets_size >> 1;
 	map->buckets = realloc(map->buckets, map->buckets_size * sizeof(hash_bucket*));
+	memset(map->buckets, 0, map->buckets_size * sizeof(hash_bucket*));
+	map->item_count = 0;
+	map->bucket_count = 0;
+	map->collision_count = 0;
 
 	// I didn't want to deal with repeating such a large block of code, so here is a malloc-heavy and free-heavy loop.
 	while (all_buckets != NULL)
@@ -0,0 +1,121 @@
+//
+// utils
+// phases.c: Records the wall time and allocations of each phase of compiling and running code.
+//
+// Created by jenra.
+// Created on October 18 2026.
+//
+
+#include <sys/resource.h>
+#include <time.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "../runtime/rc.h"
+#include "phases.h"
+
+// Phases are recorded for the whole process: a phase starts with begin_phase and ends at the next begin_phase or
+// end_phase, so only one phase runs at a time. Memory is measured as the net change in the bytes malloc has handed out
+// (which includes memory LLVM allocates), so it's what a phase retains rather than everything it allocates, and memory
+// freed from an earlier phase makes it negative. The compiled code's allocations are counted as the number of reference
+// counted objects it allocates.
+
+// The names of the phases, in the order they're printed.
+char* curly_phase_names[CURLY_PHASE_COUNT] = {
+	"lex", "parse", "ir", "check", "passes", "load", "codegen", "opt", "jit", "run"
+};
+
+// The state of phase timing.
+bool curly_phases_enabled = false;
+curly_phase_stats_t curly_phase_stats[CURLY_PHASE_COUNT] = {0};
+curly_phase_t curly_current_phase = CURLY_PHASE_COUNT;
+struct timespec curly_phase_start_time;
+long curly_phase_start_heap;
+size_t curly_phase_start_rc;
+
+// heap_in_use(void) -> long
+// Returns the number of bytes malloc has handed out and not had freed, or 0 if the C library can't tell.
+long heap_in_use()
+{
+#ifdef __GLIBC__
+	struct mallinfo2 info = mallinfo2();
+	return info.uordblks + info.hblkhd;
+#else
+	return 0;
+#endif
+}
+
+// enable_phase_timing(void) -> void
+// Starts recording statistics on phases. Nothing is recorded (or measured) until this is called.
+void enable_phase_timing()
+{
+	curly_phases_enabled = true;
+}
+
+// begin_phase(curly_phase_t) -> void
+// Ends the current phase (if any) and starts recording the given one.
+void begin_phase(curly_phase_t phase)
+{
+	if (!curly_phases_enabled)
+		return;
+	end_phase();
+	curly_current_phase = phase;
+	curly_phase_start_heap = heap_in_use();
+	curly_phase_start_rc = curly_rc_get_stats().allocations;
+	clock_gettime(CLOCK_MONOTONIC, &curly_phase_start_time);
+}
+
+// end_phase(void) -> void
+// Ends the current phase, adding its statistics to the phase's totals.
+void end_phase()
+{
+	if (!curly_phases_enabled || curly_current_phase == CURLY_PHASE_COUNT)
+		return;
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	// Add to the totals
+	curly_phase_stats_t* stats = curly_phase_stats + curly_current_phase;
+	stats->runs++;
+	stats->seconds += (now.tv_sec - curly_phase_start_time.tv_sec) + (now.tv_nsec - curly_phase_start_time.tv_nsec) / 1e9;
+	stats->retained_bytes += heap_in_use() - curly_phase_start_heap;
+	stats->rc_allocations += curly_rc_get_stats().allocations - curly_phase_start_rc;
+	curly_current_phase = CURLY_PHASE_COUNT;
+}
+
+// get_phase_stats(curly_phase_t) -> curly_phase_stats_t
+// Returns the statistics on a phase so far.
+curly_phase_stats_t get_phase_stats(curly_phase_t phase)
+{
+	return curly_phase_stats[phase];
+}
+
+// print_phase_stats(FILE*) -> void
+// Prints the statistics on every phase that has run and the peak resident set size, if timing is enabled.
+void print_phase_stats(FILE* file)
+{
+	if (!curly_phases_enabled)
+		return;
+	end_phase();
+
+	// Print every phase that ran
+	double total = 0;
+	fprintf(file, "%-8s %10s %12s %14s\n", "phase", "ms", "retained KiB", "rc allocations");
+	for (size_t i = 0; i < CURLY_PHASE_COUNT; i++)
+	{
+		curly_phase_stats_t stats = curly_phase_stats[i];
+		if (stats.runs == 0)
+			continue;
+		fprintf(file, "%-8s %10.3f %12li %14zu\n", curly_phase_names[i], stats.seconds * 1000,
+			stats.retained_bytes / 1024, stats.rc_allocations);
+		total += stats.seconds;
+	}
+
+	// Print the totals
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	fprintf(file, "%-8s %10.3f\n", "total", total * 1000);
+	fprintf(file, "peak rss: %li KiB\n", usage.ru_maxrss);
+}
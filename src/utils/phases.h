@@ -0,0 +1,63 @@
+//
+// utils
+// phases.h: Header file for phases.c.
+//
+// Created by jenra.
+// Created on October 18 2026.
+//
+
+#ifndef UTILS_PHASES_H
+#define UTILS_PHASES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// The phases of compiling and running code that are timed.
+typedef enum
+{
+	CURLY_PHASE_LEX,
+	CURLY_PHASE_PARSE,
+	CURLY_PHASE_IR,
+	CURLY_PHASE_CHECK,
+	CURLY_PHASE_PASSES,
+	CURLY_PHASE_LOAD,
+	CURLY_PHASE_CODEGEN,
+	CURLY_PHASE_OPT,
+	CURLY_PHASE_JIT,
+	CURLY_PHASE_RUN,
+	CURLY_PHASE_COUNT
+} curly_phase_t;
+
+// Represents the statistics on a phase, summed over every time it ran.
+typedef struct
+{
+	size_t runs;
+	double seconds;
+
+	// The net change in heap memory in use, which is negative if a phase frees more than it allocates.
+	long retained_bytes;
+	size_t rc_allocations;
+} curly_phase_stats_t;
+
+// enable_phase_timing(void) -> void
+// Starts recording statistics on phases. Nothing is recorded (or measured) until this is called.
+void enable_phase_timing();
+
+// begin_phase(curly_phase_t) -> void
+// Ends the current phase (if any) and starts recording the given one.
+void begin_phase(curly_phase_t phase);
+
+// end_phase(void) -> void
+// Ends the current phase, adding its statistics to the phase's totals.
+void end_phase();
+
+// get_phase_stats(curly_phase_t) -> curly_phase_stats_t
+// Returns the statistics on a phase so far.
+curly_phase_stats_t get_phase_stats(curly_phase_t phase);
+
+// print_phase_stats(FILE*) -> void
+// Prints the statistics on every phase that has run and the peak resident set size, if timing is enabled.
+void print_phase_stats(FILE* file);
+
+#endif /* UTILS_PHASES_H */
@@ -0,0 +1,95 @@
+#!/bin/sh
+##
+## Curly
+## bench.sh: Runs the benchmarks and prints the time and allocations of every phase as JSON, to compare across commits.
+## Besides every sample, it times checking on one thread and building from a saved IR image.
+##
+## jenra
+## October 18 2026
+##
+
+CURLY=${CURLY:-./curly}
+RUNS=${RUNS:-3}
+dir=$(mktemp -d)
+
+# A large generated file of chained definitions, which folds to a constant and so only stresses the front end
+{
+	echo "def0 x = x + 1"
+	i=1
+	while [ $i -le 3000 ]
+	do
+		echo "def$i x = if x % $((i % 7 + 2)) == 0 then def$((i - 1)) (x + $i) % 1000 else x * $((i % 5 + 1)) - $i"
+		i=$((i + 1))
+	done
+	echo "def3000 7 > 0"
+} >"$dir/generated.curly"
+
+# run_bench(name, file, [variable=value...]) -> void
+# Runs a benchmark with the given environment variables and prints its report as JSON. The fastest time of each phase
+# over the runs is kept.
+run_bench()
+{
+	name=$1
+	file=$2
+	shift 2
+
+	# Every run adds its phase report and wall time to the report
+	: >"$dir/report"
+	run=0
+	while [ $run -lt "$RUNS" ]
+	do
+		start=$(date +%s%N)
+		env "$@" "$CURLY" --time-phases "$file" 2>>"$dir/report" >/dev/null || echo "failed" >>"$dir/report"
+		end=$(date +%s%N)
+		echo "wall $(((end - start) / 1000))" >>"$dir/report"
+		run=$((run + 1))
+	done
+
+	printf '%s\n\t\t' "$separator"
+	awk -v name="$name" '
+		$1 == "wall" && (wall == "" || $2 / 1000 < wall) { wall = $2 / 1000 }
+		$1 == "failed" { failed = "true" }
+		$1 == "peak" && $3 > rss { rss = $3 }
+		NF == 4 && $1 != "phase" && $1 != "peak" {
+			if (!($1 in ms))
+				phases[count++] = $1
+			if (!($1 in ms) || $2 < ms[$1])
+				ms[$1] = $2
+			retained[$1] = $3
+			rc[$1] = $4
+		}
+		END {
+			compile = 0
+			allocations = 0
+			for (i = 0; i < count; i++)
+			{
+				if (phases[i] != "jit" && phases[i] != "run")
+					compile += ms[phases[i]]
+				allocations += rc[phases[i]]
+			}
+			printf "{\"name\": \"%s\", \"failed\": %s, \"wall_ms\": %.3f, \"compile_ms\": %.3f, \"jit_ms\": %.3f, \"run_ms\": %.3f, ",
+				name, failed == "" ? "false" : "true", wall, compile, ms["jit"], ms["run"]
+			printf "\"peak_rss_kib\": %d, \"rc_allocations\": %d, \"phases\": {", rss, allocations
+			for (i = 0; i < count; i++)
+				printf "%s\"%s\": {\"ms\": %.3f, \"retained_kib\": %d}", i == 0 ? "" : ", ", phases[i], ms[phases[i]], retained[phases[i]]
+			printf "}}"
+		}' "$dir/report"
+	separator=","
+}
+
+printf '{\n\t"commit": "%s",\n\t"runs": %s,\n\t"benchmarks": [' "$(git -C "$(dirname "$0")" rev-parse --short HEAD 2>/dev/null)" "$RUNS"
+separator=""
+for bench in $(dirname "$0")/*.curly "$dir/generated.curly"
+do
+	run_bench "$(basename "$bench" .curly)" "$bench"
+done
+
+# Type checking on one thread, to compare with checking on every core
+run_bench "inference-1-thread" "$(dirname "$0")/inference.curly" CURLY_CHECK_THREADS=1
+
+# Building from a saved IR image, which skips parsing and checking
+"$CURLY" --save-ir "$dir/inference.curlyir" "$(dirname "$0")/inference.curly" >/dev/null 2>&1
+run_bench "inference-image" "$dir/inference.curlyir"
+
+printf '\n\t]\n}\n'
+rm -r "$dir"
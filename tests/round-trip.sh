@@ -0,0 +1,27 @@
+#!/bin/sh
+##
+## Curly
+## round-trip.sh: Saves the IR of every sample to an image and checks that building the image gives the same output.
+##
+## jenra
+## October 18 2026
+##
+
+CURLY=${CURLY:-./curly}
+dir=$(mktemp -d)
+failed=0
+for sample in $(dirname "$0")/compile-tests/*.curly $(dirname "$0")/correctness-tests/*.curly
+do
+	image="$dir/$(basename "$sample" .curly).curlyir"
+	"$CURLY" --print-layouts --dump-ir --dump-llvm --save-ir "$image" "$sample" >"$dir/source.out" 2>&1
+
+	# Running the image prints the final IR, layouts, and LLVM IR, which end the output of running the source
+	if ! "$CURLY" --print-layouts --dump-ir --dump-llvm "$image" >"$dir/image.out" 2>&1 \
+	 || ! tail -n "$(wc -l <"$dir/image.out")" "$dir/source.out" | cmp -s - "$dir/image.out"
+	then
+		echo "$(basename "$sample"): round trip failed"
+		failed=1
+	fi
+done
+rm -r "$dir"
+exit $failed